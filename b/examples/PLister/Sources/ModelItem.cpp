@@ -132,6 +132,11 @@ UndoValue::UndoValue(
     inModelItem->MakeSetPropertyAppleEvent(ModelItem::pModelItemValueProperty, 
                                            valueDesc, mEvent);
     
+    // Values can be large, and successive values of the same item tend to be similar, 
+    // so let the document's undo store share their contents.
+    
+    Compact(inModelItem->GetUndoStore());
+    
 //  RecordComment("recording UndoValue");
 //  B::AEEventBase::SendEvent(mEvent, kAEDontExecute);
 }
@@ -331,6 +336,8 @@ UndoDelete::UndoDelete(
     targetObj->MakeCreateElementAppleEvent(classID, position, targetObj, 
                                            propertiesDesc, NULL, mEvent);
     
+    Compact(inModelItem->GetUndoStore());
+    
 //  RecordComment("recording UndoDelete");
 //  B::AEEventBase::SendEvent(mEvent, kAEDontExecute);
 }
@@ -1427,6 +1434,15 @@ ModelItem::IsInSameContainerAs(const ModelItem& inItem) const
     return (GetDocument() == inItem.GetDocument());
 }
 
+// ------------------------------------------------------------------------------------------
+/*! Returns the store that the item's undo actions share their events with.
+*/
+B::AEUndoStore&
+ModelItem::GetUndoStore() const
+{
+    return (GetDocument()->GetUndoStore());
+}
+
 // ------------------------------------------------------------------------------------------
 EventTargetRef
 ModelItem::GetUndoTarget() const
@@ -42,6 +42,7 @@
 namespace B {
     class   AbstractDocument;
     class   AEReader;
+    class   AEUndoStore;
     class   AEWriter;
     class   UndoAction;
 }
@@ -105,6 +106,7 @@ public:
     bool    IsInSameContainerAs(const ModelItem& inItem) const;
     ModelItemPtr        GetPtr();
     ConstModelItemPtr   GetPtr() const;
+    B::AEUndoStore&     GetUndoStore() const;
     
     // getting the value
     const B::String&    GetValueString() const;
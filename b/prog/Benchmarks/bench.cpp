@@ -0,0 +1,91 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <sys/time.h>
+
+volatile size_t     bench_sink      = 0;
+static unsigned     check_count     = 0;
+static unsigned     failure_count   = 0;
+
+double  bench_now()
+{
+    struct timeval  tv;
+    
+    gettimeofday(&tv, NULL);
+    
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+double  bench_time(void (*fn)(void* arg), void* arg, double min_seconds)
+{
+    // Warm up caches (and any lazily built state) before timing.
+    
+    fn(arg);
+    
+    unsigned long   calls   = 0;
+    double          start   = bench_now();
+    double          elapsed;
+    
+    do
+    {
+        fn(arg);
+        calls++;
+        elapsed = bench_now() - start;
+    }
+    while (elapsed < min_seconds);
+    
+    return elapsed / calls;
+}
+
+double  bench_run(const char* name, void (*fn)(void* arg), void* arg, size_t ops)
+{
+    double  per_op  = bench_time(fn, arg) / (ops > 0 ? ops : 1);
+    
+    printf("%-48s %12.1f ns/op\n", name, per_op * 1e9);
+    fflush(stdout);
+    
+    return per_op;
+}
+
+void    bench_ratio(const char* name, double slow, double fast)
+{
+    printf("%-48s %12.2fx\n", name, (fast > 0.0) ? slow / fast : 0.0);
+    fflush(stdout);
+}
+
+void    bench_check(bool ok, const char* what)
+{
+    check_count++;
+    
+    if (!ok)
+    {
+        failure_count++;
+        fprintf(stderr, "FAILED: %s\n", what);
+    }
+}
+
+int bench_finish()
+{
+    if (check_count > 0)
+        printf("%u checks, %u failures\n", check_count, failure_count);
+    
+    return (failure_count > 0) ? 1 : 0;
+}
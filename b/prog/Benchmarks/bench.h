@@ -0,0 +1,51 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#pragma once
+
+// Shared helpers for the benchmark and test programs in this directory.
+//
+// Each program times a few variants of an operation with bench_run(), checks its results 
+// with bench_check(), and returns bench_finish() from main(), which is non-zero if any 
+// check failed.
+
+#include <stddef.h>
+
+// Returns a monotonic time, in seconds.
+extern double   bench_now();
+
+// Calls fn(arg) repeatedly for about min_seconds (at least once), and returns the 
+// average time per call, in seconds.
+extern double   bench_time(void (*fn)(void* arg), void* arg, double min_seconds = 0.2);
+
+// Times fn(arg) with bench_time() and prints "name: N ns/op", where one call of fn 
+// performs ops operations.  Returns the time per operation, in seconds.
+extern double   bench_run(const char* name, void (*fn)(void* arg), void* arg, 
+                          size_t ops = 1);
+
+// Prints "ratio: <slow/fast>x" for two times returned by bench_run().
+extern void     bench_ratio(const char* name, double slow, double fast);
+
+// Records the outcome of a check;  failures are printed along with what.
+extern void     bench_check(bool ok, const char* what);
+
+// Prints a summary and returns the process's exit status.
+extern int      bench_finish();
+
+// Prevents the compiler from optimising away a computed value.
+extern volatile size_t  bench_sink;
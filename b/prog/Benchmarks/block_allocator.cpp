@@ -0,0 +1,184 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Tests B::BlockAllocator, and measures the cost of building buffers by small appends,
+// growing each buffer to its exact size on every append (as SetHandleSize() does)
+// against growing it the way B::HandleBuffer does.
+//
+// The makefile builds this program twice:  block_allocator uses the size-class arenas,
+// and block_allocator_malloc is built with B_BLOCK_ALLOCATOR_ARENAS set to 0.
+//
+// This program doesn't need the Mac OS X frameworks.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BBlockAllocator.h"
+
+#include "bench.h"
+
+enum    { kBuffers = 2000, kAppends = 64, kChunkSize = 24 };
+
+static char chunk[kChunkSize];
+
+// HandleBuffer's growth logic, minus the Carbon parts.
+struct block_buffer
+{
+    char*   data;
+    size_t  size;
+    size_t  capacity;
+    
+    block_buffer() : data(NULL), size(0), capacity(0) {}
+    ~block_buffer() { B::BlockAllocator::Deallocate(data, capacity); }
+    
+    void    append(const void* p, size_t n)
+    {
+        if (size + n > capacity)
+            data = static_cast<char*>(B::BlockAllocator::Resize(data, capacity, size,
+                                                                size + n, capacity));
+        
+        memcpy(data + size, p, n);
+        size += n;
+    }
+};
+
+// ------------------------------------------------------------------------------------------
+//  Checks
+
+static void check_capacity()
+{
+    using B::BlockAllocator;
+    
+#if B_BLOCK_ALLOCATOR_ARENAS
+    bench_check(BlockAllocator::GetCapacity(0) == 16, "empty blocks get the smallest class");
+    bench_check(BlockAllocator::GetCapacity(24) == 32, "small blocks round up to a power of two");
+    bench_check(BlockAllocator::GetCapacity(2049) == 4096, "the largest class is a page");
+#else
+    bench_check(BlockAllocator::GetCapacity(0) == 16, "empty blocks get 16 bytes");
+    bench_check(BlockAllocator::GetCapacity(24) == 32, "small blocks round up to 16 bytes");
+    bench_check(BlockAllocator::GetCapacity(100) == 112, "small blocks aren't rounded to a power of two");
+    bench_check(BlockAllocator::GetCapacity(2049) == 2064, "small blocks aren't rounded to a page");
+#endif
+    bench_check(BlockAllocator::GetCapacity(4097) == 8192, "large blocks round up to a page");
+    bench_check(BlockAllocator::GetGrowthCapacity(1024, 1025) >= 1536,
+                "growing a block grows its capacity by half");
+}
+
+static void check_resize()
+{
+    using B::BlockAllocator;
+    
+    size_t  capacity;
+    char*   block       = static_cast<char*>(BlockAllocator::Allocate(10, capacity));
+    size_t  old         = capacity;
+    
+    bench_check(capacity >= 10, "Allocate() returns the block's capacity");
+    
+    memcpy(block, "0123456789", 10);
+    
+    bench_check(BlockAllocator::Resize(block, capacity, 10, capacity, capacity) == block,
+                "Resize() within the capacity keeps the block");
+    bench_check(capacity == old, "Resize() within the capacity keeps the capacity");
+    
+    block = static_cast<char*>(BlockAllocator::Resize(block, capacity, 10, 10000, capacity));
+    
+    bench_check(capacity >= 10000, "Resize() beyond the capacity grows the block");
+    bench_check(memcmp(block, "0123456789", 10) == 0, "Resize() keeps the used bytes");
+    
+    BlockAllocator::Deallocate(block, capacity);
+}
+
+static void check_appends()
+{
+    block_buffer    buffer;
+    size_t          reallocations   = 0;
+    bool            ok              = true;
+    
+    for (int i = 0; i < kAppends; i++)
+    {
+        char*   old     = buffer.data;
+        char    c       = static_cast<char>('a' + i % 26);
+        
+        memset(chunk, c, sizeof(chunk));
+        buffer.append(chunk, sizeof(chunk));
+        
+        if (buffer.data != old)
+            reallocations++;
+    }
+    
+    for (int i = 0; i < kAppends; i++)
+        ok = ok && (buffer.data[i * kChunkSize] == static_cast<char>('a' + i % 26)) &&
+                   (buffer.data[i * kChunkSize + kChunkSize - 1] == buffer.data[i * kChunkSize]);
+    
+    bench_check(buffer.size == kAppends * kChunkSize, "appends add up");
+    bench_check(ok, "appends are copied in order");
+    bench_check(reallocations <= 12, "appends reallocate a logarithmic number of times");
+}
+
+// ------------------------------------------------------------------------------------------
+//  Timings
+
+static void append_exact(void*)
+{
+    for (int b = 0; b < kBuffers; b++)
+    {
+        char*   data    = NULL;
+        size_t  size    = 0;
+        
+        for (int a = 0; a < kAppends; a++)
+        {
+            data = static_cast<char*>(realloc(data, size + sizeof(chunk)));
+            memcpy(data + size, chunk, sizeof(chunk));
+            size += sizeof(chunk);
+        }
+        
+        bench_sink += data[size - 1];
+        free(data);
+    }
+}
+
+static void append_block_allocator(void*)
+{
+    for (int b = 0; b < kBuffers; b++)
+    {
+        block_buffer    buffer;
+        
+        for (int a = 0; a < kAppends; a++)
+            buffer.append(chunk, sizeof(chunk));
+        
+        bench_sink += buffer.data[buffer.size - 1];
+    }
+}
+
+int main()
+{
+    check_capacity();
+    check_resize();
+    check_appends();
+    
+    memset(chunk, 'x', sizeof(chunk));
+    
+    double  slow    = bench_run("exact growth, 64 appends", append_exact, NULL, kBuffers);
+    double  fast    = bench_run("BlockAllocator growth, 64 appends", append_block_allocator,
+                                NULL, kBuffers);
+    
+    bench_ratio("BlockAllocator speedup", slow, fast);
+    
+    return bench_finish();
+}
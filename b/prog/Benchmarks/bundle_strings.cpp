@@ -0,0 +1,194 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Builds a bundle with a 1000-entry Localizable.strings table in a temporary directory, 
+// and measures looking up its keys with B::Bundle::GetLocalisedString() against 
+// CFBundleCopyLocalizedString(), for keys that are in the table and for keys that 
+// aren't.  Also checks that both return the same strings, and that looking up missing 
+// keys doesn't add them to InternedString's table.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include "BBundle.h"
+#include "BInternedString.h"
+#include "BString.h"
+
+#include "bench.h"
+
+enum    { kEntries = 1000 };
+
+struct lookup
+{
+    B::Bundle*                  bundle;
+    CFBundleRef                 cfbundle;
+    std::vector<CFStringRef>    keys;
+};
+
+static std::string make_bundle(char* dir)
+{
+    if (mkdtemp(dir) == NULL)
+        return "";
+    
+    std::string bundle  = std::string(dir) + "/Strings.bundle";
+    std::string lproj   = bundle + "/Contents/Resources/English.lproj";
+    
+    mkdir(bundle.c_str(), 0755);
+    mkdir((bundle + "/Contents").c_str(), 0755);
+    mkdir((bundle + "/Contents/Resources").c_str(), 0755);
+    mkdir(lproj.c_str(), 0755);
+    
+    FILE*   file    = fopen((bundle + "/Contents/Info.plist").c_str(), "w");
+    
+    fprintf(file, "{ CFBundleIdentifier = \"com.example.b.bundle-strings\"; "
+                  "CFBundleDevelopmentRegion = English; }\n");
+    fclose(file);
+    
+    file = fopen((lproj + "/Localizable.strings").c_str(), "w");
+    
+    for (int i = 0; i < kEntries; i++)
+        fprintf(file, "\"Key number %d\" = \"Value number %d\";\n", i, i);
+    
+    fclose(file);
+    
+    return bundle;
+}
+
+static void remove_bundle(const char* dir)
+{
+    std::string command = std::string("rm -rf '") + dir + "'";
+    
+    system(command.c_str());
+}
+
+static CFStringRef make_key(const char* format, int i)
+{
+    char    buf[64];
+    
+    snprintf(buf, sizeof(buf), format, i);
+    
+    return CFStringCreateWithCString(NULL, buf, kCFStringEncodingUTF8);
+}
+
+static void time_bundle(void* arg)
+{
+    lookup* l   = static_cast<lookup*>(arg);
+    
+    for (size_t i = 0; i < l->keys.size(); i++)
+        bench_sink += l->bundle->GetLocalisedString(l->keys[i], NULL, NULL).size();
+}
+
+static void time_cfbundle(void* arg)
+{
+    lookup* l   = static_cast<lookup*>(arg);
+    
+    for (size_t i = 0; i < l->keys.size(); i++)
+    {
+        CFStringRef value   = CFBundleCopyLocalizedString(l->cfbundle, l->keys[i], NULL, NULL);
+        
+        bench_sink += CFStringGetLength(value);
+        CFRelease(value);
+    }
+}
+
+static void check_values(lookup& l, const char* what)
+{
+    bool    same    = true;
+    
+    for (size_t i = 0; i < l.keys.size(); i++)
+    {
+        CFStringRef value   = CFBundleCopyLocalizedString(l.cfbundle, l.keys[i], NULL, NULL);
+        
+        same = same && CFEqual(value, l.bundle->GetLocalisedString(l.keys[i], NULL, NULL).cf_ref());
+        CFRelease(value);
+    }
+    
+    bench_check(same, what);
+}
+
+static void run(lookup& l, const char* label)
+{
+    char    name[128];
+    
+    snprintf(name, sizeof(name), "CFBundleCopyLocalizedString, %s", label);
+    double  slow    = bench_run(name, time_cfbundle, &l, l.keys.size());
+    
+    snprintf(name, sizeof(name), "Bundle::GetLocalisedString, %s", label);
+    double  fast    = bench_run(name, time_bundle, &l, l.keys.size());
+    
+    snprintf(name, sizeof(name), "GetLocalisedString speedup, %s", label);
+    bench_ratio(name, slow, fast);
+}
+
+int main()
+{
+    char        dir[]   = "/tmp/b_bundle_strings_XXXXXX";
+    std::string path    = make_bundle(dir);
+    CFURLRef    url     = CFURLCreateFromFileSystemRepresentation(
+                                NULL, reinterpret_cast<const UInt8*>(path.c_str()), 
+                                path.size(), true);
+    CFBundleRef cfbundle = (url != NULL) ? CFBundleCreate(NULL, url) : NULL;
+    
+    bench_check(cfbundle != NULL, "test bundle was created");
+    
+    if (cfbundle == NULL)
+    {
+        remove_bundle(dir);
+        return bench_finish();
+    }
+    
+    B::Bundle   bundle(cfbundle);
+    lookup      hits    = { &bundle, cfbundle };
+    lookup      misses  = { &bundle, cfbundle };
+    
+    for (int i = 0; i < kEntries; i++)
+    {
+        hits.keys.push_back(make_key("Key number %d", i));
+        misses.keys.push_back(make_key("Missing key number %d", i));
+    }
+    
+    check_values(hits, "GetLocalisedString matches CFBundle for keys in the table");
+    check_values(misses, "GetLocalisedString matches CFBundle for keys not in the table");
+    
+    size_t  interned    = B::InternedString::GetTableSize();
+    
+    run(hits, "hit");
+    run(misses, "miss");
+    
+    bench_check(B::InternedString::GetTableSize() == interned, 
+                "looking up keys doesn't intern them");
+    
+    for (int i = 0; i < kEntries; i++)
+    {
+        CFRelease(hits.keys[i]);
+        CFRelease(misses.keys[i]);
+    }
+    
+    CFRelease(cfbundle);
+    CFRelease(url);
+    remove_bundle(dir);
+    
+    return bench_finish();
+}
@@ -0,0 +1,317 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Tests B::ContiguousArray<CFStringRef> against B::MutableArray<CFStringRef>:  the same 
+// inserts, erasures and sort applied to both must give the same elements;  cf_ref() must 
+// build its CFArrayRef only when asked, and drop it at the next edit;  and every element 
+// must be back to its original retain count once the arrays are gone.  Then measures 
+// sorting and scanning a large array of strings held in each.
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include "BContiguousArray.h"
+#include "BMutableArray.h"
+
+#include "bench.h"
+
+typedef B::ContiguousArray<CFStringRef> contiguous_array;
+typedef B::MutableArray<CFStringRef>    mutable_array;
+
+enum    { kCount = 10000, kChecked = 200 };
+
+static unsigned long    s_seed  = 1;
+
+static size_t random_pos(size_t size)
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    
+    return (size > 0) ? s_seed % size : 0;
+}
+
+// Makes num distinct strings, in shuffled order.  They're long enough not to be tagged 
+// pointers, so that their retain counts are real.
+static std::vector<CFStringRef> make_strings(size_t num)
+{
+    std::vector<CFStringRef>    strings(num);
+    
+    for (size_t i = 0; i < num; i++)
+    {
+        strings[i] = CFStringCreateWithFormat(NULL, NULL, CFSTR("contiguous array element %06lu"), 
+                                              static_cast<unsigned long>(i));
+    }
+    
+    for (size_t i = num; i > 1; i--)
+        std::swap(strings[i-1], strings[random_pos(i)]);
+    
+    return (strings);
+}
+
+static void release_strings(std::vector<CFStringRef>& strings)
+{
+    for (size_t i = 0; i < strings.size(); i++)
+        CFRelease(strings[i]);
+    
+    strings.clear();
+}
+
+// Orders either a ContiguousArray's references or the OSPtrs std::sort() sets aside.
+struct less_string
+{
+    template <class A, class B> bool    operator () (const A& a, const B& b) const
+    {
+        return (CFStringCompare(a.get(), b.get(), 0) == kCFCompareLessThan);
+    }
+};
+
+static CFComparisonResult   compare_strings(const void* a, const void* b, void*)
+{
+    return (CFStringCompare(static_cast<CFStringRef>(a), static_cast<CFStringRef>(b), 0));
+}
+
+static void sort_mutable(mutable_array& arr)
+{
+    CFArraySortValues(arr.cf_ref(), CFRangeMake(0, arr.size()), compare_strings, NULL);
+}
+
+static bool same(const contiguous_array& carr, const mutable_array& marr)
+{
+    if (carr.size() != marr.size())
+        return (false);
+    
+    for (size_t i = 0; i < carr.size(); i++)
+    {
+        if (!CFEqual(carr.data()[i], marr[i].get()))
+            return (false);
+    }
+    
+    return (true);
+}
+
+static bool retain_counts_are(const std::vector<CFStringRef>& strings, CFIndex count)
+{
+    for (size_t i = 0; i < strings.size(); i++)
+    {
+        if (CFGetRetainCount(strings[i]) != count)
+            return (false);
+    }
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+//  Checks
+
+static void check_edits(const std::vector<CFStringRef>& strings)
+{
+    size_t              half    = strings.size() / 2;
+    contiguous_array    carr(strings.begin(), strings.begin() + half);
+    mutable_array       marr(strings.begin(), strings.begin() + half);
+    
+    bench_check(same(carr, marr), "range construction matches MutableArray");
+    
+    carr.insert(carr.begin() + 10, strings.begin() + half, strings.end());
+    marr.insert(marr.begin() + 10, strings.begin() + half, strings.end());
+    
+    bench_check(same(carr, marr), "range insert matches MutableArray");
+    
+    for (size_t i = 0; i < 20; i++)
+    {
+        size_t  pos = random_pos(carr.size());
+        
+        carr.insert(carr.begin() + pos, strings[i]);
+        marr.insert(marr.begin() + pos, strings[i]);
+    }
+    
+    bench_check(same(carr, marr), "single inserts match MutableArray");
+    
+    carr.erase(carr.begin() + 5, carr.begin() + 25);
+    marr.erase(marr.begin() + 5, marr.begin() + 25);
+    
+    for (size_t i = 0; i < 20; i++)
+    {
+        size_t  pos = random_pos(carr.size());
+        
+        carr.erase(carr.begin() + pos);
+        marr.erase(marr.begin() + pos);
+    }
+    
+    bench_check(same(carr, marr), "erasures match MutableArray");
+    
+    std::sort(carr.begin(), carr.end(), less_string());
+    sort_mutable(marr);
+    
+    bench_check(same(carr, marr), "std::sort() matches CFArraySortValues() on MutableArray");
+    
+    contiguous_array    copied(marr);
+    
+    bench_check(copied == carr, "construction from a MutableArray copies its elements");
+}
+
+static void check_cf_ref(const std::vector<CFStringRef>& strings)
+{
+    contiguous_array    arr(strings.begin(), strings.end());
+    CFStringRef         first   = arr.data()[0];
+    
+    bench_check(CFGetRetainCount(first) == 2, "elements are retained once by the array");
+    
+    CFArrayRef          ref     = arr.cf_ref();
+    
+    bench_check(CFGetRetainCount(first) == 3, "cf_ref() builds a CFArrayRef when first asked");
+    bench_check(arr.cf_ref() == ref, "cf_ref() is cached until the next change");
+    bench_check(CFGetRetainCount(first) == 3, "a cached cf_ref() isn't rebuilt");
+    
+    bool    ok  = (CFArrayGetCount(ref) == static_cast<CFIndex>(arr.size()));
+    
+    for (size_t i = 0; ok && (i < arr.size()); i++)
+        ok = (CFArrayGetValueAtIndex(ref, i) == arr.data()[i]);
+    
+    bench_check(ok, "cf_ref() holds the array's elements, in order");
+    
+    arr.push_back(first);
+    
+    bench_check(CFGetRetainCount(first) == 3, "an edit drops the cached CFArrayRef");
+    
+    B::OSPtr<CFArrayRef>    held    = arr.cf_ptr();
+    
+    arr.pop_back();
+    
+    bench_check(CFArrayGetCount(held) == static_cast<CFIndex>(arr.size() + 1), 
+                "cf_ptr() keeps the old CFArrayRef alive, unchanged");
+    bench_check(arr.cf_ref() != held.get(), "cf_ref() is rebuilt after an edit");
+    bench_check(CFArrayGetCount(arr.cf_ref()) == static_cast<CFIndex>(arr.size()), 
+                "the rebuilt cf_ref() holds the array's elements");
+    
+    arr.cf_ref();
+    arr[1] = arr[2];
+    
+    bench_check(CFArrayGetValueAtIndex(arr.cf_ref(), 1) == arr.data()[2], 
+                "assigning through a reference drops the cached CFArrayRef");
+    
+    swap(arr[0], arr[1]);
+    
+    bench_check(CFArrayGetValueAtIndex(arr.cf_ref(), 0) == arr.data()[0], 
+                "swapping references drops the cached CFArrayRef");
+    
+    arr.clear();
+    
+    bench_check(CFArrayGetCount(arr.cf_ref()) == 0, "clear() drops the cached CFArrayRef");
+}
+
+static void check_retain_counts(const std::vector<CFStringRef>& strings)
+{
+    bench_check(retain_counts_are(strings, 1), "strings start with one reference");
+    
+    {
+        contiguous_array    arr(strings.begin(), strings.end());
+        contiguous_array    copy(arr);
+        
+        bench_check(retain_counts_are(strings, 3), "range and copy construction retain each element once");
+        
+        copy.clear();
+        
+        bench_check(retain_counts_are(strings, 2), "clear() releases each element once");
+        
+        copy.insert(copy.end(), strings.begin(), strings.end());
+        copy.erase(copy.begin(), copy.begin() + strings.size() / 2);
+        copy.resize(strings.size(), strings[0]);
+        copy.pop_back();
+        copy.assign(arr.data(), arr.data() + arr.size());
+        
+        bench_check(retain_counts_are(strings, 3), "insert, erase, resize and assign balance");
+        
+        std::sort(arr.begin(), arr.end(), less_string());
+        arr.cf_ref();
+        arr.erase(arr.begin() + 1);
+        arr.cf_ref();
+        arr = mutable_array(strings.begin(), strings.end());
+    }
+    
+    bench_check(retain_counts_are(strings, 1), "sorting, cf_ref() and destruction balance");
+}
+
+// ------------------------------------------------------------------------------------------
+//  Timings
+
+static void time_sort_mutable(void* arg)
+{
+    mutable_array   arr(*static_cast<const mutable_array*>(arg));
+    
+    sort_mutable(arr);
+    bench_sink += CFStringGetLength(static_cast<const mutable_array&>(arr).front().get());
+}
+
+static void time_sort_contiguous(void* arg)
+{
+    contiguous_array    arr(*static_cast<const contiguous_array*>(arg));
+    
+    std::sort(arr.begin(), arr.end(), less_string());
+    bench_sink += CFStringGetLength(arr.data()[0]);
+}
+
+static void time_scan_mutable(void* arg)
+{
+    const mutable_array&    arr = *static_cast<const mutable_array*>(arg);
+    
+    for (mutable_array::const_iterator it = arr.begin(); it != arr.end(); ++it)
+        bench_sink += CFStringGetLength((*it).get());
+}
+
+static void time_scan_contiguous(void* arg)
+{
+    const contiguous_array& arr = *static_cast<const contiguous_array*>(arg);
+    
+    for (const CFStringRef* p = arr.data(); p != arr.data() + arr.size(); ++p)
+        bench_sink += CFStringGetLength(*p);
+}
+
+int main()
+{
+    std::vector<CFStringRef>    strings = make_strings(kChecked);
+    
+    check_edits(strings);
+    check_cf_ref(strings);
+    check_retain_counts(strings);
+    release_strings(strings);
+    
+    strings = make_strings(kCount);
+    
+    {
+        mutable_array       marr(strings.begin(), strings.end());
+        contiguous_array    carr(strings.begin(), strings.end());
+        
+        double  slow    = bench_run("MutableArray, sort", time_sort_mutable, &marr, kCount);
+        double  fast    = bench_run("ContiguousArray, sort", time_sort_contiguous, &carr, kCount);
+        
+        bench_ratio("ContiguousArray speedup, sort", slow, fast);
+        
+        slow    = bench_run("MutableArray, scan", time_scan_mutable, &marr, kCount);
+        fast    = bench_run("ContiguousArray, scan", time_scan_contiguous, &carr, kCount);
+        
+        bench_ratio("ContiguousArray speedup, scan", slow, fast);
+    }
+    
+    release_strings(strings);
+    
+    return bench_finish();
+}
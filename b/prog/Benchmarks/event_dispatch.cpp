@@ -0,0 +1,146 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Measures the cost of dispatching a Carbon Event through B::EventHandler, as a function 
+// of the number of events the handler is registered for, against a bare Carbon handler.
+//
+// The handler's functor table is a sorted vector searched with a binary search, so the 
+// B overhead should grow only logarithmically with the number of registered events.
+
+#include <stdio.h>
+
+#include <Carbon/Carbon.h>
+
+#include "BEvent.h"
+#include "BEventHandler.h"
+
+#include "bench.h"
+
+enum    { kEventClassBench = 'Bnch', kMaxKinds = 256 };
+
+template <UInt32 KIND> bool handle_event(B::Event<kEventClassBench, KIND>&)
+{
+    bench_sink++;
+    return true;
+}
+
+// Registers handlers for kinds [KIND, count).
+template <UInt32 KIND> struct registrar
+{
+    static void add(B::EventHandler& handler, UInt32 count)
+    {
+        if (KIND < count)
+        {
+            handler.Add<kEventClassBench, KIND>(handle_event<KIND>);
+            registrar<KIND + 1>::add(handler, count);
+        }
+    }
+};
+
+template <> struct registrar<kMaxKinds>
+{
+    static void add(B::EventHandler&, UInt32) {}
+};
+
+struct dispatch_args
+{
+    EventTargetRef  target;
+    EventRef        event;
+};
+
+static void dispatch_once(void* arg)
+{
+    dispatch_args*  args    = static_cast<dispatch_args*>(arg);
+    
+    for (int i = 0; i < 1000; i++)
+        SendEventToEventTarget(args->event, args->target);
+}
+
+static pascal OSStatus  bare_handler(EventHandlerCallRef, EventRef, void*)
+{
+    bench_sink++;
+    return noErr;
+}
+
+static EventRef make_event(UInt32 kind)
+{
+    EventRef    event   = NULL;
+    
+    CreateEvent(NULL, kEventClassBench, kind, 0, kEventAttributeNone, &event);
+    
+    return event;
+}
+
+static double   time_bare(EventTargetRef target)
+{
+    EventTypeSpec   spec    = { kEventClassBench, 0 };
+    EventHandlerRef handler;
+    dispatch_args   args    = { target, make_event(0) };
+    
+    InstallEventTargetHandler(target, NewEventHandlerUPP(bare_handler), 1, &spec, NULL, 
+                              &handler);
+    
+    double  t = bench_run("Carbon handler, 1 event", dispatch_once, &args, 1000);
+    
+    RemoveEventHandler(handler);
+    ReleaseEvent(args.event);
+    
+    return t;
+}
+
+static double   time_b(EventTargetRef target, UInt32 count)
+{
+    B::EventHandler handler(target);
+    
+    registrar<0>::add(handler, count);
+    handler.Init();
+    
+    // The last kind is the one furthest from the start of the table.
+    
+    dispatch_args   args    = { target, make_event(count - 1) };
+    char            name[64];
+    size_t          before  = bench_sink;
+    
+    dispatch_once(&args);
+    bench_check(bench_sink == before + 1000, "B::EventHandler calls the registered functor");
+    
+    snprintf(name, sizeof(name), "B::EventHandler, %u events", (unsigned) count);
+    
+    double  t = bench_run(name, dispatch_once, &args, 1000);
+    
+    ReleaseEvent(args.event);
+    
+    return t;
+}
+
+int main()
+{
+    EventTargetRef  target  = GetApplicationEventTarget();
+    double          bare    = time_bare(target);
+    double          one     = time_b(target, 1);
+    
+    time_b(target, 8);
+    time_b(target, 64);
+    
+    double          many    = time_b(target, kMaxKinds);
+    
+    printf("%-48s %12.1f ns/op\n", "B overhead, 1 event", (one - bare) * 1e9);
+    printf("%-48s %12.1f ns/op\n", "B overhead, 256 events", (many - bare) * 1e9);
+    
+    return bench_finish();
+}
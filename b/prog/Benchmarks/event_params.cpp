@@ -0,0 +1,211 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Measures the cost of retrieving a kEventMouseMoved event's parameters with 
+// B::GetEventParams(), against the one-EventParam<NAME>::Get()-per-parameter approach 
+// the Event<kEventClassMouse, kEventMouseMoved> constructor used previously.  Then 
+// measures constructing the Event itself with every argument, against constructing it 
+// with only the mouse delta selected, as a handler added with B::kEventArgMouseDelta 
+// would.
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+
+#include <Carbon/Carbon.h>
+
+#include "BEvent.h"
+#include "BEventParams.h"
+
+#include "bench.h"
+
+// Same layout as the block used by B's own Event<kEventClassMouse, kEventMouseMoved>.
+struct motion_params
+{
+    ::HIPoint   mMouseLocation;
+    UInt32      mKeyModifiers;
+    ::Point     mMouseDelta;
+    WindowRef   mWindowRef;
+    ::HIPoint   mWindowMouseLocation;
+};
+
+static const B::EventParamDescriptor    kMotionParams[] = {
+    B_EVENT_PARAM(motion_params, mMouseLocation,        kEventParamMouseLocation,       true), 
+    B_EVENT_PARAM(motion_params, mKeyModifiers,         kEventParamKeyModifiers,        true), 
+    B_EVENT_PARAM(motion_params, mMouseDelta,           kEventParamMouseDelta,          true), 
+    B_EVENT_PARAM(motion_params, mWindowRef,            kEventParamWindowRef,           false), 
+    B_EVENT_PARAM(motion_params, mWindowMouseLocation,  kEventParamWindowMouseLocation, false), 
+};
+
+static EventRef make_event()
+{
+    EventRef    event   = NULL;
+    ::HIPoint   where   = { 100, 200 };
+    ::HIPoint   local   = { 10, 20 };
+    UInt32      mods    = shiftKey;
+    ::Point     delta   = { 3, 4 };
+    WindowRef   window  = reinterpret_cast<WindowRef>(0x1234);
+    
+    CreateEvent(NULL, kEventClassMouse, kEventMouseMoved, 0, kEventAttributeNone, &event);
+    SetEventParameter(event, kEventParamMouseLocation, typeHIPoint, sizeof(where), &where);
+    SetEventParameter(event, kEventParamKeyModifiers, typeUInt32, sizeof(mods), &mods);
+    SetEventParameter(event, kEventParamMouseDelta, typeQDPoint, sizeof(delta), &delta);
+    SetEventParameter(event, kEventParamWindowRef, typeWindowRef, sizeof(window), &window);
+    SetEventParameter(event, kEventParamWindowMouseLocation, typeHIPoint, sizeof(local), 
+                      &local);
+    
+    return event;
+}
+
+static void get_block(EventRef event, motion_params& params)
+{
+    B::GetEventParams(event, kMotionParams, params);
+}
+
+static void get_each(EventRef event, motion_params& params)
+{
+    params.mMouseLocation   = B::EventParam<kEventParamMouseLocation>::Get(event);
+    params.mKeyModifiers    = B::EventParam<kEventParamKeyModifiers>::Get(event);
+    params.mMouseDelta      = B::EventParam<kEventParamMouseDelta>::Get(event);
+    
+    if (B::EventParam<kEventParamWindowRef>::Get(event, params.mWindowRef, std::nothrow))
+        params.mWindowMouseLocation = B::EventParam<kEventParamWindowMouseLocation>::Get(event);
+}
+
+static void block_once(void* arg)
+{
+    EventRef        event   = static_cast<EventRef>(arg);
+    motion_params   params;
+    
+    for (int i = 0; i < 1000; i++)
+    {
+        get_block(event, params);
+        bench_sink += params.mKeyModifiers;
+    }
+}
+
+static void each_once(void* arg)
+{
+    EventRef        event   = static_cast<EventRef>(arg);
+    motion_params   params;
+    
+    for (int i = 0; i < 1000; i++)
+    {
+        get_each(event, params);
+        bench_sink += params.mKeyModifiers;
+    }
+}
+
+static void event_all(void* arg)
+{
+    EventRef    event   = static_cast<EventRef>(arg);
+    
+    for (int i = 0; i < 1000; i++)
+    {
+        B::Event<kEventClassMouse, kEventMouseMoved>    moved(NULL, event);
+        
+        bench_sink += moved.mKeyModifiers;
+    }
+}
+
+static void event_delta(void* arg)
+{
+    EventRef    event   = static_cast<EventRef>(arg);
+    
+    for (int i = 0; i < 1000; i++)
+    {
+        B::Event<kEventClassMouse, kEventMouseMoved>    moved(NULL, event, B::kEventArgMouseDelta);
+        
+        bench_sink += static_cast<size_t>(moved.mMouseDelta.x);
+    }
+}
+
+static void check_subsets(EventRef event, const motion_params& each)
+{
+    motion_params   block;
+    
+    memset(&block, 0xAB, sizeof(block));
+    
+    UInt32  present = B::GetEventParams(event, kMotionParams, block, 0x06);
+    
+    bench_check(present == 0x06, "GetEventParams reports only the wanted parameters");
+    bench_check((block.mKeyModifiers == each.mKeyModifiers) && 
+                (block.mMouseDelta.h == each.mMouseDelta.h) && 
+                (block.mMouseDelta.v == each.mMouseDelta.v), 
+                "GetEventParams fills in the wanted parameters");
+    bench_check((reinterpret_cast<const UInt8*>(&block.mMouseLocation)[0] == 0xAB) && 
+                (reinterpret_cast<const UInt8*>(&block.mWindowRef)[0] == 0xAB), 
+                "GetEventParams leaves the other fields untouched");
+    
+    B::Event<kEventClassMouse, kEventMouseMoved>    all(NULL, event);
+    B::Event<kEventClassMouse, kEventMouseMoved>    delta(NULL, event, B::kEventArgMouseDelta);
+    
+    bench_check((all.mKeyModifiers == each.mKeyModifiers) && (all.mWindowRef == each.mWindowRef) && 
+                (all.mMouseLocation.x == each.mWindowMouseLocation.x), 
+                "Event retrieves every argument by default");
+    bench_check((delta.mMouseDelta.x == each.mMouseDelta.h) && 
+                (delta.mMouseDelta.y == each.mMouseDelta.v), 
+                "Event retrieves the selected arguments");
+    bench_check((delta.mKeyModifiers == 0) && (delta.mWindowRef == NULL) && 
+                (delta.mGlobalMouseLocation.x == 0), 
+                "Event zeroes the arguments that aren't selected");
+}
+
+static bool same(const motion_params& a, const motion_params& b)
+{
+    return ((a.mMouseLocation.x == b.mMouseLocation.x) && 
+            (a.mMouseLocation.y == b.mMouseLocation.y) && 
+            (a.mKeyModifiers == b.mKeyModifiers) && 
+            (a.mMouseDelta.h == b.mMouseDelta.h) && 
+            (a.mMouseDelta.v == b.mMouseDelta.v) && 
+            (a.mWindowRef == b.mWindowRef) && 
+            (a.mWindowMouseLocation.x == b.mWindowMouseLocation.x) && 
+            (a.mWindowMouseLocation.y == b.mWindowMouseLocation.y));
+}
+
+int main()
+{
+    EventRef        event   = make_event();
+    motion_params   block, each;
+    
+    memset(&block, 0, sizeof(block));
+    memset(&each, 0, sizeof(each));
+    
+    UInt32  present = B::GetEventParams(event, kMotionParams, block);
+    
+    get_each(event, each);
+    
+    bench_check(present == 0x1F, "GetEventParams reports all parameters present");
+    bench_check(same(block, each), "GetEventParams matches EventParam<NAME>::Get");
+    
+    double  slow    = bench_run("EventParam<NAME>::Get, 5 params", each_once, event, 1000);
+    double  fast    = bench_run("GetEventParams, 5 params", block_once, event, 1000);
+    
+    bench_ratio("GetEventParams speedup", slow, fast);
+    
+    check_subsets(event, each);
+    
+    slow    = bench_run("Event<kEventMouseMoved>, all arguments", event_all, event, 1000);
+    fast    = bench_run("Event<kEventMouseMoved>, mouse delta only", event_delta, event, 1000);
+    
+    bench_ratio("kEventArgMouseDelta speedup", slow, fast);
+    
+    ReleaseEvent(event);
+    
+    return bench_finish();
+}
@@ -0,0 +1,276 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Round-trips every exception class that B registers with B::ExceptionStreamer through 
+// both of its formats, checking that the rethrown exception has the same type, what() 
+// string and OSStatus as the original, and that the binary writer didn't fall back to 
+// the text format.  Then measures externalising and rethrowing an exception in each 
+// format, which is what happens whenever one crosses a Carbon Event or Apple Event.
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <ios>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+
+#include <AGL/agl.h>
+#include <Carbon/Carbon.h>
+
+#include <boost/any.hpp>
+#include <boost/format.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/exceptions.hpp>
+
+#include "BAEObjectSupport.h"
+#include "BErrorHandler.h"
+#include "BException.h"
+#include "BExceptionStreamer.h"
+#include "BOpenGLUtilities.h"
+
+#include "bench.h"
+
+enum    { kRuns = 100 };
+
+static unsigned s_classes   = 0;
+
+static void check_rethrow(const std::exception& ex, const std::string& data, const char* format)
+{
+    bool    ok  = false;
+    
+    try
+    {
+        B::ExceptionStreamer::Get()->Rethrow(data.data(), data.size());
+    }
+    catch (const std::exception& caught)
+    {
+        ok = (typeid(caught) == typeid(ex)) && 
+             (strcmp(caught.what(), ex.what()) == 0) && 
+             (B::ErrorHandler::GetStatus(caught, noErr) == B::ErrorHandler::GetStatus(ex, noErr));
+    }
+    catch (...)
+    {
+    }
+    
+    char    what[256];
+    
+    snprintf(what, sizeof(what), "%s round trip of %s", format, typeid(ex).name());
+    bench_check(ok, what);
+}
+
+static void round_trip(const std::exception& ex)
+{
+    std::ostringstream  ostr;
+    std::string         binary;
+    char                what[256];
+    
+    B::ExceptionStreamer::Get()->Externalize(ex, ostr);
+    B::ExceptionStreamer::Get()->Externalize(ex, binary);
+    
+    snprintf(what, sizeof(what), "binary record for %s", typeid(ex).name());
+    bench_check((binary.size() >= 4) && (memcmp(binary.data(), "BExB", 4) == 0), what);
+    
+    check_rethrow(ex, ostr.str(), "text");
+    check_rethrow(ex, binary, "binary");
+    
+    s_classes++;
+}
+
+static void round_trip_std()
+{
+    round_trip(std::exception());
+    round_trip(std::bad_cast());
+    round_trip(std::bad_exception());
+    round_trip(std::bad_typeid());
+    round_trip(std::logic_error("logic_error"));
+    round_trip(std::domain_error("domain_error"));
+    round_trip(std::invalid_argument("invalid_argument"));
+    round_trip(std::length_error("length_error"));
+    round_trip(std::out_of_range("out_of_range"));
+    round_trip(std::runtime_error("runtime_error <&\"'>"));
+    round_trip(std::overflow_error("overflow_error"));
+    round_trip(std::range_error("range_error"));
+    round_trip(std::underflow_error("underflow_error"));
+    round_trip(std::ios_base::failure("ios_base::failure"));
+}
+
+static void round_trip_boost()
+{
+    round_trip(boost::bad_any_cast());
+    round_trip(boost::bad_function_call());
+    round_trip(boost::bad_weak_ptr());
+    round_trip(boost::invalid_thread_argument());
+    round_trip(boost::lock_error());
+    round_trip(boost::thread_permission_error());
+    round_trip(boost::thread_resource_error());
+    round_trip(boost::unsupported_thread_option());
+    round_trip(boost::io::format_error());
+    round_trip(boost::io::bad_format_string(3, 10));
+    round_trip(boost::io::too_few_args(1, 2));
+    round_trip(boost::io::too_many_args(3, 2));
+    round_trip(boost::io::out_of_range(5, 1, 3));
+}
+
+static void round_trip_b()
+{
+    FSRef   src, dst;
+    AEDesc  nullDesc    = { typeNull, NULL };
+    
+    memset(&src, 1, sizeof(src));
+    memset(&dst, 2, sizeof(dst));
+    
+    round_trip(B::IOException());
+    round_trip(B::FileNotFoundException());
+    round_trip(B::OpenException());
+    round_trip(B::EOFException());
+    round_trip(B::ReadException());
+    round_trip(B::WriteException());
+    round_trip(B::RuntimeOSStatusException(paramErr));
+    round_trip(B::RethrownException(fnfErr, CFSTR("RethrownException")));
+    round_trip(B::PropertyListCreateException(CFSTR("PropertyListCreateException")));
+    round_trip(B::MalformedUrlException());
+    round_trip(B::UnsupportedUrlSchemeException());
+    round_trip(B::CharacterEncodingException());
+    round_trip(B::InteractionTimeoutException());
+    round_trip(B::FSExchangeObjectsException(diffVolErr, src, dst));
+    round_trip(B::UserCanceledException());
+    round_trip(B::AENoSuchObjectException());
+    round_trip(B::AECantHandleClassException());
+    round_trip(B::AENotModifiableException());
+    round_trip(B::AEBadKeyFormException());
+    round_trip(B::AECantPutThatThereException());
+    round_trip(B::AEWrongDataTypeException());
+    round_trip(B::AECoercionFailException());
+    round_trip(B::AEEventNotHandledException());
+    round_trip(B::AEEventFailedException());
+    round_trip(B::AENoUserInteractionException());
+    round_trip(B::AEClassHasNoElementsOfThisTypeException());
+    round_trip(B::AEUnrecognisedOperatorException());
+    round_trip(B::AEDirectObjectRequiredException());
+    round_trip(B::AEDirectObjectNotAllowedException());
+    round_trip(B::AECantRelateObjectsException());
+    round_trip(B::AEBoundaryMustBeObjectException());
+    round_trip(B::ErrnoException(ENOENT));
+    round_trip(B::AglException(AGL_BAD_ATTRIBUTE));
+    round_trip(B::AEObjectSupport::ObjectResolutionException(errAENoSuchObject, nullDesc));
+}
+
+static void check_bad_alloc()
+{
+    // ExceptionStreamer deliberately writes nothing for std::bad_alloc, since it would 
+    // have to allocate memory to do so.
+    
+    std::string data;
+    
+    B::ExceptionStreamer::Get()->Externalize(std::bad_alloc(), data);
+    bench_check(data.empty(), "std::bad_alloc isn't externalised");
+}
+
+static void check_malformed()
+{
+    // A binary header promising more payload than there is, a bare magic number, an 
+    // empty buffer, and an unterminated XML document.  Rethrow() may throw whatever it 
+    // likes, or return, as long as it doesn't read past the end of the data.
+    
+    const char* const   inputs[]    = { "BExB\0\0\0\0\0\0\0\x10" "abc", "BExB", "", "<?xml" };
+    const size_t        sizes[]     = { 15, 4, 0, 5 };
+    
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        try
+        {
+            B::ExceptionStreamer::Get()->Rethrow(inputs[i], sizes[i]);
+        }
+        catch (...)
+        {
+        }
+    }
+}
+
+static void text_round_trip(void* arg)
+{
+    const std::exception&   ex  = *static_cast<const std::exception*>(arg);
+    
+    for (int i = 0; i < kRuns; i++)
+    {
+        std::ostringstream  ostr;
+        
+        B::ExceptionStreamer::Get()->Externalize(ex, ostr);
+        
+        std::string data(ostr.str());
+        
+        try
+        {
+            B::ExceptionStreamer::Get()->Rethrow(data.data(), data.size());
+        }
+        catch (const std::exception& caught)
+        {
+            bench_sink += strlen(caught.what());
+        }
+    }
+}
+
+static void binary_round_trip(void* arg)
+{
+    const std::exception&   ex  = *static_cast<const std::exception*>(arg);
+    
+    for (int i = 0; i < kRuns; i++)
+    {
+        std::string data;
+        
+        B::ExceptionStreamer::Get()->Externalize(ex, data);
+        
+        try
+        {
+            B::ExceptionStreamer::Get()->Rethrow(data.data(), data.size());
+        }
+        catch (const std::exception& caught)
+        {
+            bench_sink += strlen(caught.what());
+        }
+    }
+}
+
+int main()
+{
+    round_trip_std();
+    round_trip_boost();
+    round_trip_b();
+    check_bad_alloc();
+    check_malformed();
+    
+    printf("%u exception classes round-tripped\n", s_classes);
+    
+    std::runtime_error          runtime("Couldn't open the file because it is locked");
+    B::RuntimeOSStatusException status(fnfErr);
+    
+    double  slow    = bench_run("runtime_error, text", text_round_trip, &runtime, kRuns);
+    double  fast    = bench_run("runtime_error, binary", binary_round_trip, &runtime, kRuns);
+    
+    bench_ratio("binary speedup, runtime_error", slow, fast);
+    
+    slow    = bench_run("RuntimeOSStatusException, text", text_round_trip, &status, kRuns);
+    fast    = bench_run("RuntimeOSStatusException, binary", binary_round_trip, &status, kRuns);
+    
+    bench_ratio("binary speedup, RuntimeOSStatusException", slow, fast);
+    
+    return bench_finish();
+}
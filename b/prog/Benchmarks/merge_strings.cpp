@@ -0,0 +1,264 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Measures the MergeStrings tool's throughput on synthetic tables:  one 5000-key 
+// Localizable.strings merged into 200 localisations, each of which lacks some of the 
+// keys and has some obsolete ones, first with one MergeStrings invocation per 
+// localisation, then with one "MergeStrings -m" run, with one job and with one job per 
+// processor.  Checks that all three produce the same files, and that with -m, a file 
+// that can't be merged is reported (with a non-zero exit status) without stopping the 
+// others or leaving temporary files behind.
+//
+// The tool is found through the MERGESTRINGS environment variable, or else where its 
+// makefile builds it.  This program doesn't need the Mac OS X frameworks itself.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+
+enum    { kKeys = 5000, kFiles = 200 };
+
+static std::string  s_tool;
+static std::string  s_dir;
+
+// Writes str (which is ASCII) as UTF-16 in the host's byte order, with a BOM.
+static void write_utf16(const std::string& path, const std::string& str)
+{
+    std::vector<unsigned short> chars(1, 0xFEFF);
+    
+    chars.insert(chars.end(), str.begin(), str.end());
+    
+    FILE*   file    = fopen(path.c_str(), "wb");
+    
+    fwrite(&chars[0], sizeof(chars[0]), chars.size(), file);
+    fclose(file);
+}
+
+static std::string read_file(const std::string& path)
+{
+    std::string str;
+    FILE*       file    = fopen(path.c_str(), "rb");
+    char        buf[4096];
+    size_t      n;
+    
+    if (file == NULL)
+        return str;
+    
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+        str.append(buf, n);
+    
+    fclose(file);
+    
+    return str;
+}
+
+static std::string entry(int key, const char* value)
+{
+    char    buf[128];
+    
+    snprintf(buf, sizeof(buf), "/* Comment for key %d */\n\"key.%d\" = \"%s %d\";\n\n", 
+             key, key, value, key);
+    
+    return buf;
+}
+
+static std::string localised_path(int i)
+{
+    char    buf[32];
+    
+    snprintf(buf, sizeof(buf), "/loc%03d.strings", i);
+    
+    return s_dir + buf;
+}
+
+// Every localisation lacks a different tenth of the keys, and has 50 obsolete ones.
+static void make_localised_files()
+{
+    for (int i = 0; i < kFiles; i++)
+    {
+        std::string str;
+        
+        for (int key = 0; key < kKeys; key++)
+        {
+            if ((key + i) % 10 != 0)
+                str += entry(key, "Translated value");
+        }
+        
+        for (int key = kKeys; key < kKeys + 50; key++)
+            str += entry(key, "Obsolete value");
+        
+        write_utf16(localised_path(i), str);
+    }
+}
+
+static int run_tool(const std::string& args)
+{
+    std::string command = "'" + s_tool + "' " + args + " > /dev/null 2>&1";
+    int         status  = system(command.c_str());
+    
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static std::string all_paths()
+{
+    std::string paths;
+    
+    for (int i = 0; i < kFiles; i++)
+        paths += " '" + localised_path(i) + "'";
+    
+    return paths;
+}
+
+static void read_results(std::vector<std::string>& results)
+{
+    results.clear();
+    
+    for (int i = 0; i < kFiles; i++)
+        results.push_back(read_file(localised_path(i)));
+}
+
+static double time_separate(int& failures)
+{
+    double  start   = bench_now();
+    
+    for (int i = 0; i < kFiles; i++)
+    {
+        if (run_tool("'" + s_dir + "/ascii.strings' '" + localised_path(i) + "'") != 0)
+            failures++;
+    }
+    
+    return bench_now() - start;
+}
+
+static double time_many(const char* jobs, int& failures)
+{
+    double  start   = bench_now();
+    
+    if (run_tool(std::string("-m ") + jobs + " '" + s_dir + "/ascii.strings'" + all_paths()) != 0)
+        failures++;
+    
+    return bench_now() - start;
+}
+
+static void report(const char* name, double seconds)
+{
+    printf("%-48s %12.2f ms/file\n", name, seconds * 1000 / kFiles);
+}
+
+static bool has_temp_files()
+{
+    DIR*            dir     = opendir(s_dir.c_str());
+    struct dirent*  ent;
+    bool            found   = false;
+    
+    while ((dir != NULL) && ((ent = readdir(dir)) != NULL))
+    {
+        if (strstr(ent->d_name, ".strings.") != NULL)
+            found = true;
+    }
+    
+    if (dir != NULL)
+        closedir(dir);
+    
+    return found;
+}
+
+static void check_errors()
+{
+    std::string bad     = s_dir + "/missing.strings";
+    std::string first   = localised_path(0);
+    std::string last    = localised_path(kFiles - 1);
+    
+    make_localised_files();
+    
+    std::string before  = read_file(last);
+    int         status  = run_tool("-m -j 2 '" + s_dir + "/ascii.strings' '" + first + 
+                                   "' '" + bad + "' '" + last + "'");
+    
+    bench_check(status == 2, "-m exits with the failed file's status");
+    bench_check(read_file(last) != before, "-m merges the files after a failed one");
+    bench_check(!has_temp_files(), "no temporary files are left behind");
+}
+
+int main()
+{
+    const char* tool    = getenv("MERGESTRINGS");
+    char        dir[]   = "/tmp/b_merge_strings_XXXXXX";
+    
+    s_tool = (tool != NULL) ? tool : "../MergeStrings/build/make/MergeStrings";
+    
+    if (mkdtemp(dir) == NULL)
+    {
+        bench_check(false, "temporary directory was created");
+        return bench_finish();
+    }
+    
+    s_dir = dir;
+    
+    std::string ascii;
+    
+    for (int key = 0; key < kKeys; key++)
+        ascii += entry(key, "Value");
+    
+    write_utf16(s_dir + "/ascii.strings", ascii);
+    
+    std::vector<std::string>    separate, many, parallel;
+    int                         failures    = 0;
+    
+    make_localised_files();
+    
+    std::string original    = read_file(localised_path(0));
+    double      slow        = time_separate(failures);
+    
+    read_results(separate);
+    
+    make_localised_files();
+    
+    double      fast        = time_many("-j 1", failures);
+    
+    read_results(many);
+    make_localised_files();
+    
+    double      jobs        = time_many("", failures);
+    
+    read_results(parallel);
+    
+    bench_check(failures == 0, "MergeStrings ran successfully");
+    bench_check(separate[0] != original, "MergeStrings rewrote the localised files");
+    bench_check(many == separate, "-m -j 1 writes the same files as separate runs");
+    bench_check(parallel == separate, "-m writes the same files as separate runs");
+    
+    report("one MergeStrings per file", slow);
+    report("MergeStrings -m -j 1", fast);
+    report("MergeStrings -m", jobs);
+    bench_ratio("-m -j 1 speedup", slow, fast);
+    bench_ratio("-m speedup", slow, jobs);
+    
+    check_errors();
+    
+    system((std::string("rm -rf '") + s_dir + "'").c_str());
+    
+    return bench_finish();
+}
@@ -0,0 +1,387 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Tests B::Preferences' write-behind table against an in-memory store:  repeated writes 
+// are coalesced and read back before they reach the store, the flusher thread hands 
+// them over within B_PREFERENCES_WRITE_BEHIND_DELAY, Flush() and FlushAll() are 
+// synchronous, the single-source functions see pending values, replacing the store 
+// while it is being synchronised is safe, and values still pending at exit are written 
+// out.  Then measures setting a value and reading back a pending one.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <map>
+
+#include <unistd.h>
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "BPreferences.h"
+
+#include "bench.h"
+
+enum    { kWrites = 10000 };
+
+static const char*  kAppID      = "com.example.b.preferences-test";
+static const char*  kOtherAppID = "com.example.b.preferences-test.other";
+
+static bool s_destroyed_while_syncing   = false;
+
+static void sleep_ms(unsigned ms)
+{
+    usleep(ms * 1000);
+}
+
+// ------------------------------------------------------------------------------------------
+//  MemoryStore
+
+// Stands in for CFPreferences.  Only numbers are stored;  Synchronize() is slow, and 
+// copies the values to mSynced, and to a file if one was given, the way 
+// CFPreferencesAppSynchronize() would write them to disk.
+class MemoryStore : public B::Preferences::Store
+{
+public:
+    
+    typedef std::map<std::string, long> ValueMap;
+    
+    explicit MemoryStore(const char* path = NULL)
+        : mPath(path != NULL ? path : ""), mSets(0), mSyncs(0), mSyncing(false) {}
+    ~MemoryStore()
+    {
+        if (mSyncing)
+            s_destroyed_while_syncing = true;
+    }
+    
+    virtual B::OSPtr<CFTypeRef> CopyValue(CFStringRef key, CFStringRef)
+    {
+        boost::mutex::scoped_lock   lock(mMutex);
+        ValueMap::const_iterator    it  = mValues.find(to_string(key));
+        
+        if (it == mValues.end())
+            return (B::OSPtr<CFTypeRef>());
+        
+        return (B::OSPtr<CFTypeRef>(CFNumberCreate(NULL, kCFNumberLongType, &it->second), 
+                                    B::from_copy));
+    }
+    
+    virtual void SetValues(CFDictionaryRef keysToSet, CFArrayRef keysToRemove, CFStringRef)
+    {
+        boost::mutex::scoped_lock   lock(mMutex);
+        CFIndex                     count   = CFDictionaryGetCount(keysToSet);
+        std::vector<const void*>    keys(count + 1), values(count + 1);
+        
+        CFDictionaryGetKeysAndValues(keysToSet, &keys[0], &values[0]);
+        
+        for (CFIndex i = 0; i < count; i++)
+        {
+            long    value   = 0;
+            
+            CFNumberGetValue(static_cast<CFNumberRef>(values[i]), kCFNumberLongType, &value);
+            mValues[to_string(static_cast<CFStringRef>(keys[i]))] = value;
+        }
+        
+        for (CFIndex i = 0; i < CFArrayGetCount(keysToRemove); i++)
+        {
+            mValues.erase(to_string(static_cast<CFStringRef>(
+                                        CFArrayGetValueAtIndex(keysToRemove, i))));
+        }
+        
+        mSets++;
+    }
+    
+    virtual bool Synchronize(CFStringRef)
+    {
+        ValueMap    values;
+        
+        {
+            boost::mutex::scoped_lock   lock(mMutex);
+            
+            values      = mValues;
+            mSyncing    = true;
+        }
+        
+        sleep_ms(20);
+        
+        if (!mPath.empty())
+        {
+            FILE*   file    = fopen(mPath.c_str(), "w");
+            
+            for (ValueMap::const_iterator it = values.begin(); it != values.end(); ++it)
+                fprintf(file, "%s %ld\n", it->first.c_str(), it->second);
+            
+            fclose(file);
+        }
+        
+        boost::mutex::scoped_lock   lock(mMutex);
+        
+        mSynced     = values;
+        mSyncs++;
+        mSyncing    = false;
+        
+        return (true);
+    }
+    
+    long value(const std::string& key)
+    {
+        boost::mutex::scoped_lock   lock(mMutex);
+        ValueMap::const_iterator    it  = mValues.find(key);
+        
+        return (it != mValues.end() ? it->second : -1);
+    }
+    
+    long synced_value(const std::string& key)
+    {
+        boost::mutex::scoped_lock   lock(mMutex);
+        ValueMap::const_iterator    it  = mSynced.find(key);
+        
+        return (it != mSynced.end() ? it->second : -1);
+    }
+    
+    int sets()      { boost::mutex::scoped_lock lock(mMutex); return (mSets); }
+    int syncs()     { boost::mutex::scoped_lock lock(mMutex); return (mSyncs); }
+    bool syncing()  { boost::mutex::scoped_lock lock(mMutex); return (mSyncing); }
+    
+private:
+    
+    static std::string to_string(CFStringRef str)
+    {
+        char    buf[256];
+        
+        CFStringGetCString(str, buf, sizeof(buf), kCFStringEncodingUTF8);
+        
+        return (buf);
+    }
+    
+    const std::string   mPath;
+    boost::mutex        mMutex;
+    ValueMap            mValues;
+    ValueMap            mSynced;
+    int                 mSets;
+    int                 mSyncs;
+    bool                mSyncing;
+};
+
+static MemoryStore* install_store(const char* path = NULL)
+{
+    MemoryStore*    store   = new MemoryStore(path);
+    
+    B::Preferences::SetStore(std::auto_ptr<B::Preferences::Store>(store));
+    
+    return (store);
+}
+
+// ------------------------------------------------------------------------------------------
+//  Checks
+
+static void check_coalescing()
+{
+    MemoryStore*        store   = install_store();
+    B::Preferences      prefs(kAppID), same(kAppID), other(kOtherAppID);
+    
+    for (long i = 0; i < kWrites; i++)
+        prefs.SetNumber("Frame", i);
+    
+    bench_check(prefs.GetNumber<long>("Frame", -1) == kWrites - 1, "pending value is read back");
+    bench_check(same.GetNumber<long>("Frame", -1) == kWrites - 1, "pending value is shared by an application ID");
+    bench_check(other.GetNumber<long>("Frame", -1) == -1, "pending value isn't shared between application IDs");
+    bench_check(store->sets() == 0, "pending values aren't handed to the store right away");
+    
+    prefs.SetCFType("Frame", NULL);
+    bench_check(prefs.GetCFType("Frame").get() == NULL, "pending removal is read back");
+    
+    B::Preferences::FlushAll();
+    bench_check(store->sets() == 1, "pending values are handed to the store in one call");
+    bench_check(store->value("Frame") == -1, "removal reaches the store");
+}
+
+static void check_deadline()
+{
+    MemoryStore*    store   = install_store();
+    B::Preferences  prefs(kAppID);
+    double          start   = bench_now();
+    
+    prefs.SetNumber("Deadline", 1);
+    
+    while ((store->synced_value("Deadline") != 1) && 
+           (bench_now() - start < B_PREFERENCES_WRITE_BEHIND_DELAY / 1000.0 + 1.0))
+    {
+        sleep_ms(5);
+    }
+    
+    double  elapsed = bench_now() - start;
+    
+    printf("pending value synchronised after %.0f ms (bound %d ms)\n", 
+           elapsed * 1000, B_PREFERENCES_WRITE_BEHIND_DELAY);
+    
+    bench_check(store->synced_value("Deadline") == 1, "flusher thread synchronises pending values");
+    bench_check(elapsed <= B_PREFERENCES_WRITE_BEHIND_DELAY / 1000.0 + 0.1, 
+                "flusher thread meets the deadline");
+}
+
+static void check_flush()
+{
+    MemoryStore*    store   = install_store();
+    B::Preferences  prefs(kAppID), other(kOtherAppID);
+    
+    prefs.SetNumber("Flushed", 42);
+    other.SetNumber("NotFlushed", 43);
+    prefs.Flush();
+    
+    bench_check(store->synced_value("Flushed") == 42, "Flush() synchronises before returning");
+    bench_check(store->value("NotFlushed") == -1, "Flush() leaves other application IDs alone");
+    
+    B::Preferences::FlushAll();
+    bench_check(store->synced_value("NotFlushed") == 43, "FlushAll() synchronises before returning");
+}
+
+static void check_sources()
+{
+    MemoryStore*        store   = install_store();
+    B::Preferences      prefs(kAppID);
+    B::OSPtr<CFTypeRef> value;
+    long                number  = 0;
+    
+    prefs.SetNumber("Source", 1);
+    value = prefs.GetCFTypeFromSource("Source", kCFPreferencesCurrentUser, kCFPreferencesAnyHost);
+    
+    bench_check((value.get() != NULL) && 
+                CFNumberGetValue(static_cast<CFNumberRef>(value.get()), kCFNumberLongType, &number) && 
+                (number == 1), 
+                "GetCFTypeFromSource() sees pending values");
+    
+    prefs.SetCFTypeInSource("Source", B::OSPtr<CFTypeRef>(), kCFPreferencesCurrentUser, kCFPreferencesAnyHost);
+    bench_check(store->value("Source") == 1, "SetCFTypeInSource() hands the pending value over first");
+    
+    prefs.SetNumber("Forced", 2);
+    prefs.IsKeyForced("Forced");
+    bench_check(store->value("Forced") == 2, "IsKeyForced() hands the pending value over first");
+    
+    B::Preferences::FlushAll();
+    bench_check(store->sets() == 2, "nothing is left pending after the single-source calls");
+}
+
+static void flush_prefs(B::Preferences* prefs)
+{
+    prefs->Flush();
+}
+
+static void check_set_store_while_syncing()
+{
+    B::Preferences  prefs(kAppID);
+    
+    for (int i = 0; i < 10; i++)
+    {
+        MemoryStore*    store   = install_store();
+        
+        prefs.SetNumber("Replaced", i);
+        
+        boost::thread   flusher(boost::bind(flush_prefs, &prefs));
+        
+        while (!store->syncing() && (store->syncs() == 0))
+            sleep_ms(1);
+        
+        install_store();
+        flusher.join();
+    }
+    
+    bench_check(!s_destroyed_while_syncing, "SetStore() keeps the old store alive while it is synchronised");
+}
+
+static void check_exit(const char* self)
+{
+    char    path[]  = "/tmp/b_preferences_XXXXXX";
+    int     fd      = mkstemp(path);
+    
+    close(fd);
+    
+    std::string command = std::string(self) + " --exit " + path;
+    int         status  = system(command.c_str());
+    FILE*       file    = fopen(path, "r");
+    char        key[64] = "";
+    long        value   = 0;
+    
+    bench_check((status == 0) && (file != NULL) && 
+                (fscanf(file, "%63s %ld", key, &value) == 2) && 
+                (std::string(key) == "AtExit") && (value == 7), 
+                "pending values are written out at exit");
+    
+    if (file != NULL)
+        fclose(file);
+    
+    unlink(path);
+}
+
+// Run in a child process by check_exit().
+static int set_and_exit(const char* path)
+{
+    install_store(path);
+    
+    B::Preferences  prefs(kAppID);
+    
+    prefs.SetNumber("AtExit", 7);
+    
+    return (0);
+}
+
+// ------------------------------------------------------------------------------------------
+//  Benchmarks
+
+static void set_number(void* arg)
+{
+    B::Preferences* prefs   = static_cast<B::Preferences*>(arg);
+    
+    for (long i = 0; i < kWrites; i++)
+        prefs->SetNumber("Bench", i);
+}
+
+static void get_number(void* arg)
+{
+    B::Preferences* prefs   = static_cast<B::Preferences*>(arg);
+    
+    for (long i = 0; i < kWrites; i++)
+        bench_sink += prefs->GetNumber<long>("Bench", 0);
+}
+
+int main(int argc, char* argv[])
+{
+    if ((argc == 3) && (std::string(argv[1]) == "--exit"))
+        return (set_and_exit(argv[2]));
+    
+    check_coalescing();
+    check_deadline();
+    check_flush();
+    check_sources();
+    check_set_store_while_syncing();
+    check_exit(argv[0]);
+    
+    install_store();
+    
+    B::Preferences  prefs(kAppID);
+    
+    bench_run("SetNumber", set_number, &prefs, kWrites);
+    bench_run("GetNumber, pending", get_number, &prefs, kWrites);
+    
+    B::Preferences::FlushAll();
+    
+    return bench_finish();
+}
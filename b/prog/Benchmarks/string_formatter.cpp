@@ -0,0 +1,98 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Measures B::StringFormatter with a format string that is already in its cache of 
+// parsed formats, with format strings that never repeat, and against boost::format.  
+// Also checks that formatting doesn't add the format strings to the InternedString 
+// table, which never releases its entries.
+
+#include <stdio.h>
+#include <string>
+
+#include <boost/format.hpp>
+
+#include "BInternedString.h"
+#include "BString.h"
+#include "BStringFormatter.h"
+
+#include "bench.h"
+
+static void format_cached(void* arg)
+{
+    const B::String&    format  = *static_cast<const B::String*>(arg);
+    
+    for (int i = 0; i < 100; i++)
+    {
+        B::StringFormatter  formatter(format);
+        
+        formatter % i % "apples" % 3.5;
+        bench_sink += formatter.extract().size();
+    }
+}
+
+static void format_boost(void*)
+{
+    for (int i = 0; i < 100; i++)
+    {
+        boost::format   formatter("%1% %2% cost %3%");
+        
+        formatter % i % "apples" % 3.5;
+        bench_sink += formatter.str().size();
+    }
+}
+
+static void format_unique(void*)
+{
+    static unsigned serial  = 0;
+    
+    for (int i = 0; i < 100; i++)
+    {
+        char    buf[64];
+        
+        snprintf(buf, sizeof(buf), "%%1%% %%2%% cost %%3%% (#%u)", serial++);
+        
+        B::StringFormatter  formatter(B::String(buf));
+        
+        formatter % i % "apples" % 3.5;
+        bench_sink += formatter.extract().size();
+    }
+}
+
+int main()
+{
+    B::String   format("%1% %2% cost %3%");
+    B::String   result  = (B::StringFormatter(format) % 12 % "apples" % 3.5).extract();
+    
+    bench_check(result == B::String("12 apples cost 3.5"), "positional directives are substituted");
+    
+    size_t  interned    = B::InternedString::GetTableSize();
+    
+    format_unique(NULL);
+    format_unique(NULL);
+    
+    bench_check(B::InternedString::GetTableSize() == interned, 
+                "formatting doesn't intern format strings");
+    
+    double  slow    = bench_run("boost::format", format_boost, NULL, 100);
+    double  fast    = bench_run("StringFormatter, cached format", format_cached, &format, 100);
+    
+    bench_run("StringFormatter, unique formats", format_unique, NULL, 100);
+    bench_ratio("StringFormatter speedup over boost::format", slow, fast);
+    
+    return bench_finish();
+}
@@ -0,0 +1,256 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Measures sequential traversal of a B::String with its const_iterator, for strings 
+// whose storage CoreFoundation exposes (read directly) and for strings whose storage it 
+// doesn't (read through the iterator's own window), against one 
+// CFStringGetCharacterAtIndex() call per character and against CFStringInlineBuffer.  
+// Also measures two iterators walking the same string side by side, and reverse 
+// iteration.
+// Also checks that a MutableString's const_iterator sees modifications, and that String 
+// and MutableString widen byte ranges alike (as Latin-1).
+
+#include <stdio.h>
+#include <algorithm>
+#include <numeric>
+#include <string>
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include "BMutableString.h"
+#include "BString.h"
+
+#include "bench.h"
+
+enum    { kLength = 10000 };
+
+static size_t sum_cf(CFStringRef str)
+{
+    CFIndex length  = CFStringGetLength(str);
+    size_t  sum     = 0;
+    
+    for (CFIndex i = 0; i < length; i++)
+        sum += CFStringGetCharacterAtIndex(str, i);
+    
+    return sum;
+}
+
+static size_t sum_inline_buffer(CFStringRef str)
+{
+    CFIndex                 length  = CFStringGetLength(str);
+    CFStringInlineBuffer    buffer;
+    size_t                  sum     = 0;
+    
+    CFStringInitInlineBuffer(str, &buffer, CFRangeMake(0, length));
+    
+    for (CFIndex i = 0; i < length; i++)
+        sum += CFStringGetCharacterFromInlineBuffer(&buffer, i);
+    
+    return sum;
+}
+
+// Combines each character with the next one, the way two-cursor algorithms 
+// (std::equal(), std::search(), std::mismatch()) walk a string.
+static size_t pairs_cf(CFStringRef str)
+{
+    CFIndex length  = CFStringGetLength(str);
+    size_t  sum     = 0;
+    
+    for (CFIndex i = 0; i + 1 < length; i++)
+        sum += CFStringGetCharacterAtIndex(str, i) ^ CFStringGetCharacterAtIndex(str, i + 1);
+    
+    return sum;
+}
+
+template <class STRING> size_t pairs_iterator(const STRING& str)
+{
+    typename STRING::const_iterator first   = str.begin();
+    typename STRING::const_iterator second  = str.begin() + 1;
+    typename STRING::const_iterator end     = str.end();
+    size_t                          sum     = 0;
+    
+    for ( ; second != end; ++first, ++second)
+        sum += *first ^ *second;
+    
+    return sum;
+}
+
+template <class STRING> size_t sum_iterator(const STRING& str)
+{
+    return std::accumulate(str.begin(), str.end(), size_t(0));
+}
+
+template <class STRING> size_t sum_postfix(const STRING& str)
+{
+    typename STRING::const_iterator it  = str.begin();
+    typename STRING::const_iterator end = str.end();
+    size_t                          sum = 0;
+    
+    while (it != end)
+        sum += *it++;
+    
+    return sum;
+}
+
+static void time_cf(void* arg)
+{
+    bench_sink += sum_cf(static_cast<const B::String*>(arg)->cf_ref());
+}
+
+static void time_inline_buffer(void* arg)
+{
+    bench_sink += sum_inline_buffer(static_cast<const B::String*>(arg)->cf_ref());
+}
+
+static void time_iterator(void* arg)
+{
+    bench_sink += sum_iterator(*static_cast<const B::String*>(arg));
+}
+
+static void time_postfix(void* arg)
+{
+    bench_sink += sum_postfix(*static_cast<const B::String*>(arg));
+}
+
+static void time_pairs_cf(void* arg)
+{
+    bench_sink += pairs_cf(static_cast<const B::String*>(arg)->cf_ref());
+}
+
+static void time_pairs_iterator(void* arg)
+{
+    bench_sink += pairs_iterator(*static_cast<const B::String*>(arg));
+}
+
+static void time_reverse(void* arg)
+{
+    const B::String*    str = static_cast<const B::String*>(arg);
+    
+    bench_sink += std::accumulate(str->rbegin(), str->rend(), size_t(0));
+}
+
+static void time_mutable(void* arg)
+{
+    bench_sink += sum_iterator(*static_cast<const B::MutableString*>(arg));
+}
+
+static void run(const char* label, const B::String& str)
+{
+    char    name[80];
+    size_t  expected    = sum_cf(str.cf_ref());
+    
+    printf("-- %s (storage %s)\n", label, 
+           (CFStringGetCharactersPtr(str.cf_ref()) != NULL) ? "exposed" : "not exposed");
+    
+    bench_check(sum_iterator(str) == expected, "accumulate over const_iterator");
+    bench_check(sum_postfix(str) == expected, "*it++ over const_iterator");
+    bench_check(sum_inline_buffer(str.cf_ref()) == expected, "CFStringInlineBuffer");
+    bench_check(std::accumulate(str.rbegin(), str.rend(), size_t(0)) == expected, 
+                "accumulate over const_reverse_iterator");
+    bench_check(pairs_iterator(str) == pairs_cf(str.cf_ref()), "two cursors over const_iterator");
+    bench_check(std::equal(str.begin(), str.end(), str.begin()), "std::equal over const_iterator");
+    
+    double  slow    = bench_run("CFStringGetCharacterAtIndex", time_cf, (void*) &str, kLength);
+    
+    bench_run("CFStringInlineBuffer", time_inline_buffer, (void*) &str, kLength);
+    
+    double  fast    = bench_run("String::const_iterator, accumulate", time_iterator, 
+                                (void*) &str, kLength);
+    
+    bench_run("String::const_iterator, *it++", time_postfix, (void*) &str, kLength);
+    
+    snprintf(name, sizeof(name), "const_iterator speedup, %s", label);
+    bench_ratio(name, slow, fast);
+    
+    bench_run("String::const_reverse_iterator, accumulate", time_reverse, (void*) &str, kLength);
+    
+    slow    = bench_run("CFStringGetCharacterAtIndex, two cursors", time_pairs_cf, 
+                        (void*) &str, kLength);
+    fast    = bench_run("String::const_iterator, two cursors", time_pairs_iterator, 
+                        (void*) &str, kLength);
+    
+    snprintf(name, sizeof(name), "two-cursor speedup, %s", label);
+    bench_ratio(name, slow, fast);
+}
+
+static void check_mutable()
+{
+    B::MutableString                    str(B::String("abcdef"));
+    B::MutableString::const_iterator    it  = static_cast<const B::MutableString&>(str).begin();
+    
+    bench_check(it[3] == 'd', "MutableString const_iterator reads");
+    
+    str[3] = 'X';
+    
+    bench_check(it[3] == 'X', "MutableString const_iterator sees modifications");
+}
+
+static void check_byte_ranges()
+{
+    const char          bytes[] = "caf\xE9 \xFF";
+    const char*         end     = bytes + sizeof(bytes) - 1;
+    std::string         std_str(bytes, end);
+    B::String           str(bytes, end);
+    B::MutableString    from_ptrs(bytes, end);
+    B::MutableString    from_iters(std_str.begin(), std_str.end());
+    B::MutableString    appended;
+    
+    appended.append(std_str.begin(), std_str.end());
+    
+    bench_check((str[3] == 0x00E9) && (str[5] == 0x00FF), "String widens bytes as Latin-1");
+    bench_check(CFEqual(from_ptrs.cf_ref(), str.cf_ref()), 
+                "MutableString(const char*, const char*) matches String");
+    bench_check(CFEqual(from_iters.cf_ref(), str.cf_ref()), 
+                "MutableString(std::string iterators) matches String");
+    bench_check(CFEqual(appended.cf_ref(), str.cf_ref()), 
+                "MutableString::append(first, last) matches String");
+}
+
+int main()
+{
+    // An ASCII string is usually stored as 8-bit characters, so its UniChars aren't 
+    // exposed;  a string with non-Latin characters is usually stored as UTF-16.
+    
+    char    ascii[kLength];
+    UniChar wide[kLength];
+    
+    for (size_t i = 0; i < kLength; i++)
+    {
+        ascii[i]    = 'a' + (i % 26);
+        wide[i]     = 0x3041 + (i % 80);
+    }
+    
+    B::String   narrow_str(ascii, kCFStringEncodingASCII, kLength);
+    B::String   wide_str(wide, kLength);
+    
+    printf("sizeof(String::const_iterator) = %u\n", (unsigned) sizeof(B::String::const_iterator));
+    
+    run("8-bit", narrow_str);
+    run("UTF-16", wide_str);
+    
+    B::MutableString    mutable_str(narrow_str);
+    
+    bench_check(sum_iterator(mutable_str) == sum_cf(narrow_str.cf_ref()), 
+                "accumulate over MutableString const_iterator");
+    bench_run("MutableString::const_iterator, accumulate", time_mutable, &mutable_str, kLength);
+    
+    check_mutable();
+    check_byte_ranges();
+    
+    return bench_finish();
+}
@@ -0,0 +1,166 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Measures B::StringRope edits against the same edits on a B::MutableString:  typing 
+// (single-character inserts, with the odd backspace) in the middle of a long text, and 
+// cutting and pasting blocks of text.  Then measures a full scan of a rope that has 
+// been through many such edits against one freshly built from the same characters;  
+// since underfull chunks are merged with their neighbours, the two should be close.
+
+#include <stdio.h>
+#include <vector>
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include "BMutableString.h"
+#include "BString.h"
+#include "BStringRope.h"
+
+#include "bench.h"
+
+enum    { kLength = 1000000, kTyped = 1000, kBlocks = 100, kBlockSize = 300 };
+
+static unsigned long    s_seed  = 1;
+
+static size_t random_pos(size_t size)
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    
+    return (size > 0) ? s_seed % size : 0;
+}
+
+template <class STRING> void type(STRING& str)
+{
+    size_t  pos = str.size() / 2;
+    UniChar c   = 'z';
+    
+    for (size_t i = 0; i < kTyped; i++)
+    {
+        str.insert(pos++, &c, 1);
+        
+        if (i % 10 == 9)
+            str.erase(--pos, 1);
+    }
+}
+
+template <class STRING> void cut_and_paste(STRING& str)
+{
+    std::vector<UniChar>    block(kBlockSize, 'q');
+    
+    for (size_t i = 0; i < kBlocks; i++)
+    {
+        str.erase(random_pos(str.size() - kBlockSize), kBlockSize);
+        str.insert(random_pos(str.size()), &block[0], kBlockSize);
+    }
+}
+
+static void time_rope_typing(void* arg)
+{
+    type(*static_cast<B::StringRope*>(arg));
+}
+
+static void time_mutable_typing(void* arg)
+{
+    type(*static_cast<B::MutableString*>(arg));
+}
+
+static void time_rope_paste(void* arg)
+{
+    cut_and_paste(*static_cast<B::StringRope*>(arg));
+}
+
+static void time_mutable_paste(void* arg)
+{
+    cut_and_paste(*static_cast<B::MutableString*>(arg));
+}
+
+static void time_scan(void* arg)
+{
+    bench_sink += static_cast<const B::StringRope*>(arg)->find(UniChar('#'));
+}
+
+static bool same(const B::StringRope& rope, const B::MutableString& str)
+{
+    std::vector<UniChar>    chars(rope.size());
+    
+    if (rope.size() != str.size())
+        return (false);
+    
+    rope.copy(&chars[0], chars.size());
+    
+    for (size_t i = 0; i < chars.size(); i++)
+    {
+        if (chars[i] != str[i])
+            return (false);
+    }
+    
+    return (true);
+}
+
+int main()
+{
+    std::vector<UniChar>    text(kLength);
+    
+    for (size_t i = 0; i < kLength; i++)
+        text[i] = "abcdefgh "[i % 9];
+    
+    B::StringRope       rope(&text[0], kLength);
+    B::MutableString    str(B::String(&text[0], kLength));
+    
+    // Apply the same edits to both, and check they agree.
+    
+    unsigned long   seed    = s_seed;
+    
+    type(rope);
+    cut_and_paste(rope);
+    s_seed = seed;
+    type(str);
+    cut_and_paste(str);
+    
+    bench_check(same(rope, str), "rope and MutableString agree after edits");
+    
+    double  slow    = bench_run("MutableString, typing", time_mutable_typing, &str, kTyped);
+    double  fast    = bench_run("StringRope, typing", time_rope_typing, &rope, kTyped);
+    
+    bench_ratio("StringRope speedup, typing", slow, fast);
+    
+    slow    = bench_run("MutableString, cut and paste", time_mutable_paste, &str, kBlocks);
+    fast    = bench_run("StringRope, cut and paste", time_rope_paste, &rope, kBlocks);
+    
+    bench_ratio("StringRope speedup, cut and paste", slow, fast);
+    
+    // Every timed call above edited the rope further.  Compare scanning it with scanning 
+    // a copy built afresh from its characters, whose chunks are all full.
+    
+    std::vector<UniChar>    chars(rope.size());
+    
+    rope.copy(&chars[0], chars.size());
+    
+    B::StringRope   fresh(&chars[0], chars.size());
+    
+    bench_check(rope.find(UniChar('#')) == B::StringRope::npos, "scan of edited rope");
+    
+    slow    = bench_run("StringRope scan, after edits", time_scan, &rope, rope.size());
+    fast    = bench_run("StringRope scan, freshly built", time_scan, &fresh, fresh.size());
+    
+    bench_ratio("scan slowdown after edits", slow, fast);
+    
+    return bench_finish();
+}
@@ -0,0 +1,288 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Tests B::TaskQueue, and measures the cost of posting and draining tasks against a 
+// mutex-protected std::deque, single-threaded and with several producer threads.
+//
+// This program doesn't need the Mac OS X frameworks.
+
+#include <stdio.h>
+#include <deque>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <boost/bind.hpp>
+
+#include "BTaskQueue.h"
+
+#include "bench.h"
+
+enum    { kProducers = 4, kTasksPerProducer = 100000 };
+
+static void count_task(size_t* counter)
+{
+    ++*counter;
+}
+
+// Checks that tasks from one producer run in the order they were posted.
+struct sequence
+{
+    size_t  next;
+    bool    in_order;
+};
+
+static void sequence_task(sequence* seq, size_t n)
+{
+    if (n != seq->next)
+        seq->in_order = false;
+    
+    seq->next = n + 1;
+}
+
+// ------------------------------------------------------------------------------------------
+//  Checks
+
+static void check_fifo()
+{
+    B::TaskQueue    queue;
+    sequence        seq = { 0, true };
+    
+    for (size_t i = 0; i < 1000; i++)
+        queue.Post(boost::bind(sequence_task, &seq, i));
+    
+    bench_check(queue.size() == 1000, "size() counts posted tasks");
+    bench_check(queue.Drain(10) == 10, "Drain(n) runs at most n tasks");
+    bench_check(queue.Drain() == 990, "Drain() runs the remaining tasks");
+    bench_check(seq.in_order && (seq.next == 1000), "tasks run in FIFO order");
+    bench_check(queue.empty(), "queue is empty after Drain()");
+}
+
+static void check_capacity()
+{
+    B::TaskQueue    queue(10);
+    size_t          counter = 0;
+    bool            was_empty;
+    
+    bench_check(queue.Post(boost::bind(count_task, &counter), was_empty) && was_empty, 
+                "first Post() reports an empty queue");
+    
+    for (int i = 1; i < 10; i++)
+        queue.Post(boost::bind(count_task, &counter));
+    
+    bench_check(!queue.Post(boost::bind(count_task, &counter)), 
+                "Post() fails when the queue is full");
+    
+    queue.Drain();
+    
+    B::TaskQueue::Statistics    stats   = queue.GetStatistics();
+    
+    bench_check(counter == 10, "accepted tasks run");
+    bench_check((stats.mPostedCount == 10) && (stats.mExecutedCount == 10) && 
+                (stats.mRejectedCount == 1), "statistics count posted, run and rejected tasks");
+    bench_check(stats.mMaxDepth == 10, "statistics record the maximum depth");
+}
+
+struct producer_args
+{
+    B::TaskQueue*   queue;
+    sequence*       seq;
+};
+
+static void* producer(void* arg)
+{
+    producer_args*  args    = static_cast<producer_args*>(arg);
+    
+    for (size_t i = 0; i < kTasksPerProducer; i++)
+        args->queue->Post(boost::bind(sequence_task, args->seq, i));
+    
+    return NULL;
+}
+
+// Runs kProducers threads against the calling thread as consumer.  Returns the time taken.
+static double run_producers(B::TaskQueue& queue, sequence* seqs)
+{
+    pthread_t       threads[kProducers];
+    producer_args   args[kProducers];
+    double          start   = bench_now();
+    size_t          total   = 0;
+    
+    for (int i = 0; i < kProducers; i++)
+    {
+        seqs[i].next        = 0;
+        seqs[i].in_order    = true;
+        args[i].queue       = &queue;
+        args[i].seq         = &seqs[i];
+        pthread_create(&threads[i], NULL, producer, &args[i]);
+    }
+    
+    while (total < kProducers * kTasksPerProducer)
+    {
+        size_t  n   = queue.Drain();
+        
+        if (n == 0)
+            sched_yield();
+        
+        total += n;
+    }
+    
+    for (int i = 0; i < kProducers; i++)
+        pthread_join(threads[i], NULL);
+    
+    return (bench_now() - start);
+}
+
+static void check_producers()
+{
+    B::TaskQueue    queue;
+    sequence        seqs[kProducers];
+    bool            ok      = true;
+    
+    run_producers(queue, seqs);
+    
+    for (int i = 0; i < kProducers; i++)
+        ok = ok && seqs[i].in_order && (seqs[i].next == kTasksPerProducer);
+    
+    bench_check(ok, "every producer's tasks run once, in order");
+    bench_check(queue.empty() && (queue.Drain() == 0), "queue is empty after producers finish");
+}
+
+// ------------------------------------------------------------------------------------------
+//  Baseline:  a mutex-protected std::deque.
+
+class locked_queue
+{
+public:
+    locked_queue()  { pthread_mutex_init(&mutex, NULL); }
+    ~locked_queue() { pthread_mutex_destroy(&mutex); }
+    
+    void    post(const B::TaskQueue::Task& task)
+    {
+        pthread_mutex_lock(&mutex);
+        tasks.push_back(task);
+        pthread_mutex_unlock(&mutex);
+    }
+    
+    size_t  drain()
+    {
+        std::deque<B::TaskQueue::Task>  batch;
+        
+        pthread_mutex_lock(&mutex);
+        batch.swap(tasks);
+        pthread_mutex_unlock(&mutex);
+        
+        for (size_t i = 0; i < batch.size(); i++)
+            batch[i]();
+        
+        return batch.size();
+    }
+    
+private:
+    pthread_mutex_t                 mutex;
+    std::deque<B::TaskQueue::Task>  tasks;
+};
+
+// ------------------------------------------------------------------------------------------
+//  Timings
+
+static void post_drain_task_queue(void* arg)
+{
+    B::TaskQueue*   queue   = static_cast<B::TaskQueue*>(arg);
+    size_t          counter = 0;
+    
+    for (int i = 0; i < 1000; i++)
+        queue->Post(boost::bind(count_task, &counter));
+    
+    queue->Drain();
+    bench_sink += counter;
+}
+
+static void post_drain_locked(void* arg)
+{
+    locked_queue*   queue   = static_cast<locked_queue*>(arg);
+    size_t          counter = 0;
+    
+    for (int i = 0; i < 1000; i++)
+        queue->post(boost::bind(count_task, &counter));
+    
+    queue->drain();
+    bench_sink += counter;
+}
+
+static void* locked_producer(void* arg)
+{
+    locked_queue*   queue   = static_cast<locked_queue*>(arg);
+    size_t          dummy   = 0;
+    
+    for (size_t i = 0; i < kTasksPerProducer; i++)
+        queue->post(boost::bind(count_task, &dummy));
+    
+    return NULL;
+}
+
+static double run_locked_producers(locked_queue& queue)
+{
+    pthread_t   threads[kProducers];
+    double      start   = bench_now();
+    size_t      total   = 0;
+    
+    for (int i = 0; i < kProducers; i++)
+        pthread_create(&threads[i], NULL, locked_producer, &queue);
+    
+    while (total < kProducers * kTasksPerProducer)
+    {
+        size_t  n   = queue.drain();
+        
+        if (n == 0)
+            sched_yield();
+        
+        total += n;
+    }
+    
+    for (int i = 0; i < kProducers; i++)
+        pthread_join(threads[i], NULL);
+    
+    return (bench_now() - start);
+}
+
+int main()
+{
+    check_fifo();
+    check_capacity();
+    check_producers();
+    
+    B::TaskQueue    queue;
+    locked_queue    locked;
+    
+    double  slow    = bench_run("mutex + deque, post & drain", post_drain_locked, &locked, 1000);
+    double  fast    = bench_run("TaskQueue, post & drain", post_drain_task_queue, &queue, 1000);
+    
+    bench_ratio("TaskQueue speedup, 1 thread", slow, fast);
+    
+    sequence    seqs[kProducers];
+    size_t      ops     = kProducers * kTasksPerProducer;
+    
+    slow    = run_locked_producers(locked) / ops;
+    fast    = run_producers(queue, seqs) / ops;
+    
+    printf("%-48s %12.1f ns/op\n", "mutex + deque, 4 producers", slow * 1e9);
+    printf("%-48s %12.1f ns/op\n", "TaskQueue, 4 producers", fast * 1e9);
+    bench_ratio("TaskQueue speedup, 4 producers", slow, fast);
+    
+    return bench_finish();
+}
@@ -0,0 +1,540 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Tests B::Transcoding against straightforward reference implementations, and measures 
+// its conversions against them.
+//
+// The checks cover every Mac OS Roman byte at every alignment, 200000 random UTF-16 
+// strings (with and without unpaired surrogates), random and hand-picked ill-formed 
+// UTF-8, and ASCII detection at every length and position.  The Makefile builds the 
+// program twice:  once as is (using SSE2 where the compiler enables it) and once as 
+// transcoding_scalar, with __SSE2__ undefined, so that both code paths are exercised.
+//
+// This program doesn't need the Mac OS X frameworks.
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "BTranscoding.h"
+
+#include "bench.h"
+
+using namespace B::Transcoding;
+
+typedef std::vector<uint16_t>   utf16;
+
+// ------------------------------------------------------------------------------------------
+//  Random numbers (a fixed-seed xorshift, so that failures are reproducible)
+
+static uint32_t rng_state   = 2463534242u;
+
+static uint32_t rng()
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    
+    return rng_state;
+}
+
+// ------------------------------------------------------------------------------------------
+//  Reference implementations
+
+static bool ref_encode_utf8(const uint16_t* s, size_t n, std::string& out)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t    c   = s[i];
+        
+        if ((c >= 0xD800) && (c <= 0xDBFF))
+        {
+            if ((i + 1 >= n) || (s[i+1] < 0xDC00) || (s[i+1] > 0xDFFF))
+                return false;
+            
+            c = 0x10000 + ((c - 0xD800) << 10) + (s[++i] - 0xDC00);
+        }
+        else if ((c >= 0xDC00) && (c <= 0xDFFF))
+        {
+            return false;
+        }
+        
+        if (c < 0x80)
+        {
+            out += static_cast<char>(c);
+        }
+        else if (c < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (c >> 6));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (c >> 12));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (c >> 18));
+            out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    
+    return true;
+}
+
+static bool ref_decode_utf8(const char* s, size_t n, utf16& out)
+{
+    const unsigned char*    p   = reinterpret_cast<const unsigned char*>(s);
+    
+    for (size_t i = 0; i < n; )
+    {
+        uint32_t    b   = p[i];
+        uint32_t    c, min;
+        size_t      len;
+        
+        if (b < 0x80)       { c = b;        len = 1; min = 0; }
+        else if (b < 0xC0)  { return false; }
+        else if (b < 0xE0)  { c = b & 0x1F; len = 2; min = 0x80; }
+        else if (b < 0xF0)  { c = b & 0x0F; len = 3; min = 0x800; }
+        else if (b < 0xF8)  { c = b & 0x07; len = 4; min = 0x10000; }
+        else                { return false; }
+        
+        if (i + len > n)
+            return false;
+        
+        for (size_t k = 1; k < len; k++)
+        {
+            if ((p[i+k] & 0xC0) != 0x80)
+                return false;
+            
+            c = (c << 6) | (p[i+k] & 0x3F);
+        }
+        
+        if ((c < min) || (c > 0x10FFFF) || ((c >= 0xD800) && (c <= 0xDFFF)))
+            return false;
+        
+        if (c >= 0x10000)
+        {
+            out.push_back(0xD800 + ((c - 0x10000) >> 10));
+            out.push_back(0xDC00 + ((c - 0x10000) & 0x3FF));
+        }
+        else
+        {
+            out.push_back(c);
+        }
+        
+        i += len;
+    }
+    
+    return true;
+}
+
+static size_t ref_count_ascii(const char* s, size_t n)
+{
+    size_t  i   = 0;
+    
+    while ((i < n) && (static_cast<unsigned char>(s[i]) < 0x80))
+        i++;
+    
+    return i;
+}
+
+static size_t ref_count_ascii(const uint16_t* s, size_t n)
+{
+    size_t  i   = 0;
+    
+    while ((i < n) && (s[i] < 0x80))
+        i++;
+    
+    return i;
+}
+
+// ------------------------------------------------------------------------------------------
+//  Checks
+
+static const uint16_t*  ptr(const utf16& v)         { return v.empty() ? NULL : &v[0]; }
+
+// Every byte, alone and at each position of a 40-byte ASCII run, decodes to the same 
+// character, and the 256 characters are distinct and encode back to their byte.
+static void check_mac_roman()
+{
+    uint16_t    table[256];
+    bool        ok  = true;
+    
+    for (int b = 0; b < 256; b++)
+    {
+        char    c   = static_cast<char>(b);
+        utf16   u;
+        
+        DecodeMacRoman(&c, 1, u);
+        ok = ok && (u.size() == 1);
+        table[b] = u.empty() ? 0 : u[0];
+        ok = ok && ((b >= 0x80) || (table[b] == b));
+    }
+    
+    bench_check(ok, "Mac OS Roman: each byte decodes to one character, ASCII unchanged");
+    bench_check((table[0x80] == 0x00C4) && (table[0xA5] == 0x2022) && (table[0xDB] == 0x20AC) && 
+                (table[0xF0] == 0xF8FF) && (table[0xFF] == 0x02C7), 
+                "Mac OS Roman: spot checks against Apple's table");
+    
+    ok = true;
+    
+    for (int a = 0; a < 256; a++)
+        for (int b = a + 1; b < 256; b++)
+            ok = ok && (table[a] != table[b]);
+    
+    bench_check(ok, "Mac OS Roman: the mapping is one-to-one");
+    
+    bool    decoded = true, encoded = true;
+    
+    for (int b = 0; b < 256; b++)
+    {
+        for (size_t pos = 0; pos < 40; pos++)
+        {
+            std::string bytes(40, 'x');
+            utf16       u;
+            std::string back;
+            
+            bytes[pos] = static_cast<char>(b);
+            DecodeMacRoman(bytes.data(), bytes.size(), u);
+            
+            decoded = decoded && (u.size() == 40) && (u[pos] == table[b]);
+            encoded = encoded && EncodeMacRoman(ptr(u), u.size(), back) && (back == bytes);
+        }
+    }
+    
+    bench_check(decoded, "Mac OS Roman: decoding at every alignment");
+    bench_check(encoded, "Mac OS Roman: round trip at every alignment");
+    
+    uint16_t    cjk     = 0x4E00;
+    std::string out;
+    
+    bench_check(!EncodeMacRoman(&cjk, 1, out), "Mac OS Roman: unmappable character is refused");
+}
+
+// Builds a random UTF-16 string, made of runs of ASCII, other BMP characters and 
+// surrogate pairs.  If lone is true, unpaired surrogates may also appear.
+static void random_utf16(utf16& u, bool lone)
+{
+    size_t  runs    = rng() % 8;
+    
+    u.clear();
+    
+    for (size_t r = 0; r < runs; r++)
+    {
+        size_t  len     = rng() % 40;
+        
+        switch (rng() % (lone ? 5 : 4))
+        {
+        case 0:
+        case 1:
+            for (size_t i = 0; i < len; i++)
+                u.push_back(rng() % 0x80);
+            break;
+            
+        case 2:
+            for (size_t i = 0; i < len; i++)
+            {
+                uint16_t    c;
+                
+                do { c = 0x80 + rng() % 0xFF80; } while ((c >= 0xD800) && (c <= 0xDFFF));
+                
+                u.push_back(c);
+            }
+            break;
+            
+        case 3:
+            for (size_t i = 0; i < len; i++)
+            {
+                u.push_back(0xD800 + rng() % 0x400);
+                u.push_back(0xDC00 + rng() % 0x400);
+            }
+            break;
+            
+        case 4:
+            u.push_back(0xD800 + rng() % 0x800);
+            break;
+        }
+    }
+}
+
+static void check_utf16()
+{
+    bool    encode_ok   = true, decode_ok = true, lone_ok = true, ascii_ok = true;
+    
+    for (int i = 0; i < 200000; i++)
+    {
+        utf16       u, back;
+        std::string bytes, ref_bytes;
+        bool        lone    = (i % 4 == 3);
+        
+        random_utf16(u, lone);
+        
+        bool    valid   = ref_encode_utf8(ptr(u), u.size(), ref_bytes);
+        bool    result  = EncodeUtf8(ptr(u), u.size(), bytes);
+        
+        if (!lone)
+        {
+            encode_ok = encode_ok && valid && result && (bytes == ref_bytes);
+            decode_ok = decode_ok && DecodeUtf8(bytes.data(), bytes.size(), back) && (back == u);
+        }
+        else
+        {
+            lone_ok = lone_ok && (result == valid) && (!valid || (bytes == ref_bytes));
+        }
+        
+        std::string ascii;
+        bool        is_ascii    = (ref_count_ascii(ptr(u), u.size()) == u.size());
+        
+        ascii_ok = ascii_ok && (EncodeAscii(ptr(u), u.size(), ascii) == is_ascii);
+    }
+    
+    bench_check(encode_ok, "UTF-8: 150000 random well-formed strings encode as the reference");
+    bench_check(decode_ok, "UTF-8: 150000 random well-formed strings round-trip");
+    bench_check(lone_ok, "UTF-8: 50000 random strings with lone surrogates agree with the reference");
+    bench_check(ascii_ok, "ASCII: 200000 random strings are accepted iff pure ASCII");
+}
+
+static void check_invalid_utf8()
+{
+    static const char* const    kInvalid[] = {
+        "\x80",                 // lone continuation byte
+        "\xBF",
+        "\xC2",                 // truncated sequences
+        "\xE2\x82",
+        "\xF0\x9F\x98",
+        "\xC2" "A",             // missing continuation
+        "\xE2" "A" "\xAC",
+        "\xC0\x80",             // overlong encodings
+        "\xC1\xBF",
+        "\xE0\x80\x80",
+        "\xE0\x9F\xBF",
+        "\xF0\x80\x80\x80",
+        "\xF0\x8F\xBF\xBF",
+        "\xED\xA0\x80",         // encoded surrogates
+        "\xED\xBF\xBF",
+        "\xF4\x90\x80\x80",     // beyond U+10FFFF
+        "\xF5\x80\x80\x80",
+        "\xF8\x88\x80\x80\x80", // five- and six-byte forms
+        "\xFC\x84\x80\x80\x80\x80",
+        "\xFE",
+        "\xFF",
+    };
+    bool    ok  = true;
+    
+    for (size_t i = 0; i < sizeof(kInvalid) / sizeof(kInvalid[0]); i++)
+    {
+        // Each sequence on its own, and after a run of ASCII long enough to go through 
+        // the bulk path.
+        
+        std::string s   = kInvalid[i];
+        std::string t   = std::string(37, 'a') + s + "tail";
+        utf16       u;
+        
+        ok = ok && !DecodeUtf8(s.data(), s.size(), u);
+        ok = ok && !DecodeUtf8(t.data(), t.size(), u);
+    }
+    
+    bench_check(ok, "UTF-8: hand-picked ill-formed sequences are refused");
+    
+    // Random byte strings, biased towards bytes >= 0x80.
+    
+    bool    agree   = true;
+    size_t  valid   = 0;
+    
+    for (int i = 0; i < 200000; i++)
+    {
+        std::string s;
+        size_t      len = rng() % 24;
+        
+        for (size_t k = 0; k < len; k++)
+            s += static_cast<char>((rng() % 3 == 0) ? (rng() % 0x80) : (0x80 + rng() % 0x80));
+        
+        utf16   u, ref;
+        bool    result  = DecodeUtf8(s.data(), s.size(), u);
+        bool    expect  = ref_decode_utf8(s.data(), s.size(), ref);
+        
+        agree = agree && (result == expect) && (!expect || (u == ref));
+        valid += expect;
+    }
+    
+    bench_check(agree, "UTF-8: 200000 random byte strings agree with the reference");
+    bench_check(valid > 0, "UTF-8: some random byte strings are well-formed");
+}
+
+static void check_count_ascii()
+{
+    bool    ok  = true;
+    
+    for (size_t n = 0; n < 100; n++)
+    {
+        for (size_t pos = 0; pos <= n; pos++)
+        {
+            for (size_t offset = 0; offset < 4; offset++)
+            {
+                // offset misaligns the start of the data.
+                
+                std::string bytes(offset + n, 'x');
+                utf16       chars(offset + n, 'x');
+                
+                if (pos < n)
+                {
+                    bytes[offset + pos] = static_cast<char>(0x80 + rng() % 0x80);
+                    chars[offset + pos] = 0x80 + rng() % 0xFF80;
+                }
+                
+                ok = ok && (CountAscii(bytes.data() + offset, n) == pos);
+                ok = ok && (CountAscii(ptr(chars) + offset, n) == pos);
+            }
+        }
+    }
+    
+    bench_check(ok, "CountAscii at every length, position and alignment");
+    
+    // Byte strings with scattered non-ASCII bytes, against the reference.
+    
+    ok = true;
+    
+    for (int i = 0; i < 20000; i++)
+    {
+        std::string bytes(rng() % 200, 'x');
+        
+        for (size_t j = 0; j < bytes.size(); j++)
+            bytes[j] = static_cast<char>((rng() % 64 == 0) ? 0x80 + rng() % 0x80 : rng() % 0x80);
+        
+        ok = ok && (CountAscii(bytes.data(), bytes.size()) == 
+                    ref_count_ascii(bytes.data(), bytes.size()));
+    }
+    
+    bench_check(ok, "CountAscii: 20000 random byte strings agree with the reference");
+}
+
+// ------------------------------------------------------------------------------------------
+//  Timings
+
+struct text
+{
+    utf16       chars;
+    std::string utf8;
+    std::string mac_roman;
+};
+
+static void encode_utf8_ref(void* arg)
+{
+    const text* t   = static_cast<const text*>(arg);
+    std::string out;
+    
+    ref_encode_utf8(ptr(t->chars), t->chars.size(), out);
+    bench_sink += out.size();
+}
+
+static void encode_utf8(void* arg)
+{
+    const text* t   = static_cast<const text*>(arg);
+    std::string out;
+    
+    EncodeUtf8(ptr(t->chars), t->chars.size(), out);
+    bench_sink += out.size();
+}
+
+static void decode_utf8_ref(void* arg)
+{
+    const text* t   = static_cast<const text*>(arg);
+    utf16       out;
+    
+    ref_decode_utf8(t->utf8.data(), t->utf8.size(), out);
+    bench_sink += out.size();
+}
+
+static void decode_utf8(void* arg)
+{
+    const text* t   = static_cast<const text*>(arg);
+    utf16       out;
+    
+    DecodeUtf8(t->utf8.data(), t->utf8.size(), out);
+    bench_sink += out.size();
+}
+
+static void encode_mac_roman(void* arg)
+{
+    const text* t   = static_cast<const text*>(arg);
+    std::string out;
+    
+    EncodeMacRoman(ptr(t->chars), t->chars.size(), out);
+    bench_sink += out.size();
+}
+
+static void decode_mac_roman(void* arg)
+{
+    const text* t   = static_cast<const text*>(arg);
+    utf16       out;
+    
+    DecodeMacRoman(t->mac_roman.data(), t->mac_roman.size(), out);
+    bench_sink += out.size();
+}
+
+// Text that is mostly ASCII, with an accented letter every 64 characters.
+static void make_text(text& t, size_t n)
+{
+    static const char   kWords[]    = "the quick brown fox jumps over the lazy dog ";
+    
+    for (size_t i = 0; i < n; i++)
+        t.chars.push_back((i % 64 == 63) ? 0x00E9 : kWords[i % (sizeof(kWords) - 1)]);
+    
+    ref_encode_utf8(ptr(t.chars), t.chars.size(), t.utf8);
+    EncodeMacRoman(ptr(t.chars), t.chars.size(), t.mac_roman);
+}
+
+int main()
+{
+#if defined(__SSE2__)
+    printf("B::Transcoding built with SSE2\n");
+#else
+    printf("B::Transcoding built without SSE2\n");
+#endif
+    
+    check_mac_roman();
+    check_utf16();
+    check_invalid_utf8();
+    check_count_ascii();
+    
+    text    t;
+    
+    make_text(t, 64 * 1024);
+    
+    size_t  n       = t.chars.size();
+    double  slow, fast;
+    
+    slow = bench_run("reference EncodeUtf8, mostly ASCII", encode_utf8_ref, &t, n);
+    fast = bench_run("EncodeUtf8, mostly ASCII", encode_utf8, &t, n);
+    bench_ratio("EncodeUtf8 speedup", slow, fast);
+    
+    slow = bench_run("reference DecodeUtf8, mostly ASCII", decode_utf8_ref, &t, n);
+    fast = bench_run("DecodeUtf8, mostly ASCII", decode_utf8, &t, n);
+    bench_ratio("DecodeUtf8 speedup", slow, fast);
+    
+    bench_run("EncodeMacRoman, mostly ASCII", encode_mac_roman, &t, n);
+    bench_run("DecodeMacRoman, mostly ASCII", decode_mac_roman, &t, n);
+    
+    return bench_finish();
+}
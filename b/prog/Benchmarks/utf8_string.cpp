@@ -0,0 +1,536 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// Tests B::Utf8String against UTF-16 built by hand from the same code points, and
+// measures random access through its index against walking the UTF-8 from the start.
+//
+// The checks cover sizes, indexing (including both halves of surrogate pairs, and
+// strings long enough to need several index entries), iteration in both directions,
+// find(), substr(), append() and compare(), the switch from inline to heap storage,
+// and the rejection of ill-formed UTF-8 and unpaired surrogates.
+//
+// This program doesn't need the Mac OS X frameworks.
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BUtf8String.h"
+
+#include "bench.h"
+
+using B::Utf8String;
+
+typedef std::vector<uint16_t>   utf16;
+
+// ------------------------------------------------------------------------------------------
+//  Reference strings
+
+// Appends code point cp to both the UTF-8 and the UTF-16 reference.
+static void add(uint32_t cp, std::string& utf8, utf16& u)
+{
+    if (cp < 0x80)
+    {
+        utf8 += static_cast<char>(cp);
+    }
+    else if (cp < 0x800)
+    {
+        utf8 += static_cast<char>(0xC0 | (cp >> 6));
+        utf8 += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        utf8 += static_cast<char>(0xE0 | (cp >> 12));
+        utf8 += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        utf8 += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        utf8 += static_cast<char>(0xF0 | (cp >> 18));
+        utf8 += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        utf8 += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        utf8 += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    
+    if (cp < 0x10000)
+    {
+        u.push_back(static_cast<uint16_t>(cp));
+    }
+    else
+    {
+        u.push_back(static_cast<uint16_t>(0xD800 + ((cp - 0x10000) >> 10)));
+        u.push_back(static_cast<uint16_t>(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+    }
+}
+
+// Builds n code points cycling through ASCII, Latin-1, CJK and astral characters.
+static void make_text(size_t n, std::string& utf8, utf16& u)
+{
+    static const uint32_t   kCodePoints[]   = {
+                                'a', 'b', 0xE9, 'c', 0x4E2D, 0x1F600, 'd', 0x3B1,
+                                0xFFFD, 0x10348, 'e', ' ', 0x20AC, 0x10FFFF
+                            };
+    
+    utf8.clear();
+    u.clear();
+    
+    for (size_t i = 0; i < n; i++)
+        add(kCodePoints[i % (sizeof(kCodePoints) / sizeof(kCodePoints[0]))], utf8, u);
+}
+
+static const uint16_t*  ptr(const utf16& v)         { return v.empty() ? NULL : &v[0]; }
+
+static bool same(const Utf8String& str, const utf16& u)
+{
+    if (str.size() != u.size())
+        return false;
+    
+    for (size_t i = 0; i < u.size(); i++)
+        if (str[i] != u[i])
+            return false;
+    
+    return true;
+}
+
+// Returns the index of the first occurrence of needle in u at or after pos, or npos.
+static size_t ref_find(const utf16& u, const utf16& needle, size_t pos)
+{
+    if (pos > u.size())
+        return Utf8String::npos;
+    
+    utf16::const_iterator   it  = std::search(u.begin() + pos, u.end(),
+                                              needle.begin(), needle.end());
+    
+    if ((it == u.end()) && !needle.empty())
+        return Utf8String::npos;
+    
+    return it - u.begin();
+}
+
+static bool is_low_surrogate(uint16_t c)    { return ((c >= 0xDC00) && (c <= 0xDFFF)); }
+
+// ------------------------------------------------------------------------------------------
+//  Checks
+
+static void check_contents()
+{
+    std::string utf8;
+    utf16       u;
+    
+    for (size_t n = 0; n < 300; n += 7)
+    {
+        make_text(n, utf8, u);
+        
+        Utf8String  from_utf8(utf8);
+        Utf8String  from_utf16(ptr(u), u.size());
+        bool        ok  = true;
+        
+        ok = ok && same(from_utf8, u) && same(from_utf16, u);
+        ok = ok && (from_utf8.byte_size() == utf8.size());
+        ok = ok && (memcmp(from_utf16.data(), utf8.data(), utf8.size()) == 0);
+        ok = ok && (from_utf8 == from_utf16);
+        ok = ok && (from_utf8.is_ascii() == (n < 2));
+        
+        if (!ok)
+        {
+            bench_check(false, "contents match the UTF-16 reference");
+            return;
+        }
+    }
+    
+    bench_check(true, "contents match the UTF-16 reference, up to 300 code points");
+}
+
+static void check_iteration()
+{
+    std::string utf8;
+    utf16       u;
+    
+    make_text(200, utf8, u);
+    
+    Utf8String  str(utf8);
+    utf16       forward(str.begin(), str.end());
+    utf16       backward;
+    
+    for (Utf8String::const_iterator it = str.end(); it != str.begin(); )
+        backward.push_back(*--it);
+    
+    std::reverse(backward.begin(), backward.end());
+    
+    bench_check(forward == u, "const_iterator yields the UTF-16 code units");
+    bench_check(backward == u, "const_iterator yields the UTF-16 code units backwards");
+}
+
+static void check_at()
+{
+    std::string utf8;
+    utf16       u;
+    
+    make_text(500, utf8, u);
+    
+    Utf8String  str(utf8);
+    bool        ok  = true;
+    
+    // Random order, so that the index is used rather than a sequential walk.
+    
+    for (size_t i = 0; i < u.size(); i++)
+    {
+        size_t  pos = (i * 7919) % u.size();
+        
+        ok = ok && (str.at(pos) == u[pos]);
+    }
+    
+    bench_check(ok, "at() matches the reference at every index, surrogates included");
+    
+    bool    thrown  = false;
+    
+    try
+    {
+        str.at(u.size());
+    }
+    catch (const std::out_of_range&)
+    {
+        thrown = true;
+    }
+    
+    bench_check(thrown, "at(size()) throws std::out_of_range");
+}
+
+static void check_find_substr()
+{
+    std::string utf8;
+    utf16       u;
+    
+    make_text(150, utf8, u);
+    
+    Utf8String  str(utf8);
+    bool        substr_ok   = true;
+    bool        find_ok     = true;
+    bool        split_ok    = true;
+    
+    for (size_t pos = 0; pos <= u.size(); pos++)
+    {
+        for (size_t n = 0; (n < 40) && (pos + n <= u.size()); n += 3)
+        {
+            bool    splits  = ((pos < u.size()) && is_low_surrogate(u[pos])) ||
+                              ((pos + n < u.size()) && is_low_surrogate(u[pos + n]));
+            
+            if (splits)
+            {
+                bool    thrown  = false;
+                
+                try
+                {
+                    str.substr(pos, n);
+                }
+                catch (const std::invalid_argument&)
+                {
+                    thrown = true;
+                }
+                
+                split_ok = split_ok && thrown;
+                continue;
+            }
+            
+            utf16       expected(u.begin() + pos, u.begin() + pos + n);
+            Utf8String  sub = str.substr(pos, n);
+            
+            substr_ok = substr_ok && same(sub, expected);
+            
+            for (size_t from = 0; from <= u.size(); from += 37)
+                find_ok = find_ok && (str.find(sub, from) == ref_find(u, expected, from));
+        }
+    }
+    
+    bench_check(substr_ok, "substr() matches the reference");
+    bench_check(split_ok, "substr() refuses to split a surrogate pair");
+    bench_check(find_ok, "find() matches the reference, from any position");
+    
+    bool    thrown  = false;
+    
+    try
+    {
+        str.substr(u.size() + 1);
+    }
+    catch (const std::out_of_range&)
+    {
+        thrown = true;
+    }
+    
+    bench_check(thrown, "substr(size() + 1) throws std::out_of_range");
+}
+
+static void check_append()
+{
+    std::string utf8;
+    utf16       u;
+    
+    Utf8String  str;
+    utf16       expected;
+    bool        ok  = true;
+    
+    // Read the string between appends, so that a stale index would show.
+    
+    for (size_t i = 1; i <= 10; i++)
+    {
+        make_text(i * 5, utf8, u);
+        
+        str += Utf8String(ptr(u), u.size());
+        expected.insert(expected.end(), u.begin(), u.end());
+        
+        ok = ok && same(str, expected);
+    }
+    
+    make_text(100, utf8, u);
+    
+    bench_check(ok, "append() matches the reference, and refreshes the index");
+    
+    Utf8String  bytes("x");
+    
+    bytes.append(utf8.data(), utf8.size());
+    expected.assign(1, 'x');
+    expected.insert(expected.end(), u.begin(), u.end());
+    
+    bench_check(same(bytes, expected), "append() of UTF-8 bytes matches the reference");
+}
+
+static void check_storage()
+{
+    std::string inline_bytes(Utf8String::kInlineCapacity, 'x');
+    Utf8String  small(inline_bytes);
+    Utf8String  large(inline_bytes + "y");
+    Utf8String  grown(small);
+    
+    grown.append("\xC3\xA9", 2);
+    
+    bench_check(small.capacity() == Utf8String::kInlineCapacity, "23 bytes are stored inline");
+    bench_check(large.capacity() > Utf8String::kInlineCapacity, "24 bytes go on the heap");
+    bench_check((grown.byte_size() == 25) && (grown.size() == 24) && (grown[23] == 0xE9) &&
+                (strcmp(grown.c_str(), (inline_bytes + "\xC3\xA9").c_str()) == 0),
+                "appending past the inline capacity keeps the contents");
+    
+    Utf8String  copy(large);
+    
+    copy.swap(small);
+    
+    bench_check((copy.byte_size() == 23) && (small.byte_size() == 24) &&
+                (small.c_str()[23] == 'y'), "swap() exchanges inline and heap strings");
+}
+
+static void check_compare()
+{
+    // In UTF-16, U+10000 (D800 DC00) sorts before U+FFFF;  by code point, it's after.
+    
+    Utf8String  bmp("\xEF\xBF\xBF");
+    Utf8String  astral("\xF0\x90\x80\x80");
+    
+    bench_check((bmp < astral) && !(astral < bmp), "compare() orders by code point");
+    bench_check((Utf8String("abc") != Utf8String("abd")) && (Utf8String("ab") < Utf8String("abc")),
+                "compare() orders by bytes, shorter first");
+}
+
+static void check_invalid()
+{
+    static const char* const    kInvalid[] = {
+        "\x80",                 // lone continuation byte
+        "\xC2",                 // truncated sequences
+        "\xE2\x82",
+        "\xF0\x9F\x98",
+        "\xC2" "A",             // missing continuation
+        "\xC0\x80",             // overlong encodings
+        "\xE0\x80\x80",
+        "\xF0\x80\x80\x80",
+        "\xED\xA0\x80",         // encoded surrogates
+        "\xED\xBF\xBF",
+        "\xF4\x90\x80\x80",     // beyond U+10FFFF
+        "\xF5\x80\x80\x80",
+        "\xFF",
+    };
+    bool    ok  = true;
+    
+    for (size_t i = 0; i < sizeof(kInvalid) / sizeof(kInvalid[0]); i++)
+    {
+        bool    thrown  = false;
+        
+        try
+        {
+            Utf8String  str(std::string("ok") + kInvalid[i]);
+        }
+        catch (const std::invalid_argument&)
+        {
+            thrown = true;
+        }
+        
+        ok = ok && thrown;
+    }
+    
+    bench_check(ok, "ill-formed UTF-8 is rejected");
+    
+    static const uint16_t   kLone[][3]  = {
+        { 0xD800, 0, 0 },       // high surrogate at the end
+        { 0xDC00, 'a', 0 },     // low surrogate first
+        { 'a', 0xD800, 'b' },   // high surrogate followed by a non-surrogate
+        { 0xDBFF, 0xDBFF, 0 },  // two high surrogates
+    };
+    static const size_t     kLoneLength[]   = { 1, 2, 3, 2 };
+    
+    ok = true;
+    
+    for (size_t i = 0; i < sizeof(kLoneLength) / sizeof(kLoneLength[0]); i++)
+    {
+        bool    thrown  = false;
+        
+        try
+        {
+            Utf8String  str(kLone[i], kLoneLength[i]);
+        }
+        catch (const std::invalid_argument&)
+        {
+            thrown = true;
+        }
+        
+        ok = ok && thrown;
+    }
+    
+    bench_check(ok, "unpaired surrogates are rejected");
+    
+    Utf8String  str("abc");
+    bool        thrown  = false;
+    
+    try
+    {
+        str.append("\xC3", 1);
+    }
+    catch (const std::invalid_argument&)
+    {
+        thrown = true;
+    }
+    
+    bench_check(thrown && (str == Utf8String("abc")), "append() of ill-formed UTF-8 is rejected");
+}
+
+// ------------------------------------------------------------------------------------------
+//  Timings
+
+struct text
+{
+    std::string utf8;
+    utf16       u;
+    Utf8String  str;
+};
+
+// Returns the code unit at pos by decoding from the start of the UTF-8.
+static uint16_t walk_at(const std::string& utf8, size_t pos)
+{
+    const unsigned char*    s       = reinterpret_cast<const unsigned char*>(utf8.data());
+    size_t                  unit    = 0;
+    
+    for (;;)
+    {
+        size_t  len     = (s[0] < 0x80) ? 1 : ((s[0] < 0xE0) ? 2 : ((s[0] < 0xF0) ? 3 : 4));
+        size_t  units   = (len == 4) ? 2 : 1;
+        
+        if (unit + units > pos)
+            break;
+        
+        unit    += units;
+        s       += len;
+    }
+    
+    uint32_t    cp;
+    
+    if (s[0] < 0x80)
+        cp = s[0];
+    else if (s[0] < 0xE0)
+        cp = ((s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+    else if (s[0] < 0xF0)
+        cp = ((s[0] & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+    else
+        cp = ((s[0] & 0x07) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+    
+    if (cp < 0x10000)
+        return cp;
+    else if (unit == pos)
+        return 0xD800 + ((cp - 0x10000) >> 10);
+    else
+        return 0xDC00 + ((cp - 0x10000) & 0x3FF);
+}
+
+static void random_walk(void* arg)
+{
+    const text* t   = static_cast<const text*>(arg);
+    size_t      n   = t->u.size();
+    
+    for (size_t i = 0; i < 1000; i++)
+        bench_sink += walk_at(t->utf8, (i * 7919) % n);
+}
+
+static void random_index(void* arg)
+{
+    const text* t   = static_cast<const text*>(arg);
+    size_t      n   = t->u.size();
+    
+    for (size_t i = 0; i < 1000; i++)
+        bench_sink += t->str[(i * 7919) % n];
+}
+
+static void construct_inline(void*)
+{
+    Utf8String  str("identifier");
+    
+    bench_sink += str.size();
+}
+
+static void construct_heap(void*)
+{
+    Utf8String  str("a rather longer identifier");
+    
+    bench_sink += str.size();
+}
+
+int main()
+{
+    check_contents();
+    check_iteration();
+    check_at();
+    check_find_substr();
+    check_append();
+    check_storage();
+    check_compare();
+    check_invalid();
+    
+    text    t;
+    
+    make_text(10000, t.utf8, t.u);
+    t.str = Utf8String(t.utf8);
+    
+    bench_check(walk_at(t.utf8, 4321) == t.u[4321], "the reference walk agrees");
+    
+    double  slow    = bench_run("random access, walking from the start", random_walk, &t, 1000);
+    double  fast    = bench_run("random access, Utf8String index", random_index, &t, 1000);
+    
+    bench_ratio("index speedup", slow, fast);
+    
+    bench_run("construct, 10 bytes (inline)", construct_inline, NULL);
+    bench_run("construct, 26 bytes (heap)", construct_heap, NULL);
+    
+    return bench_finish();
+}
@@ -18,9 +18,11 @@
 
 #include <algorithm>
 #include <iostream>
-#include <map>
+#include <pthread.h>
 #include <stdarg.h>
 #include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 
 #include <CoreFoundation/CFData.h>
@@ -45,14 +47,14 @@ private:
 struct CopyChangedAscii
 {
             CopyChangedAscii(
-                StringsMap& oldAsciiKeys, 
-                StringsMap& englishKeys, 
-                bool&       englishChanged);
+                const StringsMap&   oldAsciiKeys, 
+                StringsMap&         englishKeys, 
+                bool&               englishChanged);
     void    operator () (const StringsMap::value_type& val);
             
 private:
     
-    StringsMap& mOldAsciiKeys;
+    const StringsMap&   mOldAsciiKeys;
     StringsMap& mEnglishKeys;
     bool&       mEnglishChanged;
 };
@@ -86,26 +88,66 @@ private:
 struct RemoveDeletedNewAscii
 {
             RemoveDeletedNewAscii(
-                StringsMap& newAsciiKeys, 
-                StringsMap& englishKeys, 
-                bool&       englishChanged);
+                const StringsMap&   newAsciiKeys, 
+                StringsMap&         englishKeys, 
+                bool&               englishChanged);
     void    operator () (const StringsMap::value_type& val);
             
 private:
     
-    StringsMap& mNewAsciiKeys;
+    const StringsMap&   mNewAsciiKeys;
     StringsMap& mEnglishKeys;
     bool&       mEnglishChanged;
 };
 
-static void read_strings_file(const char* path, StringsMap& stringsMap);
+// Thrown by fatal() while merging one of several files, so that the worker can go on 
+// with the other files, and the main thread can report the error once they're done.
+
+struct MergeError
+{
+    MergeError() : status(0) {}
+    
+    int         status;         // 0 if the file was merged
+    std::string message;
+};
+
+struct MergeJobs
+{
+    const StringsMap*       oldAsciiMap;    // NULL for a 2-way merge
+    const StringsMap*       newAsciiMap;
+    const char**            paths;
+    size_t                  count;
+    size_t                  next;           // protected by mutex
+    pthread_mutex_t         mutex;
+    std::vector<MergeError> errors;         // one per path, written by its worker
+};
+
+struct CompareKeys
+{
+    bool    operator () (const StringsMap::value_type* lhs, const StringsMap::value_type* rhs) const
+            {
+                return (lhs->first < rhs->first);
+            }
+};
+
+static bool merge_strings(
+                const StringsMap*   oldAsciiMap, 
+                const StringsMap&   newAsciiMap, 
+                StringsMap&         englishMap);
+static void merge_strings_file(
+                const StringsMap*   oldAsciiMap, 
+                const StringsMap&   newAsciiMap, 
+                const char*         path);
+static int  merge_many(int argc, const char** argv);
+static void*    merge_worker(void* arg);
 static void write_strings_file(const char* path, const StringsMap& stringsMap);
 void        print_map(std::ostream& ostr, const StringsMap& stringsMap);
 static void status(const char* format, ...);
 static void usage();
 
-bool        verbose     = true;
-const char* progname    = "";
+bool            verbose     = true;
+const char*     progname    = "";
+pthread_key_t   status_file_key;
 
 
 int main(int argc, const char** argv)
@@ -115,71 +157,238 @@ int main(int argc, const char** argv)
     else
         progname = argv[0];
     
+    pthread_key_create(&status_file_key, NULL);
+    
+    if ((argc >= 2) && (strcmp(argv[1], "-m") == 0))
+        return merge_many(argc, argv);
+    
+    if ((argc == 4) && (argv[1][0] == '-'))
+    {
+        // Compiled string table:  -c compiles the .strings file, -v verifies it.
+        
+        StringsMap  stringsMap;
+        
+        if (strcmp(argv[1], "-c") == 0)
+        {
+            read_strings_file(argv[2], stringsMap);
+            write_strings_table(argv[3], stringsMap);
+            status("compiled %lu entries into %s", (unsigned long) stringsMap.size(), argv[3]);
+        }
+        else if (strcmp(argv[1], "-v") == 0)
+        {
+            read_strings_file(argv[2], stringsMap);
+            
+            if (verify_strings_table(argv[3], stringsMap) != 0)
+                fatal(5, "%s doesn't match %s", argv[3], argv[2]);
+        }
+        else
+        {
+            usage();
+        }
+        
+        return 0;
+    }
+    
     if ((argc != 3) && (argc != 4))
         usage();
     
-    StringsMap  englishMap;
-    bool        englishChanged  = false;
+    StringsMap  oldAsciiMap, newAsciiMap;
+    
+    if (argc == 4)
+        read_strings_file(argv[1], oldAsciiMap);
     
-    read_strings_file(argv[argc-1], englishMap);
+    read_strings_file(argv[argc-2], newAsciiMap);
+    
+    merge_strings_file((argc == 4) ? &oldAsciiMap : NULL, newAsciiMap, argv[argc-1]);
+    
+    return 0;
+}
+
+
+// Merges newAsciiMap (and oldAsciiMap, for a 3-way merge) into englishMap.  Returns true 
+// if englishMap changed.  The ascii maps are only read, so they may be shared between 
+// threads.
+
+static bool merge_strings(
+    const StringsMap*   oldAsciiMap, 
+    const StringsMap&   newAsciiMap, 
+    StringsMap&         englishMap)
+{
+    bool    englishChanged  = false;
     
-    if (argc == 3)
+    if (oldAsciiMap == NULL)
     {
         // 2-way merge
         
-        StringsMap  asciiMap;
-        
-        read_strings_file(argv[1], asciiMap);
-        
-        // Remove entries from englishMap that are not in asciiMap.
+        // Remove entries from englishMap that are not in newAsciiMap.
         
         std::vector<std::string>    deletedKeys;
         
         std::for_each(englishMap.begin(), englishMap.end(), 
-                      IdentifyDeletedKeys(asciiMap, deletedKeys));
+                      IdentifyDeletedKeys(newAsciiMap, deletedKeys));
         std::for_each(deletedKeys.begin(), deletedKeys.end(), 
                       RemoveDeletedAscii(englishMap, englishChanged));
         
-        // Add entries that are present in asciiMap but not in the englishMap.
+        // Add entries that are present in newAsciiMap but not in the englishMap.
         
-        std::for_each(asciiMap.begin(), asciiMap.end(), 
+        std::for_each(newAsciiMap.begin(), newAsciiMap.end(), 
                     CopyAscii(englishMap, englishChanged));
     }
     else
     {
         // 3-way merge
         
-        StringsMap  oldAsciiMap, newAsciiMap;
-        
-        read_strings_file(argv[1], oldAsciiMap);
-        read_strings_file(argv[2], newAsciiMap);
-        
         // Remove entries from englishMap that are in oldAsciiMap but not in newAsciiMap.
         
-        std::for_each(oldAsciiMap.begin(), oldAsciiMap.end(), 
+        std::for_each(oldAsciiMap->begin(), oldAsciiMap->end(), 
                     RemoveDeletedNewAscii(newAsciiMap, englishMap, englishChanged));
         
         // Copy entries whose value has changed between oldAsciiMap and newAsciiMap to englishMap.
         
         std::for_each(newAsciiMap.begin(), newAsciiMap.end(), 
-                    CopyChangedAscii(oldAsciiMap, englishMap, englishChanged));
+                    CopyChangedAscii(*oldAsciiMap, englishMap, englishChanged));
     }
     
-    if (englishChanged)
+    return englishChanged;
+}
+
+// Reads, merges and (if it changed) rewrites the localised file at path.
+
+static void merge_strings_file(
+    const StringsMap*   oldAsciiMap, 
+    const StringsMap&   newAsciiMap, 
+    const char*         path)
+{
+    StringsMap  englishMap;
+    
+    read_strings_file(path, englishMap);
+    
+    if (merge_strings(oldAsciiMap, newAsciiMap, englishMap))
     {
-        write_strings_file(argv[argc-1], englishMap);
+        write_strings_file(path, englishMap);
     }
-    
-    return 0;
 }
 
 
-static void read_strings_file(const char* path, StringsMap& stringsMap)
+// Merges one ascii file (or pair of them) into any number of localised files:
+//
+//     MergeStrings -m [-j jobs] [-o old-ascii-file] new-ascii-file localised-file...
+//
+// The ascii tables are read once and shared.  The localised files are handed out to 
+// jobs threads (by default, one per processor), each of which reads, merges and writes 
+// one file at a time, so at most jobs localised tables are in memory at once.
+
+static int merge_many(int argc, const char** argv)
+{
+    const char* oldAsciiPath    = NULL;
+    long        jobs            = sysconf(_SC_NPROCESSORS_ONLN);
+    int         argi            = 2;
+    
+    for ( ; (argi < argc) && (argv[argi][0] == '-'); argi += 2)
+    {
+        if (argi + 1 >= argc)
+            usage();
+        
+        if (strcmp(argv[argi], "-j") == 0)
+            jobs = atol(argv[argi+1]);
+        else if (strcmp(argv[argi], "-o") == 0)
+            oldAsciiPath = argv[argi+1];
+        else
+            usage();
+    }
+    
+    if (argc - argi < 2)
+        usage();
+    
+    StringsMap  oldAsciiMap, newAsciiMap;
+    MergeJobs   mergeJobs;
+    
+    if (oldAsciiPath != NULL)
+        read_strings_file(oldAsciiPath, oldAsciiMap);
+    
+    read_strings_file(argv[argi], newAsciiMap);
+    
+    mergeJobs.oldAsciiMap   = (oldAsciiPath != NULL) ? &oldAsciiMap : NULL;
+    mergeJobs.newAsciiMap   = &newAsciiMap;
+    mergeJobs.paths         = argv + argi + 1;
+    mergeJobs.count         = argc - argi - 1;
+    mergeJobs.next          = 0;
+    mergeJobs.errors.resize(mergeJobs.count);
+    pthread_mutex_init(&mergeJobs.mutex, NULL);
+    
+    jobs = std::max(1L, std::min(jobs, (long) mergeJobs.count));
+    
+    std::vector<pthread_t>  threads(jobs - 1);
+    
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        if (pthread_create(&threads[i], NULL, merge_worker, &mergeJobs) != 0)
+            fatal(6, "Can't create thread");
+    }
+    
+    // The main thread does its share of the work.
+    
+    merge_worker(&mergeJobs);
+    
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    
+    pthread_mutex_destroy(&mergeJobs.mutex);
+    
+    // Report the errors in the order the files were given.  The exit status is that of 
+    // the first file that failed.
+    
+    int exitStatus  = 0;
+    
+    for (size_t i = 0; i < mergeJobs.count; i++)
+    {
+        const MergeError&   error   = mergeJobs.errors[i];
+        
+        if (error.status != 0)
+        {
+            fprintf(stderr, "%s:  %s:  %s\n", progname, mergeJobs.paths[i], error.message.c_str());
+            
+            if (exitStatus == 0)
+                exitStatus = error.status;
+        }
+    }
+    
+    return exitStatus;
+}
+
+static void*    merge_worker(void* arg)
 {
-    InitParser(path, stringsMap);
+    MergeJobs&  mergeJobs   = *static_cast<MergeJobs*>(arg);
+    
+    while (true)
+    {
+        size_t  job;
+        
+        pthread_mutex_lock(&mergeJobs.mutex);
+        job = mergeJobs.next++;
+        pthread_mutex_unlock(&mergeJobs.mutex);
+        
+        if (job >= mergeJobs.count)
+            break;
+        
+        pthread_setspecific(status_file_key, mergeJobs.paths[job]);
+        
+        try
+        {
+            merge_strings_file(mergeJobs.oldAsciiMap, *mergeJobs.newAsciiMap, 
+                               mergeJobs.paths[job]);
+        }
+        catch (const MergeError& error)
+        {
+            mergeJobs.errors[job] = error;
+        }
+        
+        pthread_setspecific(status_file_key, NULL);
+    }
     
-    if (yyparse() != 0)
-        fatal(4, "Can't parse %s", path);
+    return NULL;
 }
 
 static void write_strings_file(const char* path, const StringsMap& stringsMap)
@@ -191,36 +400,117 @@ static void write_strings_file(const char* path, const StringsMap& stringsMap)
     std::string outstr  = ostr.str();
     CFStringRef dataStr = CFStringCreateWithCString(NULL, outstr.c_str(), kCFStringEncodingUTF8);
     CFDataRef   dataRef = CFStringCreateExternalRepresentation(NULL, dataStr, kCFStringEncodingUnicode, 0);
+    std::string tempPath;
+    FILE*       fp      = create_temp_file(path, tempPath);
+    size_t      length  = CFDataGetLength(dataRef);
+    bool        written = (fwrite(CFDataGetBytePtr(dataRef), 1, length, fp) == length);
+    
+    CFRelease(dataRef);
+    CFRelease(dataStr);
     
-    FILE*   fp  = fopen(path, "wb");
+    replace_with_temp_file(fp, written, tempPath, path);
+}
+
+
+// Creates a temporary file next to path, with the same permissions as path if it 
+// exists.  Writing to it and then calling replace_with_temp_file() means that path 
+// never holds a partial file, even if the process is interrupted.
+
+FILE*   create_temp_file(const char* path, std::string& tempPath)
+{
+    struct stat sb;
+    
+    tempPath = std::string(path) + ".XXXXXX";
+    
+    int     fd  = mkstemp(&tempPath[0]);
+    FILE*   fp  = (fd >= 0) ? fdopen(fd, "wb") : NULL;
     
     if (fp == NULL)
-        fatal(2, "Can't create %s", path);
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+            unlink(tempPath.c_str());
+        }
+        
+        fatal(2, "Can't create %s", tempPath.c_str());
+    }
     
-    fwrite(CFDataGetBytePtr(dataRef), 1, CFDataGetLength(dataRef), fp);
-    fclose(fp);
+    fchmod(fd, (stat(path, &sb) == 0) ? (sb.st_mode & 07777) : 0644);
     
-    CFRelease(dataRef);
-    CFRelease(dataStr);
+    return fp;
+}
+
+
+// Closes fp and renames tempPath to path.  written is false if writing to fp failed, in 
+// which case the temporary file is removed and path is left alone.
+
+void    replace_with_temp_file(FILE* fp, bool written, const std::string& tempPath, const char* path)
+{
+    if ((fclose(fp) != 0) || !written)
+    {
+        unlink(tempPath.c_str());
+        fatal(2, "Can't write %s", path);
+    }
+    
+    if (rename(tempPath.c_str(), path) != 0)
+    {
+        unlink(tempPath.c_str());
+        fatal(2, "Can't replace %s", path);
+    }
 }
 
 
 void    print_map(std::ostream& ostr, const StringsMap& stringsMap)
 {
+    // Write the entries sorted by key, so that the output doesn't depend on the map's 
+    // hash function.
+    
+    std::vector<const StringsMap::value_type*>  entries;
+    
+    entries.reserve(stringsMap.size());
+    
     for (StringsMap::const_iterator it = stringsMap.begin(); 
          it != stringsMap.end(); 
          ++it)
     {
-        ostr << it->second.comment << "\n"
-             << it->first << " = " << it->second.value << ";\n" << std::endl;
+        entries.push_back(&*it);
+    }
+    
+    std::sort(entries.begin(), entries.end(), CompareKeys());
+    
+    for (std::vector<const StringsMap::value_type*>::const_iterator it = entries.begin(); 
+         it != entries.end(); 
+         ++it)
+    {
+        ostr << (*it)->second.comment << "\n"
+             << (*it)->first << " = " << (*it)->second.value << ";\n" << std::endl;
     }
 }
 
 
+// Reports an error and exits with status.  While merging one of several files, the 
+// error is thrown as a MergeError instead, to be reported by merge_many().
+
 void    fatal(int status, const char* format, ...)
 {
     va_list args;
     
+    if (pthread_getspecific(status_file_key) != NULL)
+    {
+        MergeError  error;
+        char        message[1024];
+        
+        va_start(args, format);
+        vsnprintf(message, sizeof(message), format, args);
+        va_end(args);
+        
+        error.status    = status;
+        error.message   = message;
+        
+        throw error;
+    }
+    
     va_start(args, format);
     fprintf(stderr, "%s:  ", progname);
     vfprintf(stderr, format, args);
@@ -230,28 +520,35 @@ void    fatal(int status, const char* format, ...)
     exit(status);
 }
 
-void    yyerror(const char* msg)
-{
-    fatal(4, "Parse error: %s", msg);
-}
-
 static void status(const char* format, ...)
 {
     if (verbose)
     {
         va_list args;
         
+        // Several files may be merged at once, so say which one the message is about, 
+        // and don't let messages from different threads interleave.
+        
+        const char* path    = static_cast<const char*>(pthread_getspecific(status_file_key));
+        
+        flockfile(stdout);
         va_start(args, format);
         fprintf(stdout, "%s:  ", progname);
+        if (path != NULL)
+            fprintf(stdout, "%s:  ", path);
         vfprintf(stdout, format, args);
         fputc('\n', stdout);
         va_end(args);
+        funlockfile(stdout);
     }
 }
 
 static void usage()
 {
     fprintf(stderr, "usage:  %s [old-ascii-file] new-ascii-file old-english-file\n", progname);
+    fprintf(stderr, "        %s -m [-j jobs] [-o old-ascii-file] new-ascii-file localised-file...\n", progname);
+    fprintf(stderr, "        %s -c strings-file table-file\n", progname);
+    fprintf(stderr, "        %s -v strings-file table-file\n", progname);
     exit(1);
 }
 
@@ -297,9 +594,9 @@ CopyAscii::operator () (const StringsMap::value_type& val)
 
 
 CopyChangedAscii::CopyChangedAscii(
-    StringsMap& oldAsciiKeys, 
-    StringsMap& englishKeys, 
-    bool&       englishChanged)
+    const StringsMap&   oldAsciiKeys, 
+    StringsMap&         englishKeys, 
+    bool&               englishChanged)
         : mOldAsciiKeys(oldAsciiKeys), mEnglishKeys(englishKeys), mEnglishChanged(englishChanged)
 {
 }
@@ -307,7 +604,7 @@ CopyChangedAscii::CopyChangedAscii(
 void
 CopyChangedAscii::operator () (const StringsMap::value_type& val)
 {
-    StringsMap::iterator    oit = mOldAsciiKeys.find(val.first);
+    StringsMap::const_iterator  oit = mOldAsciiKeys.find(val.first);
     
     if (oit != mOldAsciiKeys.end())
     {
@@ -400,9 +697,9 @@ RemoveDeletedAscii::operator () (const std::string& val)
 
 
 RemoveDeletedNewAscii::RemoveDeletedNewAscii(
-    StringsMap& newAsciiKeys, 
-    StringsMap& englishKeys, 
-    bool&       englishChanged)
+    const StringsMap&   newAsciiKeys, 
+    StringsMap&         englishKeys, 
+    bool&               englishChanged)
         : mNewAsciiKeys(newAsciiKeys), mEnglishKeys(englishKeys), mEnglishChanged(englishChanged)
 {
 }
@@ -410,7 +707,7 @@ RemoveDeletedNewAscii::RemoveDeletedNewAscii(
 void
 RemoveDeletedNewAscii::operator () (const StringsMap::value_type& val)
 {
-    StringsMap::iterator    nit = mNewAsciiKeys.find(val.first);
+    StringsMap::const_iterator  nit = mNewAsciiKeys.find(val.first);
     
     if (nit == mNewAsciiKeys.end())
     {
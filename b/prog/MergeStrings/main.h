@@ -18,22 +18,51 @@
 
 #pragma once
 
-#include <list>
-#include <map>
+#include <stdio.h>
 #include <string>
 
+#if defined(__MWERKS__)
+#   include <hash_map>
+#elif defined(__GNUC__)
+#   include <ext/hash_map>
+#endif
+
 struct StringsEntry
 {
     std::string value;
     std::string comment;
 };
 
-typedef std::map<std::string, StringsEntry> StringsMap;
+struct StringHash
+{
+    size_t  operator () (const std::string& str) const
+            {
+                size_t  hash    = 0;
+                
+                for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+                    hash = 5 * hash + static_cast<unsigned char>(*it);
+                
+                return hash;
+            }
+};
 
-extern void InitParser(const char* path, StringsMap& stringsMap);
-extern void InitScanner(const char* path);
+// Keys are only ever looked up, so the maps are unordered;  print_map() sorts the 
+// entries when writing them out.
 
-extern void fatal(int status, const char* format, ...);
+#if defined(__MWERKS__)
+typedef Metrowerks::hash_map<std::string, StringsEntry, StringHash> StringsMap;
+#elif defined(__GNUC__)
+typedef __gnu_cxx::hash_map<std::string, StringsEntry, StringHash>  StringsMap;
+#endif
+
+extern void read_strings_file(const char* path, StringsMap& stringsMap);
 
-extern int  yyparse(void);
-extern void yyerror(const char* msg);
+extern void write_strings_table(const char* path, const StringsMap& stringsMap);
+extern int  verify_strings_table(const char* path, const StringsMap& stringsMap);
+
+extern FILE*    create_temp_file(const char* path, std::string& tempPath);
+extern void     replace_with_temp_file(FILE* fp, bool written, const std::string& tempPath, const char* path);
+
+extern const char* progname;
+
+extern void fatal(int status, const char* format, ...);
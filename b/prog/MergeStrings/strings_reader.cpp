@@ -0,0 +1,346 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#include <algorithm>
+#include <stdexcept>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <CoreFoundation/CFString.h>
+
+#include "main.h"
+
+
+// Reads .strings files.  All of the state lives in a StringsReader, so any number of 
+// files may be read at once, on different threads.
+//
+// The grammar is the one MergeStrings has always accepted:  a sequence of entries, each 
+// made up of a comment, a quoted key, '=', a quoted value and ';'.  Comments and strings 
+// are kept verbatim (including the delimiters and any escape sequences), since they are 
+// written back out as-is.
+
+class StringsReader
+{
+public:
+    
+            StringsReader(const char* path);
+    
+    void    Read(StringsMap& stringsMap);
+    
+private:
+    
+    enum Token  { kEnd, kComment, kString, kEquals, kSemicolon };
+    
+    Token   NextToken();
+    void    Expect(Token token, const char* what);
+    void    ScanComment();
+    void    ScanString();
+    void    SkipEol();
+    
+    const std::string   mPath;
+    std::string         mInput;
+    size_t              mOffset;
+    int                 mLine;
+    std::string         mToken;
+};
+
+static void read_file_into_string(const char* path, std::string& str);
+static void read_file(const char* path, std::vector<char>& data);
+static std::string& CFStringToString(
+                        CFStringRef         cfstr, 
+                        CFStringEncoding    encoding, 
+                        std::string&        nstr);
+
+
+void    read_strings_file(const char* path, StringsMap& stringsMap)
+{
+    StringsReader   reader(path);
+    
+    reader.Read(stringsMap);
+}
+
+
+StringsReader::StringsReader(const char* path)
+    : mPath(path), mOffset(0), mLine(1)
+{
+    read_file_into_string(path, mInput);
+}
+
+void
+StringsReader::Read(StringsMap& stringsMap)
+{
+    Token   token;
+    
+    while ((token = NextToken()) != kEnd)
+    {
+        StringsEntry    entry;
+        std::string     key;
+        
+        if (token != kComment)
+            fatal(4, "Parse error in %s line %d:  expected a comment", mPath.c_str(), mLine);
+        
+        entry.comment = mToken;
+        
+        Expect(kString, "a key");
+        key = mToken;
+        
+        Expect(kEquals, "'='");
+        Expect(kString, "a value");
+        entry.value = mToken;
+        
+        Expect(kSemicolon, "';'");
+        
+        stringsMap.insert(StringsMap::value_type(key, entry));
+    }
+}
+
+void
+StringsReader::Expect(Token token, const char* what)
+{
+    if (NextToken() != token)
+        fatal(4, "Parse error in %s line %d:  expected %s", mPath.c_str(), mLine, what);
+}
+
+StringsReader::Token
+StringsReader::NextToken()
+{
+    while (mOffset < mInput.size())
+    {
+        char    c   = mInput[mOffset];
+        
+        switch (c)
+        {
+        case '\r':
+        case '\n':
+            SkipEol();
+            break;
+            
+        case ' ':
+        case '\t':
+            mOffset++;
+            break;
+            
+        case '=':
+            mOffset++;
+            return (kEquals);
+            
+        case ';':
+            mOffset++;
+            return (kSemicolon);
+            
+        case '"':
+            ScanString();
+            return (kString);
+            
+        case '/':
+            if ((mOffset + 1 < mInput.size()) && (mInput[mOffset+1] == '*'))
+            {
+                ScanComment();
+                return (kComment);
+            }
+            // fall through
+            
+        default:
+            fatal(3, "bad character 0x%02.2x in %s line %d", (c & 0x0FF), mPath.c_str(), mLine);
+            break;
+        }
+    }
+    
+    return (kEnd);
+}
+
+// A comment only ends at a "*/" that is followed by the end of a line.
+
+void
+StringsReader::ScanComment()
+{
+    size_t  start   = mOffset;
+    
+    mOffset += 2;
+    
+    while (true)
+    {
+        size_t  end = mInput.find("*/", mOffset);
+        
+        for (size_t i = mOffset; i < std::min(end, mInput.size()); i++)
+        {
+            if ((mInput[i] == '\n') || ((mInput[i] == '\r') && 
+                                        ((i + 1 >= mInput.size()) || (mInput[i+1] != '\n'))))
+            {
+                mLine++;
+            }
+        }
+        
+        if (end == std::string::npos)
+            fatal(4, "Unterminated comment in %s line %d", mPath.c_str(), mLine);
+        
+        mOffset = end + 2;
+        
+        if ((mOffset >= mInput.size()) || (mInput[mOffset] == '\r') || (mInput[mOffset] == '\n'))
+            break;
+    }
+    
+    mToken.assign(mInput, start, mOffset - start);
+}
+
+void
+StringsReader::ScanString()
+{
+    size_t  start   = mOffset++;
+    
+    while (true)
+    {
+        if (mOffset >= mInput.size())
+            fatal(4, "Unterminated string in %s line %d", mPath.c_str(), mLine);
+        
+        char    c   = mInput[mOffset++];
+        
+        if (c == '"')
+            break;
+        else if ((c == '\\') && (mOffset < mInput.size()))
+            mOffset++;
+        else if (c == '\n')
+            mLine++;
+    }
+    
+    mToken.assign(mInput, start, mOffset - start);
+}
+
+void
+StringsReader::SkipEol()
+{
+    if ((mInput[mOffset++] == '\r') && (mOffset < mInput.size()) && (mInput[mOffset] == '\n'))
+        mOffset++;
+    
+    mLine++;
+}
+
+
+static void read_file_into_string(const char* path, std::string& str)
+{
+    std::vector<char>   data;
+    
+    read_file(path, data);
+    
+    if (data.size() < 2)
+        fatal(2, "%s is too short", path);
+    
+    CFStringRef dataStr;
+    
+    dataStr = CFStringCreateWithBytes(NULL, (const UInt8 *) &data[0], data.size(), kCFStringEncodingUnicode, true);
+    if (dataStr == NULL)
+        fatal(2, "can't convert %s to unicode", path);
+    
+    try
+    {
+        CFStringToString(dataStr, kCFStringEncodingUTF8, str);
+    }
+    catch (...)
+    {
+        CFRelease(dataStr);
+        fatal(2, "can't convert %s to UTF-8", path);
+    }
+    
+    CFRelease(dataStr);
+}
+
+static void read_file(const char* path, std::vector<char>& data)
+{
+    FILE*   fp  = fopen(path, "rb");
+    long    size;
+    
+    if (fp == NULL)
+        fatal(2, "can't open %s", path);
+    
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    
+    data.resize(size);
+    
+    bool    ok  = (fread(&data[0], 1, size, fp) == (size_t) size);
+    
+    fclose(fp);
+    
+    if (!ok)
+        fatal(2, "can't read %s", path);
+}
+
+static std::string& CFStringToString(
+    CFStringRef         cfstr, 
+    CFStringEncoding    encoding, 
+    std::string&        nstr)
+{
+    const size_t    kBuffSize   = 512;
+    UInt8*          buff        = NULL;
+    CFAllocatorRef  allocator   = CFAllocatorGetDefault();
+    
+    try
+    {
+        UInt8       buffArray[kBuffSize];
+        char*       buffPtr = (char *) buffArray;
+        CFIndex     buffLen = kBuffSize;
+        CFIndex     strLen;
+        
+        strLen = CFStringGetLength(cfstr);
+        
+        if (strLen * sizeof(UniChar) > kBuffSize)
+        {
+            buff = (UInt8*) CFAllocatorAllocate(allocator, strLen * sizeof(UniChar), 0);
+            
+            if (buff != NULL)
+            {
+                buffPtr = (char *) buff;
+                buffLen = strLen;
+            }
+        }
+        
+        CFRange range   = CFRangeMake(0, strLen);
+        
+        nstr.clear();
+        
+        while (range.length > 0)
+        {
+            CFIndex usedLen, numConverted;
+            
+            numConverted = CFStringGetBytes(cfstr, range, encoding, '?', 
+                                            false, (UInt8 *) buffPtr, 
+                                            buffLen, &usedLen);
+            if (numConverted == 0)
+                throw std::runtime_error("string conversion error");
+            
+            nstr.append(buffPtr, usedLen);
+            
+            range.location  += numConverted;
+            range.length    -= numConverted;
+        }
+        
+        if (buff != NULL)
+            CFAllocatorDeallocate(allocator, buff);
+    }
+    catch (...)
+    {
+        if (buff != NULL)
+            CFAllocatorDeallocate(allocator, buff);
+        
+        throw;
+    }
+    
+    return (nstr);
+}
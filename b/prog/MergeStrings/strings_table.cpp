@@ -0,0 +1,467 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+#include <CoreFoundation/CFString.h>
+
+#include "BCompiledStringTable.h"
+#include "main.h"
+
+
+typedef std::vector<UniChar>    UniString;
+
+struct TableEntry
+{
+    UniString   key;
+    UniString   value;
+};
+
+struct CompareKeys
+{
+    bool    operator () (const TableEntry& lhs, const TableEntry& rhs) const
+            {
+                return (std::lexicographical_compare(lhs.key.begin(), lhs.key.end(), 
+                                                     rhs.key.begin(), rhs.key.end()));
+            }
+};
+
+struct Bucket
+{
+    UInt32                  index;
+    std::vector<UInt32>     entries;
+};
+
+struct CompareBucketSizes
+{
+    bool    operator () (const Bucket* lhs, const Bucket* rhs) const
+            {
+                return (lhs->entries.size() > rhs->entries.size());
+            }
+};
+
+typedef B::CompiledStringTable  Table;
+
+static void make_table_entries(const StringsMap& stringsMap, std::vector<TableEntry>& entries);
+static void unquote(const std::string& str, UniString& ustr);
+static bool build_perfect_hash(
+                const std::vector<TableEntry>&  entries, 
+                UInt32                          bucketCount, 
+                UInt32                          slotCount, 
+                std::vector<UInt32>&            displacements, 
+                std::vector<UInt32>&            slots);
+static void read_table_file(const char* path, std::vector<char>& data);
+static std::string  to_utf8(const UniString& ustr);
+
+
+// Writes stringsMap to path as a compiled string table.
+
+void    write_strings_table(const char* path, const StringsMap& stringsMap)
+{
+    std::vector<TableEntry> entries;
+    
+    make_table_entries(stringsMap, entries);
+    
+    // Find a perfect hash.  With four keys per bucket on average and a slot per key, 
+    // this nearly always succeeds on the first try;  if it doesn't, add some slack.
+    
+    UInt32              count       = entries.size();
+    UInt32              bucketCount = std::max<UInt32>(1, (count + 3) / 4);
+    UInt32              slotCount   = std::max<UInt32>(1, count);
+    std::vector<UInt32> displacements, slots;
+    
+    while (!build_perfect_hash(entries, bucketCount, slotCount, displacements, slots))
+    {
+        slotCount += std::max<UInt32>(1, slotCount / 8);
+    }
+    
+    // Lay out the file.
+    
+    Table::Header       header;
+    std::vector<Table::Entry>   tableEntries(count);
+    UniString           blob;
+    
+    for (UInt32 i = 0; i < count; i++)
+    {
+        Table::Entry&   entry   = tableEntries[i];
+        
+        entry.mKeyOffset    = blob.size();
+        entry.mKeyLength    = entries[i].key.size();
+        blob.insert(blob.end(), entries[i].key.begin(), entries[i].key.end());
+        
+        entry.mValueOffset  = blob.size();
+        entry.mValueLength  = entries[i].value.size();
+        blob.insert(blob.end(), entries[i].value.begin(), entries[i].value.end());
+    }
+    
+    header.mMagic               = Table::kMagic;
+    header.mVersion             = Table::kVersion;
+    header.mByteOrder           = Table::kByteOrderMark;
+    header.mCount               = count;
+    header.mBucketCount         = bucketCount;
+    header.mSlotCount           = slotCount;
+    header.mEntriesOffset       = sizeof(header);
+    header.mDisplacementsOffset = header.mEntriesOffset + count * sizeof(Table::Entry);
+    header.mSlotsOffset         = header.mDisplacementsOffset + bucketCount * sizeof(UInt32);
+    header.mBlobOffset          = header.mSlotsOffset + slotCount * sizeof(UInt32);
+    header.mBlobLength          = blob.size();
+    
+    // Applications may have the old table mapped, so it must be replaced, not rewritten.
+    
+    std::string tempPath;
+    FILE*       fp      = create_temp_file(path, tempPath);
+    bool        written = (fwrite(&header, sizeof(header), 1, fp) == 1) && 
+                          ((count == 0) || 
+                           (fwrite(&tableEntries[0], sizeof(Table::Entry), count, fp) == count)) && 
+                          (fwrite(&displacements[0], sizeof(UInt32), bucketCount, fp) == bucketCount) && 
+                          (fwrite(&slots[0], sizeof(UInt32), slotCount, fp) == slotCount) && 
+                          (blob.empty() || 
+                           (fwrite(&blob[0], sizeof(UniChar), blob.size(), fp) == blob.size()));
+    
+    replace_with_temp_file(fp, written, tempPath, path);
+}
+
+
+// Checks that the compiled string table at path holds exactly the entries in stringsMap.  
+// Returns the number of discrepancies.
+
+int     verify_strings_table(const char* path, const StringsMap& stringsMap)
+{
+    std::vector<TableEntry> entries;
+    std::vector<char>       data;
+    
+    make_table_entries(stringsMap, entries);
+    read_table_file(path, data);
+    
+    const Table::Header*    header  = Table::Validate(data.empty() ? NULL : &data[0], 
+                                                      data.size());
+    
+    if (header == NULL)
+        fatal(5, "%s isn't a valid string table", path);
+    
+    const Table::Entry*     tableEntries    = Table::GetEntries(header);
+    const UniChar*          blob            = Table::GetBlob(header);
+    int                     errors          = 0;
+    
+    if (header->mCount != entries.size())
+    {
+        fprintf(stderr, "%s:  %s has %lu entries, expected %lu\n", progname, path, 
+                (unsigned long) header->mCount, (unsigned long) entries.size());
+        errors++;
+    }
+    
+    for (std::vector<TableEntry>::const_iterator it = entries.begin(); 
+         it != entries.end(); 
+         ++it)
+    {
+        long    index   = Table::Find(header, it->key.empty() ? NULL : &it->key[0], 
+                                      it->key.size());
+        
+        if (index < 0)
+        {
+            fprintf(stderr, "%s:  %s is missing %s\n", progname, path, 
+                    to_utf8(it->key).c_str());
+            errors++;
+            continue;
+        }
+        
+        const Table::Entry& entry   = tableEntries[index];
+        
+        if ((entry.mValueLength != it->value.size()) || 
+            !std::equal(it->value.begin(), it->value.end(), blob + entry.mValueOffset))
+        {
+            fprintf(stderr, "%s:  %s has a different value for %s\n", progname, path, 
+                    to_utf8(it->key).c_str());
+            errors++;
+        }
+    }
+    
+    // Keys must be sorted, which also implies that they are unique.
+    
+    for (UInt32 i = 1; i < header->mCount; i++)
+    {
+        const Table::Entry& prev    = tableEntries[i-1];
+        const Table::Entry& entry   = tableEntries[i];
+        
+        if (!std::lexicographical_compare(blob + prev.mKeyOffset, 
+                                          blob + prev.mKeyOffset + prev.mKeyLength, 
+                                          blob + entry.mKeyOffset, 
+                                          blob + entry.mKeyOffset + entry.mKeyLength))
+        {
+            fprintf(stderr, "%s:  %s isn't sorted at entry %lu\n", progname, path, 
+                    (unsigned long) i);
+            errors++;
+        }
+    }
+    
+    return (errors);
+}
+
+
+static void make_table_entries(const StringsMap& stringsMap, std::vector<TableEntry>& entries)
+{
+    entries.resize(stringsMap.size());
+    
+    std::vector<TableEntry>::iterator   eit = entries.begin();
+    
+    for (StringsMap::const_iterator it = stringsMap.begin(); 
+         it != stringsMap.end(); 
+         ++it, ++eit)
+    {
+        unquote(it->first, eit->key);
+        unquote(it->second.value, eit->value);
+    }
+    
+    // The map is sorted on the quoted UTF-8 keys, which isn't the same order as that 
+    // of the unescaped UTF-16 ones.
+    
+    std::sort(entries.begin(), entries.end(), CompareKeys());
+    
+    for (size_t i = 1; i < entries.size(); i++)
+    {
+        if (entries[i-1].key == entries[i].key)
+            fatal(4, "Duplicate key %s", to_utf8(entries[i].key).c_str());
+    }
+}
+
+
+// Converts a quoted string as returned by the scanner into the UTF-16 string it denotes, 
+// handling the same escape sequences as CFPropertyList's .strings parser.
+
+static void unquote(const std::string& str, UniString& ustr)
+{
+    std::string inner;
+    
+    if ((str.size() >= 2) && (str[0] == '"') && (str[str.size()-1] == '"'))
+        inner = str.substr(1, str.size() - 2);
+    else
+        inner = str;
+    
+    CFStringRef cfstr   = CFStringCreateWithBytes(NULL, (const UInt8*) inner.data(), 
+                                                  inner.size(), kCFStringEncodingUTF8, 
+                                                  false);
+    
+    if (cfstr == NULL)
+        fatal(4, "Can't convert %s to unicode", str.c_str());
+    
+    UniString   chars(CFStringGetLength(cfstr));
+    
+    if (!chars.empty())
+        CFStringGetCharacters(cfstr, CFRangeMake(0, chars.size()), &chars[0]);
+    
+    CFRelease(cfstr);
+    
+    ustr.clear();
+    ustr.reserve(chars.size());
+    
+    for (size_t i = 0; i < chars.size(); i++)
+    {
+        if ((chars[i] != '\\') || (i + 1 >= chars.size()))
+        {
+            ustr.push_back(chars[i]);
+            continue;
+        }
+        
+        UniChar c   = chars[++i];
+        
+        switch (c)
+        {
+        case 'a':   ustr.push_back('\a');   break;
+        case 'b':   ustr.push_back('\b');   break;
+        case 'f':   ustr.push_back('\f');   break;
+        case 'n':   ustr.push_back('\n');   break;
+        case 'r':   ustr.push_back('\r');   break;
+        case 't':   ustr.push_back('\t');   break;
+        case 'v':   ustr.push_back('\v');   break;
+        
+        case 'U':
+            {
+                UniChar value   = 0;
+                size_t  n;
+                
+                for (n = 0; (n < 4) && (i + 1 < chars.size()); n++)
+                {
+                    UniChar h   = chars[i+1];
+                    
+                    if ((h >= '0') && (h <= '9'))
+                        value = (value << 4) | (h - '0');
+                    else if ((h >= 'a') && (h <= 'f'))
+                        value = (value << 4) | (h - 'a' + 10);
+                    else if ((h >= 'A') && (h <= 'F'))
+                        value = (value << 4) | (h - 'A' + 10);
+                    else
+                        break;
+                    
+                    i++;
+                }
+                
+                ustr.push_back((n > 0) ? value : c);
+            }
+            break;
+            
+        default:
+            if ((c >= '0') && (c <= '7'))
+            {
+                UniChar value   = c - '0';
+                
+                for (size_t n = 1; (n < 3) && (i + 1 < chars.size()) && 
+                                   (chars[i+1] >= '0') && (chars[i+1] <= '7'); n++)
+                {
+                    value = (value << 3) | (chars[++i] - '0');
+                }
+                
+                ustr.push_back(value);
+            }
+            else
+            {
+                // \", \', \\, and anything unknown:  keep the escaped character.
+                
+                ustr.push_back(c);
+            }
+            break;
+        }
+    }
+}
+
+
+// Computes the displacements and slots of a "hash and displace" perfect hash of the 
+// entries' keys (see BCompiledStringTable.h).  Buckets are placed largest first, since 
+// they are the hardest to fit.  Returns false if some bucket couldn't be placed.
+
+static bool build_perfect_hash(
+    const std::vector<TableEntry>&  entries, 
+    UInt32                          bucketCount, 
+    UInt32                          slotCount, 
+    std::vector<UInt32>&            displacements, 
+    std::vector<UInt32>&            slots)
+{
+    const UInt32            kMaxDisplacement    = 1000000;
+    std::vector<Bucket>     buckets(bucketCount);
+    std::vector<Bucket*>    order(bucketCount);
+    std::vector<UInt32>     bucketSlots;
+    
+    for (UInt32 i = 0; i < bucketCount; i++)
+    {
+        buckets[i].index    = i;
+        order[i]            = &buckets[i];
+    }
+    
+    for (UInt32 i = 0; i < entries.size(); i++)
+    {
+        const UniString&    key = entries[i].key;
+        
+        buckets[Table::Hash(key.empty() ? NULL : &key[0], key.size(), 0) % bucketCount].entries.push_back(i);
+    }
+    
+    std::stable_sort(order.begin(), order.end(), CompareBucketSizes());
+    
+    displacements.assign(bucketCount, 0);
+    slots.assign(slotCount, Table::kEmptySlot);
+    
+    for (std::vector<Bucket*>::const_iterator it = order.begin(); 
+         (it != order.end()) && !(*it)->entries.empty(); 
+         ++it)
+    {
+        const Bucket&   bucket  = **it;
+        UInt32          seed;
+        
+        for (seed = 1; seed < kMaxDisplacement; seed++)
+        {
+            bucketSlots.clear();
+            
+            for (size_t j = 0; j < bucket.entries.size(); j++)
+            {
+                const UniString&    key     = entries[bucket.entries[j]].key;
+                UInt32              slot    = Table::Hash(key.empty() ? NULL : &key[0], 
+                                                          key.size(), seed) % slotCount;
+                
+                if ((slots[slot] != static_cast<UInt32>(Table::kEmptySlot)) || 
+                    (std::find(bucketSlots.begin(), bucketSlots.end(), slot) != bucketSlots.end()))
+                {
+                    break;
+                }
+                
+                bucketSlots.push_back(slot);
+            }
+            
+            if (bucketSlots.size() == bucket.entries.size())
+                break;
+        }
+        
+        if (seed >= kMaxDisplacement)
+            return (false);
+        
+        displacements[bucket.index] = seed;
+        
+        for (size_t j = 0; j < bucketSlots.size(); j++)
+            slots[bucketSlots[j]] = bucket.entries[j];
+    }
+    
+    return (true);
+}
+
+
+static void read_table_file(const char* path, std::vector<char>& data)
+{
+    FILE*   fp  = fopen(path, "rb");
+    long    size;
+    
+    if (fp == NULL)
+        fatal(2, "Can't open %s", path);
+    
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    
+    data.resize(size);
+    
+    if ((size > 0) && (fread(&data[0], 1, size, fp) != (size_t) size))
+        fatal(2, "Can't read %s", path);
+    
+    fclose(fp);
+}
+
+
+static std::string  to_utf8(const UniString& ustr)
+{
+    std::string str;
+    CFIndex     length  = ustr.size();
+    CFStringRef cfstr   = CFStringCreateWithCharacters(NULL, ustr.empty() ? NULL : &ustr[0], 
+                                                       length);
+    
+    if (cfstr != NULL)
+    {
+        CFIndex usedLen = 0;
+        
+        CFStringGetBytes(cfstr, CFRangeMake(0, length), kCFStringEncodingUTF8, '?', 
+                         false, NULL, 0, &usedLen);
+        str.resize(usedLen);
+        
+        if (usedLen > 0)
+        {
+            CFStringGetBytes(cfstr, CFRangeMake(0, length), kCFStringEncodingUTF8, '?', 
+                             false, (UInt8*) &str[0], usedLen, &usedLen);
+        }
+        
+        CFRelease(cfstr);
+    }
+    
+    return (str);
+}
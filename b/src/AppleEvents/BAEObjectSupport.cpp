@@ -36,6 +36,7 @@
 #include "BAEToken.h"
 #include "BAEWriter.h"
 #include "BBundle.h"
+#include "BDispatchTrace.h"
 #include "BEventCustomParams.h"
 #include "BExceptionStreamer.h"
 #include "BMemoryUtilities.h"
@@ -1030,6 +1031,9 @@ AEObjectSupport::CacheExceptionInfo(const std::exception& ex) const
         ExInfo&             exInfo  = GetExInfo();
         std::ostringstream  ostr;
         
+        // The state ends up in an Apple Event reply, whose recipient may be another 
+        // process running an older version of B, so use the text format.
+        
         ExceptionStreamer::Get()->Externalize(ex, ostr);
         
         exInfo.mState   = ostr.str();
@@ -1130,11 +1134,8 @@ AEObjectSupport::RethrowExceptionFromAppleEventReply(
                             &junkType, &buffer[0], buffer.size(), &junkSize);
         B_THROW_IF_STATUS(err);
         
-        std::string         str(&buffer[0], buffer.size());
-        std::istringstream  istr(str);
-        
         // If all goes well, this will throw an exception.
-        ExceptionStreamer::Get()->Rethrow(istr);
+        ExceptionStreamer::Get()->Rethrow(&buffer[0], buffer.size());
         
         // If we're here, then something went wrong.  Fall through to the fall-back 
         // behaviour.
@@ -2543,7 +2544,9 @@ AEObjectSupport::AEEventHandlerProc(
             B_THROW(ConstantOSStatusException<errAEEventNotHandled>());
         
         AEInfo::EventKey    key = eventKeys[handlerRefcon];
-    
+        
+        B_DISPATCH_TRACE_SCOPE(kAppleEvent, key.first, key.second, "AEObjectSupport");
+        
         sAEObjectSupport->HandleAppleEvent(key, *theAppleEvent, *reply);
         
 #if 0
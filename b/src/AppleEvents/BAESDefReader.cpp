@@ -381,12 +381,12 @@ AESDefReader::RecordSuiteNames(
     
     // Initialise the keyform name map.
     
-    mKeyFormNames.insert(std::pair<String, DescType>(String("index"),    formAbsolutePosition));
-    mKeyFormNames.insert(std::pair<String, DescType>(String("relative"), formRelativePosition));
-    mKeyFormNames.insert(std::pair<String, DescType>(String("test"),     formTest));
-    mKeyFormNames.insert(std::pair<String, DescType>(String("range"),    formRange));
-    mKeyFormNames.insert(std::pair<String, DescType>(String("name"),     formName));
-    mKeyFormNames.insert(std::pair<String, DescType>(String("id"),       formUniqueID));
+    mKeyFormNames.insert(NameMapType(InternedString("index"),    formAbsolutePosition));
+    mKeyFormNames.insert(NameMapType(InternedString("relative"), formRelativePosition));
+    mKeyFormNames.insert(NameMapType(InternedString("test"),     formTest));
+    mKeyFormNames.insert(NameMapType(InternedString("range"),    formRange));
+    mKeyFormNames.insert(NameMapType(InternedString("name"),     formName));
+    mKeyFormNames.insert(NameMapType(InternedString("id"),       formUniqueID));
     
     InvokeFunctorOnElements(
         inSuiteTree, CFSTR("enumeration"), 
@@ -452,7 +452,7 @@ AESDefReader::RecordTypeName(
     String      name    = GetElementAttribute(inEnumTree, CFSTR("name"));
     DescType    code    = GetCodeAttribute(inEnumTree);
     
-    if (!mTypeNames.insert(NameMapType(name, code)).second)
+    if (!mTypeNames.insert(NameMapType(InternedString(name), code)).second)
         throw std::runtime_error("Malformed scripting definition file:  duplicate type code.");
 }
 
@@ -463,7 +463,7 @@ AESDefReader::RecordEventName(CFXMLTreeRef eventTree)
     String              name    = GetElementAttribute(eventTree, CFSTR("name"));
     AEInfo::EventKey    code    = GetCommandCodeAttribute(eventTree);
     
-    if (!mEventNames.insert(EventNameMapType(name, code)).second)
+    if (!mEventNames.insert(EventNameMapType(InternedString(name), code)).second)
         throw std::runtime_error("Malformed scripting definition file:  duplicate event code.");
 }
 
@@ -577,7 +577,7 @@ AEInfo::ClassInfo&
 AESDefReader::GetClassInfoForClassName(
     const String&           inClassName)
 {
-    NameMap::const_iterator nit = mTypeNames.find(inClassName);
+    NameMap::const_iterator nit = mTypeNames.find(InternedString(inClassName));
     
     if (nit == mTypeNames.end())
     {
@@ -704,7 +704,7 @@ AESDefReader::RegisterClassEvent(
     
     // Ensure that the event this class responds to is actually defined.
     
-    if ((eit = mEventNames.find(eventName)) == mEventNames.end())
+    if ((eit = mEventNames.find(InternedString(eventName))) == mEventNames.end())
     {
         std::ostringstream  ostr;
         
@@ -799,7 +799,7 @@ AESDefReader::GetElementTypeCode(
         }
     }
     
-    NameMap::const_iterator nit = mTypeNames.find(typeName);
+    NameMap::const_iterator nit = mTypeNames.find(InternedString(typeName));
     
     if (nit == mTypeNames.end())
     {
@@ -822,7 +822,7 @@ AESDefReader::RegisterElementAccessor(
 {
     String  style   = GetElementAttribute(inAccessorTree, CFSTR("style"));
     
-    NameMap::const_iterator it  = mKeyFormNames.find(style);
+    NameMap::const_iterator it  = mKeyFormNames.find(InternedString(style));
     
     B_THROW_IF(it == mKeyFormNames.end(), 
             std::runtime_error("Unknown key form."));
@@ -21,8 +21,16 @@
 
 #pragma once
 
+// library headers
+#if defined(__MWERKS__)
+#   include <hash_map>
+#elif defined(__GNUC__)
+#   include <ext/hash_map>
+#endif
+
 // B headers
 #include "BAEInfo.h"
+#include "BInternedString.h"
 #include "BString.h"
 
 
@@ -64,8 +72,13 @@ public:
 private:
 
     // types
-    typedef std::map<String, DescType>          NameMap;
-    typedef std::map<String, AEInfo::EventKey>  EventNameMap;
+#if defined(__MWERKS__)
+    typedef Metrowerks::hash_map<InternedString, DescType, InternedStringHash>          NameMap;
+    typedef Metrowerks::hash_map<InternedString, AEInfo::EventKey, InternedStringHash>  EventNameMap;
+#elif defined(__GNUC__)
+    typedef __gnu_cxx::hash_map<InternedString, DescType, InternedStringHash>           NameMap;
+    typedef __gnu_cxx::hash_map<InternedString, AEInfo::EventKey, InternedStringHash>   EventNameMap;
+#endif
     typedef NameMap::value_type                 NameMapType;
     typedef EventNameMap::value_type            EventNameMapType;
     typedef AEInfo::ClassMap::value_type        ClassMapType;
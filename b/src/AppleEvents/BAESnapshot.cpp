@@ -0,0 +1,575 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BAESnapshot.h"
+
+// standard headers
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <set>
+
+// library headers
+#include <boost/logic/tribool.hpp>
+
+// B headers
+#include "BAEDescParam.h"
+#include "BAEObject.h"
+#include "BAEObjectSupport.h"
+#include "BAEWriter.h"
+#include "BException.h"
+
+
+namespace {
+
+// Returned by GetElements() for element types that have no elements.  This needs to be
+// a namespace-scope object, because function-level statics aren't thread-safe.
+const B::AESnapshot::NodeList   gNoNodes;
+
+}   // anonymous namespace
+
+
+namespace B {
+
+// ==========================================================================================
+//  AESnapshot::Node
+
+#pragma mark AESnapshot::Node
+
+// ------------------------------------------------------------------------------------------
+AESnapshot::Node::Node(
+    DescType    inClassID)
+        : mClassID(inClassID), mUniqueID(0)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @internal   The class hierarchy held by AEObjectSupport doesn't change after the
+                application's dictionary has been loaded, so it's safe to consult it from
+                any thread.
+*/
+bool
+AESnapshot::Node::InheritsFrom(
+    DescType    inBaseClassID)  //!< The base class ID.
+    const
+{
+    return (AEObject::DoesClassInheritFrom(mClassID, inBaseClassID));
+}
+
+// ------------------------------------------------------------------------------------------
+const AEDesc*
+AESnapshot::Node::FindProperty(
+    DescType    inPropertyID)   //!< The property ID.
+    const
+{
+    PropertyMap::const_iterator it  = mProperties.find(inPropertyID);
+    
+    if (it != mProperties.end())
+        return (static_cast<const AEDesc*>(const_cast<AEDescriptor&>(it->second)));
+    else
+        return (NULL);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  AENoSuchObjectException If the property wasn't captured.
+*/
+void
+AESnapshot::Node::GetProperty(
+    DescType    inPropertyID,   //!< The property ID.
+    AEDesc&     outValue)       //!< The output value.  Its previous contents are disposed.
+    const
+{
+    const AEDesc*   value   = FindProperty(inPropertyID);
+    AEDesc          tempDesc;
+    OSStatus        err;
+    
+    B_THROW_IF(value == NULL, AENoSuchObjectException());
+    
+    err = AEDuplicateDesc(value, &tempDesc);
+    B_THROW_IF_STATUS(err);
+    
+    AEDisposeDesc(&outValue);
+    outValue = tempDesc;
+}
+
+// ------------------------------------------------------------------------------------------
+size_t
+AESnapshot::Node::CountElements(
+    DescType    inElementType)  //!< The base class ID of the elements.
+    const
+{
+    return (GetElements(inElementType).size());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Passing @c cObject for @a inElementType returns all of the object's elements.
+*/
+const AESnapshot::NodeList&
+AESnapshot::Node::GetElements(
+    DescType    inElementType)  //!< The base class ID of the elements.
+    const
+{
+    ElementMap::const_iterator  it  = mElements.find(inElementType);
+    
+    if (it != mElements.end())
+        return (it->second);
+    else
+        return (gNoNodes);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @return A valid node, or @c NULL if @a inIndex is out of range.
+*/
+AESnapshot::NodePtr
+AESnapshot::Node::GetElementByIndex(
+    DescType    inElementType,  //!< The base class ID of the element.
+    size_t      inIndex)        //!< The element's zero-based index.
+    const
+{
+    const NodeList& elements    = GetElements(inElementType);
+    
+    if (inIndex < elements.size())
+        return (elements[inIndex]);
+    else
+        return (NodePtr());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @return A valid node, or @c NULL if there's no such element.
+*/
+AESnapshot::NodePtr
+AESnapshot::Node::GetElementByName(
+    DescType        inElementType,  //!< The base class ID of the element.
+    const String&   inName)         //!< The element's name.
+    const
+{
+    const NodeList& elements    = GetElements(inElementType);
+    
+    for (NodeList::const_iterator it = elements.begin(); it != elements.end(); ++it)
+    {
+        if ((*it)->GetName() == inName)
+            return (*it);
+    }
+    
+    return (NodePtr());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @return A valid node, or @c NULL if there's no such element.
+*/
+AESnapshot::NodePtr
+AESnapshot::Node::GetElementByUniqueID(
+    DescType        inElementType,  //!< The base class ID of the element.
+    SInt32          inUniqueID)     //!< The element's unique id.
+    const
+{
+    const NodeList& elements    = GetElements(inElementType);
+    
+    for (NodeList::const_iterator it = elements.begin(); it != elements.end(); ++it)
+    {
+        if ((*it)->GetUniqueID() == inUniqueID)
+            return (*it);
+    }
+    
+    return (NodePtr());
+}
+
+
+// ==========================================================================================
+//  AESnapshot
+
+#pragma mark -
+#pragma mark AESnapshot
+
+// ------------------------------------------------------------------------------------------
+AESnapshot::AESnapshot(
+    UInt32  inVersion)
+        : mVersion(inVersion), mNodeCount(0)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The object model is walked depth-first, starting at @a inRoot.  For each object, we
+    record its class, name and unique id (if it has them), the values of all of its
+    readable properties except @c pProperties, and its elements of each class declared
+    in the application's dictionary.
+    
+    Because AEObjects are only accessible from the main thread, this function must be
+    called from there.  The resulting snapshot may be used from any thread.
+*/
+AESnapshot::SnapshotPtr
+AESnapshot::Take(
+    ConstAEObjectPtr    inRoot,     //!< The object to capture.
+    UInt32              inVersion)  //!< An arbitrary version number, returned by GetVersion().
+{
+    B_ASSERT(inRoot != NULL);
+    
+    boost::shared_ptr<AESnapshot>   snapshot(new AESnapshot(inVersion));
+    CaptureMap                      captured;
+    
+    snapshot->mRoot         = snapshot->Capture(inRoot, captured);
+    snapshot->mNodeCount    = captured.size();
+    
+    return (snapshot);
+}
+
+// ------------------------------------------------------------------------------------------
+boost::shared_ptr<AESnapshot::Node>
+AESnapshot::Capture(
+    ConstAEObjectPtr    inObject,
+    CaptureMap&         ioCaptured)
+{
+    // An object may appear under several element classes (since the "index-space" of
+    // a class includes its derived classes), so make sure we only capture it once.
+    
+    CaptureMap::iterator    it  = ioCaptured.find(inObject);
+    
+    if (it != ioCaptured.end())
+        return (it->second);
+    
+    boost::shared_ptr<Node> node(new Node(inObject->GetClassID()));
+    
+    ioCaptured.insert(CaptureMap::value_type(inObject, node));
+    
+    try
+    {
+        node->mName = inObject->GetName();
+    }
+    catch (...)
+    {
+        // The object doesn't have a name.
+    }
+    
+    try
+    {
+        node->mUniqueID = inObject->GetUniqueID();
+    }
+    catch (...)
+    {
+        // The object doesn't have a unique id.
+    }
+    
+    CaptureProperties(*inObject, *node);
+    
+    const AEInfo::ClassInfo&    classInfo   = AEObjectSupport::Get().GetClassInfo(node->mClassID);
+    NodeList&                   allElements = node->mElements[cObject];
+    std::set<const Node*>       allSet;
+    
+    for (AEInfo::ElementMap::const_iterator eit = classInfo.mElements.begin();
+         eit != classInfo.mElements.end();
+         ++eit)
+    {
+        DescType                elementType = eit->first;
+        std::list<AEObjectPtr>  elements;
+        
+        if (elementType == cObject)
+            continue;
+        
+        try
+        {
+            inObject->GetAllElements(elementType, elements);
+        }
+        catch (...)
+        {
+            // The dictionary declares an element class that the object doesn't
+            // actually implement.  Skip it.
+            continue;
+        }
+        
+        NodeList&   nodes   = node->mElements[elementType];
+        
+        nodes.reserve(elements.size());
+        
+        for (std::list<AEObjectPtr>::const_iterator oit = elements.begin();
+             oit != elements.end();
+             ++oit)
+        {
+            boost::shared_ptr<Node> element = Capture(*oit, ioCaptured);
+            
+            nodes.push_back(element);
+            
+            if (allSet.insert(element.get()).second)
+                allElements.push_back(element);
+        }
+    }
+    
+    return (node);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+AESnapshot::CaptureProperties(
+    const AEObject& inObject,
+    Node&           ioNode)
+{
+    std::vector<DescType>   propertyIDs;
+    
+    inObject.GetPropertyIDs(boost::indeterminate, boost::indeterminate,
+                            std::back_inserter(propertyIDs));
+    
+    for (std::vector<DescType>::const_iterator it = propertyIDs.begin();
+         it != propertyIDs.end();
+         ++it)
+    {
+        // pProperties is just an aggregate of the other properties, and properties
+        // implemented as objects would require capturing those objects as well.
+        
+        if ((*it == pProperties) || (inObject.GetPropertyObject(*it) != NULL))
+            continue;
+        
+        try
+        {
+            AEWriter        writer;
+            AEDescriptor    value;
+            
+            inObject.WriteProperty(*it, writer);
+            writer.Close(value);
+            
+            ioNode.mProperties[*it].swap(value);
+        }
+        catch (...)
+        {
+            // The property can't be read right now.  Leave it out.
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The supported key forms are @c formAbsolutePosition (integers and the @c kAEFirst,
+    @c kAEMiddle, @c kAELast and @c kAEAll ordinals), @c formName and @c formUniqueID.
+    A null container denotes the snapshot's root.
+    
+    This function may be called from any thread.
+    
+    @exception  AENoSuchObjectException If the specifier doesn't match anything.
+    @exception  OSStatusException       If the specifier is malformed or uses an
+                                        unsupported key form.
+*/
+void
+AESnapshot::Resolve(
+    const AEDesc&   inSpecifier,    //!< The object specifier.
+    NodeList&       outNodes)       //!< The output list.  Its previous contents are discarded.
+    const
+{
+    outNodes.clear();
+    
+    if (inSpecifier.descriptorType == typeNull)
+    {
+        outNodes.push_back(mRoot);
+        return;
+    }
+    
+    AEDescriptor    record, container, keyData;
+    DescType        desiredClass, keyForm;
+    OSStatus        err;
+    
+    err = AECoerceDesc(&inSpecifier, typeAERecord, record);
+    B_THROW_IF_STATUS(err);
+    
+    err = AEGetKeyDesc(record, keyAEContainer, typeWildCard, container);
+    B_THROW_IF_STATUS(err);
+    
+    err = AEGetKeyDesc(record, keyAEKeyData, typeWildCard, keyData);
+    B_THROW_IF_STATUS(err);
+    
+    DescParamHelper::ReadKey<typeType>(record, keyAEDesiredClass, desiredClass);
+    DescParamHelper::ReadKey<typeEnumerated>(record, keyAEKeyForm, keyForm);
+    
+    NodeList    containers;
+    
+    Resolve(container, containers);
+    ResolveKey(containers, desiredClass, keyForm, keyData, outNodes);
+    
+    B_THROW_IF(outNodes.empty(), AENoSuchObjectException());
+}
+
+// ------------------------------------------------------------------------------------------
+void
+AESnapshot::ResolveKey(
+    const NodeList& inContainers,
+    DescType        inDesiredClass,
+    DescType        inKeyForm,
+    const AEDesc&   inKeyData,
+    NodeList&       outNodes) const
+{
+    for (NodeList::const_iterator it = inContainers.begin(); it != inContainers.end(); ++it)
+    {
+        const NodeList& elements    = (*it)->GetElements(inDesiredClass);
+        NodePtr         element;
+        
+        switch (inKeyForm)
+        {
+        case formAbsolutePosition:
+            if (inKeyData.descriptorType == typeAbsoluteOrdinal)
+            {
+                DescType    ordinal;
+                
+                DescParamHelper::GetCoercedData(inKeyData, typeAbsoluteOrdinal, 
+                                                &ordinal, sizeof(ordinal));
+                
+                if (elements.empty())
+                    break;
+                
+                switch (ordinal)
+                {
+                case kAEFirst:  element = elements.front();                     break;
+                case kAEMiddle: element = elements[(elements.size() - 1) / 2];  break;
+                case kAELast:   element = elements.back();                      break;
+                case kAEAll:
+                    outNodes.insert(outNodes.end(), elements.begin(), elements.end());
+                    break;
+                default:
+                    B_THROW_STATUS(errAEBadKeyForm);
+                    break;
+                }
+            }
+            else
+            {
+                SInt32  index;
+                
+                DescParam<typeSInt32>::Get(inKeyData, index);
+                
+                // AppleScript indices are one-based;  negative indices count from the end.
+                
+                if (index < 0)
+                    index += static_cast<SInt32>(elements.size()) + 1;
+                
+                if (index > 0)
+                    element = (*it)->GetElementByIndex(inDesiredClass, index - 1);
+            }
+            break;
+        
+        case formName:
+            {
+                String  name;
+                
+                DescParam<typeUTF16ExternalRepresentation>::Get(inKeyData, name);
+                element = (*it)->GetElementByName(inDesiredClass, name);
+            }
+            break;
+        
+        case formUniqueID:
+            {
+                SInt32  uniqueID;
+                
+                DescParam<typeSInt32>::Get(inKeyData, uniqueID);
+                element = (*it)->GetElementByUniqueID(inDesiredClass, uniqueID);
+            }
+            break;
+        
+        default:
+            B_THROW_STATUS(errAEBadKeyForm);
+            break;
+        }
+        
+        if (element != NULL)
+            outNodes.push_back(element);
+    }
+}
+
+
+// ==========================================================================================
+//  AESnapshotSource
+
+#pragma mark -
+#pragma mark AESnapshotSource
+
+// ------------------------------------------------------------------------------------------
+AESnapshotSource::AESnapshotSource(
+    ConstAEObjectPtr    inObject)   //!< The object to capture.
+        : mObject(inObject), mVersion(1)
+{
+    B_ASSERT(mObject != NULL);
+}
+
+// ------------------------------------------------------------------------------------------
+AESnapshotSource::~AESnapshotSource()
+{
+    // The object can outlast us, so tear down our connections to its signals.
+    
+    std::for_each(mConnections.begin(), mConnections.end(),
+                  boost::bind(&Connection::disconnect, _1));
+}
+
+// ------------------------------------------------------------------------------------------
+void
+AESnapshotSource::Invalidate()
+{
+    boost::mutex::scoped_lock   lock(mMutex);
+    
+    ++mVersion;
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The snapshot is taken outside of the lock, so reader threads aren't held up while
+    the object model is walked.
+*/
+AESnapshot::SnapshotPtr
+AESnapshotSource::Update()
+{
+    UInt32  version;
+    
+    {
+        boost::mutex::scoped_lock   lock(mMutex);
+        
+        if ((mSnapshot != NULL) && (mSnapshot->GetVersion() == mVersion))
+            return (mSnapshot);
+        
+        version = mVersion;
+    }
+    
+    AESnapshot::SnapshotPtr snapshot    = AESnapshot::Take(mObject, version);
+    
+    {
+        boost::mutex::scoped_lock   lock(mMutex);
+        
+        mSnapshot = snapshot;
+    }
+    
+    return (snapshot);
+}
+
+// ------------------------------------------------------------------------------------------
+AESnapshot::SnapshotPtr
+AESnapshotSource::GetSnapshot() const
+{
+    boost::mutex::scoped_lock   lock(mMutex);
+    
+    return (mSnapshot);
+}
+
+// ------------------------------------------------------------------------------------------
+UInt32
+AESnapshotSource::GetVersion() const
+{
+    boost::mutex::scoped_lock   lock(mMutex);
+    
+    return (mVersion);
+}
+
+// ------------------------------------------------------------------------------------------
+bool
+AESnapshotSource::IsCurrent(
+    const AESnapshot&   inSnapshot) //!< The snapshot to check.
+    const
+{
+    return (inSnapshot.GetVersion() == GetVersion());
+}
+
+}   // namespace B
@@ -0,0 +1,335 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BAESnapshot_H_
+#define BAESnapshot_H_
+
+#pragma once
+
+// standard headers
+#include <map>
+#include <vector>
+
+// system headers
+#include <ApplicationServices/ApplicationServices.h>
+
+// library headers
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/signal.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/utility.hpp>
+
+// B headers
+#include "BAEDescriptor.h"
+#include "BFwd.h"
+#include "BString.h"
+
+
+namespace B {
+
+// ==========================================================================================
+//  AESnapshot
+
+#pragma mark AESnapshot
+
+/*!
+    @brief  An immutable copy of part of the Apple %Event object model.
+    
+    All access to AEObjects has to happen on the main thread, because that's where the
+    objects are being modified.  This is a problem for code that needs to walk large
+    object hierarchies, such as reporting or indexing tools, since it blocks the user
+    interface for the duration of the walk.
+    
+    AESnapshot addresses this by capturing, on the main thread, an AEObject and its
+    elements (recursively), along with the values of their readable properties.  The
+    result is a tree of immutable nodes which may then be examined from any number of
+    threads concurrently, while the live object model carries on changing.
+    
+    Nodes support the same kinds of queries as AEObject:  counting elements, retrieving
+    elements by index, name or unique id, and reading property values.  Additionally,
+    Resolve() evaluates an object specifier against the snapshot, and Count() and
+    Select() apply an arbitrary predicate to a node's elements.
+    
+    @note   Property values are kept as Apple %Event descriptors.  Reader threads may
+            duplicate and coerce them, but must never modify them.
+    
+    @sa         AESnapshotSource
+    @ingroup    AppleEvents
+*/
+class AESnapshot : public boost::noncopyable
+{
+public:
+    
+    //! @name Types
+    //@{
+    class   Node;
+    //! Smart pointer to a node.
+    typedef boost::shared_ptr<const Node>       NodePtr;
+    //! A sequence of nodes.
+    typedef std::vector<NodePtr>                NodeList;
+    //! Smart pointer to a snapshot.
+    typedef boost::shared_ptr<const AESnapshot> SnapshotPtr;
+    //@}
+    
+    /*! @brief  The immutable image of a single AEObject.
+        
+        All member functions may be called from any thread.
+    */
+    class Node : public boost::noncopyable
+    {
+    public:
+        
+        //! @name Inquiries
+        //@{
+        //! Returns the object's class ID.
+        DescType        GetClassID() const      { return (mClassID); }
+        //! Returns the object's name.  Empty if the object doesn't have one.
+        const String&   GetName() const         { return (mName); }
+        //! Returns the object's unique id.  Zero if the object doesn't have one.
+        SInt32          GetUniqueID() const     { return (mUniqueID); }
+        //! Returns true if the object's class is or derives from @a inBaseClassID.
+        bool            InheritsFrom(DescType inBaseClassID) const;
+        //@}
+        
+        //! @name Properties
+        //@{
+        //! Returns the value of the given property, or @c NULL if it wasn't captured.
+        const AEDesc*   FindProperty(DescType inPropertyID) const;
+        //! Copies the value of the given property into @a outValue.
+        void            GetProperty(DescType inPropertyID, AEDesc& outValue) const;
+        //@}
+        
+        //! @name Elements
+        //@{
+        //! Returns the number of elements of the given class.
+        size_t          CountElements(DescType inElementType) const;
+        //! Returns all of the elements of the given class.
+        const NodeList& GetElements(DescType inElementType) const;
+        //! Returns the element of the given class with the given (zero-based) index.
+        NodePtr         GetElementByIndex(DescType inElementType, size_t inIndex) const;
+        //! Returns the element of the given class with the given name, if any.
+        NodePtr         GetElementByName(DescType inElementType, const String& inName) const;
+        //! Returns the element of the given class with the given unique id, if any.
+        NodePtr         GetElementByUniqueID(DescType inElementType, SInt32 inUniqueID) const;
+        //! Returns the number of elements of the given class that satisfy @a inPredicate.
+        template <class PREDICATE>
+        size_t          Count(DescType inElementType, PREDICATE inPredicate) const;
+        //! Appends to @a outNodes the elements of the given class that satisfy @a inPredicate.
+        template <class PREDICATE>
+        void            Select(DescType inElementType, PREDICATE inPredicate, NodeList& outNodes) const;
+        //@}
+    
+    private:
+        
+        // types
+        typedef std::map<DescType, AEDescriptor>    PropertyMap;
+        typedef std::map<DescType, NodeList>        ElementMap;
+        
+        // constructor
+        explicit    Node(DescType inClassID);
+        
+        // member variables
+        const DescType  mClassID;
+        String          mName;
+        SInt32          mUniqueID;
+        PropertyMap     mProperties;
+        ElementMap      mElements;
+        
+        // friends
+        friend class    AESnapshot;
+    };
+    
+    //! @name Instantiation
+    //@{
+    //! Captures @a inRoot and its elements.  Must be called from the main thread.
+    static SnapshotPtr  Take(ConstAEObjectPtr inRoot, UInt32 inVersion = 0);
+    //@}
+    
+    //! @name Inquiries
+    //@{
+    //! Returns the node for the object passed to Take().
+    NodePtr     GetRoot() const     { return (mRoot); }
+    //! Returns the version number passed to Take().
+    UInt32      GetVersion() const  { return (mVersion); }
+    //! Returns the number of nodes in the snapshot.
+    size_t      size() const        { return (mNodeCount); }
+    //@}
+    
+    //! @name Object Resolution
+    //@{
+    //! Evaluates the object specifier @a inSpecifier against the snapshot.
+    void        Resolve(const AEDesc& inSpecifier, NodeList& outNodes) const;
+    //@}
+
+private:
+    
+    // types
+    typedef std::map<ConstAEObjectPtr, boost::shared_ptr<Node> >    CaptureMap;
+    
+    // constructor
+    AESnapshot(UInt32 inVersion);
+    
+    boost::shared_ptr<Node>
+                Capture(ConstAEObjectPtr inObject, CaptureMap& ioCaptured);
+    static void CaptureProperties(const AEObject& inObject, Node& ioNode);
+    void        ResolveKey(
+                    const NodeList& inContainers,
+                    DescType        inDesiredClass,
+                    DescType        inKeyForm,
+                    const AEDesc&   inKeyData,
+                    NodeList&       outNodes) const;
+    
+    // member variables
+    const UInt32    mVersion;
+    NodePtr         mRoot;
+    size_t          mNodeCount;
+};
+
+// ------------------------------------------------------------------------------------------
+/*! @a PREDICATE must be callable with a <tt>const AESnapshot::Node&</tt> and return a
+    value convertible to @c bool.
+*/
+template <class PREDICATE> size_t
+AESnapshot::Node::Count(
+    DescType    inElementType,  //!< The base class ID of the elements.
+    PREDICATE   inPredicate)    //!< The predicate to apply to each element.
+    const
+{
+    const NodeList& elements    = GetElements(inElementType);
+    size_t          count       = 0;
+    
+    for (NodeList::const_iterator it = elements.begin(); it != elements.end(); ++it)
+    {
+        if (inPredicate(**it))
+            ++count;
+    }
+    
+    return (count);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @a PREDICATE must be callable with a <tt>const AESnapshot::Node&</tt> and return a
+    value convertible to @c bool.
+*/
+template <class PREDICATE> void
+AESnapshot::Node::Select(
+    DescType    inElementType,  //!< The base class ID of the elements.
+    PREDICATE   inPredicate,    //!< The predicate to apply to each element.
+    NodeList&   outNodes)       //!< The output list;  matching elements are appended to it.
+    const
+{
+    const NodeList& elements    = GetElements(inElementType);
+    
+    for (NodeList::const_iterator it = elements.begin(); it != elements.end(); ++it)
+    {
+        if (inPredicate(**it))
+            outNodes.push_back(*it);
+    }
+}
+
+
+// ==========================================================================================
+//  AESnapshotSource
+
+#pragma mark -
+#pragma mark AESnapshotSource
+
+/*!
+    @brief  Hands out up-to-date snapshots of an AEObject to reader threads.
+    
+    An AESnapshotSource maintains a version number for its object.  Whenever the object's
+    contents change, Invalidate() should be called to bump the version;  this is most
+    easily done by connecting the source to the relevant signals with InvalidateOn(), eg:
+    
+    @code
+        mSnapshotSource.InvalidateOn(doc->GetContentChangedSignal());
+        mSnapshotSource.InvalidateOn(doc->GetDirtyStateChangedSignal());
+    @endcode
+    
+    Update() (main thread only) takes a new snapshot if the current one is stale.
+    Reader threads call GetSnapshot() to obtain the most recent snapshot, and IsCurrent()
+    to find out whether it has been superseded in the mean time.
+    
+    @sa         AESnapshot
+    @ingroup    AppleEvents
+*/
+class AESnapshotSource : public boost::noncopyable
+{
+public:
+    
+    //! @name Constructor & Destructor
+    //@{
+    //! Constructor.
+    explicit    AESnapshotSource(ConstAEObjectPtr inObject);
+    //! Destructor.
+                ~AESnapshotSource();
+    //@}
+    
+    //! @name Main Thread Functions
+    //@{
+    //! Marks the current snapshot as being out of date.
+    void        Invalidate();
+    //! Calls Invalidate() whenever @a ioSignal is emitted.
+    template <class SIGNAL>
+    void        InvalidateOn(SIGNAL& ioSignal);
+    //! Takes a new snapshot if the current one is out of date, and returns it.
+    AESnapshot::SnapshotPtr
+                Update();
+    //@}
+    
+    //! @name Reader Thread Functions
+    //@{
+    //! Returns the most recent snapshot.  May be @c NULL if Update() hasn't been called.
+    AESnapshot::SnapshotPtr
+                GetSnapshot() const;
+    //! Returns the current version number.
+    UInt32      GetVersion() const;
+    //! Returns true if @a inSnapshot reflects the current state of the object.
+    bool        IsCurrent(const AESnapshot& inSnapshot) const;
+    //@}
+
+private:
+    
+    // types
+    typedef boost::signals::connection  Connection;
+    
+    // member variables
+    const ConstAEObjectPtr      mObject;
+    mutable boost::mutex        mMutex;
+    AESnapshot::SnapshotPtr     mSnapshot;
+    UInt32                      mVersion;
+    std::vector<Connection>     mConnections;
+};
+
+// ------------------------------------------------------------------------------------------
+/*! @a SIGNAL may be any @c boost::signal type;  the signal's arguments are ignored.
+    The connection is torn down when the source is destroyed.
+*/
+template <class SIGNAL> void
+AESnapshotSource::InvalidateOn(
+    SIGNAL& ioSignal)   //!< The signal to connect to.
+{
+    mConnections.push_back(ioSignal.connect(boost::bind(&AESnapshotSource::Invalidate, this)));
+}
+
+
+}   // namespace B
+
+
+#endif  // BAESnapshot_H_
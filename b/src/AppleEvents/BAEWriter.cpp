@@ -78,6 +78,7 @@ AEWriter::~AEWriter()
     if ((mStream != NULL) && mOwned)
     {
         err = AEStreamClose(mStream, NULL);
+        AllocationAccounting::Deallocated(AllocationAccounting::kAEWriter);
     }
 }
 
@@ -92,6 +93,7 @@ AEWriter::Open()
     
     mStream = AEStreamOpen();
     B_THROW_IF_NULL(mStream);
+    AllocationAccounting::Allocated(AllocationAccounting::kAEWriter);
     
     mOwned = true;
 }
@@ -115,6 +117,7 @@ AEWriter::Open(
                                   typeProcessSerialNumber, &psn, sizeof(psn), 
                                   returnID, transactionID);
     B_THROW_IF_NULL(mStream);
+    AllocationAccounting::Allocated(AllocationAccounting::kAEWriter);
     
     mOwned = true;
 }
@@ -131,6 +134,7 @@ AEWriter::Open(
     
     mStream = AEStreamOpenEvent(&event);
     B_THROW_IF_NULL(mStream);
+    AllocationAccounting::Allocated(AllocationAccounting::kAEWriter);
     
     mOwned = true;
 }
@@ -147,6 +151,7 @@ AEWriter::Close(
     
     err = AEStreamClose(mStream, &outDesc);
     B_THROW_IF_STATUS(err);
+    AllocationAccounting::Deallocated(AllocationAccounting::kAEWriter);
     
     mStream = NULL;
     mOwned  = false;
@@ -182,6 +187,7 @@ AEWriter::Close()
     
     err = AEStreamClose(mStream, NULL);
     // ignore the error
+    AllocationAccounting::Deallocated(AllocationAccounting::kAEWriter);
     
     mStream = NULL;
     mOwned  = false;
@@ -30,6 +30,7 @@
 
 // B headers
 #include "BAEDescParam.h"
+#include "BAllocationAccounting.h"
 
 
 namespace B {
@@ -273,6 +274,7 @@ AEWriter::Open(
                                   target.Type(), target.Data(), target.Size(), 
                                   returnID, transactionID);
     B_THROW_IF_NULL(mStream);
+    AllocationAccounting::Allocated(AllocationAccounting::kAEWriter);
     
     mOwned = true;
 }
@@ -0,0 +1,351 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BCommandTable_H_
+#define BCommandTable_H_
+
+#pragma once
+
+// standard headers
+#include <algorithm>
+#include <vector>
+
+// system headers
+#include <Carbon/Carbon.h>
+
+// library headers
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/signals/trackable.hpp>
+#include <boost/utility.hpp>
+
+// B headers
+#include "BCommandData.h"
+
+
+namespace B {
+
+// forward declarations
+template <class T> class    CommandTable;
+
+
+// ==========================================================================================
+//  CommandStatusCache
+
+#pragma mark CommandStatusCache
+
+/*!
+    @brief  Remembers the enabled state of the commands in a CommandTable.
+    
+    Each responder that uses a CommandTable may own a CommandStatusCache.  The first
+    status request after the cache has been invalidated computes the state of every
+    command in the table in one pass;  subsequent requests (eg for the other items of
+    the menu being opened) are simple lookups.
+    
+    The owner is responsible for invalidating the cache whenever the state on which
+    its commands' enabling depends changes.  This is most easily done by connecting the
+    cache to the relevant signals with InvalidateOn(), eg:
+    
+    @code
+        mCommandCache.InvalidateOn(GetDirtyStateChangedSignal());
+    @endcode
+    
+    @sa         CommandTable
+    @ingroup    CarbonEvents
+*/
+class CommandStatusCache : public boost::signals::trackable, public boost::noncopyable
+{
+public:
+    
+    //! @name Constructor
+    //@{
+    //! Constructor.  The cache starts out invalid.
+                CommandStatusCache() : mValid(false) {}
+    //@}
+    
+    //! @name Invalidation
+    //@{
+    //! Marks the cached state as being out of date.
+    void        Invalidate()        { mValid = false; }
+    //! Calls Invalidate() whenever @a ioSignal is emitted.
+    template <class SIGNAL>
+    void        InvalidateOn(SIGNAL& ioSignal);
+    //@}
+    
+    //! @name Inquiries
+    //@{
+    //! Returns @c true if the cached state is up to date.
+    bool        IsValid() const     { return (mValid); }
+    //@}
+
+private:
+    
+    // member variables
+    std::vector<bool>   mEnabled;   //!< Parallel to the table's entries.
+    bool                mValid;
+    
+    // friends
+    template <class T> friend class CommandTable;
+};
+
+// ------------------------------------------------------------------------------------------
+/*! @a SIGNAL may be any @c boost::signal type;  the signal's arguments are ignored.
+    The connection is torn down when the cache is destroyed.
+*/
+template <class SIGNAL> void
+CommandStatusCache::InvalidateOn(
+    SIGNAL& ioSignal)   //!< The signal to connect to.
+{
+    ioSignal.connect(boost::bind(&CommandStatusCache::Invalidate, this));
+}
+
+
+// ==========================================================================================
+//  CommandTable
+
+#pragma mark -
+#pragma mark CommandTable
+
+/*!
+    @brief  Maps command IDs onto the member functions of a responder class.
+    
+    A CommandTable replaces the @c switch statements traditionally found in
+    @c HandleCommand() and @c HandleUpdateStatus() with a declarative table.  Each
+    entry associates a command ID with a function that performs the command, and
+    optionally a predicate that tells whether the command is enabled.  The table is
+    usually built once per responder class, eg:
+    
+    @code
+        static CommandTable<MyDoc>  sTable;
+        
+        if (sTable.empty())
+        {
+            sTable.Add(kMyCommand,  boost::bind(&MyDoc::DoIt, _1),
+                                    boost::bind(&MyDoc::CanDoIt, _1))
+                  .Add(kHICommandNew, boost::bind(&MyDoc::New, _1));
+        }
+    @endcode
+    
+    Commands without a predicate are always enabled.  Entries without a process
+    function only take part in status updates.
+    
+    Lookups are binary searches in a sorted, contiguous table.  Status updates may be
+    served from a CommandStatusCache, in which case the state of every command in the
+    table is computed in one batched pass the first time any of them is requested.
+    
+    @param  T   The responder class.
+    
+    @sa         CommandStatusCache
+    @ingroup    CarbonEvents
+*/
+template <class T>
+class CommandTable : public boost::noncopyable
+{
+public:
+    
+    //! @name Types
+    //@{
+    //! Performs a command.
+    typedef boost::function2<void, T&, const HICommandExtended&>    ProcessFunction;
+    //! Returns @c true if a command is enabled.
+    typedef boost::function1<bool, const T&>                        EnableFunction;
+    //@}
+    
+    //! @name Building the Table
+    //@{
+    //! Associates @a inCommandID with @a inProcess and @a inEnable.  Returns the table, for chaining.
+    CommandTable&   Add(
+                        UInt32          inCommandID,
+                        ProcessFunction inProcess,
+                        EnableFunction  inEnable = EnableFunction());
+    //@}
+    
+    //! @name Inquiries
+    //@{
+    //! Returns @c true if the table has no entries.
+    bool    empty() const   { return (mEntries.empty()); }
+    //! Returns the number of entries.
+    size_t  size() const    { return (mEntries.size()); }
+    //! Returns @c true if the table has an entry for @a inCommandID.
+    bool    Contains(UInt32 inCommandID) const;
+    //@}
+    
+    //! @name Dispatching
+    //@{
+    //! Performs @a inHICommand on @a ioResponder.  Returns @c false if the command isn't handled.
+    bool    Process(
+                T&                          ioResponder,
+                const HICommandExtended&    inHICommand) const;
+    //! Computes the status of @a inHICommand for @a inResponder.  Returns @c false if the command isn't handled.
+    bool    UpdateStatus(
+                const T&                    inResponder,
+                const HICommandExtended&    inHICommand,
+                CommandData&                ioCmdData,
+                CommandStatusCache*         ioCache = NULL) const;
+    //! Computes the status of every command for @a inResponder, and stores it into @a ioCache.
+    void    Refresh(
+                const T&                    inResponder,
+                CommandStatusCache&         ioCache) const;
+    //@}
+
+private:
+    
+    struct Entry
+    {
+        UInt32          mCommandID;
+        ProcessFunction mProcess;
+        EnableFunction  mEnable;
+    };
+    
+    struct EntryLess
+    {
+        bool    operator () (const Entry& e, UInt32 id) const   { return (e.mCommandID < id); }
+        bool    operator () (UInt32 id, const Entry& e) const   { return (id < e.mCommandID); }
+        bool    operator () (const Entry& e1, const Entry& e2) const
+                                        { return (e1.mCommandID < e2.mCommandID); }
+    };
+    
+    typedef std::vector<Entry>  EntryVector;
+    
+    const Entry*    Find(UInt32 inCommandID) const;
+    
+    // member variables
+    EntryVector mEntries;   //!< Sorted by command ID.
+};
+
+// ------------------------------------------------------------------------------------------
+/*! If the table already contains an entry for @a inCommandID, it is replaced.
+*/
+template <class T> CommandTable<T>&
+CommandTable<T>::Add(
+    UInt32          inCommandID,    //!< The command ID.
+    ProcessFunction inProcess,      //!< Performs the command.  May be empty.
+    EnableFunction  inEnable)       //!< Returns the command's enabled state.  If empty, the command is always enabled.
+{
+    typename EntryVector::iterator  it;
+    
+    it = std::lower_bound(mEntries.begin(), mEntries.end(), inCommandID, EntryLess());
+    
+    if ((it == mEntries.end()) || (it->mCommandID != inCommandID))
+        it = mEntries.insert(it, Entry());
+    
+    it->mCommandID  = inCommandID;
+    it->mProcess    = inProcess;
+    it->mEnable     = inEnable;
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+template <class T> inline const typename CommandTable<T>::Entry*
+CommandTable<T>::Find(
+    UInt32  inCommandID) const
+{
+    typename EntryVector::const_iterator    it;
+    
+    it = std::lower_bound(mEntries.begin(), mEntries.end(), inCommandID, EntryLess());
+    
+    if ((it == mEntries.end()) || (it->mCommandID != inCommandID))
+        return (NULL);
+    
+    return (&*it);
+}
+
+// ------------------------------------------------------------------------------------------
+template <class T> inline bool
+CommandTable<T>::Contains(
+    UInt32  inCommandID) const
+{
+    return (Find(inCommandID) != NULL);
+}
+
+// ------------------------------------------------------------------------------------------
+template <class T> bool
+CommandTable<T>::Process(
+    T&                          ioResponder,    //!< The object performing the command.
+    const HICommandExtended&    inHICommand)    //!< The command.
+    const
+{
+    const Entry*    entry   = Find(inHICommand.commandID);
+    
+    if ((entry == NULL) || entry->mProcess.empty())
+        return (false);
+    
+    entry->mProcess(ioResponder, inHICommand);
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! If @a ioCache is given and is out of date, it is refreshed first.
+*/
+template <class T> bool
+CommandTable<T>::UpdateStatus(
+    const T&                    inResponder,    //!< The object whose state determines the command's status.
+    const HICommandExtended&    inHICommand,    //!< The command.
+    CommandData&                ioCmdData,      //!< The command's status.
+    CommandStatusCache*         ioCache)        //!< The responder's cache.  May be @c NULL.
+    const
+{
+    const Entry*    entry   = Find(inHICommand.commandID);
+    
+    if (entry == NULL)
+        return (false);
+    
+    if (entry->mEnable.empty())
+    {
+        ioCmdData.SetEnabled(true);
+    }
+    else if (ioCache != NULL)
+    {
+        if (!ioCache->mValid || (ioCache->mEnabled.size() != mEntries.size()))
+            Refresh(inResponder, *ioCache);
+        
+        ioCmdData.SetEnabled(ioCache->mEnabled[entry - &mEntries[0]]);
+    }
+    else
+    {
+        ioCmdData.SetEnabled(entry->mEnable(inResponder));
+    }
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+template <class T> void
+CommandTable<T>::Refresh(
+    const T&                    inResponder,    //!< The object whose state determines the commands' status.
+    CommandStatusCache&         ioCache)        //!< The responder's cache.
+    const
+{
+    ioCache.mEnabled.resize(mEntries.size());
+    
+    for (size_t i = 0; i < mEntries.size(); i++)
+    {
+        const Entry&    entry   = mEntries[i];
+        
+        ioCache.mEnabled[i] = entry.mEnable.empty() || entry.mEnable(inResponder);
+    }
+    
+    ioCache.mValid = true;
+}
+
+}   // namespace B
+
+
+#endif  // BCommandTable_H_
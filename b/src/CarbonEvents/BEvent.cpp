@@ -21,6 +21,7 @@
 
 // standard headers
 #include <sstream>
+#include <string>
 
 // B headers
 #include "BAbstractDocument.h"
@@ -29,6 +30,270 @@
 #include "BWindowUtils.h"
 
 
+namespace {
+
+// Parameter blocks for high-frequency events.  See B::EventParamDescriptor.  Each 
+// descriptor table comes with a table giving, for each descriptor, the B::EventArgs flag 
+// that selects it, or kAlwaysFetched.
+
+const UInt32    kAlwaysFetched  = 0;
+
+// ------------------------------------------------------------------------------------------
+//  kEventMouseDown, kEventMouseUp
+
+struct MouseButtonParams
+{
+    ::HIPoint           mMouseLocation;
+    UInt32              mKeyModifiers;
+    EventMouseButton    mMouseButton;
+    UInt32              mClickCount;
+    UInt32              mMouseChord;
+    WindowRef           mWindowRef;
+    ::HIPoint           mWindowMouseLocation;
+};
+
+const B::EventParamDescriptor   kMouseButtonParams[] = {
+    B_EVENT_PARAM(MouseButtonParams, mMouseLocation,        kEventParamMouseLocation,       true), 
+    B_EVENT_PARAM(MouseButtonParams, mKeyModifiers,         kEventParamKeyModifiers,        true), 
+    B_EVENT_PARAM(MouseButtonParams, mMouseButton,          kEventParamMouseButton,         true), 
+    B_EVENT_PARAM(MouseButtonParams, mClickCount,           kEventParamClickCount,          true), 
+    B_EVENT_PARAM(MouseButtonParams, mMouseChord,           kEventParamMouseChord,          true), 
+    B_EVENT_PARAM(MouseButtonParams, mWindowRef,            kEventParamWindowRef,           false), 
+    B_EVENT_PARAM(MouseButtonParams, mWindowMouseLocation,  kEventParamWindowMouseLocation, false), 
+};
+
+const UInt32    kMouseButtonArgs[] = {
+    B::kEventArgMouseLocation, 
+    B::kEventArgKeyModifiers, 
+    B::kEventArgMouseButton, 
+    B::kEventArgMouseButton, 
+    B::kEventArgMouseButton, 
+    B::kEventArgMouseLocation, 
+    B::kEventArgMouseLocation, 
+};
+
+enum { kMouseButtonWindowRef = 5, kMouseButtonWindowMouseLocation = 6 };
+
+// ------------------------------------------------------------------------------------------
+//  kEventMouseMoved, kEventMouseDragged
+
+struct MouseMotionParams
+{
+    ::HIPoint           mMouseLocation;
+    UInt32              mKeyModifiers;
+    ::Point             mMouseDelta;
+    WindowRef           mWindowRef;
+    ::HIPoint           mWindowMouseLocation;
+};
+
+const B::EventParamDescriptor   kMouseMotionParams[] = {
+    B_EVENT_PARAM(MouseMotionParams, mMouseLocation,        kEventParamMouseLocation,       true), 
+    B_EVENT_PARAM(MouseMotionParams, mKeyModifiers,         kEventParamKeyModifiers,        true), 
+    B_EVENT_PARAM(MouseMotionParams, mMouseDelta,           kEventParamMouseDelta,          true), 
+    B_EVENT_PARAM(MouseMotionParams, mWindowRef,            kEventParamWindowRef,           false), 
+    B_EVENT_PARAM(MouseMotionParams, mWindowMouseLocation,  kEventParamWindowMouseLocation, false), 
+};
+
+const UInt32    kMouseMotionArgs[] = {
+    B::kEventArgMouseLocation, 
+    B::kEventArgKeyModifiers, 
+    B::kEventArgMouseDelta, 
+    B::kEventArgMouseLocation, 
+    B::kEventArgMouseLocation, 
+};
+
+enum { kMouseMotionWindowRef = 3, kMouseMotionWindowMouseLocation = 4 };
+
+// ------------------------------------------------------------------------------------------
+//  kEventMouseWheelMoved
+
+struct MouseWheelParams
+{
+    ::HIPoint           mMouseLocation;
+    WindowRef           mWindowRef;
+    ::HIPoint           mWindowMouseLocation;
+    UInt32              mKeyModifiers;
+    EventMouseWheelAxis mMouseWheelAxis;
+    SInt32              mMouseWheelDelta;
+};
+
+const B::EventParamDescriptor   kMouseWheelParams[] = {
+    B_EVENT_PARAM(MouseWheelParams, mMouseLocation,         kEventParamMouseLocation,       true), 
+    B_EVENT_PARAM(MouseWheelParams, mWindowRef,             kEventParamWindowRef,           true), 
+    B_EVENT_PARAM(MouseWheelParams, mWindowMouseLocation,   kEventParamWindowMouseLocation, true), 
+    B_EVENT_PARAM(MouseWheelParams, mKeyModifiers,          kEventParamKeyModifiers,        true), 
+    B_EVENT_PARAM(MouseWheelParams, mMouseWheelAxis,        kEventParamMouseWheelAxis,      true), 
+    B_EVENT_PARAM(MouseWheelParams, mMouseWheelDelta,       kEventParamMouseWheelDelta,     true), 
+};
+
+const UInt32    kMouseWheelArgs[] = {
+    B::kEventArgMouseLocation, 
+    B::kEventArgMouseLocation, 
+    B::kEventArgMouseLocation, 
+    B::kEventArgKeyModifiers, 
+    B::kEventArgMouseWheel, 
+    B::kEventArgMouseWheel, 
+};
+
+// ------------------------------------------------------------------------------------------
+//  kEventControlTrack
+
+struct ControlTrackParams
+{
+    HIViewRef           mViewRef;
+    ::HIPoint           mMouseLocation;
+    UInt32              mKeyModifiers;
+};
+
+const B::EventParamDescriptor   kControlTrackParams[] = {
+    B_EVENT_PARAM_AND_TYPE(ControlTrackParams, mViewRef, kEventParamDirectObject, typeControlRef, true), 
+    B_EVENT_PARAM(ControlTrackParams, mMouseLocation,       kEventParamMouseLocation,       true), 
+    B_EVENT_PARAM(ControlTrackParams, mKeyModifiers,        kEventParamKeyModifiers,        true), 
+};
+
+// The key modifiers are written back by Update(), so they're always needed.
+const UInt32    kControlTrackArgs[] = {
+    kAlwaysFetched, 
+    B::kEventArgMouseLocation, 
+    kAlwaysFetched, 
+};
+
+// ------------------------------------------------------------------------------------------
+//  kEventControlBoundsChanged
+
+struct BoundsChangedParams
+{
+    HIViewRef           mViewRef;
+    UInt32              mAttributes;
+    ::Rect              mOriginalBounds;
+    ::Rect              mPreviousBounds;
+    ::Rect              mCurrentBounds;
+};
+
+const B::EventParamDescriptor   kBoundsChangedParams[] = {
+    B_EVENT_PARAM_AND_TYPE(BoundsChangedParams, mViewRef, kEventParamDirectObject, typeControlRef, true), 
+    B_EVENT_PARAM(BoundsChangedParams, mAttributes,         kEventParamAttributes,          true), 
+    B_EVENT_PARAM(BoundsChangedParams, mOriginalBounds,     kEventParamOriginalBounds,      true), 
+    B_EVENT_PARAM(BoundsChangedParams, mPreviousBounds,     kEventParamPreviousBounds,      true), 
+    B_EVENT_PARAM(BoundsChangedParams, mCurrentBounds,      kEventParamCurrentBounds,       true), 
+};
+
+const UInt32    kBoundsChangedArgs[] = {
+    kAlwaysFetched, 
+    B::kEventArgAttributes, 
+    B::kEventArgOriginalBounds, 
+    B::kEventArgPreviousBounds, 
+    B::kEventArgCurrentBounds, 
+};
+
+// ------------------------------------------------------------------------------------------
+/*! Converts a combination of B::EventArgs flags into the mask of the descriptors to pass 
+    to B::GetEventParams(), given the flag that selects each descriptor.  Both tables 
+    must have the same length.
+*/
+template <size_t N> UInt32
+SelectParams(
+    const B::EventParamDescriptor   (&)[N], 
+    const UInt32                    (&inDescriptorArgs)[N], 
+    UInt32                          inArgs)
+{
+    UInt32  wanted  = 0;
+    
+    for (size_t i = 0; i < N; i++)
+    {
+        if ((inDescriptorArgs[i] == kAlwaysFetched) || ((inDescriptorArgs[i] & inArgs) != 0))
+            wanted |= (1U << i);
+    }
+    
+    return (wanted);
+}
+
+// ------------------------------------------------------------------------------------------
+inline bool
+IsParamPresent(UInt32 inMask, unsigned inIndex)
+{
+    return ((inMask & (1U << inIndex)) != 0);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Fills in the arguments of the kEventMouseDown and kEventMouseUp events that are 
+    selected by @a inArgs.
+*/
+template <class EVENT> void
+GetMouseButtonParams(EVENT& ioEvent, UInt32 inArgs)
+{
+    MouseButtonParams   params  = MouseButtonParams();
+    UInt32              wanted  = SelectParams(kMouseButtonParams, kMouseButtonArgs, inArgs);
+    UInt32              present = B::GetEventParams(ioEvent, kMouseButtonParams, params, wanted);
+    
+    ioEvent.mGlobalMouseLocation    = params.mMouseLocation;
+    ioEvent.mMouseLocation          = ioEvent.mGlobalMouseLocation;
+    ioEvent.mKeyModifiers           = params.mKeyModifiers;
+    ioEvent.mMouseButton            = params.mMouseButton;
+    ioEvent.mClickCount             = params.mClickCount;
+    ioEvent.mMouseChord             = params.mMouseChord;
+    
+    if (IsParamPresent(present, kMouseButtonWindowRef))
+    {
+        B_THROW_STATUS_IF(!IsParamPresent(present, kMouseButtonWindowMouseLocation), 
+                          eventParameterNotFoundErr);
+        
+        ioEvent.mWindowRef      = params.mWindowRef;
+        ioEvent.mMouseLocation  = params.mWindowMouseLocation;
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Fills in the arguments of the kEventMouseMoved and kEventMouseDragged events that are 
+    selected by @a inArgs.
+*/
+template <class EVENT> void
+GetMouseMotionParams(EVENT& ioEvent, UInt32 inArgs)
+{
+    MouseMotionParams   params  = MouseMotionParams();
+    UInt32              wanted  = SelectParams(kMouseMotionParams, kMouseMotionArgs, inArgs);
+    UInt32              present = B::GetEventParams(ioEvent, kMouseMotionParams, params, wanted);
+    
+    ioEvent.mGlobalMouseLocation    = params.mMouseLocation;
+    ioEvent.mMouseLocation          = ioEvent.mGlobalMouseLocation;
+    ioEvent.mKeyModifiers           = params.mKeyModifiers;
+    ioEvent.mMouseDelta             = params.mMouseDelta;
+    
+    // Unlike the kEventMouseDown and kEventMouseUp events, kEventMouseMoved apparently 
+    // didn't get the kEventParamWindowRef and kEventParamWindowMouseLocation parameters 
+    // until 10.3.  So if they aren't present, compute them ourselves.
+    
+    if (IsParamPresent(present, kMouseMotionWindowRef))
+    {
+        // We got 'em.
+        
+        B_THROW_STATUS_IF(!IsParamPresent(present, kMouseMotionWindowMouseLocation), 
+                          eventParameterNotFoundErr);
+        
+        ioEvent.mWindowRef      = params.mWindowRef;
+        ioEvent.mMouseLocation  = params.mWindowMouseLocation;
+    }
+    else if ((inArgs & B::kEventArgMouseLocation) != 0)
+    {
+        // Need to do some work.
+        
+        ::Point     qdPt    = ioEvent.mGlobalMouseLocation;
+        OSStatus    err;
+        
+        err = FindWindowOfClass(&qdPt, kAllWindowClasses, &ioEvent.mWindowRef, NULL);
+        
+        if ((err == noErr) && (ioEvent.mWindowRef != NULL))
+        {
+            ioEvent.mGlobalMouseLocation = B::ViewUtils::ConvertFromGlobal(
+                                                ioEvent.mGlobalMouseLocation, 
+                                                ioEvent.mWindowRef);
+        }
+    }
+}
+
+}   // anonymous namespace
+
+
 namespace B {
 
 // ==========================================================================================
@@ -85,8 +350,13 @@ EventBase::Send(
     EventTargetRef  inTarget,               //!< The event target to which the event is initially sent.
     OptionBits      inOptions /* = 0 */)    //!< The options to use when sending.
 {
+    DescType    format  = kBExceptionFormatBinary;
     OSStatus    err;
     
+    // Tell the handlers that we can read exceptions in the binary format.
+    
+    SetEventParameter(mEvent, keyBExceptionFormat, typeType, sizeof(format), &format);
+    
     err = SendEventToEventTargetWithOptions(mEvent, inTarget, inOptions);
     
     if (err != noErr)
@@ -328,6 +598,10 @@ EventBase::Retrieve()
 }
 
 // ------------------------------------------------------------------------------------------
+/*! The exception is written in ExceptionStreamer's text format, which any version of B 
+    can read, unless the event's sender has indicated (via the @c keyBExceptionFormat 
+    parameter) that it can read the binary format.
+*/
 OSStatus
 EventBase::StoreExceptionIntoCarbonEvent(
     EventRef                inEvent, 
@@ -339,11 +613,23 @@ EventBase::StoreExceptionIntoCarbonEvent(
     
     try
     {
-        std::ostringstream  ostr;
+        DescType    format;
+        std::string blob;
         
-        ExceptionStreamer::Get()->Externalize(ex, ostr);
-        
-        std::string blob(ostr.str());
+        if ((GetEventParameter(inEvent, keyBExceptionFormat, typeType, NULL, 
+                               sizeof(format), NULL, &format) == noErr) && 
+            (format == kBExceptionFormatBinary))
+        {
+            ExceptionStreamer::Get()->Externalize(ex, blob);
+        }
+        else
+        {
+            std::ostringstream  ostr;
+            
+            ExceptionStreamer::Get()->Externalize(ex, ostr);
+            
+            blob = ostr.str();
+        }
         
         // ignore any errors -- after all, we're already handling an exception.
         
@@ -378,11 +664,8 @@ EventBase::RethrowExceptionFromCarbonEvent(
                                 buffer.size(), NULL, &buffer[0]);
         B_THROW_IF_STATUS(err);
         
-        std::string         str(&buffer[0], buffer.size());
-        std::istringstream  istr(str);
-        
         // If all goes well, this will throw an exception.
-        ExceptionStreamer::Get()->Rethrow(istr);
+        ExceptionStreamer::Get()->Rethrow(&buffer[0], buffer.size());
         
         // If we're here, then something went wrong.  Fall through to the fall-back 
         // behaviour.
@@ -403,21 +686,12 @@ EventBase::RethrowExceptionFromCarbonEvent(
 // ------------------------------------------------------------------------------------------
 Event<kEventClassMouse, kEventMouseDown>::Event(
     EventHandlerCallRef inHandlerCallRef, 
-    EventRef            inEvent)
+    EventRef            inEvent, 
+    UInt32              inArgs /* = kEventArgAll */)
         : EventBase(inHandlerCallRef, inEvent), 
           mWindowRef(NULL)
 {
-    mGlobalMouseLocation    = EventParam<kEventParamMouseLocation>::Get(*this);
-    mMouseLocation          = mGlobalMouseLocation;
-    mKeyModifiers           = EventParam<kEventParamKeyModifiers>::Get(*this);
-    mMouseButton            = EventParam<kEventParamMouseButton>::Get(*this);
-    mClickCount             = EventParam<kEventParamClickCount>::Get(*this);
-    mMouseChord             = EventParam<kEventParamMouseChord>::Get(*this);
-    
-    if (EventParam<kEventParamWindowRef>::Get(*this, mWindowRef, std::nothrow))
-    {
-        mMouseLocation = EventParam<kEventParamWindowMouseLocation>::Get(*this);
-    }
+    GetMouseButtonParams(*this, inArgs);
 }
 
 // ==========================================================================================
@@ -426,21 +700,12 @@ Event<kEventClassMouse, kEventMouseDown>::Event(
 // ------------------------------------------------------------------------------------------
 Event<kEventClassMouse, kEventMouseUp>::Event(
     EventHandlerCallRef inHandlerCallRef, 
-    EventRef            inEvent)
+    EventRef            inEvent, 
+    UInt32              inArgs /* = kEventArgAll */)
         : EventBase(inHandlerCallRef, inEvent), 
           mWindowRef(NULL)
 {
-    mGlobalMouseLocation    = EventParam<kEventParamMouseLocation>::Get(*this);
-    mMouseLocation          = mGlobalMouseLocation;
-    mKeyModifiers           = EventParam<kEventParamKeyModifiers>::Get(*this);
-    mMouseButton            = EventParam<kEventParamMouseButton>::Get(*this);
-    mClickCount             = EventParam<kEventParamClickCount>::Get(*this);
-    mMouseChord             = EventParam<kEventParamMouseChord>::Get(*this);
-    
-    if (EventParam<kEventParamWindowRef>::Get(*this, mWindowRef, std::nothrow))
-    {
-        mMouseLocation = EventParam<kEventParamWindowMouseLocation>::Get(*this);
-    }
+    GetMouseButtonParams(*this, inArgs);
 }
 
 // ==========================================================================================
@@ -449,39 +714,26 @@ Event<kEventClassMouse, kEventMouseUp>::Event(
 // ------------------------------------------------------------------------------------------
 Event<kEventClassMouse, kEventMouseMoved>::Event(
     EventHandlerCallRef inHandlerCallRef, 
-    EventRef            inEvent)
+    EventRef            inEvent, 
+    UInt32              inArgs /* = kEventArgAll */)
         : EventBase(inHandlerCallRef, inEvent), 
           mWindowRef(NULL)
 {
-    mGlobalMouseLocation    = EventParam<kEventParamMouseLocation>::Get(*this);
-    mMouseLocation          = mGlobalMouseLocation;
-    mKeyModifiers           = EventParam<kEventParamKeyModifiers>::Get(*this);
-    mMouseDelta             = EventParam<kEventParamMouseDelta>::Get(*this);
-    
-    // Unlike the kEventMouseDown and kEventMouseUp events, kEventMouseMoved apparently 
-    // didn't get the kEventParamWindowRef and kEventParamWindowMouseLocation parameters 
-    // until 10.3.  So if they aren't present, compute them ourselves.
-    
-    if (EventParam<kEventParamWindowRef>::Get(*this, mWindowRef, std::nothrow))
-    {
-        // We got 'em.
-        mMouseLocation = EventParam<kEventParamWindowMouseLocation>::Get(*this);
-    }
-    else
-    {
-        // Need to do some work.
-        
-        ::Point     qdPt    = mGlobalMouseLocation;
-        OSStatus    err;
-        
-        err = FindWindowOfClass(&qdPt, kAllWindowClasses, &mWindowRef, NULL);
-        
-        if ((err == noErr) && (mWindowRef != NULL))
-        {
-            mGlobalMouseLocation = B::ViewUtils::ConvertFromGlobal(mGlobalMouseLocation, 
-                                                                   mWindowRef);
-        }
-    }
+    GetMouseMotionParams(*this, inArgs);
+}
+
+// ==========================================================================================
+//  Event<kEventClassMouse, kEventMouseDragged>
+
+// ------------------------------------------------------------------------------------------
+Event<kEventClassMouse, kEventMouseDragged>::Event(
+    EventHandlerCallRef inHandlerCallRef, 
+    EventRef            inEvent, 
+    UInt32              inArgs /* = kEventArgAll */)
+        : EventBase(inHandlerCallRef, inEvent), 
+          mWindowRef(NULL)
+{
+    GetMouseMotionParams(*this, inArgs);
 }
 
 // ==========================================================================================
@@ -490,15 +742,21 @@ Event<kEventClassMouse, kEventMouseMoved>::Event(
 // ------------------------------------------------------------------------------------------
 Event<kEventClassMouse, kEventMouseWheelMoved>::Event(
     EventHandlerCallRef inHandlerCallRef, 
-    EventRef            inEvent)
+    EventRef            inEvent, 
+    UInt32              inArgs /* = kEventArgAll */)
         : EventBase(inHandlerCallRef, inEvent)
 {
-    mGlobalMouseLocation    = EventParam<kEventParamMouseLocation>::Get(*this);
-    mWindowRef              = EventParam<kEventParamWindowRef>::Get(*this);
-    mMouseLocation          = EventParam<kEventParamWindowMouseLocation>::Get(*this);
-    mKeyModifiers           = EventParam<kEventParamKeyModifiers>::Get(*this);
-    mMouseWheelAxis         = EventParam<kEventParamMouseWheelAxis>::Get(*this);
-    mMouseWheelDelta        = EventParam<kEventParamMouseWheelDelta>::Get(*this);
+    MouseWheelParams    params  = MouseWheelParams();
+    UInt32              wanted  = SelectParams(kMouseWheelParams, kMouseWheelArgs, inArgs);
+    
+    GetEventParams(*this, kMouseWheelParams, params, wanted);
+    
+    mGlobalMouseLocation    = params.mMouseLocation;
+    mWindowRef              = params.mWindowRef;
+    mMouseLocation          = params.mWindowMouseLocation;
+    mKeyModifiers           = params.mKeyModifiers;
+    mMouseWheelAxis         = params.mMouseWheelAxis;
+    mMouseWheelDelta        = params.mMouseWheelDelta;
 }
 
 #pragma mark -
@@ -2050,13 +2308,19 @@ Event<kEventClassControl, kEventControlGetClickActivation>::Retrieve()
 // ------------------------------------------------------------------------------------------
 Event<kEventClassControl, kEventControlTrack>::Event(
     EventHandlerCallRef inHandlerCallRef, 
-    EventRef            inEvent)
+    EventRef            inEvent, 
+    UInt32              inArgs /* = kEventArgAll */)
         : EventBase(inHandlerCallRef, inEvent), 
           mHitPart(kHIViewNoPart)
 {
-    mViewRef        = EventDirectParam<typeControlRef>::Get(*this);
-    mMouseLocation  = EventParam<kEventParamMouseLocation>::Get(*this);
-    mKeyModifiers   = EventParam<kEventParamKeyModifiers>::Get(*this);
+    ControlTrackParams  params  = ControlTrackParams();
+    UInt32              wanted  = SelectParams(kControlTrackParams, kControlTrackArgs, inArgs);
+    
+    GetEventParams(*this, kControlTrackParams, params, wanted);
+    
+    mViewRef        = params.mViewRef;
+    mMouseLocation  = params.mMouseLocation;
+    mKeyModifiers   = params.mKeyModifiers;
 }
 
 // ------------------------------------------------------------------------------------------
@@ -2274,14 +2538,20 @@ Event<kEventClassControl, kEventControlRemovingSubControl>::Event(
 // ------------------------------------------------------------------------------------------
 Event<kEventClassControl, kEventControlBoundsChanged>::Event(
     EventHandlerCallRef inHandlerCallRef, 
-    EventRef            inEvent)
+    EventRef            inEvent, 
+    UInt32              inArgs /* = kEventArgAll */)
         : EventBase(inHandlerCallRef, inEvent)
 {
-    mViewRef        = EventDirectParam<typeControlRef>::Get(*this);
-    mAttributes     = EventParam<kEventParamAttributes>::Get(*this);
-    mOriginalBounds = EventParam<kEventParamOriginalBounds>::Get(*this);
-    mPreviousBounds = EventParam<kEventParamPreviousBounds>::Get(*this);
-    mCurrentBounds  = EventParam<kEventParamCurrentBounds>::Get(*this);
+    BoundsChangedParams params  = BoundsChangedParams();
+    UInt32              wanted  = SelectParams(kBoundsChangedParams, kBoundsChangedArgs, inArgs);
+    
+    GetEventParams(*this, kBoundsChangedParams, params, wanted);
+    
+    mViewRef        = params.mViewRef;
+    mAttributes     = params.mAttributes;
+    mOriginalBounds = params.mOriginalBounds;
+    mPreviousBounds = params.mPreviousBounds;
+    mCurrentBounds  = params.mCurrentBounds;
 }
 
 
@@ -3054,6 +3324,28 @@ Event<kEventClassB, kEventBUndoEnable>::Event(
     mEnable = EventParam<kEventParamBUndoEnable>::Get(*this);
 }
 
+
+// ==========================================================================================
+//  Event<kEventClassB, kEventBDrainTasks>
+
+// ------------------------------------------------------------------------------------------
+Event<kEventClassB, kEventBDrainTasks>::Event(
+    void*               inExecutor)
+        : EventBase(kEventClassB, kEventBDrainTasks), 
+          mExecutor(inExecutor)
+{
+    EventParam<kEventParamUserData>::Set(*this, mExecutor);
+}
+
+// ------------------------------------------------------------------------------------------
+Event<kEventClassB, kEventBDrainTasks>::Event(
+    EventHandlerCallRef inHandlerCallRef, 
+    EventRef            inEvent)
+        : EventBase(inHandlerCallRef, inEvent)
+{
+    mExecutor = EventParam<kEventParamUserData>::Get(*this);
+}
+
 #endif  // DOXYGEN_SKIP
 
 }   // namespace B
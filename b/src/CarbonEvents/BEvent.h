@@ -314,6 +314,39 @@ Event<CLASS, KIND>::Event(
 }
 
 
+// ==========================================================================================
+//  EventArgs
+
+/*!
+    @brief  Selects the arguments an incoming Event<CLASS, KIND> retrieves.
+    
+    The Event specialisations for frequently-sent Carbon %Events (mouse clicks, moves 
+    and drags, the mouse wheel, control tracking and bounds changes) take a combination 
+    of these flags as an optional third constructor argument.  They then retrieve only 
+    the parameters backing the selected arguments, and set the others to zero.  The 
+    direct object (eg @c mViewRef) is always retrieved, as are arguments that the event 
+    writes back when the handler returns.
+    
+    Handlers usually pass the flags to EventHandler::Add(), along with the function 
+    that implements the event.  The default is to retrieve every argument.
+    
+    @ingroup    CarbonEvents
+*/
+enum EventArgs
+{
+    kEventArgMouseLocation  = 0x00000001,   //!< @c mGlobalMouseLocation, @c mWindowRef and @c mMouseLocation.
+    kEventArgKeyModifiers   = 0x00000002,   //!< @c mKeyModifiers.
+    kEventArgMouseButton    = 0x00000004,   //!< @c mMouseButton, @c mClickCount and @c mMouseChord.
+    kEventArgMouseDelta     = 0x00000008,   //!< @c mMouseDelta.
+    kEventArgMouseWheel     = 0x00000010,   //!< @c mMouseWheelAxis and @c mMouseWheelDelta.
+    kEventArgAttributes     = 0x00000020,   //!< @c mAttributes.
+    kEventArgOriginalBounds = 0x00000040,   //!< @c mOriginalBounds.
+    kEventArgPreviousBounds = 0x00000080,   //!< @c mPreviousBounds.
+    kEventArgCurrentBounds  = 0x00000100,   //!< @c mCurrentBounds.
+    kEventArgAll            = 0xFFFFFFFF    //!< Every argument.
+};
+
+
 // ==========================================================================================
 //  Event<CLASS, KIND> Template Specialisations
 
@@ -337,7 +370,8 @@ public:
     // constructors
     Event(
         EventHandlerCallRef inHandlerCallRef, 
-        EventRef            inEvent);
+        EventRef            inEvent, 
+        UInt32              inArgs = kEventArgAll);
     
     // event arguments
     Point               mGlobalMouseLocation;
@@ -359,7 +393,8 @@ public:
     // constructors
     Event(
         EventHandlerCallRef inHandlerCallRef, 
-        EventRef            inEvent);
+        EventRef            inEvent, 
+        UInt32              inArgs = kEventArgAll);
     
     // event arguments
     Point               mGlobalMouseLocation;
@@ -381,7 +416,29 @@ public:
     // constructors
     Event(
         EventHandlerCallRef inHandlerCallRef, 
-        EventRef            inEvent);
+        EventRef            inEvent, 
+        UInt32              inArgs = kEventArgAll);
+    
+    // event arguments
+    Point               mGlobalMouseLocation;
+    WindowRef           mWindowRef;
+    Point               mMouseLocation;
+    UInt32              mKeyModifiers;
+    Point               mMouseDelta;
+};
+
+#pragma mark Event<kEventClassMouse, kEventMouseDragged>
+
+template <>
+class Event<kEventClassMouse, kEventMouseDragged> : public EventBase
+{
+public:
+    
+    // constructors
+    Event(
+        EventHandlerCallRef inHandlerCallRef, 
+        EventRef            inEvent, 
+        UInt32              inArgs = kEventArgAll);
     
     // event arguments
     Point               mGlobalMouseLocation;
@@ -402,7 +459,8 @@ public:
     // constructors
     Event(
         EventHandlerCallRef inHandlerCallRef, 
-        EventRef            inEvent);
+        EventRef            inEvent, 
+        UInt32              inArgs = kEventArgAll);
     
     // event arguments
     Point               mGlobalMouseLocation;
@@ -1889,7 +1947,8 @@ public:
     // constructors
     Event(
         EventHandlerCallRef inHandlerCallRef, 
-        EventRef            inEvent);
+        EventRef            inEvent, 
+        UInt32              inArgs = kEventArgAll);
     
     virtual void    Update();
     virtual void    Retrieve();
@@ -2081,7 +2140,8 @@ public:
     // constructors
     Event(
         EventHandlerCallRef inHandlerCallRef, 
-        EventRef            inEvent);
+        EventRef            inEvent, 
+        UInt32              inArgs = kEventArgAll);
     
     // event arguments
     HIViewRef   mViewRef;
@@ -2960,6 +3020,25 @@ public:
     bool    mEnable;
 };
 
+
+#pragma mark Event<kEventClassB, kEventBDrainTasks>
+
+template <>
+class Event<kEventClassB, kEventBDrainTasks> : public EventBase
+{
+public:
+    
+    // constructors
+    Event(
+        void*               inExecutor);
+    Event(
+        EventHandlerCallRef inHandlerCallRef, 
+        EventRef            inEvent);
+    
+    // event arguments
+    void*   mExecutor;
+};
+
 #endif  // DOXYGEN_SKIP
 
 
@@ -46,6 +46,7 @@ enum {
     kEventBUndoAbort            = 8,
     kEventBUndoAdd              = 9,
     kEventBUndoEnable           = 10,
+    kEventBDrainTasks           = 11,
     
     kEventParamBFromUser        = FOUR_CHAR_CODE('BFrm'),   /* typeBoolean */
     kEventParamBUndoName        = FOUR_CHAR_CODE('BUnN'),   /* typeCFStringRef */
@@ -58,9 +59,12 @@ enum {
     kEventParamToolbarItemData  = FOUR_CHAR_CODE('TItd'),   /* typeCFDictionaryRef */
     
     keyBExceptionState          = FOUR_CHAR_CODE('BExS'),   /* typeBExceptionState */
+    keyBExceptionFormat         = FOUR_CHAR_CODE('BExF'),   /* typeType */
     
     typeBUndoAction             = FOUR_CHAR_CODE('BUdA'),   /* B::UndoAction* */
     typeBExceptionState         = FOUR_CHAR_CODE('BExS'),   /* blob */
+    
+    kBExceptionFormatBinary     = FOUR_CHAR_CODE('BExB'),   /* ExceptionStreamer's binary format */
     typeBNib                    = FOUR_CHAR_CODE('BNib'),   /* Nib* */
     
     kHICommandOpenRecent        = 'BOpR',
@@ -104,6 +108,9 @@ enum {
 
     kEventBUndoEnable
         -->     kEventParamBUndoEnable      typeBoolean
+
+    kEventBDrainTasks
+        -->     kEventParamUserData         typeVoidPtr (the MainThreadExecutor)
 */
 
 
@@ -19,6 +19,10 @@
 // file header
 #include "BEventHandler.h"
 
+// standard headers
+#include <algorithm>
+#include <cstring>
+
 // system headers
 #include <Carbon/Carbon.h>
 
@@ -36,35 +40,55 @@ namespace B {
 // ------------------------------------------------------------------------------------------
 EventHandler::EventHandler(
     EventTargetRef  inTarget)
-        : mTarget(inTarget), mEventHandlerRef(NULL)
+        : mTarget(inTarget), 
+#if B_DISPATCH_TRACE
+          mTargetType("EventTarget"), 
+#endif
+          mEventHandlerRef(NULL), mCoalescedCount(0)
 {
 }
 
 // ------------------------------------------------------------------------------------------
 EventHandler::EventHandler(
     HIObjectRef     inTarget)
-        : mTarget(HIObjectGetEventTarget(inTarget)), mEventHandlerRef(NULL)
+        : mTarget(HIObjectGetEventTarget(inTarget)), 
+#if B_DISPATCH_TRACE
+          mTargetType("HIObject"), 
+#endif
+          mEventHandlerRef(NULL), mCoalescedCount(0)
 {
 }
 
 // ------------------------------------------------------------------------------------------
 EventHandler::EventHandler(
     HIViewRef       inTarget)
-        : mTarget(GetControlEventTarget(inTarget)), mEventHandlerRef(NULL)
+        : mTarget(GetControlEventTarget(inTarget)), 
+#if B_DISPATCH_TRACE
+          mTargetType("HIView"), 
+#endif
+          mEventHandlerRef(NULL), mCoalescedCount(0)
 {
 }
 
 // ------------------------------------------------------------------------------------------
 EventHandler::EventHandler(
     MenuRef         inTarget)
-        : mTarget(GetMenuEventTarget(inTarget)), mEventHandlerRef(NULL)
+        : mTarget(GetMenuEventTarget(inTarget)), 
+#if B_DISPATCH_TRACE
+          mTargetType("Menu"), 
+#endif
+          mEventHandlerRef(NULL), mCoalescedCount(0)
 {
 }
 
 // ------------------------------------------------------------------------------------------
 EventHandler::EventHandler(
     WindowRef       inTarget)
-        : mTarget(GetWindowEventTarget(inTarget)), mEventHandlerRef(NULL)
+        : mTarget(GetWindowEventTarget(inTarget)), 
+#if B_DISPATCH_TRACE
+          mTargetType("Window"), 
+#endif
+          mEventHandlerRef(NULL), mCoalescedCount(0)
 {
 }
 
@@ -89,12 +113,17 @@ EventHandler::Init()
     {
         static AutoEventHandlerUPP  sEventHandlerUPP(EventHandlerProc);
         
-        std::vector<EventTypeSpec>  specs;
+        std::vector<EventTypeSpec>  specs(mFunctors.size());
         
-        specs.reserve(mFunctorMap.size());
-        std::transform(mFunctorMap.begin(), mFunctorMap.end(), 
-                       std::back_inserter(specs), 
-                       MapKey<MapType::key_type, MapType::mapped_type>());
+        // By now, all (or nearly all) of the functors have been registered, so trim 
+        // the table down to its actual size.
+        FunctorTable(mFunctors).swap(mFunctors);
+        
+        for (size_t i = 0; i < mFunctors.size(); i++)
+        {
+            specs[i].eventClass = static_cast<UInt32>(mFunctors[i].mKey >> 32);
+            specs[i].eventKind  = static_cast<UInt32>(mFunctors[i].mKey);
+        }
         
         if (specs.size() > 0)
         {
@@ -141,7 +170,10 @@ EventHandler::AddFunctor(
     UInt32      inKind,     //!< The Carbon %Event kind of the functor to remove.
     FunctorPtr  inFunctor)  //!< The functor object.
 {
-    EventTypeSpec   spec    = { inClass, inKind };
+    EventTypeSpec           spec    = { inClass, inKind };
+    UInt64                  key     = MakeKey(inClass, inKind);
+    FunctorTable::iterator  it      = std::lower_bound(mFunctors.begin(), mFunctors.end(), 
+                                                       key, KeyLess());
     
     if (mEventHandlerRef != NULL)
     {
@@ -151,7 +183,16 @@ EventHandler::AddFunctor(
         B_THROW_IF_STATUS(err);
     }
     
-    mFunctorMap.insert(MapType::value_type(spec, inFunctor));
+    if ((it == mFunctors.end()) || (it->mKey != key))
+    {
+        FunctorEntry    entry;
+        
+        entry.mKey      = key;
+        entry.mFunctor  = inFunctor;
+        entry.mCoalesce = false;
+        
+        mFunctors.insert(it, entry);
+    }
 }
 
 // ------------------------------------------------------------------------------------------
@@ -170,7 +211,47 @@ EventHandler::RemoveFunctor(
         B_THROW_IF_STATUS(err);
     }
     
-    mFunctorMap.erase(spec);
+    UInt64                  key = MakeKey(inClass, inKind);
+    FunctorTable::iterator  it  = std::lower_bound(mFunctors.begin(), mFunctors.end(), 
+                                                   key, KeyLess());
+    
+    if ((it != mFunctors.end()) && (it->mKey == key))
+        mFunctors.erase(it);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+EventHandler::SetCoalescing(
+    UInt32  inClass,    //!< The Carbon %Event class.
+    UInt32  inKind,     //!< The Carbon %Event kind.
+    bool    inCoalesce) //!< Whether to coalesce the Carbon %Event.
+{
+    UInt64                  key = MakeKey(inClass, inKind);
+    FunctorTable::iterator  it  = std::lower_bound(mFunctors.begin(), mFunctors.end(), 
+                                                   key, KeyLess());
+    
+    B_ASSERT((it != mFunctors.end()) && (it->mKey == key));
+    
+    if ((it != mFunctors.end()) && (it->mKey == key))
+        it->mCoalesce = inCoalesce;
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @return The table entry.  It must exist.
+*/
+const EventHandler::FunctorEntry&
+EventHandler::FindEntry(
+    UInt32  inClass,    //!< The Carbon %Event class of the entry to retrieve.
+    UInt32  inKind)     //!< The Carbon %Event kind of the entry to retrieve.
+    const
+{
+    UInt64                          key = MakeKey(inClass, inKind);
+    FunctorTable::const_iterator    it  = std::lower_bound(mFunctors.begin(), mFunctors.end(), 
+                                                           key, KeyLess());
+    
+    B_ASSERT((it != mFunctors.end()) && (it->mKey == key));
+    
+    return (*it);
 }
 
 // ------------------------------------------------------------------------------------------
@@ -182,22 +263,150 @@ EventHandler::FindFunctor(
     UInt32  inKind)     //!< The Carbon %Event kind of the functor to retrieve.
     const
 {
-    EventTypeSpec   spec    = { inClass, inKind };
-    
-    B_ASSERT(mFunctorMap.find(spec) != mFunctorMap.end());
-    
-    return (mFunctorMap.find(spec)->second.get());
+    return (FindEntry(inClass, inKind).mFunctor.get());
 }
 
 // ------------------------------------------------------------------------------------------
 bool
 EventHandler::Invoke(
     EventHandlerCallRef inHandlerCallRef, 
-    EventRef            inEvent) const
+    EventRef            inEvent)
+{
+    const FunctorEntry& entry   = FindEntry(GetEventClass(inEvent), GetEventKind(inEvent));
+    
+    if (entry.mCoalesce && IsSuperseded(inEvent))
+    {
+        // A more recent version of this event is on its way, so there's no point in 
+        // handling this one.
+        
+        mCoalescedCount++;
+        
+        return (true);
+    }
+    
+    return ((*entry.mFunctor)(inHandlerCallRef, inEvent));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Only events that were posted to the main event queue and pulled from it by the event 
+    loop are considered:  an event that is sent directly to its target (for example, a 
+    synthesised event sent from within another handler) is never superseded, because its 
+    sender expects it to be handled.
+    
+    If the event carries a relative motion parameter (@c kEventParamMouseDelta or 
+    @c kEventParamMouseWheelDelta), its value is added to the superseding event's, so 
+    that no motion is lost by dropping the event.
+*/
+bool
+EventHandler::IsSuperseded(
+    EventRef    inEvent)
+{
+    static AutoEventComparatorUPP   sSupersedesUPP(SupersedesProc);
+    
+    if (inEvent != GetCurrentEvent())
+        return (false);
+    
+    EventRef    newer   = FindSpecificEventInQueue(GetMainEventQueue(), sSupersedesUPP, inEvent);
+    
+    if (newer == NULL)
+        return (false);
+    
+    AccumulateMouseDelta(inEvent, newer);
+    AccumulateWheelDelta(inEvent, newer);
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Adds @a inOldEvent's @c kEventParamMouseDelta to @a ioNewEvent's, if both have one.
+*/
+void
+EventHandler::AccumulateMouseDelta(
+    EventRef    inOldEvent, 
+    EventRef    ioNewEvent)
+{
+    ::Point oldDelta, newDelta;
+    
+    if ((GetEventParameter(inOldEvent, kEventParamMouseDelta, typeQDPoint, NULL, 
+                           sizeof(oldDelta), NULL, &oldDelta) == noErr) && 
+        (GetEventParameter(ioNewEvent, kEventParamMouseDelta, typeQDPoint, NULL, 
+                           sizeof(newDelta), NULL, &newDelta) == noErr))
+    {
+        newDelta.h += oldDelta.h;
+        newDelta.v += oldDelta.v;
+        
+        SetEventParameter(ioNewEvent, kEventParamMouseDelta, typeQDPoint, 
+                          sizeof(newDelta), &newDelta);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Adds @a inOldEvent's @c kEventParamMouseWheelDelta to @a ioNewEvent's, if both have one.
+*/
+void
+EventHandler::AccumulateWheelDelta(
+    EventRef    inOldEvent, 
+    EventRef    ioNewEvent)
+{
+    SInt32  oldDelta, newDelta;
+    
+    if ((GetEventParameter(inOldEvent, kEventParamMouseWheelDelta, typeSInt32, NULL, 
+                           sizeof(oldDelta), NULL, &oldDelta) == noErr) && 
+        (GetEventParameter(ioNewEvent, kEventParamMouseWheelDelta, typeSInt32, NULL, 
+                           sizeof(newDelta), NULL, &newDelta) == noErr))
+    {
+        newDelta += oldDelta;
+        
+        SetEventParameter(ioNewEvent, kEventParamMouseWheelDelta, typeSInt32, 
+                          sizeof(newDelta), &newDelta);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns @c true if both events have the same value (or lack thereof) for the given 
+    parameter.  Only small parameters (eg object references) are compared.
+*/
+static bool
+HaveSameParam(
+    EventRef        inEvent1, 
+    EventRef        inEvent2, 
+    EventParamName  inName)
+{
+    EventParamType  type1, type2;
+    ByteCount       size1, size2;
+    UInt8           data1[16], data2[16];
+    bool            has1, has2;
+    
+    has1 = (GetEventParameter(inEvent1, inName, typeWildCard, &type1, 
+                              sizeof(data1), &size1, data1) == noErr);
+    has2 = (GetEventParameter(inEvent2, inName, typeWildCard, &type2, 
+                              sizeof(data2), &size2, data2) == noErr);
+    
+    if (!has1 || !has2)
+        return (has1 == has2);
+    
+    return ((type1 == type2) && (size1 == size2) && (size1 <= sizeof(data1)) && 
+            (memcmp(data1, data2, size1) == 0));
+}
+
+// ------------------------------------------------------------------------------------------
+pascal Boolean
+EventHandler::SupersedesProc(
+    EventRef    inQueuedEvent, 
+    void*       inUserData)
 {
-    EventHandlerFunctorBase*    base    = FindFunctor(GetEventClass(inEvent), GetEventKind(inEvent));
+    EventRef    event   = reinterpret_cast<EventRef>(inUserData);
     
-    return ((*base)(inHandlerCallRef, inEvent));
+    // Only an event that was generated no earlier than ours can supersede it;  this 
+    // keeps stale events that were posted back to the queue from replacing fresher ones.
+    
+    return ((inQueuedEvent != event) && 
+            (GetEventClass(inQueuedEvent) == GetEventClass(event)) && 
+            (GetEventKind(inQueuedEvent) == GetEventKind(event)) && 
+            (GetEventTime(inQueuedEvent) >= GetEventTime(event)) && 
+            HaveSameParam(inQueuedEvent, event, kEventParamDirectObject) && 
+            HaveSameParam(inQueuedEvent, event, kEventParamWindowRef) && 
+            HaveSameParam(inQueuedEvent, event, kEventParamMouseWheelAxis));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -210,6 +419,9 @@ EventHandler::EventHandlerProc(
     EventHandler*   target  = reinterpret_cast<EventHandler*>(inUserData);
     OSStatus        err;
     
+    B_DISPATCH_TRACE_SCOPE(kCarbonEvent, GetEventClass(inEvent), GetEventKind(inEvent), 
+                           target->mTargetType);
+    
     try
     {
         if (target->Invoke(inHandlerCallRef, inEvent))
@@ -21,22 +21,19 @@
 
 #pragma once
 
+// standard headers
+#include <vector>
+
 // system headers
 #include <Carbon/Carbon.h>
 
-// compiler headers
-#ifdef __MWERKS__
-#   include <hash_map>
-#elif defined(__GNUC__)
-#   include <ext/hash_map>
-#endif
-
 // library headers
 #include <boost/function.hpp>
 #include <boost/intrusive_ptr.hpp>
 #include <boost/utility.hpp>
 
 // B headers
+#include "BDispatchTrace.h"
 #include "BFwd.h"
 
 
@@ -140,6 +137,70 @@ EventHandlerFunctor<CLASS, KIND>::operator () (
     return (handled);
 }
 
+
+// ==========================================================================================
+//  EventHandlerArgsFunctor
+
+#pragma mark -
+
+/*!
+    @brief  Template class representing a Carbon %Event functor that only needs some of 
+            the event's arguments.
+    
+    The Event<CLASS, KIND> is constructed with a combination of EventArgs flags, so 
+    only @a CLASS and @a KIND pairs whose Event specialisation accepts one may be used.
+    
+    @note   This class is for the internal use of EventHandler only.
+*/
+template <UInt32 CLASS, UInt32 KIND>
+class EventHandlerArgsFunctor : public EventHandlerFunctorBase
+{
+private:
+    
+    //! Synonym for the functor's type.
+    typedef boost::function1<bool, Event<CLASS, KIND>&> FunctorType;
+    
+    //! Constructor.
+                    EventHandlerArgsFunctor(FunctorType inFunctor, UInt32 inArgs);
+    
+    //! Invocation.
+    virtual bool    operator () (
+                        EventHandlerCallRef inHandlerCallRef, 
+                        EventRef            inEvent);
+    
+    // member variables
+    FunctorType mFunctor;
+    UInt32      mArgs;
+    
+    // friends
+    friend class    EventHandler;
+};
+
+// ------------------------------------------------------------------------------------------
+template <UInt32 CLASS, UInt32 KIND>
+EventHandlerArgsFunctor<CLASS, KIND>::EventHandlerArgsFunctor(
+    FunctorType inFunctor, 
+    UInt32      inArgs)
+        : mFunctor(inFunctor), mArgs(inArgs)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+template <UInt32 CLASS, UInt32 KIND> bool
+EventHandlerArgsFunctor<CLASS, KIND>::operator () (
+    EventHandlerCallRef inHandlerCallRef, 
+    EventRef            inEvent)
+{
+    Event<CLASS, KIND>  event(inHandlerCallRef, inEvent, mArgs);
+    bool                handled;
+    
+    handled = mFunctor(event);
+    
+    event.Update();
+    
+    return (handled);
+}
+
 // ==========================================================================================
 //  EventHandler
 
@@ -165,6 +226,15 @@ EventHandlerFunctor<CLASS, KIND>::operator () (
         myEventHandler.Add(&obj, &MyObject::MyHandleEvent);
     @endcode
     
+    Handlers of frequently-sent events that only look at some of the event's arguments 
+    can say so by passing EventArgs flags to Add();  the other arguments' parameters 
+    are then never retrieved:
+    
+    @code
+        myEventHandler.Add(&obj, &MyObject::MyMouseDragged, 
+                           kEventArgMouseLocation | kEventArgMouseDelta);
+    @endcode
+    
     @ingroup    CarbonEvents
     @sa         @ref using_events
 */
@@ -226,45 +296,77 @@ public:
     void    Add(
                 T*      inObject, 
                 bool    (T::*inFunction)(Event<CLASS, KIND>&));
+    //! Adds a handler that will invoke @a inFunctor in response to a Carbon %Event of the given @a CLASS and @a KIND, retrieving only the arguments in @a inArgs.
+    template <UInt32 CLASS, UInt32 KIND>
+    void    Add(
+                boost::function1<bool, Event<CLASS, KIND>&> inFunctor, 
+                UInt32                                      inArgs);
+    //! Adds a handler that will invoke @a inObject->*inFunction in response to a Carbon %Event of the given @a CLASS and @a KIND, retrieving only the arguments in @a inArgs.
+    template <UInt32 CLASS, UInt32 KIND, class T>
+    void    Add(
+                T*      inObject, 
+                bool    (T::*inFunction)(Event<CLASS, KIND>&), 
+                UInt32  inArgs);
     //! Removes the handler for the Carbon %Event of the given @a CLASS and @a KIND.
     template <UInt32 CLASS, UInt32 KIND>
     void    Remove();
     //@}
     
+    //! @name Coalescing
+    //@{
+    //! Turns coalescing of Carbon %Events of the given @a CLASS and @a KIND on or off.
+    template <UInt32 CLASS, UInt32 KIND>
+    void    Coalesce(
+                bool    inCoalesce = true);
+    //! Returns the number of Carbon %Events that have been dropped because of coalescing.
+    UInt32  GetCoalescedCount() const   { return (mCoalescedCount); }
+    //@}
+    
 private:
     
-    // nested classes
+    // types
     
-    struct Hash : public std::unary_function<EventTypeSpec, size_t>
-    {
-        size_t  operator()(const EventTypeSpec& key) const
-                    { return (key.eventClass | key.eventKind); }
-    };
-
-    struct Equal : public std::binary_function<EventTypeSpec, EventTypeSpec, bool>
+    typedef boost::intrusive_ptr<EventHandlerFunctorBase>   FunctorPtr;
+    
+    /*! @brief  An entry in the functor table.
+        
+        The event class and kind are packed into a single 64-bit key, so that lookups 
+        only need one comparison per probe.
+    */
+    struct FunctorEntry
     {
-        bool     operator()(const EventTypeSpec& x, const EventTypeSpec& y) const
-                    { return ((x.eventClass == y.eventClass) && (x.eventKind == y.eventKind)); }
+        UInt64      mKey;
+        FunctorPtr  mFunctor;
+        bool        mCoalesce;  //!< Drop events superseded by a queued one?
     };
-
-    struct Less : public std::binary_function<EventTypeSpec, EventTypeSpec, bool>
+    
+    /*! @brief  Orders functor table entries by key.
+        
+        Also allows comparisons against bare keys, for use with @c std::lower_bound().
+    */
+    struct KeyLess : public std::binary_function<FunctorEntry, FunctorEntry, bool>
     {
-        bool     operator()(const EventTypeSpec& x, const EventTypeSpec& y) const
-                    { return ((x.eventClass < y.eventClass) || 
-                              ((x.eventClass == y.eventClass) && (x.eventKind < y.eventKind))); }
+        bool     operator()(const FunctorEntry& x, const FunctorEntry& y) const
+                    { return (x.mKey < y.mKey); }
+        bool     operator()(const FunctorEntry& x, UInt64 y) const
+                    { return (x.mKey < y); }
+        bool     operator()(UInt64 x, const FunctorEntry& y) const
+                    { return (x < y.mKey); }
     };
     
-    // types
-    
-    typedef boost::intrusive_ptr<EventHandlerFunctorBase>   FunctorPtr;
+    /*! The functor table.  It's kept sorted by key.
+        
+        A given handler rarely has more than a dozen or so entries, and there is one 
+        handler per view, window and menu.  A flat, sorted vector is both smaller and 
+        faster to search than a node-based hash map for such small sizes.
+    */
+    typedef std::vector<FunctorEntry>   FunctorTable;
     
-#ifdef __MWERKS__
-    typedef Metrowerks::hash_map<EventTypeSpec, FunctorPtr, Hash, Equal>    MapType;
-#elif defined(__GNUC__)
-    typedef __gnu_cxx::hash_map<EventTypeSpec, FunctorPtr, Hash, Equal>     MapType;
-#else
-    typedef std::map<EventTypeSpec, FunctorPtr, Less>   MapType;
-#endif
+    //! Returns the table key for a given Carbon %Event class & kind.
+    static UInt64   MakeKey(
+                        UInt32      inClass, 
+                        UInt32      inKind)
+                        { return ((static_cast<UInt64>(inClass) << 32) | inKind); }
     
     //! Adds a functor with a given Carbon %Event class & kind.
     void        AddFunctor(
@@ -275,15 +377,36 @@ private:
     void        RemoveFunctor(
                     UInt32      inClass, 
                     UInt32      inKind);
+    //! Turns coalescing on or off for a given Carbon %Event class & kind.
+    void        SetCoalescing(
+                    UInt32      inClass, 
+                    UInt32      inKind, 
+                    bool        inCoalesce);
+    //! Retrieves the table entry for a given Carbon %Event class & kind.
+    const FunctorEntry&
+                FindEntry(
+                    UInt32      inClass, 
+                    UInt32      inKind) const;
     //! Retrieves a functor a given Carbon %Event class & kind.
     EventHandlerFunctorBase*
                 FindFunctor(
                     UInt32      inClass, 
                     UInt32      inKind) const;
+    //! Returns @c true if a more recent event of the same kind, for the same target, is queued.
+    static bool IsSuperseded(
+                    EventRef    inEvent);
+    //! Adds one event's mouse delta to another's.
+    static void AccumulateMouseDelta(
+                    EventRef    inOldEvent, 
+                    EventRef    ioNewEvent);
+    //! Adds one event's mouse wheel delta to another's.
+    static void AccumulateWheelDelta(
+                    EventRef    inOldEvent, 
+                    EventRef    ioNewEvent);
     
     bool        Invoke(
                     EventHandlerCallRef inHandlerCallRef, 
-                    EventRef            inEvent) const;
+                    EventRef            inEvent);
     
     // callbacks
     static pascal OSStatus
@@ -291,11 +414,19 @@ private:
                         EventHandlerCallRef inHandlerCallRef, 
                         EventRef            inEvent, 
                         void*               inUserData);
+    static pascal Boolean
+                    SupersedesProc(
+                        EventRef            inQueuedEvent, 
+                        void*               inUserData);
     
     // member variables
     EventTargetRef  mTarget;            //!< The EventTargetRef that this event handler is attached to.
+#if B_DISPATCH_TRACE
+    const char*     mTargetType;        //!< The kind of object mTarget belongs to (for tracing).
+#endif
     EventHandlerRef mEventHandlerRef;   //!< The underlying @c EventHandlerRef for this handler.
-    MapType         mFunctorMap;
+    FunctorTable    mFunctors;          //!< The functors, sorted by class & kind.
+    UInt32          mCoalescedCount;    //!< The number of events dropped by coalescing.
 };
 
 // ------------------------------------------------------------------------------------------
@@ -324,6 +455,40 @@ EventHandler::Add(
                                                 boost::bind(inFunction, inObject, _1))));
 }
 
+// ------------------------------------------------------------------------------------------
+/*! Only the Event specialisations for frequently-sent Carbon %Events accept EventArgs 
+    flags;  see EventArgs for the list.
+    
+    @param  CLASS   Template parameter.  Should be an integral four-char constant representing a Carbon %Event class.
+    @param  KIND    Template parameter.  Should be an integral four-char constant representing a Carbon %Event kind in @a CLASS's namespace.
+*/
+template <UInt32 CLASS, UInt32 KIND> void
+EventHandler::Add(
+    boost::function1<bool, Event<CLASS, KIND>&> inFunctor,  //!< The functor that implements the Carbon %Event.
+    UInt32                                      inArgs)     //!< A combination of EventArgs flags.
+{
+    AddFunctor(CLASS, KIND, FunctorPtr(new EventHandlerArgsFunctor<CLASS, KIND>(inFunctor, inArgs)));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Only the Event specialisations for frequently-sent Carbon %Events accept EventArgs 
+    flags;  see EventArgs for the list.
+    
+    @param  CLASS   Template parameter.  Should be an integral four-char constant representing a Carbon %Event class.
+    @param  KIND    Template parameter.  Should be an integral four-char constant representing a Carbon %Event kind in @a CLASS's namespace.
+    @param  T       Template parameter.  Should of class type.
+*/
+template <UInt32 CLASS, UInt32 KIND, class T> void
+EventHandler::Add(
+    T*      inObject,                               //!< The object that implements the Carbon %Event.
+    bool    (T::*inFunction)(Event<CLASS, KIND>&),  //!< The member function of @a T that implements the Carbon %Event.
+    UInt32  inArgs)                                 //!< A combination of EventArgs flags.
+{
+    AddFunctor(CLASS, KIND, FunctorPtr(new EventHandlerArgsFunctor<CLASS, KIND>(
+                                                boost::bind(inFunction, inObject, _1), 
+                                                inArgs)));
+}
+
 // ------------------------------------------------------------------------------------------
 /*! @param  CLASS   Template parameter.  Should be an integral four-char constant representing a Carbon %Event class.
     @param  KIND    Template parameter.  Should be an integral four-char constant representing a Carbon %Event kind in @a CLASS's namespace.
@@ -334,6 +499,34 @@ EventHandler::Remove()
     RemoveFunctor(CLASS, KIND);
 }
 
+// ------------------------------------------------------------------------------------------
+/*! When coalescing is on for a given event kind and an event of that kind arrives, the 
+    main event queue is searched for a more recent event of the same class and kind, 
+    aimed at the same target (as determined by the events' @c kEventParamDirectObject 
+    and @c kEventParamWindowRef parameters).  If one is found, the incoming event is 
+    considered superseded and is dropped:  the functor isn't called, and the event is 
+    reported as handled.
+    
+    This is appropriate for events that describe a state rather than a transition, and 
+    that may arrive faster than they can be processed, such as 
+    @c kEventMouseDragged or @c kEventMouseWheelMoved.  Relative motion isn't lost:  the 
+    dropped event's @c kEventParamMouseDelta or @c kEventParamMouseWheelDelta is added 
+    to the superseding event's.  Note that events which are sent directly to their 
+    target rather than posted to the queue are never coalesced.
+    
+    A handler for the Carbon %Event of the given @a CLASS and @a KIND must already have 
+    been added with Add().
+    
+    @param  CLASS   Template parameter.  Should be an integral four-char constant representing a Carbon %Event class.
+    @param  KIND    Template parameter.  Should be an integral four-char constant representing a Carbon %Event kind in @a CLASS's namespace.
+*/
+template <UInt32 CLASS, UInt32 KIND> inline void
+EventHandler::Coalesce(
+    bool    inCoalesce) //!< Whether to coalesce the Carbon %Event.
+{
+    SetCoalescing(CLASS, KIND, inCoalesce);
+}
+
 
 }   // namespace B
 
@@ -46,6 +46,54 @@ EventParamTypeTraitBase::Exists(
 }
 
 
+// ==========================================================================================
+//  GetEventParams
+
+// ------------------------------------------------------------------------------------------
+/*! Each parameter is copied straight into <tt>outBlock + inDescriptors[i].mOffset</tt>.  
+    Fields corresponding to missing optional parameters are left untouched, so they 
+    may be given default values beforehand.  So are the fields of descriptors that 
+    aren't selected by @a inWanted;  those parameters aren't looked up at all, even 
+    if they are required.
+    
+    @return     A bit mask of the parameters that were found:  bit @a i is set if the 
+                parameter described by <tt>inDescriptors[i]</tt> was wanted and present.
+    @exception  An exception is thrown if a wanted, required parameter is missing.
+*/
+UInt32
+GetEventParams(
+    EventRef                    inEvent,        //!< The Carbon %Event.
+    const EventParamDescriptor* inDescriptors,  //!< The parameters to retrieve.
+    size_t                      inCount,        //!< The number of entries in @a inDescriptors.
+    void*                       outBlock,       //!< Holds the output.
+    UInt32                      inWanted)       //!< Bit @a i selects <tt>inDescriptors[i]</tt>.
+{
+    UInt8*  block   = static_cast<UInt8*>(outBlock);
+    UInt32  present = 0;
+    
+    B_ASSERT(inCount <= 32);
+    
+    for (size_t i = 0; i < inCount; i++)
+    {
+        const EventParamDescriptor& desc    = inDescriptors[i];
+        OSStatus                    err;
+        
+        if ((inWanted & (1U << i)) == 0)
+            continue;
+        
+        err = GetEventParameter(inEvent, desc.mName, desc.mType, NULL, 
+                                desc.mSize, NULL, block + desc.mOffset);
+        
+        if (err == noErr)
+            present |= (1U << i);
+        else if (desc.mRequired)
+            B_THROW_STATUS(err);
+    }
+    
+    return (present);
+}
+
+
 // ==========================================================================================
 //  EventParamTypeTrait<typeBoolean>
 
@@ -22,6 +22,7 @@
 #pragma once
 
 // standard headers
+#include <cstddef>
 #include <new>
 
 // system headers
@@ -826,6 +827,106 @@ template <EventParamType TYPE> struct EventResultParam
 };
 
 
+// ==========================================================================================
+//  EventParamDescriptor
+
+/*!
+    @brief  Describes one field of a block of Carbon %Event parameters.
+    
+    Some Carbon %Events (mouse moves, control tracking, bounds changes, etc.) are sent 
+    very often, and their Event<CLASS, KIND> specialisations retrieve several parameters 
+    every time.  Rather than going through EventParam<NAME> once per parameter, they 
+    describe their parameters with a static array of EventParamDescriptor, each entry 
+    mapping a parameter onto a field of a plain struct (the "block").  GetEventParams() 
+    then fetches all of them in one pass, directly into the block's fields.
+    
+    Blocks must be POD types whose fields have the exact types that 
+    @c GetEventParameter() writes (eg @c ::HIPoint, @c ::Rect, @c WindowRef), since 
+    no conversion takes place.  Descriptors are most easily constructed with the 
+    B_EVENT_PARAM() and B_EVENT_PARAM_AND_TYPE() macros:
+    
+    @code
+        struct MyParams
+        {
+            ::HIPoint   mMouseLocation;
+            UInt32      mKeyModifiers;
+        };
+        
+        const EventParamDescriptor  kMyParams[] = {
+            B_EVENT_PARAM(MyParams, mMouseLocation, kEventParamMouseLocation, true), 
+            B_EVENT_PARAM(MyParams, mKeyModifiers,  kEventParamKeyModifiers,  false), 
+        };
+        
+        MyParams    params;
+        UInt32      present = GetEventParams(inEvent, kMyParams, params);
+    @endcode
+    
+    Callers that only need some of the parameters pass a mask as well:  bit @a i 
+    selects <tt>kMyParams[i]</tt>, and the other descriptors are skipped altogether.
+    
+    @ingroup    CarbonEvents
+*/
+struct EventParamDescriptor
+{
+    EventParamName  mName;      //!< The parameter's name.
+    EventParamType  mType;      //!< The parameter's type.
+    ByteCount       mSize;      //!< The size of the field receiving the parameter.
+    size_t          mOffset;    //!< The offset of the field receiving the parameter.
+    bool            mRequired;  //!< If @c true, a missing parameter causes an exception.
+};
+
+/*! @brief  Constructs an EventParamDescriptor for a parameter whose type is given by EventParamNameTrait.
+    
+    @param  BLOCK       The block's type.
+    @param  FIELD       The name of the field within @a BLOCK.
+    @param  NAME        The parameter's name.
+    @param  REQUIRED    @c true if the parameter must be present in the event.
+    
+    @ingroup    CarbonEvents
+*/
+#define B_EVENT_PARAM(BLOCK, FIELD, NAME, REQUIRED) \
+    B_EVENT_PARAM_AND_TYPE(BLOCK, FIELD, NAME, B::EventParamNameTrait<NAME>::kTypeTag, REQUIRED)
+
+/*! @brief  Constructs an EventParamDescriptor for a parameter of an explicit type.
+    
+    @param  BLOCK       The block's type.
+    @param  FIELD       The name of the field within @a BLOCK.
+    @param  NAME        The parameter's name.
+    @param  TYPE        The parameter's type.
+    @param  REQUIRED    @c true if the parameter must be present in the event.
+    
+    @ingroup    CarbonEvents
+*/
+#define B_EVENT_PARAM_AND_TYPE(BLOCK, FIELD, NAME, TYPE, REQUIRED) \
+    { NAME, TYPE, sizeof(static_cast<BLOCK*>(0)->FIELD), offsetof(BLOCK, FIELD), REQUIRED }
+
+enum    { kAllEventParams = 0xFFFFFFFF };   //!< Selects every descriptor passed to GetEventParams().
+
+//! Retrieves a list of Carbon %Event parameters into the fields of a block.
+UInt32  GetEventParams(
+            EventRef                    inEvent, 
+            const EventParamDescriptor* inDescriptors, 
+            size_t                      inCount, 
+            void*                       outBlock, 
+            UInt32                      inWanted = kAllEventParams);
+
+// ------------------------------------------------------------------------------------------
+/*! The number of descriptors is deduced from the array's declaration.
+    
+    @return A bit mask of the parameters that were found:  bit @a i is set if the 
+            parameter described by <tt>inDescriptors[i]</tt> was wanted and present.
+*/
+template <class BLOCK, size_t N> inline UInt32
+GetEventParams(
+    EventRef                    inEvent,                    //!< The Carbon %Event.
+    const EventParamDescriptor  (&inDescriptors)[N],        //!< The parameters to retrieve.
+    BLOCK&                      outBlock,                   //!< Holds the output.
+    UInt32                      inWanted = kAllEventParams) //!< Bit @a i selects <tt>inDescriptors[i]</tt>.
+{
+    return (GetEventParams(inEvent, inDescriptors, N, &outBlock, inWanted));
+}
+
+
 }   // namespace B
 
 
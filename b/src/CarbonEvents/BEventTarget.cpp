@@ -19,20 +19,25 @@
 // file header
 #include "BEventTarget.h"
 
-// standard headers
-#include <map>
+// library headers
+#if defined(__MWERKS__)
+#   include <hash_map>
+#elif defined(__GNUC__)
+#   include <ext/hash_map>
+#endif
 
 // B headers
 #include "BAutoUPP.h"
 #include "BEvent.h"
 #include "BEventParams.h"
+#include "BInternedString.h"
 
 
 namespace
 {
     struct ClassUnregisterer
     {
-        typedef std::pair<B::String, HIObjectClassRef>  Value;
+        typedef std::pair<const B::InternedString, HIObjectClassRef> Value;
         
         void    operator () (const Value& value) const
                 {
@@ -71,7 +76,11 @@ public:
 private:
     
     // types
-    typedef std::map<String, HIObjectClassRef>  ClassMap;
+#if defined(__MWERKS__)
+    typedef Metrowerks::hash_map<InternedString, HIObjectClassRef, InternedStringHash> ClassMap;
+#elif defined(__GNUC__)
+    typedef __gnu_cxx::hash_map<InternedString, HIObjectClassRef, InternedStringHash>  ClassMap;
+#endif
     
     // member variables
     ClassMap    mRegisteredClasses;
@@ -95,7 +104,7 @@ EventTarget::Init::Add(
     CFStringRef         inClassID, 
     HIObjectClassRef    inClassRef)
 {
-    mRegisteredClasses.insert(ClassMap::value_type(String(inClassID), inClassRef));
+    mRegisteredClasses.insert(ClassMap::value_type(InternedString(inClassID), inClassRef));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -103,7 +112,7 @@ void
 EventTarget::Init::Remove(
     CFStringRef         inClassID)
 {
-    ClassMap::iterator  it  = mRegisteredClasses.find(String(inClassID));
+    ClassMap::iterator  it  = mRegisteredClasses.find(InternedString(inClassID));
     OSStatus            err;
     
     B_ASSERT(it != mRegisteredClasses.end());
@@ -119,7 +128,7 @@ HIObjectClassRef
 EventTarget::Init::Find(
     CFStringRef         inClassID)
 {
-    ClassMap::iterator  it  = mRegisteredClasses.find(String(inClassID));
+    ClassMap::iterator  it  = mRegisteredClasses.find(InternedString(inClassID));
     
     return ((it != mRegisteredClasses.end()) ? it->second : NULL);
 }
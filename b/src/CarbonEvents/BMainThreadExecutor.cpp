@@ -0,0 +1,123 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BMainThreadExecutor.h"
+
+// B headers
+#include "BErrorHandler.h"
+#include "BEvent.h"
+
+
+namespace B {
+
+// ==========================================================================================
+//  MainThreadExecutor
+
+#pragma mark MainThreadExecutor
+
+// ------------------------------------------------------------------------------------------
+MainThreadExecutor::MainThreadExecutor(
+    size_t  inCapacity,     //!< The maximum number of waiting tasks;  zero means unbounded.
+    size_t  inBatchSize)    //!< The maximum number of tasks run per event loop iteration.
+        : mQueue(inCapacity), mBatchSize(inBatchSize),
+          mEventHandler(GetApplicationEventTarget())
+{
+    B_ASSERT(inBatchSize > 0);
+    
+    InitEventHandler();
+}
+
+// ------------------------------------------------------------------------------------------
+void
+MainThreadExecutor::InitEventHandler()
+{
+    mEventHandler.Add(this, &MainThreadExecutor::BDrainTasks);
+    
+    mEventHandler.Init();
+}
+
+// ------------------------------------------------------------------------------------------
+/*! May be called from any thread.
+    
+    @return @c true if the task was queued, @c false if the queue was full.
+*/
+bool
+MainThreadExecutor::Post(
+    const Task& inTask)     //!< The task to run.
+{
+    bool    wasEmpty;
+    
+    if (!mQueue.Post(inTask, wasEmpty))
+        return (false);
+    
+    // Only the producer that makes the queue non-empty needs to wake up the main
+    // thread;  everybody else's task will be picked up by the same drain.
+    
+    if (wasEmpty)
+        Wake();
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Posts a @c kEventBDrainTasks event to the main event queue.  May be called from
+    any thread.
+*/
+void
+MainThreadExecutor::Wake()
+{
+    Event<kEventClassB, kEventBDrainTasks>  event(this);
+    
+    event.Post();
+}
+
+// ------------------------------------------------------------------------------------------
+bool
+MainThreadExecutor::BDrainTasks(
+    Event<kEventClassB, kEventBDrainTasks>& event)
+{
+    // Several executors may be installed on the application target;  let the
+    // event through if it's meant for somebody else.
+    
+    if (event.mExecutor != this)
+        return (false);
+    
+    try
+    {
+        mQueue.Drain(mBatchSize);
+    }
+    catch (...)
+    {
+        if (!mQueue.empty())
+            Wake();
+        
+        throw;
+    }
+    
+    // If the batch didn't empty the queue, come back on the next iteration of the
+    // event loop rather than hogging the main thread.  A producer that posts after
+    // this test sees an empty queue and wakes us up itself.
+    
+    if (!mQueue.empty())
+        Wake();
+    
+    return (true);
+}
+
+}   // namespace B
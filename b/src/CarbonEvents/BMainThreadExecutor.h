@@ -0,0 +1,115 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BMainThreadExecutor_H_
+#define BMainThreadExecutor_H_
+
+#pragma once
+
+// library headers
+#include <boost/utility.hpp>
+
+// B headers
+#include "BEventCustomParams.h"
+#include "BEventHandler.h"
+#include "BTaskQueue.h"
+
+
+namespace B {
+
+/*!
+    @brief  Runs tasks posted from any thread on the main thread.
+    
+    Worker threads call Post() to hand a task (any nullary function object) over to
+    the main thread.  The task is appended to a lock-free TaskQueue, so posting never
+    blocks and never contends with other producers.
+    
+    The main thread is woken up with a single @c kEventBDrainTasks Carbon %Event,
+    which is only posted when the queue goes from empty to non-empty;  a burst of
+    tasks therefore costs one trip through the event loop, rather than one per task.
+    When the event is handled, at most a batch of tasks is run, so that a flood of
+    tasks can't starve user input.  If tasks remain after that, another event is
+    posted, and the remaining tasks are run on a later iteration of the event loop.
+    
+    If the executor was given a capacity, Post() returns @c false once that many tasks
+    are waiting;  it's up to the caller to decide whether to retry, coalesce or drop.
+    
+    A MainThreadExecutor must be constructed and destroyed on the main thread.
+    
+    @sa         TaskQueue
+    @ingroup    CarbonEvents
+*/
+class MainThreadExecutor : public boost::noncopyable
+{
+public:
+    
+    //! @name Types
+    //@{
+    typedef TaskQueue::Task         Task;       //!< The type of tasks.
+    typedef TaskQueue::Statistics   Statistics; //!< Usage statistics.
+    //@}
+    
+    //! @name Constants
+    //@{
+    //! The default maximum number of tasks run per event loop iteration.
+    static const size_t kDefaultBatchSize   = 64;
+    //@}
+    
+    //! @name Constructor & Destructor
+    //@{
+    //! Constructor.  A capacity of zero means the queue is unbounded.
+    explicit    MainThreadExecutor(
+                    size_t  inCapacity = 0,
+                    size_t  inBatchSize = kDefaultBatchSize);
+    //@}
+    
+    //! @name Posting
+    //@{
+    //! Arranges for @a inTask to be run on the main thread.  Returns @c false if the queue is full.
+    bool        Post(const Task& inTask);
+    //@}
+    
+    //! @name Inquiries
+    //@{
+    //! Returns the maximum number of tasks run per event loop iteration.
+    size_t      GetBatchSize() const    { return (mBatchSize); }
+    //! Returns the number of waiting tasks.
+    size_t      GetPendingCount() const { return (mQueue.size()); }
+    //! Returns the usage statistics.  Must be called from the main thread.
+    Statistics  GetStatistics() const   { return (mQueue.GetStatistics()); }
+    //@}
+
+private:
+    
+    void    InitEventHandler();
+    void    Wake();
+    
+    // Carbon %Event handlers
+    bool    BDrainTasks(
+                Event<kEventClassB, kEventBDrainTasks>& event);
+    
+    // member variables
+    TaskQueue       mQueue;
+    const size_t    mBatchSize;
+    EventHandler    mEventHandler;
+};
+
+}   // namespace B
+
+
+#endif  // BMainThreadExecutor_H_
@@ -88,7 +88,7 @@ Pasteboard::GetPasteLocation() const
     err = PasteboardCopyPasteLocation(mPasteboard, &cfurl);
     B_THROW_IF_STATUS(err);
     
-    return (Url(OSPtr<CFURLRef>(cfurl, from_copy)));
+    return (Url(cfurl, from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -25,6 +25,7 @@
 // B headers
 #include "BAEDescParam.h"
 #include "BAEReader.h"
+#include "BAEUndoStore.h"
 #include "BAEWriter.h"
 #include "BBundle.h"
 #include "BCommandData.h"
@@ -174,9 +175,14 @@ AbstractDocument::AbstractDocument(
     DescType    inClassID,      //!< The object's class ID;  must match the application's AppleScript dictionary.
     SInt32      inUniqueID)     //!< The document's unique id number.
         : AEObject(inContainer, inClassID), 
-          mUniqueID(inUniqueID), mModCount(0), mOpenForPrinting(false), mQuitting(false)
+          mUniqueID(inUniqueID), mUndoStore(AEUndoStore::Make()), 
+          mModCount(0), mOpenForPrinting(false), mQuitting(false)
 {
     mObjectRef = AbstractDocument::EventHelper::Create(this);
+    
+    // The enabled state of our commands depends on IsNew() and IsModified().
+    mCommandStatusCache.InvalidateOn(mDirtyStateChangedSignal);
+    mCommandStatusCache.InvalidateOn(mUrlChangedSignal);
 }
 
 #pragma mark - Inquiries -
@@ -837,29 +843,37 @@ AbstractDocument::HandleUpdateStatus(
     CommandData&                ioCmdData, 
     Window*                     /* inWindow */ /* = NULL */)
 {
-    bool    handled = true;
+    return (GetCommandTable().UpdateStatus(*this, inHICommand, ioCmdData, 
+                                           &mCommandStatusCache));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The table only governs the commands' status;  the commands themselves need the 
+    invoking window, and so are performed by HandleCommand().
     
-    switch (inHICommand.commandID)
+    The commands' status is cached, and the cache is invalidated by the dirty-state-changed 
+    and URL-changed signals.  Derived classes that override IsNew() or IsModified() 
+    must therefore emit those signals when the results of these functions change.
+*/
+const CommandTable<AbstractDocument>&
+AbstractDocument::GetCommandTable()
+{
+    typedef CommandTable<AbstractDocument>  TableType;
+    
+    static TableType    sCommandTable;
+    
+    if (sCommandTable.empty())
     {
-    case kHICommandClose:
-    case kHICommandSaveAs:
-        ioCmdData.SetEnabled(true);
-        break;
-        
-    case kHICommandSave:
-        ioCmdData.SetEnabled(IsNew() || IsModified());
-        break;
-        
-    case kHICommandRevert:
-        ioCmdData.SetEnabled(!IsNew() && IsModified());
-        break;
-        
-    default:
-        handled = false;
-        break;
+        sCommandTable
+            .Add(kHICommandClose,   TableType::ProcessFunction())
+            .Add(kHICommandSaveAs,  TableType::ProcessFunction())
+            .Add(kHICommandSave,    TableType::ProcessFunction(), 
+                                    boost::bind(&AbstractDocument::CanSave, _1))
+            .Add(kHICommandRevert,  TableType::ProcessFunction(), 
+                                    boost::bind(&AbstractDocument::CanRevert, _1));
     }
     
-    return (handled);
+    return (sCommandTable);
 }
 
 
@@ -25,15 +25,18 @@
 #include <Carbon/Carbon.h>
 
 // library headers
+#include <boost/shared_ptr.hpp>
 #include <boost/signal.hpp>
 
 // B headers
 #include "BAEObject.h"
+#include "BCommandTable.h"
 
 
 namespace B {
 
 // forward declarations
+class   AEUndoStore;
 class   CommandData;
 class   Window;
 class   Nib;
@@ -120,6 +123,11 @@ public:
         This is a pure virtual function, which all derived classes must override.
     */
     virtual bool        OwnsWindow(const Window* inWindow) const = 0;
+    
+    //! Returns the store holding the document's compacted undo events.
+    AEUndoStore&        GetUndoStore()          { return (*mUndoStore); }
+    //! Returns the store holding the document's compacted undo events.
+    const AEUndoStore&  GetUndoStore() const    { return (*mUndoStore); }
     //@}
     
     //! @name Initialisation
@@ -272,9 +280,15 @@ protected:
     
 private:
     
+    static const CommandTable<AbstractDocument>&
+                    GetCommandTable();
+    bool            CanSave() const     { return (IsNew() || IsModified()); }
+    bool            CanRevert() const   { return (!IsNew() && IsModified()); }
+    
     // member variables
     const SInt32        mUniqueID;
     OSPtr<HIObjectRef>  mObjectRef;
+    boost::shared_ptr<AEUndoStore>  mUndoStore;
     DocSignal           mContentChangedSignal;
     DocSignal           mDirtyStateChangedSignal;
     DocSignal           mUrlChangedSignal;
@@ -284,6 +298,7 @@ private:
     unsigned            mModCount;
     bool                mOpenForPrinting;
     bool                mQuitting;
+    CommandStatusCache  mCommandStatusCache;
     
     // friend
     friend class    EventHelper;
@@ -33,6 +33,7 @@
 
 // B headers
 #include "BAbstractDocument.h"
+#include "BCommandTable.h"
 #include "BEventCustomParams.h"
 #include "BEventHandler.h"
 #include "BFwd.h"
@@ -264,9 +265,18 @@ private:
     typedef DocumentMap::iterator                                   DocumentIterator;
     typedef DocumentMap::const_iterator                             DocumentConstIterator;
     typedef MultipleDocumentPolicy<DOC_FACTORY>                     ThisType;
+    typedef CommandTable<ThisType>                                  CommandTableType;
     
     void    InitEventHandler(EventHandler& ioHandler);
     
+    // commands
+    static const CommandTableType&
+            GetCommandTable();
+    void    OpenRecentDocumentCommand(
+                const HICommandExtended&    inHICommand);
+    bool    HasDocuments() const        { return (!mDocuments.empty()); }
+    bool    HasRecentDocuments() const  { return (mHasRecentDocuments); }
+    
     void    HandleOpenDocumentAppleEvent(
                 const AEDesc&                                   directObj, 
                 AEEvent<kCoreEventClass, kAEOpenDocuments>&     event);
@@ -304,6 +314,7 @@ private:
     MenuRef                     mRecentDocumentsMenu;
     bool                        mHasRecentDocuments;
     DocumentMap                 mDocuments;
+    CommandStatusCache          mCommandStatusCache;
     OSType                      mQuitOption;
     SInt32                      mLastDocumentID;
 };
@@ -676,43 +676,7 @@ template <class DOC_FACTORY> bool
 MultipleDocumentPolicy<DOC_FACTORY>::HandleCommand(
     const HICommandExtended&    inHICommand)
 {
-    bool    handled = true;
-    
-    switch (inHICommand.commandID)
-    {
-    case kHICommandNew:
-        NewDocument(inHICommand.commandID);
-        break;
-        
-    case kHICommandOpen:
-        OpenDocument(inHICommand.commandID);
-        break;
-        
-    case kHICommandOpenRecentFile:
-        if (inHICommand.attributes & kHICommandFromMenu)
-        {
-            OpenRecentDocument(inHICommand.source.menu.menuItemIndex);
-        }
-        break;
-        
-    case kHICommandClearRecent:
-        ClearRecentDocuments();
-        break;
-        
-    case kHICommandCloseAll:
-        CloseAllDocuments();
-        break;
-        
-    case kHICommandSaveAll:
-        SaveAllDocuments();
-        break;
-        
-    default:
-        handled = false;
-        break;
-    }
-    
-    return (handled);
+    return (GetCommandTable().Process(*this, inHICommand));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -721,34 +685,55 @@ MultipleDocumentPolicy<DOC_FACTORY>::HandleUpdateStatus(
     const HICommandExtended&    inHICommand, 
     CommandData&                ioCmdData)
 {
-    bool    handled = true;
+    return (GetCommandTable().UpdateStatus(*this, inHICommand, ioCmdData, 
+                                           &mCommandStatusCache));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The table is shared by all instances of the class, and is built the first time 
+    it's needed.  The enabled state of the commands depends only on whether there are 
+    any open or recent documents, so it is cached in mCommandStatusCache, which is 
+    invalidated whenever these change.
+*/
+template <class DOC_FACTORY> const typename MultipleDocumentPolicy<DOC_FACTORY>::CommandTableType&
+MultipleDocumentPolicy<DOC_FACTORY>::GetCommandTable()
+{
+    // OpenDocument is overloaded, so we need to tell bind() which one we want.
+    typedef void    (ThisType::*CommandFunction)(UInt32);
     
-    switch (inHICommand.commandID)
+    static CommandTableType sCommandTable;
+    
+    if (sCommandTable.empty())
     {
-    case kHICommandNew:
-    case kHICommandOpen:
-        ioCmdData.SetEnabled(true);
-        break;
-        
-    case kHICommandCloseAll:
-    case kHICommandSaveAll:
-        ioCmdData.SetEnabled(!mDocuments.empty());
-        break;
-        
-    case kHICommandOpenRecent:
-        ioCmdData.SetEnabled(mHasRecentDocuments);
-        break;
-        
-    case kHICommandOpenRecentFile:
-        ioCmdData.SetEnabled(true);
-        break;
-        
-    default:
-        handled = false;
-        break;
+        CommandFunction newFn   = &ThisType::NewDocument;
+        CommandFunction openFn  = &ThisType::OpenDocument;
+        
+        sCommandTable
+            .Add(kHICommandNew,             boost::bind(newFn, _1, kHICommandNew))
+            .Add(kHICommandOpen,            boost::bind(openFn, _1, kHICommandOpen))
+            .Add(kHICommandOpenRecent,      CommandTableType::ProcessFunction(), 
+                                            boost::bind(&ThisType::HasRecentDocuments, _1))
+            .Add(kHICommandOpenRecentFile,  boost::bind(&ThisType::OpenRecentDocumentCommand, _1, _2))
+            .Add(kHICommandClearRecent,     boost::bind(&ThisType::ClearRecentDocuments, _1), 
+                                            boost::bind(&ThisType::HasRecentDocuments, _1))
+            .Add(kHICommandCloseAll,        boost::bind(&ThisType::CloseAllDocuments, _1, kAEAsk), 
+                                            boost::bind(&ThisType::HasDocuments, _1))
+            .Add(kHICommandSaveAll,         boost::bind(&ThisType::SaveAllDocuments, _1), 
+                                            boost::bind(&ThisType::HasDocuments, _1));
     }
     
-    return (handled);
+    return (sCommandTable);
+}
+
+// ------------------------------------------------------------------------------------------
+template <class DOC_FACTORY> void
+MultipleDocumentPolicy<DOC_FACTORY>::OpenRecentDocumentCommand(
+    const HICommandExtended&    inHICommand)
+{
+    if (inHICommand.attributes & kHICommandFromMenu)
+    {
+        OpenRecentDocument(inHICommand.source.menu.menuItemIndex);
+    }
 }
 
 // ------------------------------------------------------------------------------------------
@@ -1086,6 +1071,7 @@ MultipleDocumentPolicy<DOC_FACTORY>::AddDocument(boost::shared_ptr<AbstractDocum
     AbstractDocument*   document    = inDocumentPtr.get();
     
     mDocuments.insert(DocumentMap::value_type(inDocumentPtr->GetUniqueID(), inDocumentPtr));
+    mCommandStatusCache.Invalidate();
     AddRecentDocument(document);
     
     // Register for signals
@@ -1113,6 +1099,7 @@ MultipleDocumentPolicy<DOC_FACTORY>::RemoveDocument(AbstractDocument* inDocument
     // Because our document map contains a smart pointer, erase the document element will 
     // end up deleting the document proper.
     mDocuments.erase(inDocument->GetUniqueID());
+    mCommandStatusCache.Invalidate();
 }
 
 // ------------------------------------------------------------------------------------------
@@ -1172,6 +1159,7 @@ MultipleDocumentPolicy<DOC_FACTORY>::AddRecentDocumentUrl(const Url& inUrl)
     B_THROW_IF_STATUS(err);
     
     mHasRecentDocuments = true;
+    mCommandStatusCache.Invalidate();
 }
 
 // ------------------------------------------------------------------------------------------
@@ -1215,6 +1203,7 @@ MultipleDocumentPolicy<DOC_FACTORY>::ClearRecentDocuments()
     }
     
     mHasRecentDocuments = false;
+    mCommandStatusCache.Invalidate();
 }
 
 // ------------------------------------------------------------------------------------------
@@ -1272,6 +1261,7 @@ MultipleDocumentPolicy<DOC_FACTORY>::ReadRecentDocuments()
         B_THROW_IF_STATUS(err);
         
         mHasRecentDocuments = true;
+        mCommandStatusCache.Invalidate();
     }
 }
 
@@ -46,12 +46,18 @@ public:
     
     // constructors / destructor
                 Context(const Context& inContext);
+#if B_HAS_RVALUE_REFS
+                Context(Context&& inContext) throw();
+#endif
     explicit    Context(CGContextRef inContext);
     explicit    Context(CGContextRef inContext, const from_copy_t&);
     explicit    Context(const OSPtr<CGContextRef>& inContext);
                 
     // assignment
     Context&    operator = (const Context& inContext);
+#if B_HAS_RVALUE_REFS
+    Context&    operator = (Context&& inContext) throw();
+#endif
     Context&    operator = (const OSPtr<CGContextRef>& inContext);
     Context&    assign(const Context& inContext);
     Context&    assign(CGContextRef inContext);
@@ -152,6 +158,15 @@ Context::Context(const Context& inContext)
 {
 }
 
+#if B_HAS_RVALUE_REFS
+// ------------------------------------------------------------------------------------------
+inline
+Context::Context(Context&& inContext) throw()
+    : mContext(static_cast<OSPtr<CGContextRef>&&>(inContext.mContext))
+{
+}
+#endif
+
 // ------------------------------------------------------------------------------------------
 inline
 Context::Context(CGContextRef inContext)
@@ -188,6 +203,16 @@ Context::operator = (const Context& inContext)
     return (*this);
 }
 
+#if B_HAS_RVALUE_REFS
+// ------------------------------------------------------------------------------------------
+inline Context&
+Context::operator = (Context&& inContext) throw()
+{
+    mContext.swap(inContext.mContext);
+    return (*this);
+}
+#endif
+
 // ------------------------------------------------------------------------------------------
 inline Context&
 Context::operator = (const OSPtr<CGContextRef>& inContext)
@@ -91,7 +91,7 @@ Printer::GetDescriptionUrl() const
     err = PMPrinterGetDescriptionURL(mPrinter, kPMPPDDescriptionType, &fileUrl);
     B_THROW_IF_STATUS(err);
     
-    return (Url(OSPtr<CFURLRef>(fileUrl, from_copy)));
+    return (Url(fileUrl, from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -104,7 +104,7 @@ Printer::GetDeviceUrl() const
     err = PMPrinterGetDeviceURI(mPrinter, &fileUrl);
     B_THROW_IF_STATUS(err);
     
-    return (Url(OSPtr<CFURLRef>(fileUrl, from_copy)));
+    return (Url(fileUrl, from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -53,7 +53,50 @@ AEUndoAction::Perform()
     RecordComment("executing");
 #endif
     
-    AEEventBase::SendEvent(mEvent, kSendMode);
+    if (mPayload != NULL)
+    {
+        AEDescriptor    event;
+        
+        AEUndoStore::Load(*mPayload, event);
+        AEEventBase::SendEvent(event, kSendMode);
+    }
+    else
+    {
+        AEEventBase::SendEvent(mEvent, kSendMode);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Flattens @a mEvent into @a ioStore, then clears it.  Derived classes should call this 
+    after they are done building @a mEvent, typically at the end of their constructor.  
+    From then on, they should use GetEvent() if they need to look at the event.
+    
+    Calling Compact() on an action that has already been compacted does nothing.
+*/
+void
+AEUndoAction::Compact(
+    AEUndoStore&    ioStore)    //!< The store that will hold the event.
+{
+    if ((mPayload == NULL) && !mEvent.Empty())
+    {
+        mPayload = ioStore.Store(mEvent);
+        mEvent.Clear();
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+void
+AEUndoAction::GetEvent(
+    AEDescriptor&   outEvent) const //!< The output Apple %Event.
+{
+    if (mPayload != NULL)
+    {
+        AEUndoStore::Load(*mPayload, outEvent);
+    }
+    else
+    {
+        outEvent = mEvent;
+    }
 }
 
 // ------------------------------------------------------------------------------------------
@@ -23,6 +23,7 @@
 
 // B headers
 #include "BAEDescriptor.h"
+#include "BAEUndoStore.h"
 #include "BUndoAction.h"
 
 
@@ -44,7 +45,13 @@ namespace B {
     Instances of AEUndoAction are passed to implementations of UNDO_POLICY and maintained 
     by them until an %Undo or %Redo action is performed.
     
-    @sa         Undo, UNDO_POLICY
+    Because undo stacks can hold many events that differ only slightly from one another, 
+    a derived class may call Compact() once @a mEvent has been built.  This hands the 
+    event over to an AEUndoStore (typically the document's), which shares its contents 
+    with those of other actions.  The event is then re-expanded only when Perform() is 
+    called.
+    
+    @sa         Undo, UNDO_POLICY, AEUndoStore
     @ingroup    UndoGroup
 */
 class AEUndoAction : public UndoAction
@@ -59,11 +66,17 @@ protected:
     //! Constructor.
     AEUndoAction();
             
+    //! Moves @a mEvent into @a ioStore.
+    void    Compact(AEUndoStore& ioStore);
+    //! Returns the Apple %Event, expanding it if necessary.
+    void    GetEvent(AEDescriptor& outEvent) const;
+    
     //! Debugging support.
     void    RecordComment(const char* comment);
     
     // member variables
-    AEDescriptor    mEvent; //!< The Apple %Event.
+    AEDescriptor            mEvent;     //!< The Apple %Event.  Empty once the action has been compacted.
+    AEUndoStore::PayloadPtr mPayload;   //!< The compacted Apple %Event, if any.
 };
 
 
@@ -0,0 +1,359 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BAEUndoStore.h"
+
+// standard headers
+#include <algorithm>
+#include <memory>
+
+// B headers
+#include "BErrorHandler.h"
+
+
+namespace {
+
+// Content-defined chunking parameters.  A chunk boundary is placed wherever the top bits
+// of the rolling hash are all zero, which gives chunks of about 1 KB on average.  The
+// minimum and maximum sizes keep pathological inputs (eg long runs of identical bytes)
+// from producing absurdly small or large chunks.
+const size_t    kMinChunkSize   = 256;
+const size_t    kMaxChunkSize   = 8192;
+const UInt32    kBoundaryMask   = 0xFFC00000;
+
+// The table of pseudo-random values driving the rolling ("gear") hash.
+class GearTable
+{
+public:
+            
+            GearTable();
+    
+    UInt32  operator [] (UInt8 inByte) const    { return (mValues[inByte]); }
+
+private:
+    
+    UInt32  mValues[256];
+};
+
+GearTable::GearTable()
+{
+    // A linear congruential generator is good enough here;  all that matters is that
+    // the values be well distributed, and identical from one run to the next.
+    
+    UInt32  seed    = 0x2545F491;
+    
+    for (unsigned i = 0; i < 256; i++)
+    {
+        seed        = seed * 1664525 + 1013904223;
+        mValues[i]  = seed;
+    }
+}
+
+const GearTable gGearTable;
+
+}   // anonymous namespace
+
+
+namespace B {
+
+// ==========================================================================================
+//  AEUndoStore::Chunk
+
+#pragma mark AEUndoStore::Chunk
+
+class AEUndoStore::Chunk : public boost::noncopyable
+{
+public:
+    
+    // constructor
+    Chunk(
+        AEUndoStore&    inStore,
+        size_t          inHash,
+        const UInt8*    inData,
+        size_t          inSize);
+    
+    // member variables
+    AEUndoStore&                mStore;
+    const size_t                mHash;
+    const std::vector<UInt8>    mData;
+    SInt32                      mRefCount;
+};
+
+// ------------------------------------------------------------------------------------------
+AEUndoStore::Chunk::Chunk(
+    AEUndoStore&    inStore,
+    size_t          inHash,
+    const UInt8*    inData,
+    size_t          inSize)
+        : mStore(inStore), mHash(inHash), mData(inData, inData + inSize), mRefCount(0)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+void    intrusive_ptr_add_ref(AEUndoStore::Chunk* c)
+{
+    B_ASSERT(c != NULL);
+    
+    IncrementAtomic(&c->mRefCount);
+}
+
+// ------------------------------------------------------------------------------------------
+void    intrusive_ptr_release(AEUndoStore::Chunk* c)
+{
+    B_ASSERT(c != NULL);
+    B_ASSERT(c->mRefCount > 0);
+    
+    if (DecrementAtomic(&c->mRefCount) == 1)
+    {
+        // The ref count is now zero, so no payload refers to this chunk anymore.
+        c->mStore.Forget(c);
+        delete c;
+    }
+}
+
+
+// ==========================================================================================
+//  AEUndoStore::Payload
+
+#pragma mark -
+#pragma mark AEUndoStore::Payload
+
+// ------------------------------------------------------------------------------------------
+AEUndoStore::Payload::Payload(
+    boost::shared_ptr<AEUndoStore>  inStore,
+    size_t                          inSize)
+        : mStore(inStore), mSize(inSize)
+{
+    mStore->mPayloadCount++;
+    mStore->mLogicalBytes += mSize;
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Releasing the payload's chunks may cause them to be removed from the store.  Because
+    @a mStore is declared before @a mChunks, the store is guaranteed to outlive them.
+*/
+AEUndoStore::Payload::~Payload()
+{
+    mStore->mPayloadCount--;
+    mStore->mLogicalBytes -= mSize;
+}
+
+
+// ==========================================================================================
+//  AEUndoStore
+
+#pragma mark -
+#pragma mark AEUndoStore
+
+// ------------------------------------------------------------------------------------------
+boost::shared_ptr<AEUndoStore>
+AEUndoStore::Make()
+{
+    return (boost::shared_ptr<AEUndoStore>(new AEUndoStore));
+}
+
+// ------------------------------------------------------------------------------------------
+AEUndoStore::AEUndoStore()
+    : mPayloadCount(0), mLogicalBytes(0), mStoredBytes(0)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+AEUndoStore::~AEUndoStore()
+{
+    // Every payload holds a reference to us, so by the time we get here all chunks
+    // should be gone.
+    
+    B_ASSERT(mChunks.empty());
+    B_ASSERT(mPayloadCount == 0);
+}
+
+// ------------------------------------------------------------------------------------------
+AEUndoStore::Statistics
+AEUndoStore::GetStatistics() const
+{
+    Statistics  stats;
+    
+    stats.mPayloadCount = mPayloadCount;
+    stats.mChunkCount   = mChunks.size();
+    stats.mLogicalBytes = mLogicalBytes;
+    stats.mStoredBytes  = mStoredBytes;
+    
+    return (stats);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The descriptor is flattened, and the flattened bytes are split into chunks.  Chunks
+    that are already present in the store are shared rather than copied.
+    
+    @return     The new payload.  It keeps the store alive for as long as it exists.
+*/
+AEUndoStore::PayloadPtr
+AEUndoStore::Store(
+    const AEDesc&   inDesc) //!< The descriptor to compact.
+{
+    ::Size              size    = AESizeOfFlattenedDesc(&inDesc);
+    std::vector<UInt8>  buff(size);
+    OSStatus            err;
+    
+    B_ASSERT(size > 0);
+    
+    err = AEFlattenDesc(&inDesc, reinterpret_cast<Ptr>(&buff[0]), size, &size);
+    B_THROW_IF_STATUS(err);
+    
+    boost::shared_ptr<Payload>  payload(new Payload(shared_from_this(), size));
+    const UInt8*                data    = &buff[0];
+    size_t                      left    = size;
+    
+    while (left > 0)
+    {
+        size_t  chunkSize   = FindBoundary(data, left);
+        
+        payload->mChunks.push_back(Intern(data, chunkSize));
+        
+        data += chunkSize;
+        left -= chunkSize;
+    }
+    
+    return (payload);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The previous contents of @a outDesc, if any, are disposed.
+*/
+void
+AEUndoStore::Load(
+    const Payload&  inPayload,  //!< The payload to expand.
+    AEDesc&         outDesc)    //!< The output descriptor.
+{
+    std::vector<UInt8>  buff;
+    AEDesc              tempDesc;
+    OSStatus            err;
+    
+    buff.reserve(inPayload.mSize);
+    
+    for (std::vector<ChunkPtr>::const_iterator it = inPayload.mChunks.begin();
+         it != inPayload.mChunks.end();
+         ++it)
+    {
+        buff.insert(buff.end(), (*it)->mData.begin(), (*it)->mData.end());
+    }
+    
+    B_ASSERT(buff.size() == inPayload.mSize);
+    
+    err = AEUnflattenDesc(reinterpret_cast<Ptr>(&buff[0]), &tempDesc);
+    B_THROW_IF_STATUS(err);
+    
+    AEDisposeDesc(&outDesc);
+    outDesc = tempDesc;
+}
+
+// ------------------------------------------------------------------------------------------
+AEUndoStore::ChunkPtr
+AEUndoStore::Intern(
+    const UInt8*    inData,
+    size_t          inSize)
+{
+    size_t                                      hash    = HashBytes(inData, inSize);
+    std::pair<ChunkMap::iterator, ChunkMap::iterator>   range   = mChunks.equal_range(hash);
+    
+    for (ChunkMap::iterator it = range.first; it != range.second; ++it)
+    {
+        const Chunk*    chunk   = it->second;
+        
+        if ((chunk->mData.size() == inSize) &&
+            std::equal(chunk->mData.begin(), chunk->mData.end(), inData))
+        {
+            return (ChunkPtr(it->second));
+        }
+    }
+    
+    std::auto_ptr<Chunk>    chunkPtr(new Chunk(*this, hash, inData, inSize));
+    
+    mChunks.insert(ChunkMap::value_type(hash, chunkPtr.get()));
+    mStoredBytes += inSize;
+    
+    return (ChunkPtr(chunkPtr.release()));
+}
+
+// ------------------------------------------------------------------------------------------
+void
+AEUndoStore::Forget(
+    Chunk*  inChunk)
+{
+    std::pair<ChunkMap::iterator, ChunkMap::iterator>   range   = mChunks.equal_range(inChunk->mHash);
+    
+    for (ChunkMap::iterator it = range.first; it != range.second; ++it)
+    {
+        if (it->second == inChunk)
+        {
+            mChunks.erase(it);
+            mStoredBytes -= inChunk->mData.size();
+            break;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the size of the chunk starting at @a inData.  The boundary is determined by a
+    rolling hash over the last 32 bytes, so that inserting or deleting bytes in one part
+    of a descriptor doesn't change the chunks in the rest of it.
+*/
+size_t
+AEUndoStore::FindBoundary(
+    const UInt8*    inData,
+    size_t          inSize)
+{
+    if (inSize <= kMinChunkSize)
+        return (inSize);
+    
+    size_t  limit   = std::min(inSize, kMaxChunkSize);
+    UInt32  hash    = 0;
+    
+    for (size_t i = 0; i < limit; i++)
+    {
+        hash = (hash << 1) + gGearTable[inData[i]];
+        
+        if ((i >= kMinChunkSize) && ((hash & kBoundaryMask) == 0))
+            return (i + 1);
+    }
+    
+    return (limit);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! This is the 32-bit FNV-1a hash.
+*/
+size_t
+AEUndoStore::HashBytes(
+    const UInt8*    inData,
+    size_t          inSize)
+{
+    UInt32  hash    = 2166136261U;
+    
+    for (size_t i = 0; i < inSize; i++)
+    {
+        hash ^= inData[i];
+        hash *= 16777619U;
+    }
+    
+    return (hash);
+}
+
+}   // namespace B
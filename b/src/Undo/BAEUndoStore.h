@@ -0,0 +1,184 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BAEUndoStore_H_
+#define BAEUndoStore_H_
+
+#pragma once
+
+// standard headers
+#include <vector>
+
+// system headers
+#include <Carbon/Carbon.h>
+
+// library headers
+#if defined(__MWERKS__)
+#   include <hash_map>
+#elif defined(__GNUC__)
+#   include <ext/hash_map>
+#endif
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/intrusive_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+
+namespace B {
+
+/*! @brief  Shared, compacted storage for the Apple Events of AEUndoAction objects.
+    
+    A given document's undo stack will often contain many Apple Events that differ
+    only slightly from one another (think of successive "set value" events on a large
+    property list item).  Rather than keep a complete copy of each event, an AEUndoAction
+    may hand its event over to an AEUndoStore, which flattens it and splits the flattened
+    bytes into content-defined chunks.  Each chunk is identified by a hash of its
+    contents, and identical chunks are stored only once, regardless of how many events
+    contain them.  Because chunk boundaries depend on the data rather than on fixed
+    offsets, two events differing only in a few bytes end up sharing all but one or
+    two chunks.
+    
+    The store is reference-counted via @c boost::shared_ptr;  each payload keeps its
+    store alive, so that undo actions may safely outlive the document that created them.
+    
+    AEUndoStore is not thread-safe.  Like the rest of the undo mechanism, it is meant
+    to be used from the main thread only.
+    
+    @sa         AEUndoAction, AbstractDocument::GetUndoStore()
+    @ingroup    UndoGroup
+*/
+class AEUndoStore : public boost::enable_shared_from_this<AEUndoStore>,
+                    public boost::noncopyable
+{
+private:
+    
+    class   Chunk;
+    
+    // types
+    typedef boost::intrusive_ptr<Chunk> ChunkPtr;
+
+public:
+    
+    //! @name Types
+    //@{
+    //! Memory usage of a store.
+    struct Statistics
+    {
+        //! The number of live payloads (i.e., compacted Apple Events).
+        size_t  mPayloadCount;
+        //! The number of distinct chunks held by the store.
+        size_t  mChunkCount;
+        //! The sum of the flattened sizes of all live payloads.
+        size_t  mLogicalBytes;
+        //! The number of bytes actually held in chunks.
+        size_t  mStoredBytes;
+    };
+    
+    /*! @brief  An immutable, compacted Apple %Event descriptor.
+        
+        Payloads are created by AEUndoStore::Store() and expanded by
+        AEUndoStore::Load().
+    */
+    class Payload : public boost::noncopyable
+    {
+    public:
+        
+        //! Destructor.
+        ~Payload();
+        
+        //! Returns the size of the flattened descriptor.
+        size_t  size() const    { return (mSize); }
+    
+    private:
+        
+        // constructor
+        Payload(boost::shared_ptr<AEUndoStore> inStore, size_t inSize);
+        
+        // member variables
+        boost::shared_ptr<AEUndoStore>  mStore;     // must precede mChunks
+        std::vector<ChunkPtr>           mChunks;
+        const size_t                    mSize;
+        
+        // friends
+        friend class    AEUndoStore;
+    };
+    
+    //! Smart pointer to a payload.
+    typedef boost::shared_ptr<const Payload>    PayloadPtr;
+    //@}
+    
+    //! @name Instantiation
+    //@{
+    //! Creates a new, empty store.
+    static boost::shared_ptr<AEUndoStore>   Make();
+    //@}
+    
+    //! @name Destructor
+    //@{
+    ~AEUndoStore();
+    //@}
+    
+    //! @name Inquiries
+    //@{
+    //! Returns the store's current memory usage.
+    Statistics  GetStatistics() const;
+    //@}
+    
+    //! @name Storage
+    //@{
+    //! Compacts @a inDesc into a new payload.
+    PayloadPtr  Store(const AEDesc& inDesc);
+    //! Expands @a inPayload into @a outDesc.
+    static void Load(const Payload& inPayload, AEDesc& outDesc);
+    //@}
+
+private:
+    
+    // types
+#if defined(__MWERKS__)
+    typedef Metrowerks::hash_multimap<size_t, Chunk*>   ChunkMap;
+#elif defined(__GNUC__)
+    typedef __gnu_cxx::hash_multimap<size_t, Chunk*>    ChunkMap;
+#endif
+    
+    // constructor
+    AEUndoStore();
+    
+    ChunkPtr    Intern(const UInt8* inData, size_t inSize);
+    void        Forget(Chunk* inChunk);
+    
+    static size_t   FindBoundary(const UInt8* inData, size_t inSize);
+    static size_t   HashBytes(const UInt8* inData, size_t inSize);
+    
+    // member variables
+    ChunkMap    mChunks;
+    size_t      mPayloadCount;
+    size_t      mLogicalBytes;
+    size_t      mStoredBytes;
+    
+    // friends
+    friend class    Payload;
+    friend void     intrusive_ptr_add_ref(Chunk* c);
+    friend void     intrusive_ptr_release(Chunk* c);
+};
+
+
+}   // namespace B
+
+
+#endif  // BAEUndoStore_H_
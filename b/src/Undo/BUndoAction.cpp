@@ -43,6 +43,33 @@ UndoAction::~UndoAction()
 {
 }
 
+#if B_ALLOCATION_ACCOUNTING
+// ------------------------------------------------------------------------------------------
+/*! Since the destructor is virtual, @a inSize is the size of the most-derived class, 
+    which is what operator delete() will be given as well.
+*/
+void*
+UndoAction::operator new (size_t inSize)
+{
+    void*   ptr = ::operator new (inSize);
+    
+    AllocationAccounting::Allocated(AllocationAccounting::kUndoActions, inSize);
+    
+    return (ptr);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+UndoAction::operator delete (void* inPtr, size_t inSize)
+{
+    if (inPtr != NULL)
+    {
+        AllocationAccounting::Deallocated(AllocationAccounting::kUndoActions, inSize);
+        ::operator delete (inPtr);
+    }
+}
+#endif
+
 // ------------------------------------------------------------------------------------------
 /*! This is a pure abstract function, which all derived classes must override.
 */
@@ -21,10 +21,16 @@
 
 #pragma once
 
+// standard headers
+#include <cstddef>
+
 // library headers
 #include <boost/function.hpp>
 #include <boost/utility.hpp>
 
+// B headers
+#include "BAllocationAccounting.h"
+
 
 namespace B {
 
@@ -64,6 +70,16 @@ public:
     //! Coalescing of undo actions.
     virtual bool    Coalesce(UndoAction* inLastAction);
     
+#if B_ALLOCATION_ACCOUNTING
+    //! @name Allocation
+    //@{
+    //! Allocates an object of @a inSize bytes, and counts it.
+    static void*    operator new (size_t inSize);
+    //! Frees an object of @a inSize bytes, and counts it.
+    static void     operator delete (void* inPtr, size_t inSize);
+    //@}
+#endif
+    
 protected:
     
     //! Constructor.
@@ -0,0 +1,258 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BAllocationAccounting.h"
+
+// standard headers
+#include <iomanip>
+#include <ostream>
+
+// system headers
+#include <stdint.h>
+
+// B headers
+#include "BAtomic.h"
+#include "BErrorHandler.h"
+
+
+namespace {
+
+const char* const   kSubsystemNames[B::AllocationAccounting::kSubsystemCount] = {
+                        "OSPtr", 
+                        "Handles", 
+                        "AEWriter", 
+                        "UndoActions", 
+                        "Views", 
+                    };
+
+}   // anonymous namespace
+
+
+namespace B {
+
+// ==========================================================================================
+//  AllocationAccounting::Tag
+
+/*! The counters for one subsystem.  They're padded out to a cache line, so that 
+    subsystems that are busy at the same time don't contend for it.
+*/
+struct AllocationAccounting::Tag
+{
+    volatile int32_t    mLiveObjects;
+    volatile int32_t    mLiveBytes;
+    volatile int32_t    mPeakBytes;
+    volatile int32_t    mAllocations;
+    volatile int32_t    mBytesAllocated;
+    char                mPadding[64 - 5 * sizeof(int32_t)];
+};
+
+
+// ==========================================================================================
+//  AllocationAccounting
+
+#pragma mark -
+#pragma mark AllocationAccounting
+
+// The counters are plain data, so they're zeroed before any static constructor (which 
+// might create an OSPtr) gets to run.
+AllocationAccounting::Tag   AllocationAccounting::sTags[kSubsystemCount];
+
+// ------------------------------------------------------------------------------------------
+/*! Counters that are being updated concurrently may be read at slightly different 
+    times.
+*/
+void
+AllocationAccounting::GetCounters(
+    Subsystem   inSubsystem, 
+    Counters&   outCounters)
+{
+    B_ASSERT((inSubsystem >= 0) && (inSubsystem < kSubsystemCount));
+    
+    const Tag&  tag = sTags[inSubsystem];
+    
+    outCounters.mLiveObjects    = tag.mLiveObjects;
+    outCounters.mLiveBytes      = tag.mLiveBytes;
+    outCounters.mPeakBytes      = tag.mPeakBytes;
+    outCounters.mAllocations    = static_cast<uint32_t>(tag.mAllocations);
+    outCounters.mBytesAllocated = static_cast<uint32_t>(tag.mBytesAllocated);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+AllocationAccounting::TakeSnapshot(
+    Snapshot&   outSnapshot)
+{
+    outSnapshot.mTime = CFAbsoluteTimeGetCurrent();
+    
+    for (int i = 0; i < kSubsystemCount; i++)
+        GetCounters(static_cast<Subsystem>(i), outSnapshot.mCounters[i]);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! On output, each counter in @a outGrowth holds the counter's value in @a inAfter 
+    minus its value in @a inBefore, except for @c mPeakBytes, which is copied from 
+    @a inAfter.  @c mTime holds the number of seconds between the two snapshots.
+    
+    The cumulative counters are subtracted modulo 2<sup>32</sup>, so the result is 
+    correct even if they wrapped around in between (once).
+*/
+void
+AllocationAccounting::GetDifference(
+    const Snapshot& inBefore, 
+    const Snapshot& inAfter, 
+    Snapshot&       outGrowth)
+{
+    outGrowth.mTime = inAfter.mTime - inBefore.mTime;
+    
+    for (int i = 0; i < kSubsystemCount; i++)
+    {
+        const Counters& before  = inBefore.mCounters[i];
+        const Counters& after   = inAfter.mCounters[i];
+        Counters&       growth  = outGrowth.mCounters[i];
+        
+        growth.mLiveObjects     = after.mLiveObjects - before.mLiveObjects;
+        growth.mLiveBytes       = after.mLiveBytes - before.mLiveBytes;
+        growth.mPeakBytes       = after.mPeakBytes;
+        growth.mAllocations     = static_cast<uint32_t>(after.mAllocations - before.mAllocations);
+        growth.mBytesAllocated  = static_cast<uint32_t>(after.mBytesAllocated - before.mBytesAllocated);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+const char*
+AllocationAccounting::GetSubsystemName(
+    Subsystem   inSubsystem)
+{
+    B_ASSERT((inSubsystem >= 0) && (inSubsystem < kSubsystemCount));
+    
+    return (kSubsystemNames[inSubsystem]);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Each line gives one subsystem's counters.
+*/
+void
+AllocationAccounting::PrintSnapshot(
+    const Snapshot& inSnapshot, 
+    std::ostream&   ostr)
+{
+    ostr << "subsystem       objects        bytes   peak bytes       allocs  bytes alloced\n";
+    
+    for (int i = 0; i < kSubsystemCount; i++)
+    {
+        const Counters& counters    = inSnapshot.mCounters[i];
+        
+        ostr << std::left << std::setw(12) << kSubsystemNames[i] << std::right
+             << std::setw(11) << counters.mLiveObjects << " "
+             << std::setw(12) << counters.mLiveBytes << " "
+             << std::setw(12) << counters.mPeakBytes << " "
+             << std::setw(12) << counters.mAllocations << " "
+             << std::setw(14) << counters.mBytesAllocated << "\n";
+    }
+    
+    ostr.flush();
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Each line gives the growth in one subsystem's live objects and bytes, followed by 
+    its allocation rate over the interval, in objects and bytes per second.  Subsystems 
+    whose live objects grew are flagged with an asterisk.
+*/
+void
+AllocationAccounting::PrintDifference(
+    const Snapshot& inBefore, 
+    const Snapshot& inAfter, 
+    std::ostream&   ostr)
+{
+    Snapshot    growth;
+    
+    GetDifference(inBefore, inAfter, growth);
+    
+    double              seconds     = (growth.mTime > 0.0) ? growth.mTime : 1.0;
+    std::ios::fmtflags  flags       = ostr.flags();
+    std::streamsize     precision   = ostr.precision();
+    
+    ostr << "over " << std::fixed << std::setprecision(3) << growth.mTime << " s\n"
+         << "subsystem       objects        bytes      allocs/s       bytes/s\n";
+    
+    for (int i = 0; i < kSubsystemCount; i++)
+    {
+        const Counters& counters    = growth.mCounters[i];
+        
+        ostr << std::left << std::setw(12) << kSubsystemNames[i] << std::right
+             << std::showpos
+             << std::setw(11) << counters.mLiveObjects << " "
+             << std::setw(12) << counters.mLiveBytes << " "
+             << std::noshowpos << std::setprecision(1)
+             << std::setw(13) << (counters.mAllocations / seconds) << " "
+             << std::setw(13) << (counters.mBytesAllocated / seconds)
+             << ((counters.mLiveObjects > 0) ? "  *" : "") << "\n";
+    }
+    
+    ostr.flags(flags);
+    ostr.precision(precision);
+    ostr.flush();
+}
+
+// ------------------------------------------------------------------------------------------
+/*! A peak that is being raised concurrently may end up slightly above its subsystem's 
+    current number of live bytes.
+*/
+void
+AllocationAccounting::ResetPeaks()
+{
+    for (int i = 0; i < kSubsystemCount; i++)
+        sTags[i].mPeakBytes = sTags[i].mLiveBytes;
+}
+
+// ------------------------------------------------------------------------------------------
+void
+AllocationAccounting::Record(
+    Subsystem   inSubsystem, 
+    int         inObjects, 
+    long        inBytes) throw()
+{
+    Tag&    tag = sTags[inSubsystem];
+    
+    if (inObjects != 0)
+        AtomicAdd(&tag.mLiveObjects, inObjects);
+    
+    if (inObjects > 0)
+        AtomicAdd(&tag.mAllocations, 1);
+    
+    if (inBytes == 0)
+        return;
+    
+    int32_t liveBytes   = AtomicAdd(&tag.mLiveBytes, static_cast<int32_t>(inBytes));
+    
+    if (inBytes < 0)
+        return;
+    
+    AtomicAdd(&tag.mBytesAllocated, static_cast<int32_t>(inBytes));
+    
+    // Raise the peak, unless another thread beats us to it.
+    
+    for (int32_t peak = tag.mPeakBytes; liveBytes > peak; peak = tag.mPeakBytes)
+    {
+        if (AtomicCompareAndSwap(peak, liveBytes, &tag.mPeakBytes))
+            break;
+    }
+}
+
+}   // namespace B
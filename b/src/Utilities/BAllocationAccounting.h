@@ -0,0 +1,251 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BAllocationAccounting_H_
+#define BAllocationAccounting_H_
+
+#pragma once
+
+// standard headers
+#include <cstddef>
+#include <iosfwd>
+
+// system headers
+#include <CoreFoundation/CFDate.h>
+
+
+/*! @defgroup   AllocationAccountingGroup   Allocation Accounting
+    
+    The macros in this group control the instrumentation of B's memory-owning wrappers.
+    
+    @ingroup    Utilities
+*/
+//@{
+
+#ifndef B_ALLOCATION_ACCOUNTING
+#   define B_ALLOCATION_ACCOUNTING  0
+#elif DOXYGEN_SCAN
+    /*! @def    B_ALLOCATION_ACCOUNTING
+        @brief  Determines whether allocations are counted per subsystem.
+        
+        Defining B_ALLOCATION_ACCOUNTING to a non-zero value makes OSPtr, the Memory 
+        Manager wrappers, AEWriter, UndoAction and View report what they acquire and 
+        release to AllocationAccounting.  It's off by default, in which case the 
+        instrumentation compiles to nothing.
+        
+        @relates    AllocationAccounting
+    */
+#   define B_ALLOCATION_ACCOUNTING  1
+#endif
+
+//@}
+
+
+namespace B {
+
+/*!
+    @brief  Keeps track of how much memory each of B's subsystems owns.
+    
+    AllocationAccounting answers the question "which part of the framework is holding 
+    on to all that memory?".  The classes that own memory on behalf of the application 
+    tag each acquisition and release with a Subsystem, and AllocationAccounting keeps 
+    the following counters for each one:
+    
+        - the number of live objects, and the number of bytes they occupy;
+        - the highest number of live bytes seen so far;
+        - the cumulative number of allocations, and of bytes allocated.
+    
+    The counters are updated with atomic operations, so recording takes no locks and 
+    performs no allocation.  They're 32 bits wide;  the cumulative ones wrap around, 
+    which is harmless as long as they are only ever subtracted from each other.
+    
+    What gets counted depends on the subsystem:
+    
+        - kOSPtr counts the references held by OSPtr objects, whether they were 
+          obtained by retaining an object or by adopting one from a "Create" or "Copy" 
+          function.  The objects themselves may be shared, so no bytes are counted.
+        - kHandles counts the handles and pointers owned by AutoMacHandle, 
+          AutoTypedHandle and AutoMacPtr, along with their sizes.  A handle is 
+          measured when its wrapper acquires, resizes or gives it up, so resizing it 
+          behind the wrapper's back skews the byte counts.
+        - kAEWriter counts the @c AEStreamRefs opened by AEWriter.  Their buffers are 
+          private to the Apple %Event Manager, so no bytes are counted.
+        - kUndoActions counts UndoAction objects and their (dynamic) sizes.
+        - kViews counts View objects.  Most of a view's memory belongs to its 
+          @c HIViewRef, so no bytes are counted.
+    
+    For finding leaks, the interesting number is usually the number of live objects.  
+    Take a Snapshot, run through the suspect operation (opening and closing a document, 
+    say) a few times, take another Snapshot, and print the difference:  any subsystem 
+    whose live objects keep growing is holding on to something.  The difference also 
+    gives each subsystem's allocation rate over the interval.
+    
+    The instrumentation is only compiled in if B_ALLOCATION_ACCOUNTING is non-zero.  If 
+    it isn't, the counters stay at zero.
+    
+    @ingroup    Utilities
+*/
+class AllocationAccounting
+{
+public:
+    
+    //! @name Types
+    //@{
+    
+    //! The subsystems whose allocations are counted.
+    enum Subsystem
+    {
+        kOSPtr,             //!< References held by OSPtr.
+        kHandles,           //!< Handles and pointers owned by the Memory Manager wrappers.
+        kAEWriter,          //!< Apple %Event streams opened by AEWriter.
+        kUndoActions,       //!< UndoAction objects.
+        kViews,             //!< View objects.
+        kSubsystemCount     //!< The number of subsystems.
+    };
+    
+    //! The counters for one subsystem.
+    struct Counters
+    {
+        long            mLiveObjects;       //!< The number of objects currently allocated.
+        long            mLiveBytes;         //!< The number of bytes currently allocated.
+        long            mPeakBytes;         //!< The highest value of mLiveBytes so far.
+        unsigned long   mAllocations;       //!< The number of objects allocated so far.
+        unsigned long   mBytesAllocated;    //!< The number of bytes allocated so far.
+    };
+    
+    //! The counters for all subsystems, at a given time.
+    struct Snapshot
+    {
+        CFAbsoluteTime  mTime;                          //!< When the snapshot was taken.
+        Counters        mCounters[kSubsystemCount];     //!< Indexed by Subsystem.
+    };
+    
+    //@}
+    
+    //! @name Recording
+    //@{
+    //! Counts a new object of @a inSize bytes belonging to @a inSubsystem.
+    static void     Allocated(
+                        Subsystem   inSubsystem, 
+                        size_t      inSize = 0) throw();
+    //! Counts the release of an object of @a inSize bytes belonging to @a inSubsystem.
+    static void     Deallocated(
+                        Subsystem   inSubsystem, 
+                        size_t      inSize = 0) throw();
+    //! Counts a change in an object's size from @a inOldSize to @a inNewSize bytes.
+    static void     Resized(
+                        Subsystem   inSubsystem, 
+                        size_t      inOldSize, 
+                        size_t      inNewSize) throw();
+    //@}
+    
+    //! @name Inquiries
+    //@{
+    //! Fills @a outCounters with @a inSubsystem's current counters.
+    static void     GetCounters(
+                        Subsystem   inSubsystem, 
+                        Counters&   outCounters);
+    //! Fills @a outSnapshot with the current counters of every subsystem.
+    static void     TakeSnapshot(
+                        Snapshot&   outSnapshot);
+    //! Fills @a outGrowth with the change in each counter between @a inBefore and @a inAfter.
+    static void     GetDifference(
+                        const Snapshot& inBefore, 
+                        const Snapshot& inAfter, 
+                        Snapshot&       outGrowth);
+    //! Returns a human-readable name for @a inSubsystem.
+    static const char*  GetSubsystemName(
+                        Subsystem   inSubsystem);
+    //@}
+    
+    //! @name Reporting
+    //@{
+    //! Writes @a inSnapshot to @a ostr, in human-readable form.
+    static void     PrintSnapshot(
+                        const Snapshot& inSnapshot, 
+                        std::ostream&   ostr);
+    //! Writes the growth between @a inBefore and @a inAfter to @a ostr, in human-readable form.
+    static void     PrintDifference(
+                        const Snapshot& inBefore, 
+                        const Snapshot& inAfter, 
+                        std::ostream&   ostr);
+    //! Lowers each subsystem's peak to its current number of live bytes.
+    static void     ResetPeaks();
+    //@}
+    
+private:
+    
+    struct Tag;
+    
+    static void     Record(
+                        Subsystem   inSubsystem, 
+                        int         inObjects, 
+                        long        inBytes) throw();
+    
+    // static member variables
+    static Tag      sTags[kSubsystemCount];
+};
+
+// ------------------------------------------------------------------------------------------
+inline void
+AllocationAccounting::Allocated(
+    Subsystem   inSubsystem, 
+    size_t      inSize /* = 0 */) throw()
+{
+#if B_ALLOCATION_ACCOUNTING
+    Record(inSubsystem, 1, static_cast<long>(inSize));
+#else
+    (void) inSubsystem;
+    (void) inSize;
+#endif
+}
+
+// ------------------------------------------------------------------------------------------
+inline void
+AllocationAccounting::Deallocated(
+    Subsystem   inSubsystem, 
+    size_t      inSize /* = 0 */) throw()
+{
+#if B_ALLOCATION_ACCOUNTING
+    Record(inSubsystem, -1, -static_cast<long>(inSize));
+#else
+    (void) inSubsystem;
+    (void) inSize;
+#endif
+}
+
+// ------------------------------------------------------------------------------------------
+inline void
+AllocationAccounting::Resized(
+    Subsystem   inSubsystem, 
+    size_t      inOldSize, 
+    size_t      inNewSize) throw()
+{
+#if B_ALLOCATION_ACCOUNTING
+    Record(inSubsystem, 0, static_cast<long>(inNewSize) - static_cast<long>(inOldSize));
+#else
+    (void) inSubsystem;
+    (void) inOldSize;
+    (void) inNewSize;
+#endif
+}
+
+}   // namespace B
+
+
+#endif  // BAllocationAccounting_H_
@@ -336,6 +336,10 @@ public:
                 Array();
     //! Copy constructor.
                 Array(const Array& arr);
+#if B_HAS_RVALUE_REFS
+    //! Move constructor.
+                Array(Array&& arr) throw();
+#endif
     //! Allocator constructor.
     explicit    Array(CFAllocatorRef allocator);
     //! Size constructor.
@@ -346,10 +350,12 @@ public:
     explicit    Array(const MutableArray<T>& arr);
     //! @c CFArrayRef constructor.
     explicit    Array(CFArrayRef cfarr);
+    //! @c CFArrayRef constructor.  Takes ownership of @a cfarr.
+    explicit    Array(CFArrayRef cfarr, const from_copy_t&);
     //! @c OSPtr<CFArrayRef> constructor.
-    explicit    Array(OSPtr<CFArrayRef> cfarr);
+    explicit    Array(const OSPtr<CFArrayRef>& cfarr);
     //! @c OSPtr<CFMutableArrayRef> constructor.
-    explicit    Array(OSPtr<CFMutableArrayRef> cfarr);
+    explicit    Array(const OSPtr<CFMutableArrayRef>& cfarr);
     //! @c vector constructor.
     explicit    Array(const std::vector<value_type>& vec);
     //! Range constructor.
@@ -379,14 +385,18 @@ public:
     //@{
     //! Replaces all existing elements with copies of the elements of @a arr.
     Array&  operator = (const Array& arr);
+#if B_HAS_RVALUE_REFS
+    //! Takes over the elements of @a arr.
+    Array&  operator = (Array&& arr) throw();
+#endif
     //! MutableArray assignemnt.
     Array&  operator = (const MutableArray<T>& arr);
     //! @c CFArrayRef assignemnt.
     Array&  operator = (CFArrayRef cfarr);
     //! @c OSPtr<CFArrayRef> assignemnt.
-    Array&  operator = (OSPtr<CFArrayRef> cfarr);
+    Array&  operator = (const OSPtr<CFArrayRef>& cfarr);
     //! @c OSPtr<CFMutableArrayRef> assignemnt.
-    Array&  operator = (OSPtr<CFMutableArrayRef> cfarr);
+    Array&  operator = (const OSPtr<CFMutableArrayRef>& cfarr);
     //! @c vector assignemnt.
     Array&  operator = (const std::vector<value_type>& vec);
     //! Replaces all existing elements with @a num copies of @a value.
@@ -462,13 +472,29 @@ Array<T>::Array()
 }
 
 // ------------------------------------------------------------------------------------------
-/*! Creates a shallow copy of @a arr.
+/*! Creates a shallow copy of @a arr.  Copying a moved-from array yields another 
+    moved-from array.
 */
 template <typename T> inline
 Array<T>::Array(const Array& arr)
+    : mRef(NULL)
 {
-    init_array(arr.cf_ref(), NULL, 0, arr.get_allocator());
+    if (arr.mRef != NULL)
+        init_array(arr.cf_ref(), NULL, 0, arr.get_allocator());
+}
+
+#if B_HAS_RVALUE_REFS
+// ------------------------------------------------------------------------------------------
+/*! Takes over @a arr's underlying @c CFArrayRef.  @a arr may then only be assigned to, 
+    copied or destroyed.
+*/
+template <typename T> inline
+Array<T>::Array(Array&& arr) throw()
+    : mRef(arr.mRef)
+{
+    arr.mRef = NULL;
 }
+#endif
 
 // ------------------------------------------------------------------------------------------
 /*! Creates an empty array using @a allocator.
@@ -524,12 +550,28 @@ Array<T>::Array(
     B_THROW_IF_NULL(mRef);
 }
 
+// ------------------------------------------------------------------------------------------
+/*! Takes ownership of @a cfarr, which must have been obtained from a "Create" or "Copy" 
+    function, without copying or retaining it.  The caller must not change @a cfarr 
+    afterwards.
+    
+    @exception  std::bad_alloc  If @a cfarr is @c NULL.
+*/
+template <typename T> inline
+Array<T>::Array(
+    CFArrayRef          cfarr,  //!< The source array.
+    const from_copy_t&)
+        : mRef(cfarr)
+{
+    B_THROW_IF_NULL(mRef);
+}
+
 // ------------------------------------------------------------------------------------------
 /*! Creates an array as a copy of @a cfarr, using @a cfarr's allocator.
 */
 template <typename T> inline
 Array<T>::Array(
-    OSPtr<CFArrayRef>   cfarr)  //!< The source array.
+    const OSPtr<CFArrayRef>&    cfarr)  //!< The source array.
 {
     B_ASSERT(cfarr != NULL);
     
@@ -541,7 +583,7 @@ Array<T>::Array(
 */
 template <typename T> inline
 Array<T>::Array(
-    OSPtr<CFMutableArrayRef>    cfarr)  //!< The source array.
+    const OSPtr<CFMutableArrayRef>& cfarr)  //!< The source array.
 {
     B_ASSERT(cfarr != NULL);
     
@@ -575,7 +617,8 @@ Array<T>::Array(InputIterator first, InputIterator last, CFAllocatorRef allocato
 template <typename T> inline
 Array<T>::~Array()
 {
-    CFRelease(mRef);
+    if (mRef != NULL)
+        CFRelease(mRef);
 }
 
 // ------------------------------------------------------------------------------------------
@@ -626,13 +669,28 @@ Array<T>::capacity() const
 template <typename T> inline Array<T>&
 Array<T>::operator = (const Array& arr)
 {
-    CFRetain(arr.cf_ref());
-    CFRelease(mRef);
+    if (arr.mRef != NULL)
+        CFRetain(arr.mRef);
+    
+    if (mRef != NULL)
+        CFRelease(mRef);
+    
     mRef = arr.cf_ref();
     
     return (*this);
 }
 
+#if B_HAS_RVALUE_REFS
+// ------------------------------------------------------------------------------------------
+template <typename T> inline Array<T>&
+Array<T>::operator = (Array&& arr) throw()   //!< The input array.
+{
+    swap(arr);
+    
+    return (*this);
+}
+#endif
+
 // ------------------------------------------------------------------------------------------
 template <typename T> Array<T>&
 Array<T>::operator = (const MutableArray<T>& arr)   //!< The input array.
@@ -657,7 +715,7 @@ Array<T>::operator = (CFArrayRef cfarr) //!< The input array.
 
 // ------------------------------------------------------------------------------------------
 template <typename T> Array<T>&
-Array<T>::operator = (OSPtr<CFArrayRef> cfarr)  //!< The input array.
+Array<T>::operator = (const OSPtr<CFArrayRef>& cfarr)   //!< The input array.
 {
     Array   temp(cfarr);
     
@@ -668,7 +726,7 @@ Array<T>::operator = (OSPtr<CFArrayRef> cfarr)  //!< The input array.
 
 // ------------------------------------------------------------------------------------------
 template <typename T> Array<T>&
-Array<T>::operator = (OSPtr<CFMutableArrayRef> cfarr)   //!< The input array.
+Array<T>::operator = (const OSPtr<CFMutableArrayRef>& cfarr)    //!< The input array.
 {
     Array   temp(cfarr);
     
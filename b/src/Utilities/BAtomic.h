@@ -0,0 +1,143 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BAtomic_H_
+#define BAtomic_H_
+
+#pragma once
+
+// standard headers
+#include <stdint.h>
+
+// system headers
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 1)))
+#   define B_ATOMIC_GCC_BUILTINS    1
+#else
+#   include <libkern/OSAtomic.h>
+#endif
+
+
+namespace B {
+
+/*! @defgroup   Atomic  Atomic Primitives
+    
+    The atomic operations used by B's lock-free code.  They are implemented with GCC's 
+    @c __sync builtins where the compiler has them (GCC 4.1 and later), and with 
+    @c <libkern/OSAtomic.h> otherwise, so that the code using them stays portable.
+    
+    All of them imply a full memory barrier.
+    
+    @ingroup    Utilities
+*/
+//@{
+
+#if B_ATOMIC_GCC_BUILTINS || DOXYGEN_SCAN
+
+//! Adds @a inDelta to @a *ioValue, and returns the new value.
+inline int32_t
+AtomicAdd(volatile int32_t* ioValue, int32_t inDelta)
+{
+    return (__sync_add_and_fetch(ioValue, inDelta));
+}
+
+//! Sets @a *ioValue to @a inNewValue if it equals @a inOldValue.  Returns @c true if it did.
+inline bool
+AtomicCompareAndSwap(int32_t inOldValue, int32_t inNewValue, volatile int32_t* ioValue)
+{
+    return (__sync_bool_compare_and_swap(ioValue, inOldValue, inNewValue));
+}
+
+//! Sets @a *ioPtr to @a inNewValue if it equals @a inOldValue.  Returns @c true if it did.
+inline bool
+AtomicCompareAndSwapPtr(void* inOldValue, void* inNewValue, void* volatile* ioPtr)
+{
+    return (__sync_bool_compare_and_swap(ioPtr, inOldValue, inNewValue));
+}
+
+//! Sets @a *ioPtr to @a inValue, and returns its previous value.
+inline void*
+AtomicExchangePtr(void* volatile* ioPtr, void* inValue)
+{
+    // __sync_lock_test_and_set() is only an acquire barrier.
+    __sync_synchronize();
+    return (__sync_lock_test_and_set(ioPtr, inValue));
+}
+
+//! Makes all prior memory accesses visible before any subsequent one.
+inline void
+AtomicBarrier()
+{
+    __sync_synchronize();
+}
+
+#else
+
+inline int32_t
+AtomicAdd(volatile int32_t* ioValue, int32_t inDelta)
+{
+    return (OSAtomicAdd32Barrier(inDelta, ioValue));
+}
+
+inline bool
+AtomicCompareAndSwap(int32_t inOldValue, int32_t inNewValue, volatile int32_t* ioValue)
+{
+    return (OSAtomicCompareAndSwap32Barrier(inOldValue, inNewValue, ioValue));
+}
+
+inline bool
+AtomicCompareAndSwapPtr(void* inOldValue, void* inNewValue, void* volatile* ioPtr)
+{
+    return (OSAtomicCompareAndSwapPtrBarrier(inOldValue, inNewValue, ioPtr));
+}
+
+inline void*
+AtomicExchangePtr(void* volatile* ioPtr, void* inValue)
+{
+    void*   oldValue;
+    
+    do
+    {
+        oldValue = *ioPtr;
+    }
+    while (!OSAtomicCompareAndSwapPtrBarrier(oldValue, inValue, ioPtr));
+    
+    return (oldValue);
+}
+
+inline void
+AtomicBarrier()
+{
+    OSMemoryBarrier();
+}
+
+#endif
+
+//! Sets @a *ioPtr to @a inValue, after all prior memory accesses.
+inline void
+AtomicStorePtr(void* volatile* ioPtr, void* inValue)
+{
+    AtomicBarrier();
+    *ioPtr = inValue;
+}
+
+//@}
+
+}   // namespace B
+
+
+#endif  // BAtomic_H_
@@ -222,6 +222,12 @@ typedef AutoUPP<EventHandlerProcPtr,
                 NewEventHandlerUPP, 
                 DisposeEventHandlerUPP>         AutoEventHandlerUPP;
 
+//! Template Instantiation of AutoUPP for @c EventComparatorUPP.
+typedef AutoUPP<EventComparatorProcPtr, 
+                EventComparatorUPP, 
+                NewEventComparatorUPP, 
+                DisposeEventComparatorUPP>      AutoEventComparatorUPP;
+
 //! Template Instantiation of AutoUPP for @c EventLoopTimerUPP.
 typedef AutoUPP<EventLoopTimerProcPtr, 
                 EventLoopTimerUPP, 
@@ -0,0 +1,522 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BBlockAllocator.h"
+
+// standard headers
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include <ostream>
+
+// system headers
+#include <dlfcn.h>
+#include <stdint.h>
+
+// library headers
+#include <boost/thread/mutex.hpp>
+
+// B headers
+#include "BAtomic.h"
+
+
+namespace {
+
+struct CompareSiteActivity
+{
+    bool    operator () (
+                const B::BlockAllocator::SiteStatistics&    inLhs, 
+                const B::BlockAllocator::SiteStatistics&    inRhs) const
+            {
+                return ((inLhs.mAllocations + inLhs.mResizes) > 
+                        (inRhs.mAllocations + inRhs.mResizes));
+            }
+};
+
+}   // anonymous namespace
+
+
+namespace B {
+
+// ==========================================================================================
+//  BlockAllocator::Site
+
+//! The statistics counters for one call site.  mSite is NULL if the slot is unused.
+struct BlockAllocator::Site
+{
+    const void* volatile    mSite;
+    volatile int32_t        mAllocations;
+    volatile int32_t        mResizes;
+    volatile int32_t        mReallocations;
+    volatile int32_t        mBytes;
+};
+
+
+// ==========================================================================================
+//  BlockAllocator::Pools
+
+/*! The process-wide allocator state:  one free list and arena per size class, plus the 
+    call site table.
+*/
+struct BlockAllocator::Pools
+{
+    enum    { kClassCount = 9 };    // 16, 32, ..., 4096
+    
+    struct SizeClass
+    {
+        SizeClass() : mFree(NULL), mCursor(NULL), mEnd(NULL) {}
+        
+        boost::mutex    mMutex;     //!< Protects everything below.
+        void*           mFree;      //!< Each free block starts with a pointer to the next one.
+        char*           mCursor;    //!< The unused part of the current arena.
+        char*           mEnd;
+    };
+    
+#if B_BLOCK_ALLOCATOR_STATISTICS
+    Pools() { memset(mSites, 0, sizeof(mSites)); }
+#endif
+    
+    SizeClass   mClasses[kClassCount];
+#if B_BLOCK_ALLOCATOR_STATISTICS
+    Site        mSites[kMaxSites];
+#endif
+};
+
+
+// ==========================================================================================
+//  BlockAllocator
+
+#pragma mark -
+#pragma mark BlockAllocator
+
+boost::once_flag            BlockAllocator::sPoolsInit  = BOOST_ONCE_INIT;
+BlockAllocator::Pools*      BlockAllocator::sPools      = NULL;
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  std::bad_alloc  If memory is exhausted.
+*/
+void*
+BlockAllocator::Allocate(
+    size_t      inSize, 
+    size_t&     outCapacity)
+{
+    size_t  capacity    = GetCapacity(inSize);
+    void*   block       = AllocateBlock(capacity);
+    
+#if B_BLOCK_ALLOCATOR_STATISTICS
+    Record(B_BLOCK_ALLOCATOR_CALLER(), true, false, inSize);
+#endif
+    
+    outCapacity = capacity;
+    
+    return (block);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! If @a inNewSize fits within @a inCapacity, @a inBlock is returned as-is.  Otherwise, 
+    the block grows according to GetGrowthCapacity(), and the first @a inUsed bytes 
+    of @a inBlock are copied to the new block.  @a inBlock may be @c NULL, in which case 
+    the function behaves like Allocate().
+    
+    @exception  std::bad_alloc  If memory is exhausted.  @a inBlock is left untouched.
+*/
+void*
+BlockAllocator::Resize(
+    void*       inBlock, 
+    size_t      inCapacity, 
+    size_t      inUsed, 
+    size_t      inNewSize, 
+    size_t&     outCapacity)
+{
+    if ((inBlock != NULL) && (inNewSize <= inCapacity))
+    {
+#if B_BLOCK_ALLOCATOR_STATISTICS
+        Record(B_BLOCK_ALLOCATOR_CALLER(), false, false, inNewSize);
+#endif
+        
+        outCapacity = inCapacity;
+        
+        return (inBlock);
+    }
+    
+    size_t  capacity    = (inBlock != NULL) 
+                            ? GetGrowthCapacity(inCapacity, inNewSize) 
+                            : GetCapacity(inNewSize);
+    void*   block;
+    
+    if ((inBlock != NULL) && (GetSizeClass(inCapacity) < 0))
+    {
+        // Both blocks come from malloc(), which may be able to grow the block in place.
+        
+        block = realloc(inBlock, capacity);
+        
+        if (block == NULL)
+            throw std::bad_alloc();
+    }
+    else
+    {
+        block = AllocateBlock(capacity);
+        
+        if (inBlock != NULL)
+        {
+            memcpy(block, inBlock, std::min(inUsed, inCapacity));
+            DeallocateBlock(inBlock, inCapacity);
+        }
+    }
+    
+#if B_BLOCK_ALLOCATOR_STATISTICS
+    Record(B_BLOCK_ALLOCATOR_CALLER(), (inBlock == NULL), (inBlock != NULL), inNewSize);
+#endif
+    
+    outCapacity = capacity;
+    
+    return (block);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+BlockAllocator::Deallocate(
+    void*       inBlock, 
+    size_t      inCapacity) throw()
+{
+    if (inBlock != NULL)
+        DeallocateBlock(inBlock, inCapacity);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Small blocks are rounded up to their size class (or, without arenas, to a multiple 
+    of kMinClassSize, since @c malloc() doesn't need anything coarser);  larger ones 
+    are rounded up to a multiple of kMaxClassSize (which is the size of a page).
+*/
+size_t
+BlockAllocator::GetCapacity(size_t inSize)
+{
+    if (inSize <= kMaxClassSize)
+    {
+#if B_BLOCK_ALLOCATOR_ARENAS
+        size_t  capacity    = kMinClassSize;
+        
+        while (capacity < inSize)
+            capacity *= 2;
+        
+        return (capacity);
+#else
+        if (inSize == 0)
+            return (kMinClassSize);
+        
+        return ((inSize + kMinClassSize - 1) & ~static_cast<size_t>(kMinClassSize - 1));
+#endif
+    }
+    
+    return ((inSize + kMaxClassSize - 1) & ~static_cast<size_t>(kMaxClassSize - 1));
+}
+
+// ------------------------------------------------------------------------------------------
+size_t
+BlockAllocator::GetGrowthCapacity(
+    size_t      inCapacity, 
+    size_t      inSize)
+{
+    return (GetCapacity(std::max(inSize, inCapacity + inCapacity / 2)));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! This is the hook used by the Memory Manager wrappers, whose blocks don't come from 
+    BlockAllocator.  They pass B_BLOCK_ALLOCATOR_CALLER() as @a inSite.
+*/
+void
+BlockAllocator::RecordResize(
+    const void* inSite, 
+    size_t      inSize, 
+    bool        inReallocated)
+{
+#if B_BLOCK_ALLOCATOR_STATISTICS
+    Record(inSite, false, inReallocated, inSize);
+#else
+    (void) inSite;
+    (void) inSize;
+    (void) inReallocated;
+#endif
+}
+
+// ------------------------------------------------------------------------------------------
+/*! If B_BLOCK_ALLOCATOR_STATISTICS is zero, @a outStatistics is always empty.
+*/
+void
+BlockAllocator::GetStatistics(
+    std::vector<SiteStatistics>&    outStatistics)
+{
+    outStatistics.clear();
+    
+#if B_BLOCK_ALLOCATOR_STATISTICS
+    const Site* sites   = GetPools().mSites;
+    
+    for (size_t i = 0; i < kMaxSites; i++)
+    {
+        if (sites[i].mSite == NULL)
+            continue;
+        
+        SiteStatistics  stats;
+        
+        stats.mSite             = sites[i].mSite;
+        stats.mAllocations      = static_cast<uint32_t>(sites[i].mAllocations);
+        stats.mResizes          = static_cast<uint32_t>(sites[i].mResizes);
+        stats.mReallocations    = static_cast<uint32_t>(sites[i].mReallocations);
+        stats.mBytes            = static_cast<uint32_t>(sites[i].mBytes);
+        
+        outStatistics.push_back(stats);
+    }
+    
+    std::sort(outStatistics.begin(), outStatistics.end(), CompareSiteActivity());
+#endif
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Each line gives the call site's address, its counters, and the name of the function 
+    containing it if it can be found.
+*/
+void
+BlockAllocator::PrintStatistics(
+    std::ostream&   ostr)
+{
+    std::vector<SiteStatistics> statistics;
+    
+    GetStatistics(statistics);
+    
+    ostr << "site                 allocs    resizes   reallocs      bytes  function\n";
+    
+    for (std::vector<SiteStatistics>::const_iterator it = statistics.begin(); 
+         it != statistics.end(); 
+         ++it)
+    {
+        Dl_info     info;
+        const char* name    = "?";
+        
+        if (dladdr(const_cast<void*>(it->mSite), &info) && (info.dli_sname != NULL))
+            name = info.dli_sname;
+        
+        ostr << std::setw(18) << it->mSite << " "
+             << std::setw(10) << it->mAllocations << " "
+             << std::setw(10) << it->mResizes << " "
+             << std::setw(10) << it->mReallocations << " "
+             << std::setw(10) << it->mBytes << "  "
+             << name << "\n";
+    }
+    
+    ostr.flush();
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Counters that are being updated concurrently may not end up exactly zero.
+*/
+void
+BlockAllocator::ResetStatistics()
+{
+#if B_BLOCK_ALLOCATOR_STATISTICS
+    Site*   sites   = GetPools().mSites;
+    
+    for (size_t i = 0; i < kMaxSites; i++)
+    {
+        sites[i].mAllocations   = 0;
+        sites[i].mResizes       = 0;
+        sites[i].mReallocations = 0;
+        sites[i].mBytes         = 0;
+    }
+#endif
+}
+
+// ------------------------------------------------------------------------------------------
+BlockAllocator::Pools&
+BlockAllocator::GetPools()
+{
+    boost::call_once(InitPools, sPoolsInit);
+    
+    if (sPools == NULL)
+        throw std::bad_alloc();
+    
+    return (*sPools);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+BlockAllocator::InitPools() throw()
+{
+    try
+    {
+        sPools = new Pools;
+    }
+    catch (...)
+    {
+        // sPools stays NULL, so GetPools() will throw.
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the index of the size class of blocks of capacity @a inCapacity, or -1 if 
+    such blocks come from @c malloc().
+*/
+int
+BlockAllocator::GetSizeClass(size_t inCapacity)
+{
+#if B_BLOCK_ALLOCATOR_ARENAS
+    if (inCapacity <= kMaxClassSize)
+    {
+        int     sizeClass   = 0;
+        
+        for (size_t size = kMinClassSize; size < inCapacity; size *= 2)
+            sizeClass++;
+        
+        return (sizeClass);
+    }
+#else
+    (void) inCapacity;
+#endif
+    
+    return (-1);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @a inCapacity must have been returned by GetCapacity() or GetGrowthCapacity().
+*/
+void*
+BlockAllocator::AllocateBlock(size_t inCapacity)
+{
+    int     sizeClass   = GetSizeClass(inCapacity);
+    void*   block;
+    
+    if (sizeClass < 0)
+    {
+        block = malloc(inCapacity);
+    }
+    else
+    {
+        Pools::SizeClass&           pool    = GetPools().mClasses[sizeClass];
+        boost::mutex::scoped_lock   lock(pool.mMutex);
+        
+        if (pool.mFree != NULL)
+        {
+            block       = pool.mFree;
+            pool.mFree  = *static_cast<void**>(block);
+        }
+        else
+        {
+            if (pool.mCursor == pool.mEnd)
+            {
+                // Start a new arena.  The old one's memory is all in use or on the 
+                // free list, and remains so.
+                
+                char*   arena   = static_cast<char*>(malloc(kArenaSize));
+                
+                if (arena == NULL)
+                    throw std::bad_alloc();
+                
+                pool.mCursor    = arena;
+                pool.mEnd       = arena + kArenaSize;
+            }
+            
+            block           = pool.mCursor;
+            pool.mCursor   += inCapacity;
+        }
+    }
+    
+    if (block == NULL)
+        throw std::bad_alloc();
+    
+    return (block);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+BlockAllocator::DeallocateBlock(void* inBlock, size_t inCapacity) throw()
+{
+    int     sizeClass   = GetSizeClass(inCapacity);
+    
+    if (sizeClass < 0)
+    {
+        free(inBlock);
+    }
+    else
+    {
+        // The pools must exist, since the block was allocated from them.
+        
+        Pools::SizeClass&           pool    = sPools->mClasses[sizeClass];
+        boost::mutex::scoped_lock   lock(pool.mMutex);
+        
+        *static_cast<void**>(inBlock) = pool.mFree;
+        pool.mFree = inBlock;
+    }
+}
+
+#if B_BLOCK_ALLOCATOR_STATISTICS
+
+// ------------------------------------------------------------------------------------------
+void
+BlockAllocator::Record(
+    const void* inSite, 
+    bool        inAllocation, 
+    bool        inReallocation, 
+    size_t      inSize)
+{
+    Site*   site    = FindSite(inSite);
+    
+    if (site == NULL)
+        return;
+    
+    AtomicAdd(inAllocation ? &site->mAllocations : &site->mResizes, 1);
+    
+    if (inReallocation)
+        AtomicAdd(&site->mReallocations, 1);
+    
+    AtomicAdd(&site->mBytes, static_cast<int32_t>(inSize));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the slot for @a inSite, claiming one if necessary, or @c NULL if the table 
+    is full.  Slots are never released, so the table may be searched without locking.
+*/
+BlockAllocator::Site*
+BlockAllocator::FindSite(const void* inSite)
+{
+    Site*   sites   = GetPools().mSites;
+    size_t  start   = (reinterpret_cast<uintptr_t>(inSite) >> 2) * 2654435761U;
+    
+    for (size_t i = 0; i < kMaxSites; i++)
+    {
+        Site&   site    = sites[(start + i) % kMaxSites];
+        
+        if (site.mSite == inSite)
+            return (&site);
+        
+        if ((site.mSite == NULL) && 
+            (AtomicCompareAndSwapPtr(NULL, const_cast<void*>(inSite), 
+                                     const_cast<void* volatile*>(&site.mSite)) || 
+             (site.mSite == inSite)))
+        {
+            return (&site);
+        }
+    }
+    
+    return (NULL);
+}
+
+#endif  // B_BLOCK_ALLOCATOR_STATISTICS
+
+}   // namespace B
@@ -0,0 +1,214 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BBlockAllocator_H_
+#define BBlockAllocator_H_
+
+#pragma once
+
+// standard headers
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+// library headers
+#include <boost/thread/once.hpp>
+
+
+/*! @defgroup   BlockAllocatorGroup Block Allocation
+    
+    The macros in this group control the implementation of BlockAllocator.
+    
+    @ingroup    Utilities
+*/
+//@{
+
+#ifndef B_BLOCK_ALLOCATOR_ARENAS
+#   define B_BLOCK_ALLOCATOR_ARENAS 1
+#elif DOXYGEN_SCAN
+    /*! @def    B_BLOCK_ALLOCATOR_ARENAS
+        @brief  Determines whether small blocks are carved out of arenas.
+        
+        If non-zero (the default), blocks of up to BlockAllocator::kMaxClassSize bytes 
+        are rounded up to a size class, and are allocated from per-class free lists 
+        backed by large arenas.  If zero, every block comes straight from @c malloc().  
+        The growth policy is the same either way.
+        
+        @relates    BlockAllocator
+    */
+#   define B_BLOCK_ALLOCATOR_ARENAS 1
+#endif
+
+#ifndef B_BLOCK_ALLOCATOR_STATISTICS
+#   define B_BLOCK_ALLOCATOR_STATISTICS 0
+#elif DOXYGEN_SCAN
+    /*! @def    B_BLOCK_ALLOCATOR_STATISTICS
+        @brief  Determines whether allocations are counted per call site.
+        
+        Defining B_BLOCK_ALLOCATOR_STATISTICS to a non-zero value makes 
+        BlockAllocator, as well as the @c resize() functions of AutoMacHandle, 
+        AutoTypedHandle and AutoMacPtr, record how often each call site allocates and 
+        reallocates, and how many bytes it asks for.  It's off by default.
+        
+        @relates    BlockAllocator
+    */
+#   define B_BLOCK_ALLOCATOR_STATISTICS 1
+#endif
+
+#if defined(__GNUC__) || DOXYGEN_SCAN
+    /*! @def    B_BLOCK_ALLOCATOR_CALLER
+        @brief  Evaluates to the return address of the enclosing function, which 
+                BlockAllocator uses to identify call sites.
+        
+        @relates    BlockAllocator
+    */
+#   define B_BLOCK_ALLOCATOR_CALLER()   __builtin_return_address(0)
+#else
+#   define B_BLOCK_ALLOCATOR_CALLER()   NULL
+#endif
+
+//@}
+
+
+namespace B {
+
+/*!
+    @brief  Allocates growable blocks of raw memory.
+    
+    BlockAllocator is meant for buffers that are built up incrementally (by appending 
+    to them, say) and then copied to their final destination.  It combines two things:
+    
+        - A geometric growth policy.  Growing a block to a size that exceeds its 
+          capacity grows the capacity by at least half, so that a sequence of appends 
+          causes a logarithmic number of reallocations instead of a linear one.
+        - An optional size-class allocator (see B_BLOCK_ALLOCATOR_ARENAS).  Small 
+          blocks are rounded up to a power of two and served from per-class free 
+          lists, which are refilled from arenas.  Arena memory is recycled within its 
+          size class, but is never returned to the system.
+    
+    Blocks don't carry a header, so the caller has to keep track of each block's 
+    capacity, as returned by Allocate() and Resize(), and give it back to 
+    Deallocate().  HandleBuffer is a convenient wrapper that does just that.
+    
+    If B_BLOCK_ALLOCATOR_STATISTICS is non-zero, allocations are counted per call site.  
+    A call site is identified by the return address of the BlockAllocator function 
+    (or the @c resize() member function of one of the handle and pointer wrappers) 
+    that was called, and may be symbolised with @c atos or @c addr2line.
+    
+    The statistics counters are 32 bits wide, and wrap around.  The class contains only 
+    portable code, and is safe to use from multiple threads.
+    
+    @ingroup    Utilities
+*/
+class BlockAllocator
+{
+public:
+    
+    //! @name Constants
+    //@{
+    enum    {
+            kMinClassSize   = 16,       //!< The smallest size class.
+            kMaxClassSize   = 4096,     //!< The largest size class;  larger blocks come from @c malloc().
+            kArenaSize      = 65536,    //!< The size of each arena.
+            kMaxSites       = 1024      //!< The maximum number of call sites for which statistics are kept.
+            };
+    //@}
+    
+    //! The statistics for one call site.
+    struct SiteStatistics
+    {
+        const void*     mSite;          //!< The call site's address.
+        unsigned long   mAllocations;   //!< The number of new blocks.
+        unsigned long   mResizes;       //!< The number of calls to change a block's size.
+        unsigned long   mReallocations; //!< The number of resizes that needed a new block.
+        unsigned long   mBytes;         //!< The total number of bytes requested.
+    };
+    
+    //! @name Allocation
+    //@{
+    //! Returns a block of at least @a inSize bytes, and puts its capacity in @a outCapacity.
+    static void*    Allocate(
+                        size_t      inSize, 
+                        size_t&     outCapacity);
+    //! Returns a block able to hold @a inNewSize bytes, holding the first @a inUsed bytes of @a inBlock.
+    static void*    Resize(
+                        void*       inBlock, 
+                        size_t      inCapacity, 
+                        size_t      inUsed, 
+                        size_t      inNewSize, 
+                        size_t&     outCapacity);
+    //! Releases @a inBlock, whose capacity is @a inCapacity.
+    static void     Deallocate(
+                        void*       inBlock, 
+                        size_t      inCapacity) throw();
+    //@}
+    
+    //! @name Policies
+    //@{
+    //! Returns the capacity of a freshly allocated block of @a inSize bytes.
+    static size_t   GetCapacity(size_t inSize);
+    //! Returns the capacity to which a block of capacity @a inCapacity grows to hold @a inSize bytes.
+    static size_t   GetGrowthCapacity(
+                        size_t      inCapacity, 
+                        size_t      inSize);
+    //@}
+    
+    //! @name Statistics
+    //@{
+    //! Counts a resize of @a inSize bytes by some other allocator, attributing it to @a inSite.
+    static void     RecordResize(
+                        const void* inSite, 
+                        size_t      inSize, 
+                        bool        inReallocated);
+    //! Fills @a outStatistics with the statistics of each call site, busiest first.
+    static void     GetStatistics(
+                        std::vector<SiteStatistics>&    outStatistics);
+    //! Writes the statistics of each call site to @a ostr, in human-readable form.
+    static void     PrintStatistics(
+                        std::ostream&   ostr);
+    //! Zeroes all statistics.
+    static void     ResetStatistics();
+    //@}
+    
+private:
+    
+    // types
+    struct  Pools;
+    struct  Site;
+    
+    static Pools&   GetPools();
+    static void     InitPools() throw();
+    static int      GetSizeClass(size_t inCapacity);
+    static void*    AllocateBlock(size_t inCapacity);
+    static void     DeallocateBlock(void* inBlock, size_t inCapacity) throw();
+    static void     Record(
+                        const void* inSite, 
+                        bool        inAllocation, 
+                        bool        inReallocation, 
+                        size_t      inSize);
+    static Site*    FindSite(const void* inSite);
+    
+    // static member variables
+    static boost::once_flag sPoolsInit;
+    static Pools*           sPools;
+};
+
+}   // namespace B
+
+
+#endif  // BBlockAllocator_H_
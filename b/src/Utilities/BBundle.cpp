@@ -19,10 +19,31 @@
 // file header
 #include "BBundle.h"
 
+// standard headers
+#include <map>
+#include <vector>
+
 // system headers
 #include <ApplicationServices/ApplicationServices.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// library headers
+#if defined(__MWERKS__)
+#   include <hash_map>
+#elif defined(__GNUC__)
+#   include <ext/hash_map>
+#endif
+#include <boost/thread/mutex.hpp>
 
 // B headers
+#include "BAtomic.h"
+#include "BCompiledStringTable.h"
+#include "BErrorHandler.h"
+#include "BInternedString.h"
 #include "BString.h"
 #include "BStringUtilities.h"
 #include "BUrl.h"
@@ -182,6 +203,94 @@ namespace
 
 namespace B {
 
+// ==========================================================================================
+//  Bundle::StringTable
+
+/*! The contents of one <tt>.strings</tt> file.  Tables are immutable once built, so they 
+    may be searched without locking.
+    
+    If there's a compiled table (see CompiledStringTable) alongside the 
+    <tt>.strings</tt> file, it is mapped into memory and searched in place, instead of 
+    parsing the <tt>.strings</tt> file.  The @c CFStrings for its values are created on 
+    their first lookup, and are kept for the table's lifetime.
+*/
+struct Bundle::StringTable
+{
+#if defined(__MWERKS__)
+    typedef Metrowerks::hash_map<InternedString, String, InternedStringHash>    StringMap;
+#elif defined(__GNUC__)
+    typedef __gnu_cxx::hash_map<InternedString, String, InternedStringHash>     StringMap;
+#endif
+    
+                StringTable(
+                    const OSPtr<CFURLRef>&  inCompiledUrl, 
+                    const OSPtr<CFURLRef>&  inUrl);
+                ~StringTable();
+    
+    bool        IsFrom(
+                    const OSPtr<CFURLRef>&  inCompiledUrl, 
+                    const OSPtr<CFURLRef>&  inUrl) const;
+    bool        Find(
+                    CFStringRef             inKey, 
+                    String&                 outValue) const;
+    
+    bool        MapCompiledTable();
+    CFStringRef GetCompiledValue(long inIndex) const;
+    void        LoadStrings();
+    
+    static bool IsSameUrl(
+                    const OSPtr<CFURLRef>&  inUrl1, 
+                    const OSPtr<CFURLRef>&  inUrl2);
+    static void AddEntry(const void* inKey, const void* inValue, void* inContext);
+    
+    const OSPtr<CFURLRef>   mCompiledUrl;   //!< Where the compiled table is, or @c NULL.
+    const OSPtr<CFURLRef>   mUrl;           //!< Where the table was loaded from, or @c NULL.
+    StringMap               mStrings;
+    void*                   mMapping;       //!< The mapped compiled table, or @c NULL.
+    size_t                  mMappingSize;
+    const CompiledStringTable::Header*  mCompiled;
+    mutable std::vector<CFStringRef>    mCompiledValues;
+};
+
+
+// ==========================================================================================
+//  Bundle::StringTableCache
+
+/*! The process-wide collection of string tables, keyed by bundle and table name.  
+    mGeneration is bumped by InvalidateLocalisedStrings();  entries with an older 
+    generation are revalidated on their next use.
+*/
+struct Bundle::StringTableCache
+{
+    typedef std::pair<CFBundleRef, InternedString>  Key;
+    
+    struct Entry
+    {
+        Entry() : mGeneration(0) {}
+        
+        OSPtr<CFBundleRef>                      mBundle;
+        boost::shared_ptr<const StringTable>    mTable;
+        unsigned                                mGeneration;
+    };
+    
+    typedef std::map<Key, Entry>    TableMap;
+    
+    StringTableCache() : mGeneration(0) {}
+    
+    boost::mutex    mMutex;         //!< Protects everything below.
+    TableMap        mTables;
+    unsigned        mGeneration;
+};
+
+
+// ==========================================================================================
+//  Bundle
+
+#pragma mark -
+#pragma mark Bundle
+
+boost::once_flag            Bundle::sStringTableCacheInit   = BOOST_ONCE_INIT;
+Bundle::StringTableCache*   Bundle::sStringTableCache       = NULL;
 
 // ------------------------------------------------------------------------------------------
 /*! @note   This function does not necessarily return what CoreFoudation 
@@ -530,9 +639,7 @@ Bundle::InfoString(
 Url
 Bundle::Location() const
 {
-    OSPtr<CFURLRef> url(CFBundleCopyBundleURL(mRef), from_copy);
-    
-    return (Url(url));
+    return (Url(CFBundleCopyBundleURL(mRef), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -542,9 +649,7 @@ Bundle::Location() const
 Url
 Bundle::Resources() const
 {
-    OSPtr<CFURLRef> url(CFBundleCopyResourcesDirectoryURL(mRef), from_copy);
-    
-    return (Url(url));
+    return (Url(CFBundleCopyResourcesDirectoryURL(mRef), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -554,9 +659,7 @@ Bundle::Resources() const
 Url
 Bundle::PrivateFrameworks() const
 {
-    OSPtr<CFURLRef> url(CFBundleCopyPrivateFrameworksURL(mRef), from_copy);
-    
-    return (Url(url));
+    return (Url(CFBundleCopyPrivateFrameworksURL(mRef), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -566,9 +669,7 @@ Bundle::PrivateFrameworks() const
 Url
 Bundle::SharedFrameworks() const
 {
-    OSPtr<CFURLRef> url(CFBundleCopySharedFrameworksURL(mRef), from_copy);
-    
-    return (Url(url));
+    return (Url(CFBundleCopySharedFrameworksURL(mRef), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -578,9 +679,7 @@ Bundle::SharedFrameworks() const
 Url
 Bundle::SharedSupport() const
 {
-    OSPtr<CFURLRef> url(CFBundleCopySharedSupportURL(mRef), from_copy);
-    
-    return (Url(url));
+    return (Url(CFBundleCopySharedSupportURL(mRef), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -590,18 +689,14 @@ Bundle::SharedSupport() const
 Url
 Bundle::PlugIns() const
 {
-    OSPtr<CFURLRef> url(CFBundleCopyBuiltInPlugInsURL(mRef), from_copy);
-    
-    return (Url(url));
+    return (Url(CFBundleCopyBuiltInPlugInsURL(mRef), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
 Url
 Bundle::Executable() const
 {
-    OSPtr<CFURLRef> url(CFBundleCopyExecutableURL(mRef), from_copy);
-    
-    return (Url(url));
+    return (Url(CFBundleCopyExecutableURL(mRef), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -611,9 +706,7 @@ Bundle::Executable() const
 Url
 Bundle::AuxiliaryExecutable(const String& inName) const
 {
-    OSPtr<CFURLRef> url(CFBundleCopyAuxiliaryExecutableURL(mRef, inName.cf_ref()), from_copy);
-    
-    return (Url(url));
+    return (Url(CFBundleCopyAuxiliaryExecutableURL(mRef, inName.cf_ref()), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -1010,13 +1103,11 @@ Bundle::Resource(
     const String&       subDirectory /* = String() */)  //!< If non-empty, specifies a subdirectory under Resources or Resources/\<lang\>.lproj
     const
 {
-    OSPtr<CFURLRef> url(CFBundleCopyResourceURL(
-                            mRef, name.cf_ref(), 
-                            !type.empty() ? type.cf_ref() : NULL, 
-                            !subDirectory.empty() ? subDirectory.cf_ref() : NULL), 
-                        from_copy);
-
-    return (Url(url));
+    return (Url(CFBundleCopyResourceURL(
+                    mRef, name.cf_ref(), 
+                    !type.empty() ? type.cf_ref() : NULL, 
+                    !subDirectory.empty() ? subDirectory.cf_ref() : NULL), 
+                from_copy));
 }
 
 
@@ -1054,13 +1145,371 @@ Bundle::Resources(
 }
 
 // ------------------------------------------------------------------------------------------
+/*! The fallbacks match those of @c CFBundleCopyLocalizedString():  if @a inKey isn't 
+    in the table, the function returns @a inValue, or @a inKey if @a inValue is 
+    @c NULL or empty.  A @c NULL @a inTableName means <tt>Localizable.strings</tt>.
+*/
 String
 Bundle::GetLocalisedString(
     CFStringRef         inKey, 
     CFStringRef         inValue, 
     CFStringRef         inTableName) const
 {
-    return (String(CFBundleCopyLocalizedString(mRef, inKey, inValue, inTableName), from_copy));
+    if (inKey == NULL)
+        return (String((inValue != NULL) ? inValue : CFSTR("")));
+    
+    boost::shared_ptr<const StringTable>    table   = GetStringTable(
+                                                        (inTableName != NULL) 
+                                                            ? inTableName 
+                                                            : CFSTR("Localizable"));
+    String                                  value;
+    
+    if (table->Find(inKey, value))
+        return (value);
+    
+    if ((inValue != NULL) && (CFStringGetLength(inValue) > 0))
+        return (String(inValue));
+    else
+        return (String(inKey));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! CFBundle picks a bundle's localisation once, so normally there is no need to call 
+    this function.  It's meant for code that changes the bundle's resources (or the 
+    localisation preferences) while the process is running.  Tables are only reloaded 
+    if the table file CFBundle resolves to has changed.
+*/
+void
+Bundle::InvalidateLocalisedStrings()
+{
+    StringTableCache&           cache   = GetStringTableCache();
+    boost::mutex::scoped_lock   lock(cache.mMutex);
+    
+    ++cache.mGeneration;
+}
+
+// ------------------------------------------------------------------------------------------
+boost::shared_ptr<const Bundle::StringTable>
+Bundle::GetStringTable(
+    CFStringRef     inTableName) const
+{
+    StringTableCache&           cache   = GetStringTableCache();
+    StringTableCache::Key       key(mRef, InternedString(inTableName));
+    boost::mutex::scoped_lock   lock(cache.mMutex);
+    StringTableCache::Entry&    entry   = cache.mTables[key];
+    
+    if ((entry.mTable.get() == NULL) || (entry.mGeneration != cache.mGeneration))
+    {
+        OSPtr<CFURLRef> url(CFBundleCopyResourceURL(mRef, inTableName, CFSTR("strings"), 
+                                                    NULL), 
+                            from_copy, std::nothrow);
+        OSPtr<CFURLRef> compiledUrl;
+        
+        // The compiled table must be the one next to the .strings file CFBundle picked.  
+        // Resolving it separately could pick one from another localisation.
+        
+        if (url != NULL)
+        {
+            OSPtr<CFURLRef> baseUrl(CFURLCreateCopyDeletingPathExtension(NULL, url), 
+                                    from_copy);
+            
+            compiledUrl.reset(CFURLCreateCopyAppendingPathExtension(NULL, baseUrl, 
+                                                                    CFSTR("stringtable")), 
+                              from_copy);
+        }
+        
+        if ((entry.mTable.get() == NULL) || !entry.mTable->IsFrom(compiledUrl, url))
+            entry.mTable.reset(new StringTable(compiledUrl, url));
+        
+        // Holding on to the bundle guarantees that its address won't be reused for 
+        // another bundle while the entry exists.
+        
+        entry.mBundle.reset(mRef);
+        entry.mGeneration = cache.mGeneration;
+    }
+    
+    return (entry.mTable);
+}
+
+// ------------------------------------------------------------------------------------------
+Bundle::StringTableCache&
+Bundle::GetStringTableCache()
+{
+    boost::call_once(InitStringTableCache, sStringTableCacheInit);
+    B_THROW_IF(sStringTableCache == NULL, std::bad_alloc());
+    
+    return (*sStringTableCache);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+Bundle::InitStringTableCache() throw()
+{
+    try
+    {
+        sStringTableCache = new StringTableCache;
+    }
+    catch (...)
+    {
+        // sStringTableCache stays NULL, so GetStringTableCache() will throw.
+    }
+}
+
+
+// ==========================================================================================
+//  Bundle::StringTable
+
+#pragma mark -
+#pragma mark Bundle::StringTable
+
+// ------------------------------------------------------------------------------------------
+/*! Maps the compiled table at @a inCompiledUrl if there is one and it's usable, else 
+    loads the table at @a inUrl.  A missing or unreadable table results in an empty one, 
+    so that lookups fall back to the default value, as they do with 
+    @c CFBundleCopyLocalizedString().
+*/
+Bundle::StringTable::StringTable(
+    const OSPtr<CFURLRef>&  inCompiledUrl, 
+    const OSPtr<CFURLRef>&  inUrl)
+        : mCompiledUrl(inCompiledUrl), mUrl(inUrl), 
+          mMapping(NULL), mMappingSize(0), mCompiled(NULL)
+{
+    if (!MapCompiledTable())
+        LoadStrings();
+}
+
+// ------------------------------------------------------------------------------------------
+Bundle::StringTable::~StringTable()
+{
+    for (size_t i = 0; i < mCompiledValues.size(); i++)
+    {
+        if (mCompiledValues[i] != NULL)
+            CFRelease(mCompiledValues[i]);
+    }
+    
+    if (mMapping != NULL)
+        munmap(mMapping, mMappingSize);
+}
+
+// ------------------------------------------------------------------------------------------
+bool
+Bundle::StringTable::IsFrom(
+    const OSPtr<CFURLRef>&  inCompiledUrl, 
+    const OSPtr<CFURLRef>&  inUrl) const
+{
+    return (IsSameUrl(mCompiledUrl, inCompiledUrl) && IsSameUrl(mUrl, inUrl));
+}
+
+// ------------------------------------------------------------------------------------------
+bool
+Bundle::StringTable::Find(
+    CFStringRef             inKey, 
+    String&                 outValue) const
+{
+    if (mCompiled == NULL)
+    {
+        // The keys come from arbitrary callers (ErrorHandler looks up exceptions' 
+        // what() strings), so they mustn't be interned.  A key that was never interned 
+        // can't be in the table anyway.
+        
+        InternedString              key;
+        
+        if (!InternedString::Lookup(inKey, key))
+            return (false);
+        
+        StringMap::const_iterator   it  = mStrings.find(key);
+        
+        if (it == mStrings.end())
+            return (false);
+        
+        outValue = it->second;
+        
+        return (true);
+    }
+    
+    CFIndex         length  = CFStringGetLength(inKey);
+    const UniChar*  chars   = CFStringGetCharactersPtr(inKey);
+    UniChar         buffer[256];
+    std::vector<UniChar>    bigBuffer;
+    
+    if (chars == NULL)
+    {
+        UniChar*    buffPtr = buffer;
+        
+        if (length > static_cast<CFIndex>(sizeof(buffer) / sizeof(buffer[0])))
+        {
+            bigBuffer.resize(length);
+            buffPtr = &bigBuffer[0];
+        }
+        
+        CFStringGetCharacters(inKey, CFRangeMake(0, length), buffPtr);
+        chars = buffPtr;
+    }
+    
+    long    index   = CompiledStringTable::Find(mCompiled, chars, length);
+    
+    if (index < 0)
+        return (false);
+    
+    outValue.assign(GetCompiledValue(index));
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns @c false if there is no compiled table, or if it can't be used (because it's 
+    unreadable, corrupt, written in the other byte order, or older than the 
+    <tt>.strings</tt> file, which means it was compiled from a previous version).
+*/
+bool
+Bundle::StringTable::MapCompiledTable()
+{
+    char        path[MAXPATHLEN], stringsPath[MAXPATHLEN];
+    struct stat sb, stringsSb;
+    int         fd;
+    
+    if ((mCompiledUrl == NULL) || 
+        !CFURLGetFileSystemRepresentation(mCompiledUrl, true, 
+                                          reinterpret_cast<UInt8*>(path), sizeof(path)) || 
+        ((fd = open(path, O_RDONLY)) < 0))
+    {
+        return (false);
+    }
+    
+    bool    haveStrings = (mUrl != NULL) && 
+                          CFURLGetFileSystemRepresentation(mUrl, true, 
+                                                           reinterpret_cast<UInt8*>(stringsPath), 
+                                                           sizeof(stringsPath)) && 
+                          (stat(stringsPath, &stringsSb) == 0);
+    
+    if ((fstat(fd, &sb) == 0) && (sb.st_size > 0) && 
+        !(haveStrings && (sb.st_mtime < stringsSb.st_mtime)))
+    {
+        void*   mapping = mmap(NULL, sb.st_size, PROT_READ, MAP_FILE | MAP_SHARED, fd, 0);
+        
+        if (mapping != MAP_FAILED)
+        {
+            mCompiled = CompiledStringTable::Validate(mapping, sb.st_size);
+            
+            if (mCompiled != NULL)
+            {
+                mMapping        = mapping;
+                mMappingSize    = sb.st_size;
+            }
+            else
+            {
+                munmap(mapping, sb.st_size);
+            }
+        }
+    }
+    
+    close(fd);
+    
+    if (mCompiled == NULL)
+        return (false);
+    
+    mCompiledValues.resize(mCompiled->mCount, NULL);
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The value's @c CFString is created the first time it's asked for.  Two threads may 
+    race to create it;  the loser releases its copy and returns the winner's.
+*/
+CFStringRef
+Bundle::StringTable::GetCompiledValue(long inIndex) const
+{
+    CFStringRef value   = mCompiledValues[inIndex];
+    
+    if (value == NULL)
+    {
+        const CompiledStringTable::Entry&   entry   = 
+                                    CompiledStringTable::GetEntries(mCompiled)[inIndex];
+        const UniChar*                      chars   = 
+                                    CompiledStringTable::GetBlob(mCompiled) + entry.mValueOffset;
+        CFStringRef                         newValue;
+        
+        newValue = CFStringCreateWithCharacters(NULL, chars, entry.mValueLength);
+        B_THROW_IF_NULL(newValue);
+        
+        void* volatile* slot    = reinterpret_cast<void* volatile*>(&mCompiledValues[inIndex]);
+        
+        if (AtomicCompareAndSwapPtr(NULL, const_cast<__CFString*>(newValue), slot))
+        {
+            value = newValue;
+        }
+        else
+        {
+            CFRelease(newValue);
+            value = mCompiledValues[inIndex];
+        }
+    }
+    
+    return (value);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+Bundle::StringTable::LoadStrings()
+{
+    CFDataRef   dataRef;
+    SInt32      errorCode;
+    
+    if ((mUrl == NULL) || 
+        !CFURLCreateDataAndPropertiesFromResource(NULL, mUrl, &dataRef, NULL, NULL, 
+                                                  &errorCode))
+    {
+        return;
+    }
+    
+    OSPtr<CFDataRef>    dataPtr(dataRef, from_copy);
+    OSPtr<CFTypeRef>    plist(CFPropertyListCreateFromXMLData(NULL, dataPtr, 
+                                                              kCFPropertyListImmutable, 
+                                                              NULL), 
+                              from_copy, std::nothrow);
+    
+    if ((plist == NULL) || (CFGetTypeID(plist) != CFDictionaryGetTypeID()))
+        return;
+    
+    CFDictionaryRef     dict    = static_cast<CFDictionaryRef>(plist.get());
+    
+    mStrings.resize(CFDictionaryGetCount(dict));
+    CFDictionaryApplyFunction(dict, AddEntry, this);
+}
+
+// ------------------------------------------------------------------------------------------
+bool
+Bundle::StringTable::IsSameUrl(
+    const OSPtr<CFURLRef>&  inUrl1, 
+    const OSPtr<CFURLRef>&  inUrl2)
+{
+    if ((inUrl1 == NULL) || (inUrl2 == NULL))
+        return (inUrl1.get() == inUrl2.get());
+    else
+        return (CFEqual(inUrl1, inUrl2));
+}
+
+// ------------------------------------------------------------------------------------------
+void
+Bundle::StringTable::AddEntry(
+    const void* inKey, 
+    const void* inValue, 
+    void*       inContext)
+{
+    StringTable*    table   = static_cast<StringTable*>(inContext);
+    CFTypeRef       key     = inKey;
+    CFTypeRef       value   = inValue;
+    
+    if ((CFGetTypeID(key) != CFStringGetTypeID()) || 
+        (CFGetTypeID(value) != CFStringGetTypeID()))
+    {
+        return;
+    }
+    
+    table->mStrings.insert(StringMap::value_type(
+                                InternedString(static_cast<CFStringRef>(key)), 
+                                String(static_cast<CFStringRef>(value))));
 }
 
 
@@ -25,6 +25,8 @@
 #include <CoreFoundation/CFBundle.h>
 
 // library headers
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/once.hpp>
 #include "BString.h"
 #include "CFUtils.h"
 
@@ -54,6 +56,20 @@ class   Url;
         - #BLocalizedStringFromTable
         - #BLocalizedStringFromTableInBundle
         - #BLocalizedStringWithDefaultValue
+    
+    Localised strings don't go through @c CFBundleCopyLocalizedString().  Instead, the 
+    first lookup in a given <tt>.strings</tt> table loads the whole table into a hash 
+    table keyed by InternedString, which is shared by all Bundle objects referring to 
+    the same @c CFBundleRef.  Subsequent lookups return the table's strings, which are 
+    immutable, without creating new ones.  The keys being looked up aren't interned 
+    (see InternedString::Lookup()), so arbitrary strings may be looked up safely.
+    
+    A table may also be compiled ahead of time with <tt>MergeStrings -c</tt>.  The 
+    resulting <tt>.stringtable</tt> file, placed next to the <tt>.strings</tt> file, is 
+    mapped into memory and searched in place, so the <tt>.strings</tt> file needn't be 
+    parsed at all.  A compiled table that is older than its <tt>.strings</tt> file is 
+    ignored.  <tt>MergeStrings -v</tt> checks that a compiled table still matches 
+    its <tt>.strings</tt> file.
 */
 class Bundle
 {
@@ -287,6 +303,8 @@ public:
                 CFStringRef         inKey, 
                 CFStringRef         inValue, 
                 CFStringRef         inTableName) const;
+    //! Makes the next lookup in each string table check whether the table needs reloading.
+    static void InvalidateLocalisedStrings();
     //@}
     
     //! @name Conversions
@@ -316,11 +334,26 @@ private:
                         CFIndex                 inIndex);
     static Bundle&  GetMainBundle();
     
+    // types
+    struct  StringTable;
+    struct  StringTableCache;
+    
+    boost::shared_ptr<const StringTable>
+                    GetStringTable(
+                        CFStringRef             inTableName) const;
+    static StringTableCache&
+                    GetStringTableCache();
+    static void     InitStringTableCache() throw();
+    
     // member variables
     CFBundleRef mRef;
     OSType      mCreator;
     OSType      mType;
     mutable std::vector<DocumentType>   mDocumentTypes;
+    
+    // static member variables
+    static boost::once_flag     sStringTableCacheInit;
+    static StringTableCache*    sStringTableCache;
 };
 
 
@@ -0,0 +1,284 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BCompiledStringTable_H_
+#define BCompiledStringTable_H_
+
+#pragma once
+
+// standard headers
+#include <cstddef>
+#include <cstring>
+
+// system headers
+#include <CoreFoundation/CFBase.h>
+
+
+namespace B {
+
+/*!
+    @brief  Layout of a compiled string table.
+    
+    A compiled string table holds the same key/value pairs as a <tt>.strings</tt> file, 
+    in a form that can be mapped into memory and searched in place.  It's produced by 
+    the @c MergeStrings tool (<tt>MergeStrings -c</tt>), and is picked up by 
+    Bundle::GetLocalisedString() when it sits next to the <tt>.strings</tt> file, with 
+    the same name and an extension of <tt>.stringtable</tt>.
+    
+    The file consists of:
+    
+        - A Header.
+        - An array of Header::mCount Entry structures, sorted by key (comparing 
+          UTF-16 code units).
+        - An array of Header::mBucketCount displacements.
+        - An array of Header::mSlotCount entry indices (or kEmptySlot).
+        - A blob of UTF-16 code units, holding all of the keys and values.  Strings 
+          aren't nul-terminated.
+    
+    The displacements and slots form a "hash and displace" perfect hash of the keys:  
+    a key's first-level hash (seed 0) selects a bucket, and the bucket's displacement 
+    is the seed of the second-level hash, which selects the key's slot.  The tool 
+    picks the displacements so that no two keys share a slot.  A lookup therefore 
+    costs two hashes of the key and one key comparison, whatever the table's size.
+    
+    Everything is in the byte order of the machine that wrote the table, which is 
+    recorded in Header::mByteOrder.  A reader should ignore a table whose byte order 
+    doesn't match its own, and fall back to the <tt>.strings</tt> file.
+*/
+struct CompiledStringTable
+{
+    enum    {
+            kMagic          = 'BStT',   //!< Header::mMagic
+            kVersion        = 1,        //!< Header::mVersion
+            kByteOrderMark  = 0xFEFF,   //!< Header::mByteOrder, as written by the host.
+            kEmptySlot      = 0xFFFFFFFF
+            };
+    
+    //! The table's header.  All offsets are in bytes, from the start of the file.
+    struct Header
+    {
+        UInt32  mMagic;
+        UInt16  mVersion;
+        UInt16  mByteOrder;
+        UInt32  mCount;                 //!< Number of entries.
+        UInt32  mBucketCount;           //!< Number of first-level hash buckets.
+        UInt32  mSlotCount;             //!< Number of second-level hash slots.
+        UInt32  mEntriesOffset;
+        UInt32  mDisplacementsOffset;
+        UInt32  mSlotsOffset;
+        UInt32  mBlobOffset;
+        UInt32  mBlobLength;            //!< Length of the blob, in @c UniChars.
+    };
+    
+    //! One key/value pair.  Offsets and lengths are in @c UniChars, within the blob.
+    struct Entry
+    {
+        UInt32  mKeyOffset;
+        UInt32  mKeyLength;
+        UInt32  mValueOffset;
+        UInt32  mValueLength;
+    };
+    
+    //! Returns a pointer to @a inData's header if it holds a usable table, else @c NULL.
+    static const Header*    Validate(
+                                const void*     inData, 
+                                size_t          inSize);
+    
+    //! Returns the index of the entry for @a inKey, or -1 if there isn't one.
+    static long             Find(
+                                const Header*   inHeader, 
+                                const UniChar*  inKey, 
+                                size_t          inLength);
+    
+    //! @name Accessors
+    //@{
+    static const Entry*     GetEntries(const Header* inHeader);
+    static const UInt32*    GetDisplacements(const Header* inHeader);
+    static const UInt32*    GetSlots(const Header* inHeader);
+    static const UniChar*   GetBlob(const Header* inHeader);
+    //@}
+    
+    //! The hash function used at both levels of the perfect hash (32-bit FNV-1a).
+    static UInt32           Hash(
+                                const UniChar*  inChars, 
+                                size_t          inLength, 
+                                UInt32          inSeed);
+    
+private:
+    
+    static bool             IsValidRange(
+                                UInt32          inOffset, 
+                                UInt32          inCount, 
+                                size_t          inElementSize, 
+                                size_t          inSize);
+};
+
+// ------------------------------------------------------------------------------------------
+inline const CompiledStringTable::Entry*
+CompiledStringTable::GetEntries(const Header* inHeader)
+{
+    return (reinterpret_cast<const Entry*>(
+                reinterpret_cast<const char*>(inHeader) + inHeader->mEntriesOffset));
+}
+
+// ------------------------------------------------------------------------------------------
+inline const UInt32*
+CompiledStringTable::GetDisplacements(const Header* inHeader)
+{
+    return (reinterpret_cast<const UInt32*>(
+                reinterpret_cast<const char*>(inHeader) + inHeader->mDisplacementsOffset));
+}
+
+// ------------------------------------------------------------------------------------------
+inline const UInt32*
+CompiledStringTable::GetSlots(const Header* inHeader)
+{
+    return (reinterpret_cast<const UInt32*>(
+                reinterpret_cast<const char*>(inHeader) + inHeader->mSlotsOffset));
+}
+
+// ------------------------------------------------------------------------------------------
+inline const UniChar*
+CompiledStringTable::GetBlob(const Header* inHeader)
+{
+    return (reinterpret_cast<const UniChar*>(
+                reinterpret_cast<const char*>(inHeader) + inHeader->mBlobOffset));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The seed is folded into FNV's offset basis, so that each seed yields an independent 
+    hash function.  The hash works on code unit values, so it doesn't depend on the 
+    byte order.
+*/
+inline UInt32
+CompiledStringTable::Hash(
+    const UniChar*  inChars, 
+    size_t          inLength, 
+    UInt32          inSeed)
+{
+    UInt32  hash    = 2166136261U ^ (inSeed * 16777619U);
+    
+    for (size_t i = 0; i < inLength; i++)
+    {
+        hash ^= inChars[i] & 0xFF;
+        hash *= 16777619U;
+        hash ^= inChars[i] >> 8;
+        hash *= 16777619U;
+    }
+    
+    return (hash);
+}
+
+// ------------------------------------------------------------------------------------------
+inline bool
+CompiledStringTable::IsValidRange(
+    UInt32          inOffset, 
+    UInt32          inCount, 
+    size_t          inElementSize, 
+    size_t          inSize)
+{
+    return (((inOffset % sizeof(UInt32)) == 0) && 
+            (inOffset <= inSize) && 
+            (inCount <= (inSize - inOffset) / inElementSize));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Besides checking the header, the function makes sure that every offset in the table 
+    falls within @a inSize bytes, so that a truncated or corrupt file can't make a 
+    lookup stray outside of it.
+*/
+inline const CompiledStringTable::Header*
+CompiledStringTable::Validate(
+    const void*     inData, 
+    size_t          inSize)
+{
+    const Header*   header  = static_cast<const Header*>(inData);
+    
+    if ((inSize < sizeof(Header)) || 
+        (header->mMagic != kMagic) || 
+        (header->mVersion != kVersion) || 
+        (header->mByteOrder != kByteOrderMark) || 
+        ((header->mCount > 0) && ((header->mBucketCount == 0) || 
+                                  (header->mSlotCount < header->mCount))) || 
+        !IsValidRange(header->mEntriesOffset, header->mCount, sizeof(Entry), inSize) || 
+        !IsValidRange(header->mDisplacementsOffset, header->mBucketCount, sizeof(UInt32), inSize) || 
+        !IsValidRange(header->mSlotsOffset, header->mSlotCount, sizeof(UInt32), inSize) || 
+        !IsValidRange(header->mBlobOffset, header->mBlobLength, sizeof(UniChar), inSize))
+    {
+        return (NULL);
+    }
+    
+    const Entry*    entries = GetEntries(header);
+    const UInt32*   slots   = GetSlots(header);
+    
+    for (UInt32 i = 0; i < header->mCount; i++)
+    {
+        const Entry&    entry   = entries[i];
+        
+        if ((entry.mKeyOffset > header->mBlobLength) || 
+            (entry.mKeyLength > header->mBlobLength - entry.mKeyOffset) || 
+            (entry.mValueOffset > header->mBlobLength) || 
+            (entry.mValueLength > header->mBlobLength - entry.mValueOffset))
+        {
+            return (NULL);
+        }
+    }
+    
+    for (UInt32 i = 0; i < header->mSlotCount; i++)
+    {
+        if ((slots[i] != static_cast<UInt32>(kEmptySlot)) && (slots[i] >= header->mCount))
+            return (NULL);
+    }
+    
+    return (header);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @a inHeader must have been returned by Validate().
+*/
+inline long
+CompiledStringTable::Find(
+    const Header*   inHeader, 
+    const UniChar*  inKey, 
+    size_t          inLength)
+{
+    if (inHeader->mCount == 0)
+        return (-1);
+    
+    UInt32  bucket  = Hash(inKey, inLength, 0) % inHeader->mBucketCount;
+    UInt32  seed    = GetDisplacements(inHeader)[bucket];
+    UInt32  index   = GetSlots(inHeader)[Hash(inKey, inLength, seed) % inHeader->mSlotCount];
+    
+    if (index == static_cast<UInt32>(kEmptySlot))
+        return (-1);
+    
+    const Entry&    entry   = GetEntries(inHeader)[index];
+    
+    if ((entry.mKeyLength != inLength) || 
+        (memcmp(GetBlob(inHeader) + entry.mKeyOffset, inKey, inLength * sizeof(UniChar)) != 0))
+    {
+        return (-1);
+    }
+    
+    return (static_cast<long>(index));
+}
+
+}   // namespace B
+
+
+#endif  // BCompiledStringTable_H_
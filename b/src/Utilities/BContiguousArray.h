@@ -0,0 +1,957 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BContiguousArray_H_
+#define BContiguousArray_H_
+
+#pragma once
+
+// standard headers
+#include <algorithm>
+#include <climits>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+// system headers
+#include <CoreFoundation/CFArray.h>
+
+// library headers
+#include <boost/concept_check.hpp>
+
+// B headers
+#include "BErrorHandler.h"
+#include "BMutableArray.h"
+#include "CFUtils.h"
+
+
+namespace B {
+
+// ==========================================================================================
+//  ContiguousArray
+
+/*!
+    @brief  An array of CoreFoundation objects held in contiguous storage.
+    
+    Array and MutableArray go through the underlying @c CFArrayRef for every element 
+    access, and check the element's type each time it's extracted.  That's the right 
+    trade-off for arrays that are mostly passed to and from the toolbox, but bulk 
+    operations (sorting, copying, filtering) on large arrays pay dearly for it.
+    
+    ContiguousArray has the same interface as MutableArray (including its iterators, 
+    whose @c value_type is @c OSPtr<T>), but keeps its elements in an @c std::vector 
+    of @a T.  Element access is a simple indexing operation.  Each element is 
+    retained while it's in the array;  bulk operations (construction from a range, 
+    range insertion, erasure, clear()) retain or release all of the affected elements 
+    in a single pass.
+    
+    A @c CFArrayRef is only built when one is asked for, via cf_ref() or cf_ptr().  It's 
+    cached until the next change to the array's contents.
+    
+    Other notable differences with MutableArray :
+        
+        - Elements are not type-checked when they are extracted;  they are assumed to 
+          be of type @a T when they are put into the array.
+        
+        - data() gives direct, read-only access to the elements.
+        
+        - The @c CFArrayRef returned by cf_ref() is owned by the ContiguousArray, and 
+          becomes invalid at the next change.  Use cf_ptr() to hold on to it.
+    
+    @param  T   A CoreFoundation type.  It needs to obey the semantics of @c CFRetain() 
+                and @c CFRelease().
+    
+    @sa         Array, MutableArray
+    @ingroup    Utilities
+*/
+template <typename T>
+class ContiguousArray
+{
+public:
+    
+    //! @name Types
+    //@{
+    typedef OSPtr<T>            value_type;         //!< The type of the array's elements.
+    typedef size_t              size_type;          //!< The unsigned integral type for size values and indices.
+    typedef ptrdiff_t           difference_type;    //!< The signed integral type for difference values.
+    typedef value_type          const_reference;    //!< The type of constant element references.
+    typedef value_type*         pointer;            //!< The type of element pointers.
+    typedef const value_type*   const_pointer;      //!< The type of constant element pointers.
+    class                       iterator;           //!< The type of iterators.
+    class                       const_iterator;     //!< The type of constant iterators.
+    typedef CFAllocatorRef      allocator_type;     //!< The type of the allocator.
+    
+    /*!
+        @brief  Gives read/write access to an element of a ContiguousArray.
+        
+        Assigning to a reference releases the element's old value and retains its new 
+        one.
+    */
+    class reference
+    {
+    public:
+        
+        typedef ContiguousArray                         container_type;
+        typedef typename ContiguousArray::value_type    value_type;
+        
+        operator value_type () const                        { return (value_type(get(), std::nothrow)); }
+        T           get() const                             { return (mArray->mValues[mIndex]); }
+        reference&  operator = (const reference& ref)       { mArray->set(mIndex, ref.get()); return (*this); }
+        reference&  operator = (const value_type& value)    { mArray->set(mIndex, value.get()); return (*this); }
+        reference&  operator = (const T value)              { mArray->set(mIndex, value); return (*this); }
+        
+        // friends
+        
+        friend bool operator == (const reference& ref1, const reference& ref2)  { return (ref1.get() == ref2.get()); }
+        friend bool operator != (const reference& ref1, const reference& ref2)  { return (ref1.get() != ref2.get()); }
+        friend bool operator >  (const reference& ref1, const reference& ref2)  { return (ref1.get() >  ref2.get()); }
+        friend bool operator >= (const reference& ref1, const reference& ref2)  { return (ref1.get() >= ref2.get()); }
+        friend bool operator <  (const reference& ref1, const reference& ref2)  { return (ref1.get() <  ref2.get()); }
+        friend bool operator <= (const reference& ref1, const reference& ref2)  { return (ref1.get() <= ref2.get()); }
+        
+        friend bool operator == (const reference& ref, const value_type& value) { return (ref.get() == value.get()); }
+        friend bool operator != (const reference& ref, const value_type& value) { return (ref.get() != value.get()); }
+        friend bool operator >  (const reference& ref, const value_type& value) { return (ref.get() >  value.get()); }
+        friend bool operator >= (const reference& ref, const value_type& value) { return (ref.get() >= value.get()); }
+        friend bool operator <  (const reference& ref, const value_type& value) { return (ref.get() <  value.get()); }
+        friend bool operator <= (const reference& ref, const value_type& value) { return (ref.get() <= value.get()); }
+        
+        friend bool operator == (const value_type& value, const reference& ref) { return (value.get() == ref.get()); }
+        friend bool operator != (const value_type& value, const reference& ref) { return (value.get() != ref.get()); }
+        friend bool operator >  (const value_type& value, const reference& ref) { return (value.get() >  ref.get()); }
+        friend bool operator >= (const value_type& value, const reference& ref) { return (value.get() >= ref.get()); }
+        friend bool operator <  (const value_type& value, const reference& ref) { return (value.get() <  ref.get()); }
+        friend bool operator <= (const value_type& value, const reference& ref) { return (value.get() <= ref.get()); }
+        
+        friend bool operator == (const reference& ref, const T value)           { return (ref.get() == value); }
+        friend bool operator != (const reference& ref, const T value)           { return (ref.get() != value); }
+        friend bool operator >  (const reference& ref, const T value)           { return (ref.get() >  value); }
+        friend bool operator >= (const reference& ref, const T value)           { return (ref.get() >= value); }
+        friend bool operator <  (const reference& ref, const T value)           { return (ref.get() <  value); }
+        friend bool operator <= (const reference& ref, const T value)           { return (ref.get() <= value); }
+        
+        friend bool operator == (const T value, const reference& ref)           { return (value == ref.get()); }
+        friend bool operator != (const T value, const reference& ref)           { return (value != ref.get()); }
+        friend bool operator >  (const T value, const reference& ref)           { return (value >  ref.get()); }
+        friend bool operator >= (const T value, const reference& ref)           { return (value >= ref.get()); }
+        friend bool operator <  (const T value, const reference& ref)           { return (value <  ref.get()); }
+        friend bool operator <= (const T value, const reference& ref)           { return (value <= ref.get()); }
+        
+        //! Exchanges the referenced elements, without retaining or releasing them.
+        friend void swap(reference ref1, reference ref2)                        { ref1.swap(ref2); }
+    
+    private:
+        
+        // constructor
+        reference(ContiguousArray* inArray, size_type inIndex)
+            : mArray(inArray), mIndex(inIndex) {}
+        
+        void    swap(reference& ref)
+        {
+            T&  elem1   = mArray->mValues[mIndex];
+            T&  elem2   = ref.mArray->mValues[ref.mIndex];
+            
+            if (elem1 != elem2)
+            {
+                mArray->invalidate();
+                ref.mArray->invalidate();
+                std::swap(elem1, elem2);
+            }
+        }
+        
+        // member variables
+        ContiguousArray*    mArray;
+        size_type           mIndex;
+        
+        // friends
+        friend class    ContiguousArray;
+        friend class    ContiguousArray::iterator;
+    };
+    
+    /*!
+        @brief  Random-access iterator over the elements of a ContiguousArray.
+        
+        Dereferencing yields a reference, which may be assigned to.
+    */
+    class iterator : public std::iterator<std::random_access_iterator_tag, 
+                                          typename ContiguousArray::value_type, 
+                                          typename ContiguousArray::difference_type, 
+                                          typename ContiguousArray::pointer, 
+                                          typename ContiguousArray::reference>
+    {
+    private:
+        
+        typedef std::iterator<std::random_access_iterator_tag, 
+                              typename ContiguousArray::value_type, 
+                              typename ContiguousArray::difference_type, 
+                              typename ContiguousArray::pointer, 
+                              typename ContiguousArray::reference> base;
+    
+    public:
+        
+        // types
+        typedef typename base::value_type       value_type;
+        typedef typename base::difference_type  difference_type;
+        typedef typename base::pointer          pointer;
+        typedef typename base::reference        reference;
+        
+        // constructor
+        iterator()
+            : mArray(NULL), mIndex(0) {}
+        
+        reference   operator * () const                     { return (reference(mArray, mIndex)); }
+        reference   operator [] (difference_type i) const   { return (reference(mArray, mIndex + i)); }
+        
+        iterator&   operator ++ ()                          { ++mIndex; return (*this); }
+        iterator&   operator -- ()                          { --mIndex; return (*this); }
+        iterator&   operator += (difference_type n)         { mIndex += n; return (*this); }
+        iterator&   operator -= (difference_type n)         { mIndex -= n; return (*this); }
+        iterator    operator ++ (int)                       { return (iterator(mArray, mIndex++)); }
+        iterator    operator -- (int)                       { return (iterator(mArray, mIndex--)); }
+        iterator    operator +  (difference_type n) const   { return (iterator(mArray, mIndex + n)); }
+        iterator    operator -  (difference_type n) const   { return (iterator(mArray, mIndex - n)); }
+        
+        // friends
+        friend iterator         operator +  (difference_type n, const iterator& it)     { return (iterator(it.mArray, n + it.mIndex)); }
+        friend difference_type  operator -  (const iterator& it1, const iterator& it2)  { return (static_cast<difference_type>(it1.mIndex - it2.mIndex)); }
+        friend bool             operator == (const iterator& it1, const iterator& it2)  { return (it1.mIndex == it2.mIndex); }
+        friend bool             operator != (const iterator& it1, const iterator& it2)  { return (it1.mIndex != it2.mIndex); }
+        friend bool             operator >  (const iterator& it1, const iterator& it2)  { return (it1.mIndex >  it2.mIndex); }
+        friend bool             operator >= (const iterator& it1, const iterator& it2)  { return (it1.mIndex >= it2.mIndex); }
+        friend bool             operator <  (const iterator& it1, const iterator& it2)  { return (it1.mIndex <  it2.mIndex); }
+        friend bool             operator <= (const iterator& it1, const iterator& it2)  { return (it1.mIndex <= it2.mIndex); }
+    
+    private:
+        
+        iterator(ContiguousArray* inArray, size_type inIndex)
+            : mArray(inArray), mIndex(inIndex)  {}
+        
+        // member variables
+        ContiguousArray*    mArray;
+        size_type           mIndex;
+        
+        // friends
+        friend class    ContiguousArray;
+        friend class    ContiguousArray::const_iterator;
+    };
+    
+    /*!
+        @brief  Random-access iterator over the elements of a constant ContiguousArray.
+    */
+    class const_iterator : public std::iterator<std::random_access_iterator_tag, 
+                                                typename ContiguousArray::value_type, 
+                                                typename ContiguousArray::difference_type, 
+                                                typename ContiguousArray::const_pointer, 
+                                                typename ContiguousArray::const_reference>
+    {
+    private:
+        
+        typedef std::iterator<std::random_access_iterator_tag, 
+                              typename ContiguousArray::value_type, 
+                              typename ContiguousArray::difference_type, 
+                              typename ContiguousArray::const_pointer, 
+                              typename ContiguousArray::const_reference> base;
+    
+    public:
+        
+        // types
+        typedef typename base::value_type       value_type;
+        typedef typename base::difference_type  difference_type;
+        typedef typename base::pointer          pointer;
+        typedef typename base::reference        reference;
+        
+        // constructor
+        const_iterator()
+            : mPtr(NULL) {}
+        const_iterator(const typename ContiguousArray::iterator& it)
+            : mPtr((it.mArray != NULL) ? it.mArray->data() + it.mIndex : NULL)  {}
+        
+        value_type  operator * () const                         { return (value_type(*mPtr, std::nothrow)); }
+        value_type  operator [] (difference_type i) const       { return (value_type(mPtr[i], std::nothrow)); }
+        
+        const_iterator& operator ++ ()                          { ++mPtr; return (*this); }
+        const_iterator& operator -- ()                          { --mPtr; return (*this); }
+        const_iterator& operator += (difference_type n)         { mPtr += n; return (*this); }
+        const_iterator& operator -= (difference_type n)         { mPtr -= n; return (*this); }
+        const_iterator  operator ++ (int)                       { return (const_iterator(mPtr++)); }
+        const_iterator  operator -- (int)                       { return (const_iterator(mPtr--)); }
+        const_iterator  operator +  (difference_type n) const   { return (const_iterator(mPtr + n)); }
+        const_iterator  operator -  (difference_type n) const   { return (const_iterator(mPtr - n)); }
+        
+        // friends
+        friend const_iterator   operator +  (difference_type n, const const_iterator& it)           { return (const_iterator(n + it.mPtr)); }
+        friend difference_type  operator -  (const const_iterator& it1, const const_iterator& it2)  { return (it1.mPtr -  it2.mPtr); }
+        friend bool             operator == (const const_iterator& it1, const const_iterator& it2)  { return (it1.mPtr == it2.mPtr); }
+        friend bool             operator != (const const_iterator& it1, const const_iterator& it2)  { return (it1.mPtr != it2.mPtr); }
+        friend bool             operator >  (const const_iterator& it1, const const_iterator& it2)  { return (it1.mPtr >  it2.mPtr); }
+        friend bool             operator >= (const const_iterator& it1, const const_iterator& it2)  { return (it1.mPtr >= it2.mPtr); }
+        friend bool             operator <  (const const_iterator& it1, const const_iterator& it2)  { return (it1.mPtr <  it2.mPtr); }
+        friend bool             operator <= (const const_iterator& it1, const const_iterator& it2)  { return (it1.mPtr <= it2.mPtr); }
+    
+    private:
+        
+        explicit const_iterator(const T* inPtr)
+            : mPtr(inPtr)   {}
+        
+        // member variables
+        const T*    mPtr;
+        
+        // friends
+        friend class    ContiguousArray;
+    };
+    
+    typedef std::reverse_iterator<iterator>         reverse_iterator;       //!< The type of reverse iterators.
+    typedef std::reverse_iterator<const_iterator>   const_reverse_iterator; //!< The type of constant reverse iterators.
+    
+    //@}
+    
+    //! @name Constructors / Destructor
+    //@{
+    //! Default constructor.
+                ContiguousArray();
+    //! Copy constructor.
+                ContiguousArray(const ContiguousArray& arr);
+    //! Allocator constructor.
+    explicit    ContiguousArray(CFAllocatorRef allocator);
+    //! @a T constructor.
+    explicit    ContiguousArray(size_type num, T value, CFAllocatorRef allocator = NULL);
+    //! Array constructor.
+    explicit    ContiguousArray(const Array<T>& arr);
+    //! MutableArray constructor.
+    explicit    ContiguousArray(const MutableArray<T>& arr);
+    //! @c CFArrayRef constructor.
+    explicit    ContiguousArray(CFArrayRef cfarr);
+    //! @a T array constructor.
+    explicit    ContiguousArray(const T* values, size_type num, CFAllocatorRef allocator = NULL);
+    //! Range constructor.
+    template <class InputIterator>
+    explicit    ContiguousArray(InputIterator first, InputIterator last, CFAllocatorRef allocator = NULL);
+    //! Destructor.
+                ~ContiguousArray();
+    //@}
+    
+    //! @name Operations for Size and Capacity
+    //@{
+    //! Returns the number of elements in the array.
+    size_type   size() const        { return (mValues.size()); }
+    //! Returns whether the array is empty.
+    bool        empty() const       { return (mValues.empty()); }
+    //! Returns the maximum number of elements an array could contain.
+    size_type   max_size() const    { return (INT_MAX); }
+    //! Returns the number of elements the array could contain without reallocation.
+    size_type   capacity() const    { return (mValues.capacity()); }
+    //! Reserves room for at least @a n elements.
+    void        reserve(size_type n = 0)    { mValues.reserve(n); }
+    //@}
+    
+    //! @name Assignment
+    //@{
+    //! Replaces all existing elements with those of @a arr.
+    ContiguousArray&    operator = (const ContiguousArray& arr);
+    //! Array assignment.
+    ContiguousArray&    operator = (const Array<T>& arr);
+    //! MutableArray assignment.
+    ContiguousArray&    operator = (const MutableArray<T>& arr);
+    //! @c CFArrayRef assignment.
+    ContiguousArray&    operator = (CFArrayRef cfarr);
+    //! Replaces all existing elements with @a num copies of @a value.
+    ContiguousArray&    assign(size_type num, T value);
+    //! Replaces all existing elements with the elements in the range [@a first, @a last).
+    template <class InputIterator>
+    ContiguousArray&    assign(InputIterator first, InputIterator last);
+    //! Exchanges the contents with @a arr.
+    void                swap(ContiguousArray& arr);
+    //@}
+    
+    //! @name Direct Element Access
+    //@{
+    //! Returns the element with index @a index.
+    reference       at(size_type index);
+    //! Returns the element with index @a index.
+    const_reference at(size_type index) const;
+    //! Returns the element with index @a index.
+    reference       operator [] (size_type index)       { return (reference(this, index)); }
+    //! Returns the element with index @a index.
+    const_reference operator [] (size_type index) const { return (value_type(mValues[index], std::nothrow)); }
+    //! Returns the first element.
+    reference       front()                             { return (reference(this, 0)); }
+    //! Returns the first element.
+    const_reference front() const                       { return (value_type(mValues.front(), std::nothrow)); }
+    //! Returns the last element.
+    reference       back()                              { return (reference(this, size()-1)); }
+    //! Returns the last element.
+    const_reference back() const                        { return (value_type(mValues.back(), std::nothrow)); }
+    //! Returns a pointer to the elements, or @c NULL if the array is empty.
+    const T*        data() const                        { return (mValues.empty() ? NULL : &mValues[0]); }
+    //! Converts the array into a @a vector.
+    void            copy(std::vector<value_type>& vec) const;
+    //@}
+    
+    //! @name Operations to Generate Iterators
+    //@{
+    //! Returns an iterator for the beginning of the array.
+    iterator                begin()         { return (iterator(this, 0)); }
+    //! Returns an iterator for the beginning of the array.
+    const_iterator          begin() const   { return (const_iterator(data())); }
+    //! Returns an iterator for the end of the array.
+    iterator                end()           { return (iterator(this, size())); }
+    //! Returns an iterator for the end of the array.
+    const_iterator          end() const     { return (const_iterator(data() + size())); }
+    //! Returns an iterator for the beginning of a reverse iteration of the array.
+    reverse_iterator        rbegin()        { return (reverse_iterator(end())); }
+    //! Returns an iterator for the beginning of a reverse iteration of the array.
+    const_reverse_iterator  rbegin() const  { return (const_reverse_iterator(end())); }
+    //! Returns an iterator for the end of a reverse iteration of the array.
+    reverse_iterator        rend()          { return (reverse_iterator(begin())); }
+    //! Returns an iterator for the end of a reverse iteration of the array.
+    const_reverse_iterator  rend() const    { return (const_reverse_iterator(begin())); }
+    //@}
+    
+    //! @name Inserting and Removing Elements
+    //@{
+    //! Inserts @a value at position @a pos.
+    iterator    insert(iterator pos, T value);
+    //! Inserts @a num copies of @a value at position @a pos.
+    void        insert(iterator pos, size_type num, T value);
+    //! Inserts the elements in the range [@a first, @a last) at position @a pos.
+    template <class InputIterator>
+    void        insert(iterator pos, InputIterator first, InputIterator last);
+    //! Appends @a value.
+    void        push_back(T value);
+    //! Removes the element at position @a pos.
+    iterator    erase(iterator pos);
+    //! Removes the elements in the range [@a first, @a last).
+    iterator    erase(iterator first, iterator last);
+    //! Removes the last element.
+    void        pop_back();
+    //! Changes the number of elements to @a num, appending copies of @a value if need be.
+    void        resize(size_type num, T value);
+    //! Removes all of the elements.
+    void        clear();
+    //@}
+    
+    //! @name Generating CFArrayRefs.
+    //@{
+    //! Returns a @c CFArrayRef holding the elements, valid until the next change.
+    CFArrayRef          cf_ref() const;
+    //! Returns a "smart pointer" to a @c CFArrayRef holding the elements.
+    OSPtr<CFArrayRef>   cf_ptr() const  { return (OSPtr<CFArrayRef>(cf_ref())); }
+    //@}
+    
+    //! @name Allocator Support
+    //@{
+    //! Returns the allocator used for the @c CFArrayRef.
+    allocator_type  get_allocator() const   { return (mAllocator); }
+    //@}
+
+private:
+    
+    typedef typename std::vector<T>::iterator   ValueIterator;
+    
+    void            init_array(CFArrayRef cfarr);
+    void            set(size_type index, T value);
+    void            invalidate() const;
+    ValueIterator   value_iterator(iterator it)     { return (mValues.begin() + it.mIndex); }
+    
+    static void     retain(const T* first, const T* last);
+    static void     release(const T* first, const T* last);
+    
+    // member variables
+    std::vector<T>      mValues;    //!< Each element is retained.
+    CFAllocatorRef      mAllocator;
+    mutable CFArrayRef  mRef;       //!< The cached @c CFArrayRef, or @c NULL.
+};
+
+// ------------------------------------------------------------------------------------------
+/*! Creates an empty array using the default allocator.
+*/
+template <typename T> inline
+ContiguousArray<T>::ContiguousArray()
+    : mAllocator(NULL), mRef(NULL)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T>
+ContiguousArray<T>::ContiguousArray(
+    const ContiguousArray&  arr)    //!< The source array.
+        : mValues(arr.mValues), mAllocator(arr.mAllocator), mRef(NULL)
+{
+    retain(data(), data() + size());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Creates an empty array using @a allocator.
+*/
+template <typename T> inline
+ContiguousArray<T>::ContiguousArray(
+    CFAllocatorRef  allocator)  //!< The allocator for the @c CFArrayRef.
+        : mAllocator(allocator), mRef(NULL)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Creates an array that is initialised by @a num occurrences of @a value.
+*/
+template <typename T>
+ContiguousArray<T>::ContiguousArray(
+    size_type       num,                    //!< The number of elements.
+    T               value,                  //!< The elements' value.
+    CFAllocatorRef  allocator /* = NULL */) //!< The allocator for the @c CFArrayRef.
+        : mValues(num, value), mAllocator(allocator), mRef(NULL)
+{
+    retain(data(), data() + size());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Creates an array holding the elements of @a arr, using @a arr's allocator.
+*/
+template <typename T>
+ContiguousArray<T>::ContiguousArray(
+    const Array<T>& arr)    //!< The source array.
+        : mAllocator(arr.get_allocator()), mRef(NULL)
+{
+    init_array(arr.cf_ref());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Creates an array holding the elements of @a arr, using @a arr's allocator.
+*/
+template <typename T>
+ContiguousArray<T>::ContiguousArray(
+    const MutableArray<T>&  arr)    //!< The source array.
+        : mAllocator(arr.get_allocator()), mRef(NULL)
+{
+    init_array(arr.cf_ref());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Creates an array holding the elements of @a cfarr, using @a cfarr's allocator.
+*/
+template <typename T>
+ContiguousArray<T>::ContiguousArray(
+    CFArrayRef  cfarr)  //!< The source array.
+        : mAllocator(NULL), mRef(NULL)
+{
+    B_ASSERT(cfarr != NULL);
+    
+    mAllocator = CFGetAllocator(cfarr);
+    init_array(cfarr);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Creates an array holding the @a num elements of @a values.
+*/
+template <typename T>
+ContiguousArray<T>::ContiguousArray(
+    const T*        values,                 //!< The source elements.
+    size_type       num,                    //!< The number of elements.
+    CFAllocatorRef  allocator /* = NULL */) //!< The allocator for the @c CFArrayRef.
+        : mValues(values, values + num), mAllocator(allocator), mRef(NULL)
+{
+    retain(data(), data() + size());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Creates an array that is initialised by all elements of the range [@a first, @a last).  
+    The range's elements must be convertible to @a T.
+*/
+template <typename T> template <class InputIterator>
+ContiguousArray<T>::ContiguousArray(
+    InputIterator   first,                  //!< The start of the range.
+    InputIterator   last,                   //!< The end of the range.
+    CFAllocatorRef  allocator /* = NULL */) //!< The allocator for the @c CFArrayRef.
+        : mValues(first, last), mAllocator(allocator), mRef(NULL)
+{
+    boost::function_requires< boost::InputIteratorConcept<InputIterator> >();
+    
+    retain(data(), data() + size());
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T>
+ContiguousArray<T>::~ContiguousArray()
+{
+    invalidate();
+    release(data(), data() + size());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Fetches all of @a cfarr's elements with one call, then retains them.
+*/
+template <typename T> void
+ContiguousArray<T>::init_array(
+    CFArrayRef  cfarr)
+{
+    size_type   num = CFArrayGetCount(cfarr);
+    
+    mValues.resize(num);
+    
+    if (num > 0)
+    {
+        CFArrayGetValues(cfarr, CFRangeMake(0, num), 
+                         reinterpret_cast<const void**>(&mValues[0]));
+    }
+    
+    retain(data(), data() + size());
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> void
+ContiguousArray<T>::retain(
+    const T*    first, 
+    const T*    last)
+{
+    for ( ; first != last; ++first)
+    {
+        if (*first != NULL)
+            CFRetain(*first);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> void
+ContiguousArray<T>::release(
+    const T*    first, 
+    const T*    last)
+{
+    for ( ; first != last; ++first)
+    {
+        if (*first != NULL)
+            CFRelease(*first);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> inline void
+ContiguousArray<T>::invalidate() const
+{
+    if (mRef != NULL)
+    {
+        CFRelease(mRef);
+        mRef = NULL;
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> void
+ContiguousArray<T>::set(
+    size_type   index, 
+    T           value)
+{
+    T&  elem    = mValues[index];
+    
+    if (elem != value)
+    {
+        invalidate();
+        
+        if (value != NULL)
+            CFRetain(value);
+        
+        if (elem != NULL)
+            CFRelease(elem);
+        
+        elem = value;
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> ContiguousArray<T>&
+ContiguousArray<T>::operator = (const ContiguousArray& arr)    //!< The input array.
+{
+    ContiguousArray temp(arr);
+    
+    swap(temp);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> ContiguousArray<T>&
+ContiguousArray<T>::operator = (const Array<T>& arr)   //!< The input array.
+{
+    ContiguousArray temp(arr);
+    
+    swap(temp);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> ContiguousArray<T>&
+ContiguousArray<T>::operator = (const MutableArray<T>& arr)    //!< The input array.
+{
+    ContiguousArray temp(arr);
+    
+    swap(temp);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> ContiguousArray<T>&
+ContiguousArray<T>::operator = (CFArrayRef cfarr)  //!< The input array.
+{
+    ContiguousArray temp(cfarr);
+    
+    swap(temp);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> ContiguousArray<T>&
+ContiguousArray<T>::assign(size_type num, T value)
+{
+    ContiguousArray temp(num, value, mAllocator);
+    
+    swap(temp);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> template <class InputIterator> ContiguousArray<T>&
+ContiguousArray<T>::assign(InputIterator first, InputIterator last)
+{
+    boost::function_requires< boost::InputIteratorConcept<InputIterator> >();
+    
+    ContiguousArray temp(first, last, mAllocator);
+    
+    swap(temp);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> inline void
+ContiguousArray<T>::swap(ContiguousArray& arr)
+{
+    mValues.swap(arr.mValues);
+    std::swap(mAllocator, arr.mAllocator);
+    std::swap(mRef, arr.mRef);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> typename ContiguousArray<T>::reference
+ContiguousArray<T>::at(size_type index)
+{
+    if (index >= size())
+        B_THROW(std::out_of_range("index out of range"));
+    
+    return (reference(this, index));
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> typename ContiguousArray<T>::const_reference
+ContiguousArray<T>::at(size_type index) const
+{
+    if (index >= size())
+        B_THROW(std::out_of_range("index out of range"));
+    
+    return (value_type(mValues[index], std::nothrow));
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> void
+ContiguousArray<T>::copy(std::vector<value_type>& vec) const
+{
+    vec.clear();
+    vec.reserve(size());
+    vec.insert(vec.begin(), begin(), end());
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> typename ContiguousArray<T>::iterator
+ContiguousArray<T>::insert(iterator pos, T value)
+{
+    size_type   index   = pos.mIndex;
+    
+    insert(pos, 1, value);
+    
+    return (iterator(this, index));
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> void
+ContiguousArray<T>::insert(iterator pos, size_type num, T value)
+{
+    size_type   index   = pos.mIndex;
+    
+    invalidate();
+    mValues.insert(value_iterator(pos), num, value);
+    retain(data() + index, data() + index + num);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The range's elements must be convertible to @a T.  They are copied all at once, then 
+    retained in a single pass.
+*/
+template <typename T> template <class InputIterator> void
+ContiguousArray<T>::insert(iterator pos, InputIterator first, InputIterator last)
+{
+    boost::function_requires< boost::InputIteratorConcept<InputIterator> >();
+    
+    size_type   index   = pos.mIndex;
+    size_type   oldSize = size();
+    
+    invalidate();
+    mValues.insert(value_iterator(pos), first, last);
+    
+    size_type   num     = size() - oldSize;
+    
+    retain(data() + index, data() + index + num);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> void
+ContiguousArray<T>::push_back(T value)
+{
+    invalidate();
+    mValues.push_back(value);
+    
+    if (value != NULL)
+        CFRetain(value);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> inline typename ContiguousArray<T>::iterator
+ContiguousArray<T>::erase(iterator pos)
+{
+    return (erase(pos, pos + 1));
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> typename ContiguousArray<T>::iterator
+ContiguousArray<T>::erase(iterator first, iterator last)
+{
+    invalidate();
+    release(data() + first.mIndex, data() + last.mIndex);
+    mValues.erase(value_iterator(first), value_iterator(last));
+    
+    return (iterator(this, first.mIndex));
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> inline void
+ContiguousArray<T>::pop_back()
+{
+    erase(end() - 1);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> void
+ContiguousArray<T>::resize(size_type num, T value)
+{
+    if (num < size())
+        erase(begin() + num, end());
+    else if (num > size())
+        insert(end(), num - size(), value);
+}
+
+// ------------------------------------------------------------------------------------------
+template <typename T> void
+ContiguousArray<T>::clear()
+{
+    invalidate();
+    release(data(), data() + size());
+    mValues.clear();
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The @c CFArrayRef is created with a single call, the first time it's needed after a 
+    change.  The array must not contain @c NULL elements.
+*/
+template <typename T> CFArrayRef
+ContiguousArray<T>::cf_ref() const
+{
+    if (mRef == NULL)
+    {
+        B_ASSERT(std::find(mValues.begin(), mValues.end(), static_cast<T>(NULL)) == mValues.end());
+        
+        mRef = CFArrayCreate(mAllocator, reinterpret_cast<const void**>(const_cast<T*>(data())), 
+                             size(), &kCFTypeArrayCallBacks);
+        B_THROW_IF_NULL(mRef);
+    }
+    
+    return (mRef);
+}
+
+
+// ==========================================================================================
+//  ContiguousArray Global Functions
+
+/*! @defgroup   ContiguousArrayFunctions    ContiguousArray Global Functions
+*/
+//@{
+
+//! @name ContiguousArray Comparisons
+//@{
+
+/*! Compares two arrays for equality, element by element, using @c CFEqual().
+    
+    @return     @c true if @a a1 is equal to @a a2
+    @relates    ContiguousArray
+*/
+template <typename T> bool
+operator == (const ContiguousArray<T>& a1, const ContiguousArray<T>& a2)
+{
+    if (a1.size() != a2.size())
+        return (false);
+    
+    const T*    p1  = a1.data();
+    const T*    p2  = a2.data();
+    
+    for (size_t i = 0; i < a1.size(); i++)
+    {
+        if ((p1[i] != p2[i]) && ((p1[i] == NULL) || (p2[i] == NULL) || !CFEqual(p1[i], p2[i])))
+            return (false);
+    }
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Compares two arrays for inequality.
+    
+    @return     @c true if @a a1 is not equal to @a a2
+    @relates    ContiguousArray
+*/
+template <typename T> inline bool
+operator != (const ContiguousArray<T>& a1, const ContiguousArray<T>& a2)    { return (!(a1 == a2)); }
+
+//@}
+
+//! @name Miscellaneous
+//@{
+
+// ------------------------------------------------------------------------------------------
+/*! Exchanges the contents of @a a1 and @a a2.
+    
+    @relates    ContiguousArray
+*/
+template <typename T> inline void   swap(ContiguousArray<T>& a1, ContiguousArray<T>& a2)    { a1.swap(a2); }
+
+//@}
+
+//@}
+
+
+}   // namespace B
+
+#endif  // BContiguousArray_H_
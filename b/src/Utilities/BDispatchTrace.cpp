@@ -0,0 +1,400 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BDispatchTrace.h"
+
+#if B_DISPATCH_TRACE
+
+// standard headers
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <ios>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+// system headers
+#include <cxxabi.h>
+#include <mach/mach_time.h>
+#include <unistd.h>
+
+// library headers
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+// B headers
+#include "BAtomic.h"
+#include "BErrorHandler.h"
+
+
+namespace B {
+
+// ==========================================================================================
+//  DispatchTrace::Record
+
+struct DispatchTrace::Record
+{
+    UInt64      mBegin;
+    UInt64      mEnd;
+    UInt32      mClass;
+    UInt32      mKind;
+    const char* mTargetType;
+    UInt32      mThreadID;
+    Category    mCategory;
+};
+
+
+// ==========================================================================================
+//  DispatchTrace::Buffer
+
+/*! Only the owning thread writes into a buffer.  It fills in a record, then publishes
+    it by incrementing mCount.  Readers snapshot mCount before and after copying the
+    records out, and discard whatever the writer may have overwritten in the meantime.
+*/
+struct DispatchTrace::Buffer
+{
+    Record          mRecords[kBufferSize];
+    volatile UInt32 mCount;         //!< The number of records ever appended.
+    volatile UInt32 mClearedCount;  //!< Records before this one have been cleared.
+    UInt32          mThreadID;
+    bool            mInUse;         //!< Is a thread currently using this buffer?
+    Buffer*         mNext;
+};
+
+
+// ==========================================================================================
+//  DispatchTrace::Globals
+
+struct DispatchTrace::Globals
+{
+    Globals() : mThreadBuffer(ReleaseThreadBuffer), mBuffers(NULL), mLastThreadID(0) {}
+    
+    boost::mutex                        mMutex;         //!< Protects the list of buffers.
+    boost::thread_specific_ptr<Buffer>  mThreadBuffer;
+    Buffer*                             mBuffers;
+    UInt32                              mLastThreadID;
+};
+
+
+// ==========================================================================================
+//  DispatchTrace
+
+#pragma mark DispatchTrace
+
+boost::once_flag            DispatchTrace::sGlobalsInit = BOOST_ONCE_INIT;
+DispatchTrace::Globals*     DispatchTrace::sGlobals     = NULL;
+
+// ------------------------------------------------------------------------------------------
+void
+DispatchTrace::InitGlobals() throw()
+{
+    try
+    {
+        sGlobals = new Globals;
+    }
+    catch (...)
+    {
+        // sGlobals stays NULL, which disables tracing.
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+DispatchTrace::Globals&
+DispatchTrace::GetGlobals()
+{
+    boost::call_once(InitGlobals, sGlobalsInit);
+    B_THROW_IF(sGlobals == NULL, std::bad_alloc());
+    
+    return (*sGlobals);
+}
+
+// ------------------------------------------------------------------------------------------
+UInt64
+DispatchTrace::Now()
+{
+    return (mach_absolute_time());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the calling thread's buffer, allocating (or recycling) one if need be.
+    Returns @c NULL if no buffer could be obtained.
+*/
+DispatchTrace::Buffer*
+DispatchTrace::GetThreadBuffer() throw()
+{
+    try
+    {
+        Globals&    globals = GetGlobals();
+        Buffer*     buffer  = globals.mThreadBuffer.get();
+        
+        if (buffer == NULL)
+        {
+            boost::mutex::scoped_lock   lock(globals.mMutex);
+            
+            // Recycle the buffer of a thread that has exited, if there is one.
+            
+            for (buffer = globals.mBuffers; buffer != NULL; buffer = buffer->mNext)
+            {
+                if (!buffer->mInUse)
+                    break;
+            }
+            
+            if (buffer == NULL)
+            {
+                buffer                  = new Buffer;
+                buffer->mCount          = 0;
+                buffer->mClearedCount   = 0;
+                buffer->mNext           = globals.mBuffers;
+                globals.mBuffers        = buffer;
+            }
+            
+            buffer->mThreadID   = ++globals.mLastThreadID;
+            buffer->mInUse      = true;
+            
+            globals.mThreadBuffer.reset(buffer);
+        }
+        
+        return (buffer);
+    }
+    catch (...)
+    {
+        return (NULL);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Called on thread exit.  Buffers are never deallocated, because their records
+    outlive their thread;  instead, they are recycled by GetThreadBuffer().
+*/
+void
+DispatchTrace::ReleaseThreadBuffer(
+    Buffer*     inBuffer)
+{
+    boost::mutex::scoped_lock   lock(sGlobals->mMutex);
+    
+    inBuffer->mInUse = false;
+}
+
+// ------------------------------------------------------------------------------------------
+void
+DispatchTrace::Append(
+    Category    inCategory,
+    UInt32      inClass,
+    UInt32      inKind,
+    const char* inTargetType,
+    UInt64      inBegin,
+    UInt64      inEnd) throw()
+{
+    Buffer* buffer  = GetThreadBuffer();
+    
+    if (buffer == NULL)
+        return;
+    
+    UInt32  count   = buffer->mCount;
+    Record& record  = buffer->mRecords[count % kBufferSize];
+    
+    record.mBegin       = inBegin;
+    record.mEnd         = inEnd;
+    record.mClass       = inClass;
+    record.mKind        = inKind;
+    record.mTargetType  = inTargetType;
+    record.mThreadID    = buffer->mThreadID;
+    record.mCategory    = inCategory;
+    
+    // Make sure the record is complete before publishing it.
+    AtomicBarrier();
+    
+    buffer->mCount = count + 1;
+}
+
+// ------------------------------------------------------------------------------------------
+void
+DispatchTrace::Clear()
+{
+    Globals&                    globals = GetGlobals();
+    boost::mutex::scoped_lock   lock(globals.mMutex);
+    
+    for (Buffer* buffer = globals.mBuffers; buffer != NULL; buffer = buffer->mNext)
+    {
+        buffer->mClearedCount = buffer->mCount;
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+static void
+WriteFourCharCode(
+    std::ostream&   ostr,
+    UInt32          inCode)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        char    c   = static_cast<char>((inCode >> shift) & 0xFF);
+        
+        if ((c < ' ') || (c > '~') || (c == '"') || (c == '\\'))
+            c = '?';
+        
+        ostr << c;
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Target types are either plain strings, or (in the case of @c typeid names) mangled
+    C++ type names.  The latter are demangled.
+*/
+static void
+WriteTargetType(
+    std::ostream&   ostr,
+    const char*     inTargetType)
+{
+    if (inTargetType == NULL)
+        return;
+    
+    char*   demangled   = NULL;
+    
+    if (((*inTargetType >= '0') && (*inTargetType <= '9')) || (*inTargetType == 'N'))
+    {
+        int status;
+        
+        demangled = abi::__cxa_demangle(inTargetType, NULL, NULL, &status);
+    }
+    
+    for (const char* s = (demangled != NULL) ? demangled : inTargetType; *s != 0; s++)
+    {
+        if ((*s == '"') || (*s == '\\'))
+            ostr << '\\';
+        
+        ostr << *s;
+    }
+    
+    std::free(demangled);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The records of all threads are written as "complete" events (phase @c X), whose
+    names are made of the event's class and kind.  The target type is written as an
+    argument.
+    
+    This function may be called from any thread, while other threads are recording.
+*/
+void
+DispatchTrace::WriteChromeTrace(
+    std::ostream&   ostr)   //!< The output stream.
+{
+    static const char* const    kCategoryNames[] = { "CarbonEvent", "AppleEvent", "Draw" };
+    
+    Globals&                    globals = GetGlobals();
+    std::vector<Record>         records;
+    mach_timebase_info_data_t   timebase;
+    
+    {
+        boost::mutex::scoped_lock   lock(globals.mMutex);
+        
+        for (Buffer* buffer = globals.mBuffers; buffer != NULL; buffer = buffer->mNext)
+        {
+            UInt32  end     = buffer->mCount;
+            
+            AtomicBarrier();
+            
+            UInt32  cleared = buffer->mClearedCount;
+            UInt32  oldest  = (end > kBufferSize) ? end - static_cast<UInt32>(kBufferSize) : 0;
+            UInt32  begin   = std::max(cleared, oldest);
+            size_t  first   = records.size();
+            
+            for (UInt32 i = begin; i != end; i++)
+                records.push_back(buffer->mRecords[i % kBufferSize]);
+            
+            AtomicBarrier();
+            
+            // The owning thread may have overwritten some of the records we copied
+            // while we were copying them.  The one it may be writing right now shares
+            // its slot with the record at (newEnd - kBufferSize).
+            
+            UInt32  newEnd  = buffer->mCount;
+            
+            if (newEnd - begin >= kBufferSize)
+            {
+                size_t  stale   = std::min<size_t>(newEnd - begin - kBufferSize + 1, end - begin);
+                
+                records.erase(records.begin() + first, records.begin() + first + stale);
+            }
+        }
+    }
+    
+    mach_timebase_info(&timebase);
+    
+    double  toMicroseconds  = static_cast<double>(timebase.numer) / timebase.denom / 1000.0;
+    int     pid             = getpid();
+    bool    needComma       = false;
+    
+    // Timestamps are in microseconds;  keep the sub-microsecond digits.
+    std::ios_base::fmtflags oldFlags        = ostr.flags(std::ios_base::fixed);
+    std::streamsize         oldPrecision    = ostr.precision(3);
+    
+    ostr << "{\"traceEvents\":[\n";
+    
+    for (std::vector<Record>::const_iterator it = records.begin(); it != records.end(); ++it)
+    {
+        if (needComma)
+            ostr << ",\n";
+        
+        ostr << "{\"name\":\"";
+        WriteFourCharCode(ostr, it->mClass);
+        ostr << "/";
+        
+        if (it->mCategory == kAppleEvent)
+            WriteFourCharCode(ostr, it->mKind);
+        else
+            ostr << it->mKind;
+        
+        ostr << "\",\"cat\":\"" << kCategoryNames[it->mCategory] << "\""
+             << ",\"ph\":\"X\""
+             << ",\"ts\":" << it->mBegin * toMicroseconds
+             << ",\"dur\":" << (it->mEnd - it->mBegin) * toMicroseconds
+             << ",\"pid\":" << pid
+             << ",\"tid\":" << it->mThreadID
+             << ",\"args\":{\"target\":\"";
+        WriteTargetType(ostr, it->mTargetType);
+        ostr << "\"}}";
+        
+        needComma = true;
+    }
+    
+    ostr << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    
+    ostr.precision(oldPrecision);
+    ostr.flags(oldFlags);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+DispatchTrace::WriteChromeTrace(
+    const char*     inPath)     //!< The output file's path.
+{
+    std::ofstream   ostr(inPath);
+    
+    B_THROW_IF(!ostr, std::runtime_error("can't open dispatch trace file"));
+    
+    WriteChromeTrace(ostr);
+}
+
+}   // namespace B
+
+#endif  // B_DISPATCH_TRACE
@@ -0,0 +1,219 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BDispatchTrace_H_
+#define BDispatchTrace_H_
+
+#pragma once
+
+// standard headers
+#include <iosfwd>
+
+// system headers
+#include <Carbon/Carbon.h>
+
+// library headers
+#include <boost/thread/once.hpp>
+#include <boost/utility.hpp>
+
+
+/*! @defgroup   DispatchTraceGroup  Dispatch Tracing
+    
+    The macros in this group control the instrumentation of event dispatching.
+    
+    @ingroup    Utilities
+*/
+//@{
+
+#ifndef B_DISPATCH_TRACE
+#   ifndef NDEBUG
+#       define B_DISPATCH_TRACE 1
+#   else
+#       define B_DISPATCH_TRACE 0
+#   endif
+#elif DOXYGEN_SCAN
+    /*! @def    B_DISPATCH_TRACE
+        @brief  Determines whether event dispatching is traced.
+        
+        Normally, tracing is only compiled into debug builds.  However, by defining
+        B_DISPATCH_TRACE to a non-zero value, it can be compiled into release builds
+        also.  Conversely, defining it to zero removes it from debug builds.
+        
+        @relates    DispatchTrace
+    */
+#   define B_DISPATCH_TRACE 1
+#endif
+
+#if B_DISPATCH_TRACE || DOXYGEN_SCAN
+    /*! @def    B_DISPATCH_TRACE_SCOPE
+        @brief  Records the time spent between this point and the end of the enclosing scope.
+        
+        @param  CATEGORY    One of the DispatchTrace::Category constants, without the
+                            @c DispatchTrace:: prefix.
+        @param  CLASS       The event's class.
+        @param  KIND        The event's kind (or ID, for Apple %Events).
+        @param  TARGET      A string literal (or other static string) describing the
+                            type of the event's target.
+        
+        @relates    DispatchTrace
+    */
+#   define B_DISPATCH_TRACE_SCOPE(CATEGORY, CLASS, KIND, TARGET)  \
+        B::DispatchTrace::Scope bDispatchTraceScope(B::DispatchTrace::CATEGORY, CLASS, KIND, TARGET)
+#else
+#   define B_DISPATCH_TRACE_SCOPE(CATEGORY, CLASS, KIND, TARGET)
+#endif
+
+//@}
+
+
+#if B_DISPATCH_TRACE || DOXYGEN_SCAN
+
+namespace B {
+
+/*!
+    @brief  Records the time spent dispatching events, for post-mortem analysis.
+    
+    DispatchTrace answers the question "which handler made the UI stutter?".  The
+    framework's dispatch points (Carbon %Event handlers, Apple %Event handlers and
+    custom view drawing) are instrumented with B_DISPATCH_TRACE_SCOPE, which records
+    when each dispatch began, how long it took, the event's class and kind, and the
+    type of its target.
+    
+    Each thread records into its own fixed-size ring buffer, so recording takes no
+    locks and performs no allocation (apart from allocating the thread's buffer the
+    first time it records anything).  Once a buffer is full, the oldest records are
+    overwritten.
+    
+    WriteChromeTrace() may be called at any time, from any thread, to write the
+    contents of all buffers in Chrome's trace event format.  The output can be loaded
+    in Chrome's @c about:tracing page or any other compatible viewer.
+    
+    The instrumentation is only compiled in if B_DISPATCH_TRACE is non-zero, which by
+    default is the case only in debug builds.
+    
+    @ingroup    Utilities
+*/
+class DispatchTrace : public boost::noncopyable
+{
+public:
+    
+    //! @name Types
+    //@{
+    
+    //! The kinds of dispatches that are traced.
+    enum Category
+    {
+        kCarbonEvent,   //!< A Carbon %Event, dispatched to an EventHandler.
+        kAppleEvent,    //!< An Apple %Event, dispatched by AEObjectSupport.
+        kDraw           //!< A @c kEventControlDraw event, handled by a CustomView.
+    };
+    
+    /*! @brief  Records one dispatch for the duration of its lifetime.
+        
+        This class is normally instantiated via the B_DISPATCH_TRACE_SCOPE macro.
+    */
+    class Scope : public boost::noncopyable
+    {
+    public:
+        
+        //! Constructor.  Notes the time.
+                Scope(
+                    Category    inCategory,
+                    UInt32      inClass,
+                    UInt32      inKind,
+                    const char* inTargetType);
+        //! Destructor.  Appends a record to the thread's buffer.
+                ~Scope();
+    
+    private:
+        
+        // member variables
+        const UInt64        mBegin;
+        const UInt32        mClass;
+        const UInt32        mKind;
+        const char* const   mTargetType;
+        const Category      mCategory;
+    };
+    
+    //@}
+    
+    //! @name Constants
+    //@{
+    //! The number of records held by each thread's buffer.
+    static const size_t kBufferSize = 8192;
+    //@}
+    
+    //! @name Exporting
+    //@{
+    //! Writes the recorded dispatches to @a ostr in Chrome's trace event format.
+    static void WriteChromeTrace(std::ostream& ostr);
+    //! Writes the recorded dispatches to the file at @a inPath in Chrome's trace event format.
+    static void WriteChromeTrace(const char* inPath);
+    //! Forgets the recorded dispatches.
+    static void Clear();
+    //@}
+
+private:
+    
+    struct Record;
+    struct Buffer;
+    struct Globals;
+    
+    static void     Append(
+                        Category    inCategory,
+                        UInt32      inClass,
+                        UInt32      inKind,
+                        const char* inTargetType,
+                        UInt64      inBegin,
+                        UInt64      inEnd) throw();
+    static UInt64   Now();
+    static Buffer*  GetThreadBuffer() throw();
+    static void     ReleaseThreadBuffer(Buffer* inBuffer);
+    static Globals& GetGlobals();
+    static void     InitGlobals() throw();
+    
+    // static member variables
+    static boost::once_flag sGlobalsInit;
+    static Globals*         sGlobals;
+};
+
+// ------------------------------------------------------------------------------------------
+inline
+DispatchTrace::Scope::Scope(
+    Category    inCategory,     //!< The kind of dispatch.
+    UInt32      inClass,        //!< The event's class.
+    UInt32      inKind,         //!< The event's kind (or ID, for Apple %Events).
+    const char* inTargetType)   //!< A static string describing the type of the event's target.
+        : mBegin(Now()), mClass(inClass), mKind(inKind), mTargetType(inTargetType),
+          mCategory(inCategory)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+inline
+DispatchTrace::Scope::~Scope()
+{
+    Append(mCategory, mClass, mKind, mTargetType, mBegin, Now());
+}
+
+}   // namespace B
+
+#endif  // B_DISPATCH_TRACE || DOXYGEN_SCAN
+
+
+#endif  // BDispatchTrace_H_
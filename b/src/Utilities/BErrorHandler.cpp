@@ -143,15 +143,14 @@ CFStringRef
 ErrorHandlerGlobals::CopyLocalisedMessageForKey(const char* key) const
 {
     OSPtr<CFStringRef>  keyStr(make_cfstring(key, kCFStringEncodingASCII));
-    CFBundleRef         bundleRef   = Bundle::Main().cf_ref();
+    const Bundle&       bundle  = Bundle::Main();
     
     for (MutableArray<CFStringRef>::const_iterator it = mMessageTableArray.begin(); 
          it != mMessageTableArray.end(); 
          ++it)
     {
         CFStringRef         table   = *it;
-        OSPtr<CFStringRef>  value(CFBundleCopyLocalizedString(
-                                    bundleRef, keyStr, keyStr, table), from_copy);
+        OSPtr<CFStringRef>  value(bundle.GetLocalisedString(keyStr, keyStr, table).cf_ptr());
         
         if (CFStringCompare(value, keyStr, 0) != 0)
             return (value.release());
@@ -20,6 +20,8 @@
 #include "BExceptionStreamer.h"
 
 // standard headers
+#include <cstring>
+#include <sstream>
 #include <stdexcept>
 
 // library headers
@@ -33,10 +35,44 @@
 
 // B headers
 #include "BErrorHandler.h"
+#include "BMemoryUtilities.h"
 #include "BString.h"
 #include "CFUtils.h"
 
 
+namespace {
+
+//! Identifies the binary serialisation format.  Text-format data starts with '<'.
+const UInt32    kBinaryMagic        = 'BExB';
+//! Magic number, class ID and payload size.
+const size_t    kBinaryHeaderSize   = 3 * sizeof(UInt32);
+
+// ------------------------------------------------------------------------------------------
+inline void
+AppendBigUInt32(
+    std::string&    outData, 
+    UInt32          inValue)
+{
+    UInt32  value   = CFSwapInt32HostToBig(inValue);
+    
+    outData.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// ------------------------------------------------------------------------------------------
+inline UInt32
+ReadBigUInt32(
+    const char*     inData)
+{
+    UInt32  value;
+    
+    std::memcpy(&value, inData, sizeof(value));
+    
+    return (CFSwapInt32BigToHost(value));
+}
+
+}   // anonymous namespace
+
+
 namespace B {
 
 // ======================================================================================
@@ -318,14 +354,26 @@ ExceptionStreamer::PrivateRegister(
 {
     B_ASSERT(exceptionClass != NULL);
     
-    RethrowerMap::value_type    value(exceptionClass, rethrower.get());
-    bool                        good;
+    RethrowerMap::value_type                    value(exceptionClass, rethrower.get());
+    std::pair<RethrowerMap::iterator, bool>     result;
+    
+    result = mRethrowerMap.insert(value);
     
-    good = mRethrowerMap.insert(value).second;
+    if (result.second)
+    {
+        // Give the class an ID for the binary format.  The entry points to the map's 
+        // copy of the class name, which lives as long as the registration does.  If the 
+        // ID is already taken by another class, this one is left out of the ID map and 
+        // will be externalised in text format.
+        
+        ClassEntry  entry   = { result.first->first.c_str(), rethrower.get() };
+        
+        mClassIdMap.insert(ClassIdMap::value_type(HashClassName(exceptionClass), entry));
+    }
     
     rethrower.release();
     
-    return (good);
+    return (result.second);
 }
 
 // ------------------------------------------------------------------------------------------
@@ -339,6 +387,10 @@ ExceptionStreamer::PrivateUnregister(
     if (good)
     {
         std::auto_ptr<RethrowerBase>    ptr(it->second);
+        ClassIdMap::iterator            idIt    = mClassIdMap.find(HashClassName(exceptionClass));
+        
+        if ((idIt != mClassIdMap.end()) && (idIt->second.mRethrower == it->second))
+            mClassIdMap.erase(idIt);
         
         mRethrowerMap.erase(it);
     }
@@ -400,26 +452,30 @@ ExceptionStreamer::Rethrow(
 {
     // Read the XML data.
     
-    std::vector<UInt8>  buffer(256);
-    size_t              nused = 0, nread;
+    HandleBuffer    buffer(256);
+    size_t          nread;
     
     do
     {
-        if (nused >= buffer.size())
-            buffer.resize(buffer.size() * 2);
+        size_t  nused   = buffer.size();
         
-        nread = istr.readsome(reinterpret_cast<char*>(&buffer[nused]), 
-                              buffer.size() - nused);
+        // Grow the buffer if it's full, then read into all of its spare capacity.
         
-        nused += nread;
+        buffer.reserve(nused + 1);
+        buffer.resize(buffer.capacity());
+        
+        nread = istr.readsome(buffer.data() + nused, buffer.size() - nused);
+        
+        buffer.resize(nused + nread);
         
     } while (nread > 0);
     
-    if (nused == 0)
+    if (buffer.empty())
         return;
     
-    OSPtr<CFDataRef>    xmlData(CFDataCreateWithBytesNoCopy(NULL, &buffer[0], nused, 
-                                                            kCFAllocatorNull), 
+    OSPtr<CFDataRef>    xmlData(CFDataCreateWithBytesNoCopy(NULL, 
+                                                            reinterpret_cast<const UInt8*>(buffer.data()), 
+                                                            buffer.size(), kCFAllocatorNull), 
                                 from_copy);
     OSPtr<CFXMLTreeRef> docTree(CFXMLTreeCreateFromData(NULL, xmlData, NULL, 
                                                         kCFXMLParserSkipWhitespace, 
@@ -511,6 +567,124 @@ ExceptionStreamer::Rethrow(
     it->second->Rethrow(sstr);
 }
 
+// ------------------------------------------------------------------------------------------
+void
+ExceptionStreamer::Externalize(
+    const std::exception&   ex, 
+    std::string&            outData) const
+{
+    const char*         exClass = typeid(ex).name();
+    UInt32              classId;
+    const ClassEntry*   entry   = FindClass(exClass, classId);
+    
+    // If the class has no ID, use the text format, which also takes care of complaining 
+    // about unregistered classes.
+    
+    if (entry == NULL)
+    {
+        std::ostringstream  ostr;
+        
+        Externalize(ex, ostr);
+        outData += ostr.str();
+        
+        return;
+    }
+    
+    // See the text version of this function regarding std::bad_alloc.
+    
+    if (dynamic_cast<const std::bad_alloc*>(&ex) != NULL)
+        return;
+    
+    // Write out the header with a placeholder for the payload size, then let the 
+    // rethrower append the payload, then patch the size.
+    
+    std::string::size_type  start   = outData.size();
+    
+    AppendBigUInt32(outData, kBinaryMagic);
+    AppendBigUInt32(outData, classId);
+    AppendBigUInt32(outData, 0);
+    
+    entry->mRethrower->Externalize(ex, outData);
+    
+    UInt32  size    = CFSwapInt32HostToBig(outData.size() - start - kBinaryHeaderSize);
+    
+    outData.replace(start + kBinaryHeaderSize - sizeof(size), sizeof(size), 
+                    reinterpret_cast<const char*>(&size), sizeof(size));
+}
+
+// ------------------------------------------------------------------------------------------
+void
+ExceptionStreamer::Rethrow(
+    const void*     inData, 
+    size_t          inSize) const
+{
+    const char* data    = static_cast<const char*>(inData);
+    
+    if ((inSize < kBinaryHeaderSize) || (ReadBigUInt32(data) != kBinaryMagic))
+    {
+        // Not in binary format, so it's probably in text format.
+        
+        std::istringstream  istr(std::string(data, inSize));
+        
+        Rethrow(istr);
+        
+        return;
+    }
+    
+    UInt32  classId = ReadBigUInt32(data + sizeof(UInt32));
+    UInt32  size    = ReadBigUInt32(data + 2 * sizeof(UInt32));
+    
+    if (size > inSize - kBinaryHeaderSize)
+        return;
+    
+    // Locate the rethrower for this exception class, and invoke it.
+    
+    ClassIdMap::const_iterator  it  = mClassIdMap.find(classId);
+    
+    if (it == mClassIdMap.end())
+        return;
+    
+    it->second.mRethrower->Rethrow(data + kBinaryHeaderSize, size);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the ID map entry for @a exceptionClass, or @c NULL if the class isn't 
+    registered or doesn't own its ID.
+*/
+const ExceptionStreamer::ClassEntry*
+ExceptionStreamer::FindClass(
+    const char* exceptionClass, 
+    UInt32&     outClassId) const
+{
+    outClassId = HashClassName(exceptionClass);
+    
+    ClassIdMap::const_iterator  it  = mClassIdMap.find(outClassId);
+    
+    if ((it == mClassIdMap.end()) || (std::strcmp(it->second.mClassName, exceptionClass) != 0))
+        return (NULL);
+    
+    return (&it->second);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Computes the 32-bit FNV-1a hash of @a exceptionClass.  The result must not depend on 
+    anything but the class name, since it is interpreted by other processes.
+*/
+UInt32
+ExceptionStreamer::HashClassName(const char* exceptionClass)
+{
+    const unsigned char*    p       = reinterpret_cast<const unsigned char*>(exceptionClass);
+    UInt32                  hash    = 2166136261U;
+    
+    while (*p != 0)
+    {
+        hash ^= *p++;
+        hash *= 16777619U;
+    }
+    
+    return (hash);
+}
+
 // ------------------------------------------------------------------------------------------
 std::string
 ExceptionStreamer::Encode(const std::string& inString) const
@@ -590,6 +764,33 @@ ExceptionStreamer::Decode(const std::string& inString) const
 //  ostr << str << "\n";
 //}
 
+// ------------------------------------------------------------------------------------------
+/*! The default implementation goes through the stream-based Externalize().
+*/
+void
+ExceptionStreamer::RethrowerBase::Externalize(
+    const std::exception&   ex, 
+    std::string&            outData) const
+{
+    std::ostringstream  ostr;
+    
+    Externalize(ex, ostr);
+    outData += ostr.str();
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The default implementation goes through the stream-based Rethrow().
+*/
+void
+ExceptionStreamer::RethrowerBase::Rethrow(
+    const char*             inData, 
+    size_t                  inSize) const
+{
+    std::istringstream  istr(std::string(inData, inSize));
+    
+    Rethrow(istr);
+}
+
 // ------------------------------------------------------------------------------------------
 std::string
 ExceptionStreamer::RethrowerBase::ReadExString(
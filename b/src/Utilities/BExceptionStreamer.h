@@ -25,6 +25,7 @@
 #include <exception>
 #include <iosfwd>
 #include <typeinfo>
+#include <map>
 #if !__MWERKS__
 #   include <string>
 #endif
@@ -35,6 +36,11 @@
 #endif
 
 // library headers
+#if defined(__MWERKS__)
+#   include <hash_map>
+#elif defined(__GNUC__)
+#   include <ext/hash_map>
+#endif
 #include <boost/intrusive_ptr.hpp>
 
 // B headers
@@ -60,7 +66,27 @@ class   String;
     Serialisation is performed by Externalize(), whereas deserialisation is done by 
     Rethrow().  Developers will rarely if ever need to call these functions directly.
     
-    Currently, the format of the serialised exception is a very small XML document:
+    Two formats are supported.  The binary format is produced by the Externalize() 
+    overload taking an @c std::string.  Since older versions of B can't read it, it is 
+    only used where the reader is known to understand it:  in Carbon %Events sent 
+    through EventBase::Send(), which advertises it.  Apple %Event replies, which may 
+    go to other processes, always use the text format.  The binary format is laid out 
+    as follows (integers are big-endian):
+    
+    @verbatim
+    UInt32  magic           'BExB'
+    UInt32  class ID        FNV-1a hash of typeid(exception-object).name()
+    UInt32  payload size
+    UInt8   payload[size]   exception state, as produced by its rethrower
+    @endverbatim
+    
+    Class IDs are resolved through a hash table, so neither writing nor reading a 
+    binary exception involves iostreams or an XML parser, except for 
+    StreamExceptionTag classes and custom rethrowers, whose state is inherently 
+    stream-based.
+    
+    The text format, produced by the Externalize() overload taking an @c std::ostream, 
+    is a very small XML document:
     
     @verbatim
     <?xml version="1.0" encoding="UTF-8"?>
@@ -70,6 +96,10 @@ class   String;
     The @c class attribute contains the result of 
     <tt>typeid(<i>exception-object</i>).name()</tt>.  The @c value attribute is optional.
     
+    The Rethrow() overload taking a buffer accepts either format, so exceptions sent by 
+    an older peer are still understood.  The binary writer itself falls back to the 
+    text format for the (unlikely) class whose ID collides with that of another class.
+    
     @sa         @ref using_exceptions
     @ingroup    ExceptionGroup
     
@@ -102,20 +132,38 @@ public:
     
     //! @name Serialisation / Deserialisation
     //@{
-    //! Write out the state of @a ex to @a ostr.
+    //! Write out the state of @a ex to @a ostr, in text format.
     void    Externalize(
                 const std::exception&   ex, 
                 std::ostream&           ostr) const;
     //! Instantiate an exception object matching the contents of @a istr, then throw it.
     void    Rethrow(
                 std::istream&           istr) const;
+    //! Append the state of @a ex to @a outData, in binary format.
+    void    Externalize(
+                const std::exception&   ex, 
+                std::string&            outData) const;
+    //! Instantiate an exception object matching the contents of @a inData, then throw it.
+    void    Rethrow(
+                const void*             inData, 
+                size_t                  inSize) const;
     //@}
     
 private:
     
     // types
     class RethrowerBase;
+    struct ClassEntry
+    {
+        const char*     mClassName;
+        RethrowerBase*  mRethrower;
+    };
     typedef std::map<std::string, RethrowerBase*>   RethrowerMap;
+#if defined(__MWERKS__)
+    typedef Metrowerks::hash_map<UInt32, ClassEntry>    ClassIdMap;
+#elif defined(__GNUC__)
+    typedef __gnu_cxx::hash_map<UInt32, ClassEntry>     ClassIdMap;
+#endif
     typedef std::map<char, std::string>             EncodingMap;
     typedef std::map<std::string, char>             DecodingMap;
     
@@ -129,6 +177,12 @@ private:
                             std::ostream&           ostr) const = 0;
         virtual void    Rethrow(
                             std::istream&           istr) const = 0;
+        virtual void    Externalize(
+                            const std::exception&   ex, 
+                            std::string&            outData) const;
+        virtual void    Rethrow(
+                            const char*             inData, 
+                            size_t                  inSize) const;
     
     protected:
         
@@ -165,6 +219,12 @@ private:
                             std::ostream&           ostr) const;
         virtual void    Rethrow(
                             std::istream&           istr) const;
+        virtual void    Externalize(
+                            const std::exception&   ex, 
+                            std::string&            outData) const;
+        virtual void    Rethrow(
+                            const char*             inData, 
+                            size_t                  inSize) const;
     };
     
     template <class EXCEPTION>
@@ -181,6 +241,12 @@ private:
                             std::ostream&           ostr) const;
         virtual void    Rethrow(
                             std::istream&           istr) const;
+        virtual void    Externalize(
+                            const std::exception&   ex, 
+                            std::string&            outData) const;
+        virtual void    Rethrow(
+                            const char*             inData, 
+                            size_t                  inSize) const;
     };
     
     template <class EXCEPTION>
@@ -237,15 +303,22 @@ private:
     bool        PrivateUnregister(
                     const char*                     exceptionClass);
     
+    const ClassEntry*
+                FindClass(
+                    const char*                     exceptionClass, 
+                    UInt32&                         outClassId) const;
     std::string Encode(const std::string& inString) const;
     std::string Decode(const std::string& inString) const;
     
+    static UInt32   HashClassName(const char* exceptionClass);
+    
     static void InitSingleton();
     static void CleanupSingleton();
     
     // member variables
     SInt32          mRefCount;
     RethrowerMap    mRethrowerMap;
+    ClassIdMap      mClassIdMap;
     EncodingMap     mEncodingMap;
     DecodingMap     mDecodingMap;
     std::string     mEncodedChars;
@@ -329,6 +402,23 @@ ExceptionStreamer::Rethrower<EXCEPTION, DefaultExceptionTag>::Rethrow(
     B_THROW(EXCEPTION());
 }
 
+// ------------------------------------------------------------------------------------------
+template <class EXCEPTION> void
+ExceptionStreamer::Rethrower<EXCEPTION, DefaultExceptionTag>::Externalize(
+    const std::exception&   /* ex */, 
+    std::string&            /* outData */) const
+{
+}
+
+// ------------------------------------------------------------------------------------------
+template <class EXCEPTION> void
+ExceptionStreamer::Rethrower<EXCEPTION, DefaultExceptionTag>::Rethrow(
+    const char*             /* inData */, 
+    size_t                  /* inSize */) const
+{
+    B_THROW(EXCEPTION());
+}
+
 // ------------------------------------------------------------------------------------------
 template <class EXCEPTION> void
 ExceptionStreamer::Rethrower<EXCEPTION, StringExceptionTag>::Externalize(
@@ -346,6 +436,24 @@ ExceptionStreamer::Rethrower<EXCEPTION, StringExceptionTag>::Rethrow(
     B_THROW(EXCEPTION(ReadExString(istr)));
 }
 
+// ------------------------------------------------------------------------------------------
+template <class EXCEPTION> void
+ExceptionStreamer::Rethrower<EXCEPTION, StringExceptionTag>::Externalize(
+    const std::exception&   ex, 
+    std::string&            outData) const
+{
+    outData += ex.what();
+}
+
+// ------------------------------------------------------------------------------------------
+template <class EXCEPTION> void
+ExceptionStreamer::Rethrower<EXCEPTION, StringExceptionTag>::Rethrow(
+    const char*             inData, 
+    size_t                  inSize) const
+{
+    B_THROW(EXCEPTION(std::string(inData, inSize)));
+}
+
 // ------------------------------------------------------------------------------------------
 template <class EXCEPTION> void
 ExceptionStreamer::Rethrower<EXCEPTION, StreamExceptionTag>::Externalize(
@@ -0,0 +1,230 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BInternedString.h"
+
+// standard headers
+#include <new>
+
+// library headers
+#include <boost/thread/mutex.hpp>
+
+// B headers
+#include "BAtomic.h"
+#include "BErrorHandler.h"
+
+
+namespace B {
+
+// ==========================================================================================
+//  InternedString::Table
+
+/*! The table is a fixed array of buckets, each of which is the head of a singly-linked 
+    list of entries.  Entries are only ever prepended to a list, and are never modified 
+    once they have been published, so readers can walk the lists without locking.  
+    Writers are serialised by mMutex.
+*/
+struct InternedString::Table
+{
+    enum { kBucketCount = 2048 };
+    
+    Table() : mSize(0), mEmpty(NULL)
+    {
+        std::fill(mBuckets, mBuckets + kBucketCount, static_cast<Entry*>(NULL));
+    }
+    
+    boost::mutex    mMutex;                 //!< Serialises additions to the table.
+    Entry* volatile mBuckets[kBucketCount];
+    size_t          mSize;
+    const Entry*    mEmpty;                 //!< The entry for the empty string.
+};
+
+
+// ==========================================================================================
+//  InternedString::Entry
+
+// ------------------------------------------------------------------------------------------
+InternedString::Entry::Entry(
+    CFStringRef inString, 
+    size_t      inHash)
+        : mString(inString), mHash(inHash), mNext(NULL)
+{
+}
+
+
+// ==========================================================================================
+//  InternedString
+
+#pragma mark -
+#pragma mark InternedString
+
+boost::once_flag            InternedString::sTableInit  = BOOST_ONCE_INIT;
+InternedString::Table*      InternedString::sTable      = NULL;
+
+// ------------------------------------------------------------------------------------------
+void
+InternedString::InitTable() throw()
+{
+    Table*  table   = NULL;
+    
+    try
+    {
+        table           = new Table;
+        table->mEmpty   = Intern(*table, CFSTR(""));
+        sTable          = table;
+    }
+    catch (...)
+    {
+        // sTable stays NULL, so GetTable() will throw.
+        delete table;
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+InternedString::Table&
+InternedString::GetTable()
+{
+    boost::call_once(InitTable, sTableInit);
+    B_THROW_IF(sTable == NULL, std::bad_alloc());
+    
+    return (*sTable);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the entry in the list starting at @a inChain whose string is equal to 
+    @a inString, or @c NULL if there isn't one.
+*/
+const InternedString::Entry*
+InternedString::Find(
+    const Entry*    inChain, 
+    CFStringRef     inString, 
+    size_t          inHash)
+{
+    for (const Entry* entry = inChain; entry != NULL; entry = entry->mNext)
+    {
+        if ((entry->mHash == inHash) && CFEqual(entry->mString.cf_ref(), inString))
+            return (entry);
+    }
+    
+    return (NULL);
+}
+
+// ------------------------------------------------------------------------------------------
+const InternedString::Entry*
+InternedString::Intern(
+    CFStringRef inString)
+{
+    return (Intern(GetTable(), inString));
+}
+
+// ------------------------------------------------------------------------------------------
+const InternedString::Entry*
+InternedString::Intern(
+    Table&      ioTable, 
+    CFStringRef inString)
+{
+    B_ASSERT(inString != NULL);
+    
+    size_t          hash    = CFHash(inString);
+    Entry* volatile& bucket = ioTable.mBuckets[hash % Table::kBucketCount];
+    const Entry*    entry;
+    
+    // Fast path:  the string has already been interned.  No barrier is needed here, 
+    // because every read through the list's head depends on the head's value.
+    
+    if ((entry = Find(bucket, inString, hash)) != NULL)
+        return (entry);
+    
+    boost::mutex::scoped_lock   lock(ioTable.mMutex);
+    
+    // Somebody else may have added the string while we weren't holding the lock.
+    
+    Entry*  head    = bucket;
+    
+    if ((entry = Find(head, inString, hash)) != NULL)
+        return (entry);
+    
+    Entry*  newEntry    = new Entry(inString, hash);
+    
+    newEntry->mNext = head;
+    
+    // Make sure the entry is complete before publishing it.
+    AtomicBarrier();
+    
+    bucket = newEntry;
+    ioTable.mSize++;
+    
+    return (newEntry);
+}
+
+// ------------------------------------------------------------------------------------------
+InternedString::InternedString()
+    : mEntry(GetTable().mEmpty)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+InternedString::InternedString(
+    const char*         inString,   //!< The string to intern.
+    CFStringEncoding    inEncoding) //!< The string's encoding.
+{
+    B_ASSERT(inString != NULL);
+    
+    OSPtr<CFStringRef>  cfstr(CFStringCreateWithCStringNoCopy(NULL, inString, inEncoding, 
+                                                              kCFAllocatorNull), 
+                              from_copy);
+    
+    mEntry = Intern(cfstr.get());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! If @a inString has been interned, sets @a outString to refer to it and returns 
+    @c true.  Otherwise, returns @c false and leaves @a outString alone.  Unlike the 
+    constructors, this never adds an entry to the table, and never takes a lock.
+*/
+bool
+InternedString::Lookup(
+    CFStringRef         inString,   //!< The string to look up.
+    InternedString&     outString)  //!< Receives the interned string.
+{
+    B_ASSERT(inString != NULL);
+    
+    Table&          table   = GetTable();
+    size_t          hash    = CFHash(inString);
+    const Entry*    entry   = Find(table.mBuckets[hash % Table::kBucketCount], inString, hash);
+    
+    if (entry == NULL)
+        return (false);
+    
+    outString = InternedString(entry);
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+size_t
+InternedString::GetTableSize()
+{
+    Table&                      table   = GetTable();
+    boost::mutex::scoped_lock   lock(table.mMutex);
+    
+    return (table.mSize);
+}
+
+}   // namespace B
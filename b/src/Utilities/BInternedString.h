@@ -0,0 +1,224 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BInternedString_H_
+#define BInternedString_H_
+
+#pragma once
+
+// standard headers
+#include <algorithm>
+#include <functional>
+#include <iosfwd>
+
+// system headers
+#include <CoreFoundation/CFString.h>
+
+// library headers
+#include <boost/thread/once.hpp>
+
+// B headers
+#include "BString.h"
+
+
+namespace B {
+
+/*!
+    @brief  A handle to a string held in a global, process-wide table.
+    
+    Interning a string looks it up in the table, adding it if it isn't already there, 
+    and returns a handle to the table's entry.  Because the table holds at most one 
+    entry per distinct string, two InternedStrings are equal if and only if they 
+    refer to the same entry.  Comparing them is therefore a pointer comparison, and 
+    hashing them is a matter of returning the hash value that was computed when the 
+    string was first interned.
+    
+    This makes InternedStrings ideal as keys for the many small lookup tables keyed 
+    by names (event names, type names, class IDs, and the like) that are built once 
+    and then searched repeatedly.  Such tables should be declared as hash maps, using 
+    InternedStringHash as the hash function:
+    
+    @code
+        typedef __gnu_cxx::hash_map<InternedString, DescType, InternedStringHash>  NameMap;
+        
+        NameMap::const_iterator it  = map.find(InternedString(CFSTR("name")));
+    @endcode
+    
+    Entries are never removed from the table, so a handle remains valid for the life 
+    of the process, and the strings it returns never change.  Interning strings that 
+    come from untrusted sources is therefore not recommended.  To search a table keyed 
+    by InternedString for such a string, use Lookup(), which doesn't add anything to 
+    the table:  if the string was never interned, it can't be one of the keys.
+    
+    Interning may be performed concurrently from any number of threads.  Looking up a 
+    string that's already in the table takes no locks;  only the addition of a new 
+    entry is serialised.  Handles themselves are immutable and may be freely shared 
+    between threads.
+    
+    The ordering defined by operator < is based on the entries' addresses, not on the 
+    strings' contents.  It is consistent within one run of the process, but no more.
+    
+    @ingroup    Utilities
+*/
+class InternedString
+{
+public:
+    
+    //! @name Constructors
+    //@{
+    //! Default constructor.  The handle refers to the empty string.
+                    InternedString();
+    //! Interns @a inString.
+    explicit        InternedString(CFStringRef inString);
+    //! Interns @a inString.
+    explicit        InternedString(const String& inString);
+    //! Interns @a inString, which is in @a inEncoding.
+    explicit        InternedString(
+                        const char*         inString, 
+                        CFStringEncoding    inEncoding = kCFStringEncodingASCII);
+    //@}
+    
+    //! @name Inquiries
+    //@{
+    //! Returns the interned string.
+    const String&   str() const         { return (mEntry->mString); }
+    //! Returns the interned string as a @c CFStringRef.
+    CFStringRef     cf_ref() const      { return (mEntry->mString.cf_ref()); }
+    //! Returns the string's hash value.
+    size_t          hash() const        { return (mEntry->mHash); }
+    //! Returns @c true if the string is empty.
+    bool            empty() const       { return (mEntry->mString.empty()); }
+    //@}
+    
+    //! @name Modifiers
+    //@{
+    //! Exchanges the contents of the handle with @a ioString.
+    void            swap(InternedString& ioString)  { std::swap(mEntry, ioString.mEntry); }
+    //@}
+    
+    //! @name Table Management
+    //@{
+    //! Returns the number of distinct strings that have been interned so far.
+    static size_t   GetTableSize();
+    //! Finds @a inString without interning it.
+    static bool     Lookup(
+                        CFStringRef         inString, 
+                        InternedString&     outString);
+    //@}
+    
+private:
+    
+    struct Entry
+    {
+        Entry(CFStringRef inString, size_t inHash);
+        
+        // member variables
+        const String    mString;
+        const size_t    mHash;
+        Entry* volatile mNext;
+    };
+    
+    struct Table;
+    
+    // constructor
+    explicit        InternedString(const Entry* inEntry) : mEntry(inEntry) {}
+    
+    static const Entry* Intern(CFStringRef inString);
+    static const Entry* Intern(
+                            Table&          ioTable, 
+                            CFStringRef     inString);
+    static const Entry* Find(
+                            const Entry*    inChain, 
+                            CFStringRef     inString, 
+                            size_t          inHash);
+    static Table&       GetTable();
+    static void         InitTable() throw();
+    
+    // member variables
+    const Entry*        mEntry;
+    
+    // static member variables
+    static boost::once_flag sTableInit;
+    static Table*           sTable;
+    
+    // friends
+    friend bool operator == (const InternedString& s1, const InternedString& s2);
+    friend bool operator <  (const InternedString& s1, const InternedString& s2);
+};
+
+// ------------------------------------------------------------------------------------------
+/*! The hash function object to use with hash containers keyed by InternedString.
+    
+    @relates    InternedString
+*/
+struct InternedStringHash : public std::unary_function<InternedString, size_t>
+{
+    size_t  operator () (const InternedString& s) const { return (s.hash()); }
+};
+
+// ------------------------------------------------------------------------------------------
+inline
+InternedString::InternedString(
+    CFStringRef inString)   //!< The string to intern.
+        : mEntry(Intern(inString))
+{
+}
+
+// ------------------------------------------------------------------------------------------
+inline
+InternedString::InternedString(
+    const String&   inString)   //!< The string to intern.
+        : mEntry(Intern(inString.cf_ref()))
+{
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @relates    InternedString
+*/
+inline bool operator == (const InternedString& s1, const InternedString& s2)    { return (s1.mEntry == s2.mEntry); }
+
+// ------------------------------------------------------------------------------------------
+/*! @relates    InternedString
+*/
+inline bool operator != (const InternedString& s1, const InternedString& s2)    { return (!(s1 == s2)); }
+
+// ------------------------------------------------------------------------------------------
+/*! @relates    InternedString
+*/
+inline bool operator <  (const InternedString& s1, const InternedString& s2)    { return (s1.mEntry < s2.mEntry); }
+
+// ------------------------------------------------------------------------------------------
+/*! @relates    InternedString
+*/
+inline void swap(InternedString& s1, InternedString& s2)    { s1.swap(s2); }
+
+// ------------------------------------------------------------------------------------------
+/*! Writes the interned string to @a ostr.
+    
+    @relates    InternedString
+*/
+inline std::ostream&
+operator << (std::ostream& ostr, const InternedString& s)
+{
+    return (ostr << s.str());
+}
+
+}   // namespace B
+
+
+#endif  // BInternedString_H_
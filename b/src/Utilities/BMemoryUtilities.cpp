@@ -33,6 +33,7 @@ AutoMacHandle::AutoMacHandle()
     : mHandle(NewHandle(0))
 {
     B_THROW_IF_NULL(mHandle);
+    AllocationAccounting::Allocated(AllocationAccounting::kHandles, 0);
 }
 
 // ------------------------------------------------------------------------------------------
@@ -57,6 +58,7 @@ AutoMacHandle::AutoMacHandle(size_t inSize)
     : mHandle(NewHandle(inSize))
 {
     B_THROW_IF_NULL(mHandle);
+    AllocationAccounting::Allocated(AllocationAccounting::kHandles, inSize);
 }
 
 // ------------------------------------------------------------------------------------------
@@ -81,6 +83,11 @@ AutoMacHandle::release()
 {
     MacHandle   oldHandle   = mHandle;
     
+#if B_ALLOCATION_ACCOUNTING
+    if (oldHandle != NULL)
+        AllocationAccounting::Deallocated(AllocationAccounting::kHandles, size());
+#endif
+    
     mHandle = NULL;
     
     return (oldHandle);
@@ -96,18 +103,68 @@ AutoMacHandle::reset(MacHandle inHandle /* = NULL */)
     // If you need to wrap a resource handle, use AutoMacResourceHandle instead.
     B_ASSERT((inHandle == NULL) || !(HGetState(inHandle) & kHandleIsResourceMask));
     
+#if B_ALLOCATION_ACCOUNTING
+    if (inHandle != NULL)
+        AllocationAccounting::Allocated(AllocationAccounting::kHandles, GetHandleSize(inHandle));
+#endif
+    
     if (mHandle != NULL)
+    {
+#if B_ALLOCATION_ACCOUNTING
+        AllocationAccounting::Deallocated(AllocationAccounting::kHandles, size());
+#endif
         DisposeHandle(mHandle);
+    }
     
     mHandle = inHandle;
 }
 
 // ------------------------------------------------------------------------------------------
+/*! The handle is resized to exactly @a inNewSize bytes, since its size is visible to 
+    (and often significant for) anyone the handle is given to.  When building up a 
+    handle's contents incrementally, use a HandleBuffer instead.
+*/
 void
 AutoMacHandle::resize(size_t inNewSize)
 {
+#if B_BLOCK_ALLOCATOR_STATISTICS || B_ALLOCATION_ACCOUNTING
+    size_t  oldSize = size();
+#endif
+    
     SetHandleSize(mHandle, inNewSize);
     B_THROW_IF_STATUS(MemError());
+    
+#if B_ALLOCATION_ACCOUNTING
+    AllocationAccounting::Resized(AllocationAccounting::kHandles, oldSize, inNewSize);
+#endif
+#if B_BLOCK_ALLOCATOR_STATISTICS
+    BlockAllocator::RecordResize(B_BLOCK_ALLOCATOR_CALLER(), inNewSize, inNewSize > oldSize);
+#endif
+}
+
+
+// ==========================================================================================
+//  HandleBuffer
+
+#pragma mark -
+
+// ------------------------------------------------------------------------------------------
+HandleBuffer::HandleBuffer()
+    : mData(NULL), mSize(0), mCapacity(0)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+HandleBuffer::HandleBuffer(size_t inCapacity)
+    : mData(NULL), mSize(0), mCapacity(0)
+{
+    reserve(inCapacity);
+}
+
+// ------------------------------------------------------------------------------------------
+HandleBuffer::~HandleBuffer()
+{
+    BlockAllocator::Deallocate(mData, mCapacity);
 }
 
 
@@ -121,6 +178,7 @@ AutoMacPtr::AutoMacPtr()
     : mPtr(NewPtr(0))
 {
     B_THROW_IF_NULL(mPtr);
+    AllocationAccounting::Allocated(AllocationAccounting::kHandles, 0);
 }
 
 // ------------------------------------------------------------------------------------------
@@ -134,6 +192,10 @@ AutoMacPtr::AutoMacPtr(AutoMacPtr& ioPtr)
 AutoMacPtr::AutoMacPtr(MacPtr inPtr)
     : mPtr(inPtr)
 {
+#if B_ALLOCATION_ACCOUNTING
+    if (mPtr != NULL)
+        AllocationAccounting::Allocated(AllocationAccounting::kHandles, size());
+#endif
 }
 
 // ------------------------------------------------------------------------------------------
@@ -141,6 +203,7 @@ AutoMacPtr::AutoMacPtr(size_t inSize)
     : mPtr(NewPtr(inSize))
 {
     B_THROW_IF_NULL(mPtr);
+    AllocationAccounting::Allocated(AllocationAccounting::kHandles, inSize);
 }
 
 // ------------------------------------------------------------------------------------------
@@ -165,6 +228,11 @@ AutoMacPtr::release()
 {
     MacPtr  oldPtr  = mPtr;
     
+#if B_ALLOCATION_ACCOUNTING
+    if (oldPtr != NULL)
+        AllocationAccounting::Deallocated(AllocationAccounting::kHandles, size());
+#endif
+    
     mPtr = NULL;
     
     return (oldPtr);
@@ -174,8 +242,18 @@ AutoMacPtr::release()
 void
 AutoMacPtr::reset(MacPtr inPtr /* = NULL */)
 {
+#if B_ALLOCATION_ACCOUNTING
+    if (inPtr != NULL)
+        AllocationAccounting::Allocated(AllocationAccounting::kHandles, GetPtrSize(inPtr));
+#endif
+    
     if (mPtr != NULL)
+    {
+#if B_ALLOCATION_ACCOUNTING
+        AllocationAccounting::Deallocated(AllocationAccounting::kHandles, size());
+#endif
         DisposePtr(mPtr);
+    }
     
     mPtr = inPtr;
 }
@@ -184,8 +262,19 @@ AutoMacPtr::reset(MacPtr inPtr /* = NULL */)
 void
 AutoMacPtr::resize(size_t inNewSize)
 {
+#if B_BLOCK_ALLOCATOR_STATISTICS || B_ALLOCATION_ACCOUNTING
+    size_t  oldSize = size();
+#endif
+    
     SetPtrSize(mPtr, inNewSize);
     B_THROW_IF_STATUS(MemError());
+    
+#if B_ALLOCATION_ACCOUNTING
+    AllocationAccounting::Resized(AllocationAccounting::kHandles, oldSize, inNewSize);
+#endif
+#if B_BLOCK_ALLOCATOR_STATISTICS
+    BlockAllocator::RecordResize(B_BLOCK_ALLOCATOR_CALLER(), inNewSize, inNewSize > oldSize);
+#endif
 }
 
 
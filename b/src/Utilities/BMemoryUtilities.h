@@ -31,6 +31,8 @@
 #include <boost/utility.hpp>
 
 // B headers
+#include "BAllocationAccounting.h"
+#include "BBlockAllocator.h"
 #include "BErrorHandler.h"
 
 
@@ -178,6 +180,7 @@ AutoTypedHandle<T>::AutoTypedHandle()
     : mHandle(reinterpret_cast<T**>(NewHandle(sizeof(T))))
 {
     B_THROW_IF_NULL(mHandle);
+    AllocationAccounting::Allocated(AllocationAccounting::kHandles, sizeof(T));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -226,6 +229,11 @@ AutoTypedHandle<T>::release()
 {
     T** oldHandle   = mHandle;
     
+#if B_ALLOCATION_ACCOUNTING
+    if (oldHandle != NULL)
+        AllocationAccounting::Deallocated(AllocationAccounting::kHandles, size());
+#endif
+    
     mHandle = NULL;
     
     return oldHandle;
@@ -244,8 +252,18 @@ AutoTypedHandle<T>::reset(T** inHandle /* = NULL */)
     // If you need to wrap a resource handle, use AutoTypedResourceHandle instead.
     B_ASSERT((newH == NULL) || !(HGetState(newH) & kHandleIsResourceMask));
     
+#if B_ALLOCATION_ACCOUNTING
+    if (newH != NULL)
+        AllocationAccounting::Allocated(AllocationAccounting::kHandles, GetHandleSize(newH));
+#endif
+    
     if (oldH != NULL)
+    {
+#if B_ALLOCATION_ACCOUNTING
+        AllocationAccounting::Deallocated(AllocationAccounting::kHandles, GetHandleSize(oldH));
+#endif
         DisposeHandle(oldH);
+    }
     
     mHandle = inHandle;
 }
@@ -254,8 +272,154 @@ AutoTypedHandle<T>::reset(T** inHandle /* = NULL */)
 template <typename T> void
 AutoTypedHandle<T>::resize(size_t inNewSize)
 {
+#if B_BLOCK_ALLOCATOR_STATISTICS || B_ALLOCATION_ACCOUNTING
+    size_t  oldSize = size();
+#endif
+    
     SetHandleSize(reinterpret_cast<MacHandle>(mHandle), inNewSize);
     B_THROW_IF_STATUS(MemError());
+    
+#if B_ALLOCATION_ACCOUNTING
+    AllocationAccounting::Resized(AllocationAccounting::kHandles, oldSize, inNewSize);
+#endif
+#if B_BLOCK_ALLOCATOR_STATISTICS
+    BlockAllocator::RecordResize(B_BLOCK_ALLOCATOR_CALLER(), inNewSize, inNewSize > oldSize);
+#endif
+}
+
+
+// ==========================================================================================
+//  HandleBuffer
+
+/*!
+    @brief  Growable buffer for building up the contents of a Carbon @c Handle.
+    
+    Resizing a handle resizes it to exactly the requested size, so a loop that appends 
+    to a handle reallocates it on each iteration.  A HandleBuffer instead grows 
+    geometrically, out of BlockAllocator, so appending takes amortised constant time.  
+    Once the contents are complete, CopyTo() copies them into a handle of exactly the 
+    right size, with a single resize.
+    
+    The buffer's memory doesn't come from the Memory Manager, so data() must not be 
+    given to functions that expect a @c Ptr.
+*/
+class HandleBuffer : public boost::noncopyable
+{
+public:
+    
+    //! @name Constructors & Destructor
+    //@{
+    //! Default constructor.  Creates an empty buffer.
+                HandleBuffer();
+    //! Capacity constructor.  Creates an empty buffer able to hold @a inCapacity bytes.
+    explicit    HandleBuffer(size_t inCapacity);
+    //! Destructor.
+                ~HandleBuffer();
+    //@}
+    
+    //! @name Inquiries
+    //@{
+    //! Returns @c true if the buffer is empty.
+    bool        empty() const       { return (mSize == 0); }
+    //! Returns the number of bytes in the buffer.
+    size_t      size() const        { return (mSize); }
+    //! Returns the number of bytes the buffer can hold without reallocating.
+    size_t      capacity() const    { return (mCapacity); }
+    //! Returns the buffer's contents.
+    char*       data()              { return (mData); }
+    //! Returns the buffer's contents.
+    const char* data() const        { return (mData); }
+    //@}
+    
+    //! @name Modifiers
+    //@{
+    //! Empties the buffer, without releasing its memory.
+    void        clear()             { mSize = 0; }
+    //! Makes the buffer able to hold @a inCapacity bytes without reallocating.
+    void        reserve(size_t inCapacity);
+    //! Changes the number of bytes in the buffer.  New bytes are uninitialised.
+    void        resize(size_t inNewSize);
+    //! Appends @a inSize bytes at @a inData to the buffer.
+    void        append(const void* inData, size_t inSize);
+    //@}
+    
+    //! @name Conversions
+    //@{
+    //! Replaces @a ioHandle's contents with the buffer's.
+    void        CopyTo(AutoMacHandle& ioHandle) const;
+    //! Replaces @a ioHandle's contents with the buffer's.
+    template <typename T>
+    void        CopyTo(AutoTypedHandle<T>& ioHandle) const;
+    //@}
+    
+private:
+    
+    void        CopyData(::Handle ioHandle) const;
+    
+    // member variables
+    char*       mData;
+    size_t      mSize;
+    size_t      mCapacity;
+};
+
+// ------------------------------------------------------------------------------------------
+inline void
+HandleBuffer::reserve(size_t inCapacity)
+{
+    if (inCapacity > mCapacity)
+        mData = static_cast<char*>(BlockAllocator::Resize(mData, mCapacity, mSize, 
+                                                          inCapacity, mCapacity));
+}
+
+// ------------------------------------------------------------------------------------------
+inline void
+HandleBuffer::resize(size_t inNewSize)
+{
+    if (inNewSize > mCapacity)
+        mData = static_cast<char*>(BlockAllocator::Resize(mData, mCapacity, mSize, 
+                                                          inNewSize, mCapacity));
+    
+    mSize = inNewSize;
+}
+
+// ------------------------------------------------------------------------------------------
+inline void
+HandleBuffer::append(const void* inData, size_t inSize)
+{
+    size_t  oldSize = mSize;
+    
+    resize(oldSize + inSize);
+    BlockMoveData(inData, mData + oldSize, inSize);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The handle is resized with its own resize(), so that its size is exact and the 
+    resize is attributed to the wrapper.
+*/
+inline void
+HandleBuffer::CopyTo(AutoMacHandle& ioHandle) const
+{
+    ioHandle.resize(mSize);
+    CopyData(ioHandle.get_handle());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The handle is resized with its own resize(), so that its size is exact and the 
+    resize is attributed to the wrapper.
+*/
+template <typename T> inline void
+HandleBuffer::CopyTo(AutoTypedHandle<T>& ioHandle) const
+{
+    ioHandle.resize(mSize);
+    CopyData(ioHandle.get_handle());
+}
+
+// ------------------------------------------------------------------------------------------
+inline void
+HandleBuffer::CopyData(::Handle ioHandle) const
+{
+    if (mSize > 0)
+        BlockMoveData(mData, *ioHandle, mSize);
 }
 
 
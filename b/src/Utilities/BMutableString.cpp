@@ -992,10 +992,14 @@ MutableString::replace(
 }
 
 // ------------------------------------------------------------------------------------------
+/*! The iterator neither reads directly from the underlying @c CFMutableStringRef's 
+    storage, which may move as the string is modified, nor buffers characters, so that 
+    it sees modifications made while it's in use.
+*/
 MutableString::const_iterator
 MutableString::begin() const
 {
-    return (const_iterator(mRef, 0));
+    return (const_iterator(mRef, 0, NULL, false));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -1009,7 +1013,7 @@ MutableString::begin()
 MutableString::const_iterator
 MutableString::end() const
 {
-    return (const_iterator(mRef, CFStringGetLength(mRef)));
+    return (const_iterator(mRef, CFStringGetLength(mRef), NULL, false));
 }
 
 // ------------------------------------------------------------------------------------------
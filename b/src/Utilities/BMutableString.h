@@ -538,6 +538,11 @@ private:
     
     void    init_str(CFStringRef srcRef, CFAllocatorRef allocator);
     
+    template <class InputIterator>
+    void    append_range(InputIterator first, InputIterator last);
+    void    append_range(const UniChar* first, const UniChar* last);
+    void    append_range(UniChar* first, UniChar* last);
+    
     // member variables
     CFMutableStringRef  mRef;
 };
@@ -585,6 +590,9 @@ MutableString::MutableString(
 
 // ------------------------------------------------------------------------------------------
 /*! Creates a string that is initialised by all character of the range [@a first, @a last).
+    
+    The characters are appended directly to the new string, without going through a 
+    temporary copy.
 */
 template <class InputIterator>
 MutableString::MutableString(
@@ -595,9 +603,17 @@ MutableString::MutableString(
 {
     boost::function_requires< boost::InputIteratorConcept<InputIterator> >();
     
-    String  temp(first, last);
+    init_str(NULL, allocator);
     
-    init_str(temp.cf_ref(), allocator);
+    try
+    {
+        append_range(first, last);
+    }
+    catch (...)
+    {
+        CFRelease(mRef);
+        throw;
+    }
 }
 
 // ------------------------------------------------------------------------------------------
@@ -1098,13 +1114,57 @@ MutableString::append(
 {
     boost::function_requires< boost::InputIteratorConcept<InputIterator> >();
     
-    String  temp(first, last);
-    
-    CFStringAppend(mRef, temp.cf_ref());
+    append_range(first, last);
     
     return (*this);
 }
 
+// ------------------------------------------------------------------------------------------
+/*! Characters are gathered in a buffer on the stack, and appended a block at a time.  
+    They are widened the same way as by String's range constructor, so that bytes are 
+    taken to be Latin-1.
+*/
+template <class InputIterator> void
+MutableString::append_range(
+    InputIterator   first, 
+    InputIterator   last)
+{
+    UniChar buff[256];
+    size_t  n   = 0;
+    
+    for ( ; first != last; ++first)
+    {
+        buff[n++] = String::widen_char(*first);
+        
+        if (n == sizeof(buff) / sizeof(buff[0]))
+        {
+            CFStringAppendCharacters(mRef, buff, n);
+            n = 0;
+        }
+    }
+    
+    if (n > 0)
+        CFStringAppendCharacters(mRef, buff, n);
+}
+
+// ------------------------------------------------------------------------------------------
+inline void
+MutableString::append_range(
+    const UniChar*  first, 
+    const UniChar*  last)
+{
+    CFStringAppendCharacters(mRef, first, last - first);
+}
+
+// ------------------------------------------------------------------------------------------
+inline void
+MutableString::append_range(
+    UniChar*    first, 
+    UniChar*    last)
+{
+    CFStringAppendCharacters(mRef, first, last - first);
+}
+
 // ------------------------------------------------------------------------------------------
 inline void
 MutableString::push_back(UniChar c)
@@ -32,9 +32,33 @@
 #include <CoreFoundation/CFString.h>
 
 // B headers
+#include "BAllocationAccounting.h"
+#if B_DEBUG_CF_RETAINCOUNTS
+#   include "BAtomic.h"
+#endif
 #include "BErrorHandler.h"
 
 
+#ifndef B_HAS_RVALUE_REFS
+#   if defined(__GXX_EXPERIMENTAL_CXX0X__) || (__cplusplus >= 201103L)
+#       define B_HAS_RVALUE_REFS    1
+#   else
+#       define B_HAS_RVALUE_REFS    0
+#   endif
+#elif DOXYGEN_SCAN
+    /*! @def    B_HAS_RVALUE_REFS
+        @brief  Determines whether move constructors and move assignment operators are compiled.
+        
+        When the compiler supports rvalue references, OSPtr and the classes that wrap 
+        CoreFoundation objects (String, Array, Url, Shape, Graphics::Context) can hand 
+        their object over to another instance without retaining or releasing it.  
+        B_HAS_RVALUE_REFS is normally set automatically;  defining it to zero removes 
+        the move operations.
+    */
+#   define B_HAS_RVALUE_REFS    1
+#endif
+
+
 namespace B {
 
 namespace OSPtrOwnership {
@@ -86,11 +110,29 @@ namespace OSPtrOwnership {
         //! Declares the type of the data structure whose refcount is manipulated.
         typedef CFTypeRef   obj_type;
         
+#if B_DEBUG_CF_RETAINCOUNTS
+        //! The number of retains and releases performed so far.
+        struct Counts
+        {
+            volatile int32_t    mRetains;
+            volatile int32_t    mReleases;
+        };
+        
+        //! Returns the process-wide counts, for verifying that retains are being elided.
+        static Counts&  counts()
+        {
+            static Counts   sCounts = { 0, 0 };
+            
+            return (sCounts);
+        }
+#endif
+        
         //! Increments the object's reference count.  Throws exceptions where appropriate.
         static void     retain(obj_type ref)
         {
 #if B_DEBUG_CF_RETAINCOUNTS
             assert(CFGetRetainCount(ref) > 0);
+            AtomicAdd(&counts().mRetains, 1);
 #endif
             CFRetain(ref);
         }
@@ -99,6 +141,7 @@ namespace OSPtrOwnership {
         {
 #if B_DEBUG_CF_RETAINCOUNTS
             assert(CFGetRetainCount(ref) > 0);
+            AtomicAdd(&counts().mReleases, 1);
 #endif
             CFRelease(ref);
         }
@@ -716,6 +759,10 @@ public:
                 OSPtr();
     //! Copy constructor.
                 OSPtr(const OSPtr& ptr);
+#if B_HAS_RVALUE_REFS
+    //! Move constructor.  Leaves @a ptr @c NULL.
+                OSPtr(OSPtr&& ptr) throw();
+#endif
     //! Constructor for a @a T.
     explicit    OSPtr(T ptr);
     //! Constructor for a @a T.
@@ -732,6 +779,10 @@ public:
     //@{
     //! Assignment operator.
     OSPtr&      operator = (const OSPtr& ptr);
+#if B_HAS_RVALUE_REFS
+    //! Move assignment operator.
+    OSPtr&      operator = (OSPtr&& ptr) throw();
+#endif
     //@}
     
     //! @name Access
@@ -801,9 +852,28 @@ OSPtr<T>::OSPtr(
     const OSPtr&    ptr)    //!< The source object.
     : mPtr(ptr.mPtr)
 {
-    if (mPtr != NULL)   trait_type::retain(mPtr);
+    if (mPtr != NULL)
+    {
+        trait_type::retain(mPtr);
+        AllocationAccounting::Allocated(AllocationAccounting::kOSPtr);
+    }
 }
 
+#if B_HAS_RVALUE_REFS
+// ------------------------------------------------------------------------------------------
+/*! Takes over @a ptr's reference to the underlying object, without changing its retain 
+    count.
+*/
+template <typename T> inline
+OSPtr<T>::OSPtr(
+    OSPtr&&         ptr)    //!< The source object.
+    throw()
+    : mPtr(ptr.mPtr)
+{
+    ptr.mPtr = NULL;
+}
+#endif
+
 // ------------------------------------------------------------------------------------------
 template <typename T> inline
 OSPtr<T>::OSPtr(
@@ -854,6 +924,7 @@ OSPtr<T>::~OSPtr()
     {
         B_ASSERT(trait_type::count(mPtr) > 0);
         trait_type::release(mPtr);
+        AllocationAccounting::Deallocated(AllocationAccounting::kOSPtr);
     }
 }
 
@@ -876,12 +947,14 @@ OSPtr<T>::reset(
     if (mPtr != NULL)
     {
         trait_type::retain(mPtr);
+        AllocationAccounting::Allocated(AllocationAccounting::kOSPtr);
     }
 
     if (temp != NULL)
     {
         B_ASSERT(trait_type::count(temp) > 0);
         trait_type::release(temp);
+        AllocationAccounting::Deallocated(AllocationAccounting::kOSPtr);
     }
 }
 
@@ -892,11 +965,13 @@ OSPtr<T>::reset(
 {
     B_THROW_IF_NULL(ptr);
     trait_type::retain(ptr);
+    AllocationAccounting::Allocated(AllocationAccounting::kOSPtr);
     
     if (mPtr != NULL)
     {
         B_ASSERT(trait_type::count(mPtr) > 0);
         trait_type::release(mPtr);
+        AllocationAccounting::Deallocated(AllocationAccounting::kOSPtr);
     }
     
     mPtr = ptr;
@@ -925,11 +1000,13 @@ OSPtr<T>::reset(
     const from_copy_t&) //!< Indicates that @a ptr came from a "Create" or "Copy" function.
 {
     B_THROW_IF_NULL(ptr);
+    AllocationAccounting::Allocated(AllocationAccounting::kOSPtr);
     
     if (mPtr != NULL)
     {
         B_ASSERT(trait_type::count(mPtr) > 0);
         trait_type::release(mPtr);
+        AllocationAccounting::Deallocated(AllocationAccounting::kOSPtr);
     }
     
     mPtr = ptr;
@@ -942,12 +1019,16 @@ OSPtr<T>::reset(
     const std::nothrow_t&)      //!< indicates that the caller doesn't want the function to throw an exception.
 {
     if (ptr != NULL)
+    {
         trait_type::retain(ptr);
+        AllocationAccounting::Allocated(AllocationAccounting::kOSPtr);
+    }
     
     if (mPtr != NULL)
     {
         B_ASSERT(trait_type::count(mPtr) > 0);
         trait_type::release(mPtr);
+        AllocationAccounting::Deallocated(AllocationAccounting::kOSPtr);
     }
     
     mPtr = ptr;
@@ -974,10 +1055,14 @@ OSPtr<T>::reset(
     const from_copy_t&,     //!< Indicates that @a ptr came from a "Create" or "Copy" function.
     const std::nothrow_t&)  //!< indicates that the caller doesn't want the function to throw an exception.
 {
+    if (ptr != NULL)
+        AllocationAccounting::Allocated(AllocationAccounting::kOSPtr);
+    
     if (mPtr != NULL)
     {
         B_ASSERT(trait_type::count(mPtr) > 0);
         trait_type::release(mPtr);
+        AllocationAccounting::Deallocated(AllocationAccounting::kOSPtr);
     }
     
     mPtr = ptr;
@@ -990,7 +1075,10 @@ template <typename T> void
 OSPtr<T>::reset()
 {
     if (mPtr != NULL)
+    {
         trait_type::release(mPtr);
+        AllocationAccounting::Deallocated(AllocationAccounting::kOSPtr);
+    }
     
     mPtr = NULL;
 }
@@ -1005,6 +1093,9 @@ OSPtr<T>::release()
 {
     T   tempPtr = mPtr;
     
+    if (tempPtr != NULL)
+        AllocationAccounting::Deallocated(AllocationAccounting::kOSPtr);
+    
     mPtr = NULL;
     
     return (tempPtr);
@@ -1026,6 +1117,20 @@ OSPtr<T>::operator = (
     return (*this);
 }
 
+#if B_HAS_RVALUE_REFS
+// ------------------------------------------------------------------------------------------
+/*! Exchanges the underlying objects;  @a ptr releases ours when it's destroyed.
+*/
+template <typename T> inline OSPtr<T>&
+OSPtr<T>::operator = (
+    OSPtr&&         ptr)    //!< The source object.
+    throw()
+{
+    swap(ptr);
+    return (*this);
+}
+#endif
+
 // ------------------------------------------------------------------------------------------
 template <typename T> inline
 OSPtr<T>::operator T () const
@@ -19,20 +19,375 @@
 // file header
 #include "BPreferences.h"
 
+// standard headers
+#include <map>
+#include <string>
+
 // system headers
 #include <CoreFoundation/CFBundle.h>
 
+// library headers
+#include <boost/bind.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/xtime.hpp>
+
 // B headers
 #include "BBundle.h"
+#include "BErrorHandler.h"
 #include "BString.h"
 
 
+namespace {
+
+// ==========================================================================================
+//  CFPreferencesStore
+
+#pragma mark CFPreferencesStore
+
+/*! The default Preferences::Store, which forwards to CFPreferences.
+*/
+class CFPreferencesStore : public B::Preferences::Store
+{
+public:
+    
+    virtual B::OSPtr<CFTypeRef>
+                    CopyValue(
+                        CFStringRef         inKey, 
+                        CFStringRef         inApplicationID);
+    virtual void    SetValues(
+                        CFDictionaryRef     inKeysToSet, 
+                        CFArrayRef          inKeysToRemove, 
+                        CFStringRef         inApplicationID);
+    virtual bool    Synchronize(
+                        CFStringRef         inApplicationID);
+};
+
+// ------------------------------------------------------------------------------------------
+B::OSPtr<CFTypeRef>
+CFPreferencesStore::CopyValue(
+    CFStringRef     inKey, 
+    CFStringRef     inApplicationID)
+{
+    return (B::OSPtr<CFTypeRef>(CFPreferencesCopyAppValue(inKey, inApplicationID), 
+                                B::from_copy, std::nothrow));
+}
+
+// ------------------------------------------------------------------------------------------
+void
+CFPreferencesStore::SetValues(
+    CFDictionaryRef inKeysToSet, 
+    CFArrayRef      inKeysToRemove, 
+    CFStringRef     inApplicationID)
+{
+    // This is the domain CFPreferencesSetAppValue() writes to.
+    
+    CFPreferencesSetMultiple(inKeysToSet, inKeysToRemove, inApplicationID, 
+                             kCFPreferencesCurrentUser, kCFPreferencesAnyHost);
+}
+
+// ------------------------------------------------------------------------------------------
+bool
+CFPreferencesStore::Synchronize(
+    CFStringRef     inApplicationID)
+{
+    return (CFPreferencesAppSynchronize(inApplicationID));
+}
+
+// ------------------------------------------------------------------------------------------
+inline void
+GetTimeAfter(
+    boost::xtime&   outTime, 
+    unsigned        inMilliseconds)
+{
+    boost::xtime_get(&outTime, boost::TIME_UTC);
+    
+    outTime.sec     += inMilliseconds / 1000;
+    outTime.nsec    += (inMilliseconds % 1000) * 1000000;
+    
+    if (outTime.nsec >= 1000000000)
+    {
+        outTime.sec     += 1;
+        outTime.nsec    -= 1000000000;
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+inline bool
+HasTimePassed(
+    const boost::xtime& inTime)
+{
+    boost::xtime    now;
+    
+    boost::xtime_get(&now, boost::TIME_UTC);
+    
+    return (boost::xtime_cmp(now, inTime) >= 0);
+}
+
+}   // anonymous namespace
+
+
 namespace B {
 
+// ==========================================================================================
+//  Preferences::Domain
+
+#pragma mark -
+#pragma mark Preferences::Domain
+
+/*! The pending values for one application ID.  There is only one Domain per 
+    application ID, shared by all Preferences objects using that ID.  All members are 
+    protected by the WriteBehind's mutex.
+*/
+struct Preferences::Domain
+{
+    typedef std::map<std::string, OSPtr<CFTypeRef> >    ValueMap;
+    
+    explicit    Domain(const OSPtr<CFStringRef>& inApplicationID)
+                    : mApplicationID(inApplicationID), mNeedsSync(false) {}
+    
+    const OSPtr<CFStringRef>    mApplicationID;
+    ValueMap                    mValues;        //!< Pending values;  @c NULL means "remove".
+    bool                        mNeedsSync;     //!< The store needs to be synchronised.
+};
+
+
+// ==========================================================================================
+//  Preferences::WriteBehind
+
+#pragma mark -
+#pragma mark Preferences::WriteBehind
+
+/*! The process-wide write-behind state.  The flusher thread is only started when a 
+    value first becomes pending, so processes that only read preferences never get one.
+*/
+struct Preferences::WriteBehind
+{
+    typedef std::map<std::string, boost::shared_ptr<Domain> >  DomainMap;
+    typedef std::vector<boost::shared_ptr<Domain> >             DomainList;
+    
+                WriteBehind();
+    
+    void        Schedule();
+    void        Write(Domain& ioDomain);
+    void        WriteKey(Domain& ioDomain, const char* inKey);
+    void        SetValues(
+                    Domain::ValueMap::const_iterator    inBegin, 
+                    Domain::ValueMap::const_iterator    inEnd, 
+                    CFStringRef                         inApplicationID);
+    void        Collect(DomainList& outToSync, boost::shared_ptr<Store>& outStore);
+    void        Synchronize(const DomainList& inToSync, Store& inStore);
+    void        Run();
+    
+    boost::mutex                    mMutex;         //!< Protects everything below.
+    boost::condition                mCondition;     //!< Wakes up the flusher thread.
+    boost::shared_ptr<Store>        mStore;         //!< Copied before calling Synchronize().
+    DomainMap                       mDomains;
+    std::auto_ptr<boost::thread>    mThread;
+    boost::xtime                    mDeadline;      //!< When pending values must be written.
+    bool                            mPending;       //!< Some domain has work for the flusher.
+    bool                            mStopped;       //!< The process is exiting.
+};
+
+// ------------------------------------------------------------------------------------------
+Preferences::WriteBehind::WriteBehind()
+    : mStore(new CFPreferencesStore), mPending(false), mStopped(false)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Arranges for the flusher thread to write out the pending values by the deadline.  
+    The deadline is set when the first value becomes pending, and isn't pushed back by 
+    later ones;  this is what bounds the staleness of the store.  Must be called with 
+    mMutex held.
+*/
+void
+Preferences::WriteBehind::Schedule()
+{
+    // If something is already pending, the flusher is waiting for the current deadline.
+    
+    if (mPending)
+        return;
+    
+    GetTimeAfter(mDeadline, B_PREFERENCES_WRITE_BEHIND_DELAY);
+    mPending = true;
+    
+    if (mThread.get() == NULL)
+        mThread.reset(new boost::thread(boost::bind(&WriteBehind::Run, this)));
+    
+    mCondition.notify_one();
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Hands @a ioDomain's pending values to the store.  Must be called with mMutex held.
+*/
+void
+Preferences::WriteBehind::Write(Domain& ioDomain)
+{
+    if (ioDomain.mValues.empty())
+        return;
+    
+    SetValues(ioDomain.mValues.begin(), ioDomain.mValues.end(), ioDomain.mApplicationID);
+    
+    // Only forget the values once the store has them, so that readers find them in one 
+    // place or the other.
+    
+    ioDomain.mValues.clear();
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Hands @a ioDomain's pending value for @a inKey, if any, to the store.  This is 
+    done before going around the table, so that the store sees writes in the order 
+    they were made.  Must be called with mMutex held.
+*/
+void
+Preferences::WriteBehind::WriteKey(Domain& ioDomain, const char* inKey)
+{
+    if (ioDomain.mValues.empty())
+        return;
+    
+    Domain::ValueMap::iterator  it  = ioDomain.mValues.find(inKey);
+    
+    if (it == ioDomain.mValues.end())
+        return;
+    
+    Domain::ValueMap::iterator  next    = it;
+    
+    SetValues(it, ++next, ioDomain.mApplicationID);
+    ioDomain.mValues.erase(it);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Hands the values in [@a inBegin, @a inEnd) to the store.  Must be called with mMutex 
+    held.
+*/
+void
+Preferences::WriteBehind::SetValues(
+    Domain::ValueMap::const_iterator    inBegin, 
+    Domain::ValueMap::const_iterator    inEnd, 
+    CFStringRef                         inApplicationID)
+{
+    OSPtr<CFMutableDictionaryRef>   keysToSet(CFDictionaryCreateMutable(NULL, 0, 
+                                                    &kCFTypeDictionaryKeyCallBacks, 
+                                                    &kCFTypeDictionaryValueCallBacks), 
+                                              from_copy);
+    OSPtr<CFMutableArrayRef>        keysToRemove(CFArrayCreateMutable(NULL, 0, 
+                                                    &kCFTypeArrayCallBacks), 
+                                                 from_copy);
+    
+    for (Domain::ValueMap::const_iterator it = inBegin; it != inEnd; ++it)
+    {
+        String  key(it->first, kCFStringEncodingASCII);
+        
+        if (it->second != NULL)
+            CFDictionarySetValue(keysToSet, key.cf_ref(), it->second);
+        else
+            CFArrayAppendValue(keysToRemove, key.cf_ref());
+    }
+    
+    mStore->SetValues(keysToSet, keysToRemove, inApplicationID);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Hands all pending values to the store, and fills @a outToSync with the domains that 
+    need synchronising, and @a outStore with the store to synchronise.  Must be called 
+    with mMutex held.
+    
+    If the store throws, the remaining values stay in their domains, and are retried on 
+    the next write or flush rather than in a tight loop.
+*/
+void
+Preferences::WriteBehind::Collect(DomainList& outToSync, boost::shared_ptr<Store>& outStore)
+{
+    mPending    = false;
+    outStore    = mStore;
+    
+    for (DomainMap::iterator it = mDomains.begin(); it != mDomains.end(); ++it)
+    {
+        Domain& domain  = *it->second;
+        
+        Write(domain);
+        
+        if (domain.mNeedsSync)
+        {
+            outToSync.push_back(it->second);
+            domain.mNeedsSync = false;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Synchronises @a inStore for each domain in @a inToSync.  This is the slow part, so 
+    it's called without mMutex held;  the caller keeps @a inStore alive, in case 
+    SetStore() replaces it in the meantime.
+*/
+void
+Preferences::WriteBehind::Synchronize(const DomainList& inToSync, Store& inStore)
+{
+    for (DomainList::const_iterator it = inToSync.begin(); it != inToSync.end(); ++it)
+    {
+        inStore.Synchronize((*it)->mApplicationID);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The flusher thread's entry point.
+*/
+void
+Preferences::WriteBehind::Run()
+{
+    for (;;)
+    {
+        DomainList                  toSync;
+        boost::shared_ptr<Store>    store;
+        
+        try
+        {
+            {
+                boost::mutex::scoped_lock   lock(mMutex);
+                
+                while (!mStopped && !(mPending && HasTimePassed(mDeadline)))
+                {
+                    if (mPending)
+                        mCondition.timed_wait(lock, mDeadline);
+                    else
+                        mCondition.wait(lock);
+                }
+                
+                // Whatever is still pending at this point is written out by 
+                // CleanupWriteBehind().
+                
+                if (mStopped)
+                    break;
+                
+                Collect(toSync, store);
+            }
+            
+            Synchronize(toSync, *store);
+        }
+        catch (...)
+        {
+            // Prevent exceptions from propagating, which would terminate the process.
+        }
+    }
+}
+
+
+// ==========================================================================================
+//  Preferences
+
+#pragma mark -
+#pragma mark Preferences
+
+boost::once_flag                Preferences::sWriteBehindInit   = BOOST_ONCE_INIT;
+Preferences::WriteBehind*       Preferences::sWriteBehind       = NULL;
+
 // ------------------------------------------------------------------------------------------
 Preferences::Preferences()
     : mApplicationID(Bundle::Main().Identifier().cf_ptr())
 {
+    InitDomain();
 }
 
 // ------------------------------------------------------------------------------------------
@@ -40,6 +395,7 @@ Preferences::Preferences(
     const char* inApplicationID)
         : mApplicationID(String(inApplicationID, kCFStringEncodingASCII).cf_ptr())
 {
+    InitDomain();
 }
 
 // ------------------------------------------------------------------------------------------
@@ -47,17 +403,111 @@ Preferences::Preferences(
     const Bundle&   inBundle)
         : mApplicationID(inBundle.Identifier().cf_ptr())
 {
+    InitDomain();
+}
+
+// ------------------------------------------------------------------------------------------
+void
+Preferences::InitDomain()
+{
+    WriteBehind&    writeBehind = GetWriteBehind();
+    std::string     applicationID;
+    
+    String(mApplicationID).copy(applicationID, kCFStringEncodingUTF8);
+    
+    boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+    boost::shared_ptr<Domain>&  domain  = writeBehind.mDomains[applicationID];
+    
+    if (domain.get() == NULL)
+        domain.reset(new Domain(mApplicationID));
+    
+    mDomain = domain;
+}
+
+// ------------------------------------------------------------------------------------------
+void
+Preferences::InitWriteBehind() throw()
+{
+    WriteBehind*    writeBehind = NULL;
+    
+    try
+    {
+        writeBehind     = new WriteBehind;
+        sWriteBehind    = writeBehind;
+        
+        atexit(CleanupWriteBehind);
+    }
+    catch (...)
+    {
+        // sWriteBehind stays NULL, so GetWriteBehind() will throw.
+        delete writeBehind;
+        sWriteBehind = NULL;
+    }
 }
 
 // ------------------------------------------------------------------------------------------
+/*! Stops the flusher thread, then writes out whatever is still pending.  The 
+    WriteBehind itself is left alone, because Preferences objects with static storage 
+    duration may still refer to it;  once it's stopped, their writes go straight to the 
+    store.
+*/
+void
+Preferences::CleanupWriteBehind()
+{
+    WriteBehind&    writeBehind = *sWriteBehind;
+    
+    {
+        boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+        
+        writeBehind.mStopped = true;
+        writeBehind.mCondition.notify_one();
+    }
+    
+    if (writeBehind.mThread.get() != NULL)
+        writeBehind.mThread->join();
+    
+    try
+    {
+        FlushAll();
+    }
+    catch (...)
+    {
+        // Prevent exceptions from propagating.
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+Preferences::WriteBehind&
+Preferences::GetWriteBehind()
+{
+    boost::call_once(InitWriteBehind, sWriteBehindInit);
+    B_THROW_IF(sWriteBehind == NULL, std::bad_alloc());
+    
+    return (*sWriteBehind);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Pending values are served from the write-behind table;  anything else comes from the 
+    store.
+*/
 OSPtr<CFTypeRef>
 Preferences::GetCFType(
     const char*     inKey) const
 {
+    WriteBehind&                writeBehind = GetWriteBehind();
+    boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+    
+    if (!mDomain->mValues.empty())
+    {
+        Domain::ValueMap::const_iterator    it  = mDomain->mValues.find(inKey);
+        
+        if (it != mDomain->mValues.end())
+            return (it->second);
+    }
+    
     String  key(inKey, kCFStringEncodingASCII);
     
-    return (OSPtr<CFTypeRef>(CFPreferencesCopyAppValue(key.cf_ref(), mApplicationID), 
-                             from_copy, std::nothrow));
+    return (writeBehind.mStore->CopyValue(key.cf_ref(), mApplicationID));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -182,23 +632,57 @@ Preferences::GetCFTypeFromSource(
     CFStringRef     inUser /* = kCFPreferencesCurrentUser */, 
     CFStringRef     inHost /* = kCFPreferencesCurrentHost */) const
 {
+    WriteBehind&                writeBehind = GetWriteBehind();
+    boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+    
+    // Pending values belong to the current user and any host (see Store).
+    
+    if (!mDomain->mValues.empty() && 
+        CFEqual(inUser, kCFPreferencesCurrentUser) && 
+        CFEqual(inHost, kCFPreferencesAnyHost))
+    {
+        Domain::ValueMap::const_iterator    it  = mDomain->mValues.find(inKey);
+        
+        if (it != mDomain->mValues.end())
+            return (it->second);
+    }
+    
     String  key(inKey, kCFStringEncodingASCII);
     
     return (OSPtr<CFTypeRef>(CFPreferencesCopyValue(key.cf_ref(), mApplicationID, inUser, inHost), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
+/*! The value is recorded in the write-behind table, replacing any pending value for 
+    @a inKey, and is handed to the store later.  A @c NULL @a inValue removes the key.
+*/
 void
 Preferences::SetCFType(
     const char*     inKey, 
     CFTypeRef       inValue)
 {
-    String  key(inKey, kCFStringEncodingASCII);
+    WriteBehind&                writeBehind = GetWriteBehind();
+    boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+    
+    mDomain->mValues[inKey].reset(inValue, std::nothrow);
+    mDomain->mNeedsSync = true;
     
-    CFPreferencesSetAppValue(key.cf_ref(), inValue, mApplicationID);
+    if (writeBehind.mStopped || (B_PREFERENCES_WRITE_BEHIND_DELAY == 0))
+    {
+        // Write through, without synchronising, like CFPreferencesSetAppValue().
+        
+        writeBehind.Write(*mDomain);
+    }
+    else
+    {
+        writeBehind.Schedule();
+    }
 }
 
 // ------------------------------------------------------------------------------------------
+/*! Any pending value for @a inKey is handed to the store first, so that it can't 
+    overwrite @a inValue later.
+*/
 void
 Preferences::SetCFTypeInSource(
     const char*         inKey, 
@@ -206,34 +690,121 @@ Preferences::SetCFTypeInSource(
     CFStringRef         inUser /* = kCFPreferencesCurrentUser */, 
     CFStringRef         inHost /* = kCFPreferencesCurrentHost */)
 {
-    String  key(inKey, kCFStringEncodingASCII);
+    WriteBehind&                writeBehind = GetWriteBehind();
+    boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+    String                      key(inKey, kCFStringEncodingASCII);
+    
+    writeBehind.WriteKey(*mDomain, inKey);
     
     CFPreferencesSetValue(key.cf_ref(), inValue, mApplicationID, inUser, inHost);
 }
 
 // ------------------------------------------------------------------------------------------
+/*! Any pending value for @a inKey is handed to the store first.  CFPreferences ignores 
+    writes to forced keys, so after this GetCFType() returns the forced value rather 
+    than the one that was set.
+*/
 bool
 Preferences::IsKeyForced(
     const char*     inKey) const
 {
-    String  key(inKey, kCFStringEncodingASCII);
+    WriteBehind&                writeBehind = GetWriteBehind();
+    boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+    String                      key(inKey, kCFStringEncodingASCII);
+    
+    writeBehind.WriteKey(*mDomain, inKey);
     
     return (CFPreferencesAppValueIsForced(key.cf_ref(), mApplicationID));
 }
 
 // ------------------------------------------------------------------------------------------
+/*! Writes out the pending values for this object's application ID and synchronises 
+    the store, on the caller's thread.  Other application IDs are left to the flusher 
+    thread;  use FlushAll() to write them all.
+*/
 void
 Preferences::Flush()
 {
-    CFPreferencesAppSynchronize(mApplicationID);
+    WriteBehind&                writeBehind = GetWriteBehind();
+    boost::shared_ptr<Store>    store;
+    
+    {
+        boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+        
+        writeBehind.Write(*mDomain);
+        mDomain->mNeedsSync = false;
+        store = writeBehind.mStore;
+    }
+    
+    store->Synchronize(mApplicationID);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Writes out the pending values of all application IDs and synchronises the store, on 
+    the caller's thread.  This also happens automatically when the process exits.
+*/
+void
+Preferences::FlushAll()
+{
+    WriteBehind&                writeBehind = GetWriteBehind();
+    WriteBehind::DomainList     toSync;
+    boost::shared_ptr<Store>    store;
+    
+    {
+        boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+        
+        writeBehind.Collect(toSync, store);
+    }
+    
+    writeBehind.Synchronize(toSync, *store);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Replaces the backing store.  Values pending for the old store are handed to it (and 
+    it is synchronised) first.  The old store is destroyed once any synchronisation 
+    in progress on another thread is done with it.
+*/
+void
+Preferences::SetStore(
+    std::auto_ptr<Store>    inStore)
+{
+    B_ASSERT(inStore.get() != NULL);
+    
+    FlushAll();
+    
+    WriteBehind&                writeBehind = GetWriteBehind();
+    boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+    
+    writeBehind.mStore.reset(inStore.release());
+}
+
+
+// ==========================================================================================
+//  Preferences::Store
+
+#pragma mark -
+#pragma mark Preferences::Store
+
+// ------------------------------------------------------------------------------------------
+Preferences::Store::~Store()
+{
 }
 
 // ------------------------------------------------------------------------------------------
+/*! The pending values are handed to the store first, so that they are written out too.
+*/
 void
 Preferences::FlushSource(
     CFStringRef     inUser /* = kCFPreferencesCurrentUser */, 
     CFStringRef     inHost /* = kCFPreferencesCurrentHost */)
 {
+    {
+        WriteBehind&                writeBehind = GetWriteBehind();
+        boost::mutex::scoped_lock   lock(writeBehind.mMutex);
+        
+        writeBehind.Write(*mDomain);
+    }
+    
     CFPreferencesSynchronize(mApplicationID, inUser, inHost);
 }
 
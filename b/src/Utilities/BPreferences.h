@@ -22,15 +22,34 @@
 #pragma once
 
 // standard headers
+#include <memory>
 #include <vector>
 
 // system headers
 #include <CoreFoundation/CFPreferences.h>
 
 // library headers
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/once.hpp>
 #include "CFUtils.h"
 
 
+#ifndef B_PREFERENCES_WRITE_BEHIND_DELAY
+#   define B_PREFERENCES_WRITE_BEHIND_DELAY 2000
+#elif DOXYGEN_SCAN
+    /*! @def    B_PREFERENCES_WRITE_BEHIND_DELAY
+        @brief  The longest time, in milliseconds, that a value set through Preferences 
+                may wait before being handed to the backing store.
+        
+        Defining it to zero makes Preferences write through to the backing store on 
+        every call, as it used to.
+        
+        @relates    Preferences
+    */
+#   define B_PREFERENCES_WRITE_BEHIND_DELAY 2000
+#endif
+
+
 namespace B {
 
 
@@ -40,6 +59,23 @@ class   Bundle;
 
 /*! @brief  Interface to CF preferences
     
+    Values set through SetCFType() and the functions built on top of it aren't written 
+    to the backing store (normally CFPreferences) right away.  Instead, they are kept 
+    in a process-wide table of pending values, shared by all Preferences objects with 
+    the same application ID.  Repeated writes to the same key overwrite each other in 
+    the table, and reads are served from it, so callers always see their own writes.
+    
+    A background thread hands the pending values to the store, then synchronises it.  
+    It does so at most #B_PREFERENCES_WRITE_BEHIND_DELAY milliseconds after the first 
+    value became pending (later writes don't push the deadline back), and when the 
+    process exits.  Flush() and FlushAll() do the same on the caller's thread, for 
+    when the values must be on disk before proceeding.
+    
+    The single-source variants (GetCFTypeFromSource(), SetCFTypeInSource() etc.) talk 
+    to CFPreferences directly.  Reads from the current user and any host are served 
+    from the table like GetCFType();  writes, and IsKeyForced(), first hand the key's 
+    pending value to the store, so that it can't overwrite them later.
+    
     @todo   %Document this class!
 */
 class Preferences
@@ -48,6 +84,7 @@ public:
     
     // types
     typedef std::vector<UInt8>  DataBlob;
+    class                       Store;
     
     // constructors / destructor
             Preferences();
@@ -114,6 +151,11 @@ public:
     
     // Writing to disk.
     void        Flush();
+    static void FlushAll();
+    
+    // Backing store.
+    static void SetStore(
+                    std::auto_ptr<Store>    inStore);
     
     // Single-source variants.
     OSPtr<CFTypeRef>
@@ -143,7 +185,56 @@ public:
     
 private:
     
-    OSPtr<CFStringRef>  mApplicationID;
+    // types
+    struct  Domain;
+    struct  WriteBehind;
+    
+    void                InitDomain();
+    
+    static WriteBehind& GetWriteBehind();
+    static void         InitWriteBehind() throw();
+    static void         CleanupWriteBehind();
+    
+    // member variables
+    OSPtr<CFStringRef>          mApplicationID;
+    boost::shared_ptr<Domain>   mDomain;
+    
+    // static member variables
+    static boost::once_flag     sWriteBehindInit;
+    static WriteBehind*         sWriteBehind;
+};
+
+
+/*! @brief  The place Preferences ultimately reads values from and writes them to.
+    
+    The default store forwards to CFPreferences, using the current user and any host 
+    (the same domain as @c CFPreferencesSetAppValue()).  Preferences::SetStore() 
+    replaces it, which is mostly useful for testing.
+    
+    SetValues() and CopyValue() are called with Preferences' internal lock held, so 
+    they should be quick.  Synchronize() is called without the lock, possibly on a 
+    background thread, and is where any slow I/O should happen.
+*/
+class Preferences::Store
+{
+public:
+    
+    //! Destructor.
+    virtual         ~Store();
+    
+    //! Returns the value for @a inKey, or @c NULL if there isn't one.
+    virtual OSPtr<CFTypeRef>
+                    CopyValue(
+                        CFStringRef         inKey, 
+                        CFStringRef         inApplicationID) = 0;
+    //! Sets the values in @a inKeysToSet and removes the keys in @a inKeysToRemove.
+    virtual void    SetValues(
+                        CFDictionaryRef     inKeysToSet, 
+                        CFArrayRef          inKeysToRemove, 
+                        CFStringRef         inApplicationID) = 0;
+    //! Writes out the values for @a inApplicationID.
+    virtual bool    Synchronize(
+                        CFStringRef         inApplicationID) = 0;
 };
 
 
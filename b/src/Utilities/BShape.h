@@ -49,6 +49,9 @@ public:
     // constructors / destructor
                 Shape();
                 Shape(const Shape& inShape);
+#if B_HAS_RVALUE_REFS
+                Shape(Shape&& inShape) throw();
+#endif
     explicit    Shape(const MutableShape& inShape);
     explicit    Shape(RgnHandle inRegion);
     explicit    Shape(const Rect& inRect);
@@ -73,6 +76,9 @@ public:
     
     // assignment
     Shape&  operator = (const Shape &inShape);
+#if B_HAS_RVALUE_REFS
+    Shape&  operator = (Shape&& inShape) throw();
+#endif
     Shape&  operator = (const MutableShape& inShape);
     Shape&  assign(RgnHandle inRegion);
     Shape&  assign(const Rect& inRect);
@@ -101,18 +107,44 @@ private:
 };
 
 // ------------------------------------------------------------------------------------------
+/*! Copying a moved-from shape yields another moved-from shape.
+*/
 inline
 Shape::Shape(const Shape& inShape)
     : mShapeRef(inShape.mShapeRef)
 {
-    CFRetain(mShapeRef);
+    if (mShapeRef != NULL)
+        CFRetain(mShapeRef);
+}
+
+#if B_HAS_RVALUE_REFS
+// ------------------------------------------------------------------------------------------
+/*! Takes over @a inShape's underlying @c HIShapeRef.  @a inShape may then only be 
+    assigned to, copied or destroyed.
+*/
+inline
+Shape::Shape(Shape&& inShape) throw()
+    : mShapeRef(inShape.mShapeRef)
+{
+    inShape.mShapeRef = NULL;
+}
+
+// ------------------------------------------------------------------------------------------
+inline Shape&
+Shape::operator = (Shape&& inShape) throw()
+{
+    swap(inShape);
+    
+    return (*this);
 }
+#endif
 
 // ------------------------------------------------------------------------------------------
 inline
 Shape::~Shape()
 {
-    CFRelease(mShapeRef);
+    if (mShapeRef != NULL)
+        CFRelease(mShapeRef);
 }
 
 // ------------------------------------------------------------------------------------------
@@ -20,7 +20,9 @@
 #include "BString.h"
 
 // standard headers
+#include <algorithm>
 #include <istream>
+#include <new>
 #include <ostream>
 #include <stdexcept>
 #include <vector>
@@ -33,10 +35,13 @@
 #include "BBundle.h"
 #include "BException.h"
 #include "BMutableString.h"
+#include "BTranscoding.h"
 
 
 namespace B {
 
+const no_copy_t     no_copy     = {};
+
 
 // ------------------------------------------------------------------------------------------
 OSPtr<CFStringRef>
@@ -167,6 +172,49 @@ String::make_str(ConstStringPtr pstr, CFStringEncoding encoding, CFAllocatorRef
     return (OSPtr<CFStringRef>(str, from_copy));
 }
 
+// ------------------------------------------------------------------------------------------
+OSPtr<CFStringRef>
+String::make_range_str(const UniChar* first, const UniChar* last, CFAllocatorRef allocator)
+{
+    UniChar junk;
+    
+    if (first == last)
+        first = last = &junk;
+    
+    return (OSPtr<CFStringRef>(CFStringCreateWithCharacters(allocator, first, last - first), from_copy));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Each @c char is converted to the @c UniChar of the same (unsigned) value, which 
+    is exactly what the ISO Latin-1 encoding does.
+*/
+OSPtr<CFStringRef>
+String::make_range_str(const char* first, const char* last, CFAllocatorRef allocator)
+{
+    CFStringRef str = CFStringCreateWithBytes(allocator, 
+                                              reinterpret_cast<const UInt8*>(first), 
+                                              last - first, 
+                                              kCFStringEncodingISOLatin1, false);
+    
+    return (OSPtr<CFStringRef>(str, from_copy));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The range is a substring of an existing string, so let CoreFoundation create (or, 
+    if the range covers the whole string, share) it.
+*/
+OSPtr<CFStringRef>
+String::make_range_str(const_iterator first, const_iterator last, CFAllocatorRef allocator)
+{
+    B_ASSERT(first.mRef == last.mRef);
+    B_ASSERT(first.mIndex <= last.mIndex);
+    
+    if (first.mRef == NULL)
+        return (make_range_str(static_cast<const UniChar*>(NULL), NULL, allocator));
+    
+    return (make_str(first.mRef, first.mIndex, last.mIndex - first.mIndex, allocator, false));
+}
+
 // ------------------------------------------------------------------------------------------
 size_t
 String::uni_strlen(const UniChar* ustr)
@@ -461,6 +509,51 @@ String::String(
     B_THROW_IF_NULL(mRef);
 }
 
+// ------------------------------------------------------------------------------------------
+/*! Creates a string whose characters are the @a n @c UniChars at @a ustr, without 
+    copying them.  The string takes ownership of the buffer, and frees it with 
+    @a deallocator once it's no longer needed.
+    
+    If @a deallocator is @c kCFAllocatorNull, the caller keeps ownership of the 
+    buffer, and must make sure it outlives the string and isn't modified.
+    
+    @note   CoreFoundation is allowed to copy the characters anyway, in which case the 
+            buffer is freed immediately.
+*/
+String::String(
+    const UniChar*  ustr,           //!< The source characters.
+    size_type       n,              //!< The number of characters.
+    CFAllocatorRef  deallocator,    //!< The allocator that frees @a ustr, or @c kCFAllocatorNull.
+    const no_copy_t&)               //!< An indication that @a ustr should be adopted rather than copied.
+{
+    mRef = CFStringCreateWithCharactersNoCopy(NULL, ustr, n, deallocator);
+    B_THROW_IF_NULL(mRef);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Creates a string from the @a n bytes at @a cstr, encoded in @a encoding, without 
+    copying them.  The string takes ownership of the buffer, and frees it with 
+    @a deallocator once it's no longer needed.
+    
+    If @a deallocator is @c kCFAllocatorNull, the caller keeps ownership of the 
+    buffer, and must make sure it outlives the string and isn't modified.
+    
+    @note   Unless @a encoding is one that CoreFoundation can store as is (eg ASCII or 
+            ISO Latin-1), the bytes are converted, and the buffer is freed immediately.
+*/
+String::String(
+    const char*         cstr,           //!< The source bytes.
+    size_type           n,              //!< The number of bytes.
+    CFStringEncoding    encoding,       //!< The character encoding of @a cstr.
+    CFAllocatorRef      deallocator,    //!< The allocator that frees @a cstr, or @c kCFAllocatorNull.
+    const no_copy_t&)                   //!< An indication that @a cstr should be adopted rather than copied.
+{
+    mRef = CFStringCreateWithBytesNoCopy(NULL, reinterpret_cast<const UInt8*>(cstr), n, 
+                                         encoding, false, deallocator);
+    
+    B_THROW_IF(mRef == NULL, CharacterEncodingException());
+}
+
 // ------------------------------------------------------------------------------------------
 OSPtr<CFStringRef>
 String::cf_ptr() const
@@ -692,6 +785,59 @@ String::private_copy(
     }
 }
 
+// ------------------------------------------------------------------------------------------
+/*! Handles the most common cases of converting @a ref to a @c std::string without going 
+    through @c CFStringGetBytes().  If the string's contents are already available in 
+    @a encoding, they are copied directly.  Otherwise, conversions to ASCII, UTF-8 and 
+    Mac OS Roman are performed by the functions in B::Transcoding.
+    
+    @return @c false if the conversion wasn't performed (in which case @a sstr's contents 
+            are unspecified), @c true otherwise.
+*/
+bool
+String::transcode_copy(
+    CFStringRef         ref,        //!< The input string.
+    CFIndex             len,        //!< The input string's length.
+    std::string&        sstr,       //!< The output string.
+    CFStringEncoding    encoding)   //!< The output string's encoding.
+{
+    // CoreFoundation only hands out a C string pointer if each character maps onto 
+    // exactly one byte, so the string's length is also the pointer's size.
+    
+    if (const char* cstr = CFStringGetCStringPtr(ref, encoding))
+    {
+        sstr.assign(cstr, len);
+        
+        return (true);
+    }
+    
+    if ((encoding != kCFStringEncodingASCII) && 
+        (encoding != kCFStringEncodingUTF8) && 
+        (encoding != kCFStringEncodingMacRoman))
+    {
+        return (false);
+    }
+    
+    const UniChar*          uptr    = CFStringGetCharactersPtr(ref);
+    std::vector<UniChar>    ubuff;
+    
+    if ((uptr == NULL) && (len > 0))
+    {
+        ubuff.resize(len);
+        CFStringGetCharacters(ref, CFRangeMake(0, len), &ubuff[0]);
+        uptr = &ubuff[0];
+    }
+    
+    sstr.reserve(len);
+    
+    switch (encoding)
+    {
+    case kCFStringEncodingASCII:    return (Transcoding::EncodeAscii(uptr, len, sstr));
+    case kCFStringEncodingUTF8:     return (Transcoding::EncodeUtf8(uptr, len, sstr));
+    default:                        return (Transcoding::EncodeMacRoman(uptr, len, sstr));
+    }
+}
+
 // ------------------------------------------------------------------------------------------
 void
 String::private_copy(
@@ -703,6 +849,11 @@ String::private_copy(
     CFRange range   = { 0, len };
     CFIndex nconv, nbuff;
     
+    sstr.clear();
+    
+    if (transcode_copy(ref, len, sstr, encoding))
+        return;
+    
     // First check for convertability.
     
     nconv = CFStringGetBytes(ref, range, encoding, 0, false, 
@@ -1258,17 +1409,21 @@ String::private_find_of(CFStringRef ref, const std::string& sstr, CFStringEncodi
 }
 
 // ------------------------------------------------------------------------------------------
+/*! Because a String's contents never change, its const_iterators may read 
+    characters straight out of the underlying @c CFStringRef's storage, if it is 
+    accessible.
+*/
 String::const_iterator
 String::begin() const
 {
-    return (const_iterator(mRef, 0));
+    return (const_iterator(mRef, 0, CFStringGetCharactersPtr(mRef), true));
 }
 
 // ------------------------------------------------------------------------------------------
 String::const_iterator
 String::end() const
 {
-    return (const_iterator(mRef, CFStringGetLength(mRef)));
+    return (const_iterator(mRef, CFStringGetLength(mRef), CFStringGetCharactersPtr(mRef), true));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -1285,6 +1440,58 @@ String::rend() const
     return (const_reverse_iterator(end()));
 }
 
+// ------------------------------------------------------------------------------------------
+/*! Refills the iterator's window so that it contains the character at @a inIndex.  
+    Returns @c false, leaving the window untouched, if @a inIndex is out of range.
+    
+    A window that has never been filled fetches just that character, since the 
+    iterator may well be a temporary that is read once.  After that, it fetches 
+    kBufferSize characters, in the direction of travel:  if @a inIndex lies before the 
+    window's current contents, the iterator is presumably moving backwards, so the 
+    window is filled with the characters that @e precede @a inIndex.
+*/
+bool
+String::const_iterator::load(
+    CFIndex inIndex)    //!< The index of the character to buffer.
+    const
+{
+    CFIndex length  = CFStringGetLength(mRef);
+    
+    if ((inIndex < 0) || (inIndex >= length))
+        return (false);
+    
+    CFIndex size    = (mWindow.mLength > 0) ? kBufferSize : 1;
+    CFIndex start;
+    
+    if (inIndex < mWindow.mStart)
+        start = std::max<CFIndex>(inIndex + 1 - size, 0);
+    else
+        start = inIndex;
+    
+    mWindow.mStart  = start;
+    mWindow.mLength = std::min<CFIndex>(size, length - start);
+    
+    CFStringGetCharacters(mRef, CFRangeMake(mWindow.mStart, mWindow.mLength), 
+                          mWindow.mChars);
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Called when the character at @a inIndex isn't in the window.  Iterators that may 
+    not buffer characters fetch them one at a time.
+*/
+String::value_type
+String::const_iterator::fill(
+    CFIndex inIndex)    //!< The index of the character to return.
+    const
+{
+    if (!mBuffered || !load(inIndex))
+        return (CFStringGetCharacterAtIndex(mRef, inIndex));
+    
+    return (mWindow.mChars[inIndex - mWindow.mStart]);
+}
+
 // ------------------------------------------------------------------------------------------
 std::ostream&
 String::Write(std::ostream& ostr, CFStringEncoding encoding) const
@@ -27,6 +27,7 @@
 #pragma once
 
 // standard headers
+#include <algorithm>
 #include <iosfwd>
 #include <istream>
 #include <iterator>
@@ -51,6 +52,10 @@ namespace B {
 // forward declarations
 class   MutableString;
 
+//! Tag type selecting the constructors that adopt their caller's buffer.
+struct no_copy_t { };
+extern const no_copy_t  no_copy;
+
 // ==========================================================================================
 //  String
 
@@ -218,6 +223,29 @@ public:
     /*! @brief  Non-modifiable iterator on a string.
         
         This class is used internally by String and MutableString.
+        
+        Rather than fetching characters one at a time from the underlying 
+        @c CFStringRef, a String's const_iterator reads them directly from the 
+        string's storage when CoreFoundation exposes it, and otherwise copies them a 
+        block at a time into a small buffer.  Sequential traversals in either 
+        direction, which is what most STL algorithms do, therefore cost one 
+        CoreFoundation call per kBufferSize characters rather than one per character.
+        
+        Each iterator has a buffer of its own, which copies of the iterator start out 
+        with, so that several iterators may traverse the same string (as 
+        @c std::equal() or @c std::search() do) without evicting each other's 
+        characters, and copies may be used from different threads.  An iterator 
+        whose buffer has never been filled fetches a single character, so that 
+        short-lived copies (such as <tt>it + n</tt>, or the temporaries made by 
+        @c std::reverse_iterator) don't pay for a whole block.  A given iterator 
+        object must not be read concurrently from different threads, though, since 
+        reading it may refill its buffer.
+        
+        A MutableString's const_iterator doesn't buffer anything, because the 
+        string may change while the iterator is in use;  it sees every modification, 
+        as it always has.
+        
+        @sa StringInlineBuffer
     */
     class const_iterator : public std::iterator<std::random_access_iterator_tag, 
                                                 String::value_type, 
@@ -227,36 +255,56 @@ public:
     {
     public:
         
+        //! The number of characters buffered by a String's iterators.
+        enum { kBufferSize = 16 };
+        
         // constructor
-        const_iterator()                                        : mRef(NULL), mIndex(0) {}
-        const_iterator(const const_iterator& it)                : mRef(it.mRef), mIndex(it.mIndex)  {}
+        const_iterator()                                        : mRef(NULL), mIndex(0), mChars(NULL), mBuffered(false) { mWindow.mStart = mWindow.mLength = 0; }
         
-        const_iterator& operator = (const const_iterator& it)   { mRef = it.mRef; mIndex = it.mIndex; return (*this); }
-        const_iterator& operator = (const String::iterator& it) { mRef = it.mRef; mIndex = it.mIndex; return (*this); }
+        const_iterator& operator = (const String::iterator& it) { const_iterator temp(it.mRef, it.mIndex, NULL, false); swap(temp); return (*this); }
         
-        value_type  operator * () const                         { return (CFStringGetCharacterAtIndex(mRef, mIndex)); }
-        value_type  operator [] (difference_type i) const       { return (CFStringGetCharacterAtIndex(mRef, mIndex + i)); }
+        value_type  operator * () const                         { return (get(mIndex)); }
+        value_type  operator [] (difference_type i) const       { return (get(mIndex + i)); }
         
         const_iterator& operator ++ ()                          { ++mIndex; return (*this); }
         const_iterator& operator -- ()                          { --mIndex; return (*this); }
         const_iterator& operator += (difference_type n)         { mIndex += n; return (*this); }
         const_iterator& operator -= (difference_type n)         { mIndex -= n; return (*this); }
-        const_iterator  operator ++ (int)                       { return (const_iterator(mRef, mIndex++)); }
-        const_iterator  operator -- (int)                       { return (const_iterator(mRef, mIndex--)); }
-        const_iterator  operator +  (difference_type n) const   { return (const_iterator(mRef, mIndex + n)); }
-        const_iterator  operator -  (difference_type n) const   { return (const_iterator(mRef, mIndex - n)); }
+        const_iterator  operator ++ (int)                       { prime(); const_iterator temp(*this); ++mIndex; return (temp); }
+        const_iterator  operator -- (int)                       { prime(); const_iterator temp(*this); --mIndex; return (temp); }
+        const_iterator  operator +  (difference_type n) const   { const_iterator temp(*this); temp.mIndex += n; return (temp); }
+        const_iterator  operator -  (difference_type n) const   { const_iterator temp(*this); temp.mIndex -= n; return (temp); }
         
         // internal
         int             compare(const const_iterator& it) const { return ((mIndex > it.mIndex) ? 1 : ((mIndex < it.mIndex) ? -1 : 0)); }
         difference_type distance(const const_iterator& it) const{ return (mIndex - it.mIndex); }
+        void            swap(const_iterator& it);
         
     private:
         
-        const_iterator(CFStringRef inRef, CFIndex inIndex)      : mRef(inRef), mIndex(inIndex)  {}
+        //! A block of buffered characters.
+        struct Window
+        {
+            CFIndex mStart;                 //!< The index of mChars[0] in the string.
+            CFIndex mLength;
+            UniChar mChars[kBufferSize];
+        };
+        
+        const_iterator(CFStringRef inRef, CFIndex inIndex, const UniChar* inChars, bool inBuffered)
+                                                                : mRef(inRef), mIndex(inIndex), mChars(inChars), mBuffered(inBuffered) { mWindow.mStart = mWindow.mLength = 0; }
+        
+        value_type  get(CFIndex inIndex) const;
+        value_type  fill(CFIndex inIndex) const;
+        bool        load(CFIndex inIndex) const;
+        bool        buffers(CFIndex inIndex) const  { return ((inIndex >= mWindow.mStart) && (inIndex < mWindow.mStart + mWindow.mLength)); }
+        void        prime() const                   { if (mBuffered && (mChars == NULL) && !buffers(mIndex)) load(mIndex); }
         
         // member variables
-        CFStringRef mRef;
-        CFIndex     mIndex;
+        CFStringRef         mRef;
+        CFIndex             mIndex;
+        const UniChar*      mChars;     //!< The string's storage, or @c NULL if it isn't accessible.
+        mutable Window      mWindow;    //!< The buffered characters.
+        bool                mBuffered;  //!< May characters be buffered?
         
         // friends
         friend class    String;
@@ -280,6 +328,10 @@ public:
                 String();
     //! Copy constructor.
                 String(const String& str);
+#if B_HAS_RVALUE_REFS
+    //! Move constructor.
+                String(String&& str) throw();
+#endif
     //! Allocator constructor.
     explicit    String(CFAllocatorRef allocator);
     //! String constructor.
@@ -318,6 +370,10 @@ public:
     explicit    String(const OSPtr<CFStringRef>& cfstr);
     //! @c OSPtr<CFMutableStringRef> constructor.
     explicit    String(const OSPtr<CFMutableStringRef>& cfstr);
+    //! @c UniChar array adoption constructor.
+    explicit    String(const UniChar* ustr, size_type n, CFAllocatorRef deallocator, const no_copy_t&);
+    //! @c char array adoption constructor.
+    explicit    String(const char* cstr, size_type n, CFStringEncoding encoding, CFAllocatorRef deallocator, const no_copy_t&);
     //! Range constructor.
     template <class InputIterator>
     explicit    String(InputIterator first, InputIterator last, CFAllocatorRef allocator = NULL);
@@ -416,6 +472,10 @@ public:
     //@{
     //! String assignemnt.
     String& operator = (const String& str);
+#if B_HAS_RVALUE_REFS
+    //! String move assignemnt.
+    String& operator = (String&& str) throw();
+#endif
     //! MutableString assignemnt.
     String& operator = (const MutableString& str);
     //! @c CFStringRef assignemnt.
@@ -595,6 +655,23 @@ private:
     static OSPtr<CFStringRef>   make_str(ConstStringPtr pstr, CFStringEncoding encoding, CFAllocatorRef allocator, bool is_temp);
     static size_t               uni_strlen(const UniChar* ustr);
     
+    // range construction
+    template <class InputIterator>
+    static OSPtr<CFStringRef>   make_range_str(InputIterator first, InputIterator last, CFAllocatorRef allocator);
+    template <class InputIterator>
+    static OSPtr<CFStringRef>   make_range_str(InputIterator first, InputIterator last, CFAllocatorRef allocator, std::input_iterator_tag);
+    template <class ForwardIterator>
+    static OSPtr<CFStringRef>   make_range_str(ForwardIterator first, ForwardIterator last, CFAllocatorRef allocator, std::forward_iterator_tag);
+    static OSPtr<CFStringRef>   make_range_str(const UniChar* first, const UniChar* last, CFAllocatorRef allocator);
+    static OSPtr<CFStringRef>   make_range_str(UniChar* first, UniChar* last, CFAllocatorRef allocator);
+    static OSPtr<CFStringRef>   make_range_str(const char* first, const char* last, CFAllocatorRef allocator);
+    static OSPtr<CFStringRef>   make_range_str(char* first, char* last, CFAllocatorRef allocator);
+    static OSPtr<CFStringRef>   make_range_str(const_iterator first, const_iterator last, CFAllocatorRef allocator);
+    static UniChar              widen_char(char c)          { return (static_cast<unsigned char>(c)); }
+    static UniChar              widen_char(signed char c)   { return (static_cast<unsigned char>(c)); }
+    template <class T>
+    static UniChar              widen_char(T c)             { return (static_cast<UniChar>(c)); }
+    
     // comparisons
     static int  private_compare(CFStringRef ref, CFStringRef cfstr);
     static int  private_compare(CFStringRef ref, size_type pos1, size_type n1, CFStringRef cfstr);
@@ -614,6 +691,7 @@ private:
     static void         private_copy(CFStringRef ref, std::string& sstr, CFStringEncoding encoding);
     static void         private_copy(CFStringRef ref, StringPtr pstr, size_type n, CFStringEncoding encoding);
     static void         private_copy(CFStringRef ref, std::vector<UInt8>& blob, CFStringEncoding encoding, bool external, char loss_byte);
+    static bool         transcode_copy(CFStringRef ref, CFIndex len, std::string& sstr, CFStringEncoding encoding);
     
     // finding a character
     static size_type    private_find(CFStringRef ref, UniChar c, size_type pos, unsigned opts);
@@ -656,8 +734,36 @@ String::String(
     OSPtrOwnership::CFObjectOwnershipTrait::retain(mRef);
 }
 
+#if B_HAS_RVALUE_REFS
+// ------------------------------------------------------------------------------------------
+/*! Takes over @a str's underlying @c CFStringRef.  @a str is left holding the constant 
+    empty string, which is retained like any other so that @a str's destructor can 
+    release it;  constant strings are never deallocated, so this can't throw.
+*/
+inline
+String::String(
+    String&&    str)    //!< The source string.
+    throw()
+        : mRef(str.mRef)
+{
+    str.mRef = CFSTR("");
+    OSPtrOwnership::CFObjectOwnershipTrait::retain(str.mRef);
+}
+#endif
+
 // ------------------------------------------------------------------------------------------
 /*! Creates a string that is initialised by all character of the range [@a first, @a last).
+    
+    The characters are copied only once, straight into the new string's storage, if 
+    @a InputIterator is a pointer to @c UniChar or @c char, or a const_iterator.  The 
+    latter case is handled as a substring, so it may not involve copying at all.
+    
+    Other forward iterators are copied once into a buffer of the right size, which is 
+    then handed over to the new string.  Only pure input iterators, whose ranges can't 
+    be measured in advance, need a temporary copy.
+    
+    @note   @c char ranges are interpreted as ISO Latin-1, ie each @c char is converted 
+            to the @c UniChar of the same (unsigned) value.
 */
 template <class InputIterator>
 String::String(
@@ -667,9 +773,98 @@ String::String(
 {
     boost::function_requires< boost::InputIteratorConcept<InputIterator> >();
     
-    std::vector<UniChar>    temp(first, last);
+    mRef = make_range_str(first, last, allocator).release();
+}
+
+// ------------------------------------------------------------------------------------------
+template <class InputIterator> inline OSPtr<CFStringRef>
+String::make_range_str(
+    InputIterator   first, 
+    InputIterator   last, 
+    CFAllocatorRef  allocator)
+{
+    typedef typename std::iterator_traits<InputIterator>::iterator_category category;
+    
+    return (make_range_str(first, last, allocator, category()));
+}
+
+// ------------------------------------------------------------------------------------------
+template <class InputIterator> OSPtr<CFStringRef>
+String::make_range_str(
+    InputIterator   first, 
+    InputIterator   last, 
+    CFAllocatorRef  allocator, 
+    std::input_iterator_tag)
+{
+    std::vector<UniChar>    temp;
+    
+    for (; first != last; ++first)
+        temp.push_back(widen_char(*first));
+    
+    if (temp.empty())
+        return (make_range_str(static_cast<const UniChar*>(NULL), NULL, allocator));
+    
+    return (make_str(&temp[0], 0, temp.size(), allocator, false));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The range's length is known in advance, so the characters are copied directly into 
+    a buffer obtained from @a allocator, which the new string then adopts.
+*/
+template <class ForwardIterator> OSPtr<CFStringRef>
+String::make_range_str(
+    ForwardIterator first, 
+    ForwardIterator last, 
+    CFAllocatorRef  allocator, 
+    std::forward_iterator_tag)
+{
+    size_type   n   = std::distance(first, last);
+    
+    if (n == 0)
+        return (make_range_str(static_cast<const UniChar*>(NULL), NULL, allocator));
+    
+    UniChar*    buff    = static_cast<UniChar*>(CFAllocatorAllocate(allocator, n * sizeof(UniChar), 0));
+    CFStringRef str;
+    
+    B_THROW_IF_NULL(buff);
+    
+    try
+    {
+        for (UniChar* p = buff; first != last; ++first)
+            *p++ = widen_char(*first);
+    }
+    catch (...)
+    {
+        CFAllocatorDeallocate(allocator, buff);
+        throw;
+    }
+    
+    str = CFStringCreateWithCharactersNoCopy(allocator, buff, n, allocator);
+    
+    if (str == NULL)
+        CFAllocatorDeallocate(allocator, buff);
     
-    mRef = make_str(&temp[0], 0, temp.size(), allocator, false).release();
+    return (OSPtr<CFStringRef>(str, from_copy));
+}
+
+// ------------------------------------------------------------------------------------------
+inline OSPtr<CFStringRef>
+String::make_range_str(
+    UniChar*        first, 
+    UniChar*        last, 
+    CFAllocatorRef  allocator)
+{
+    return (make_range_str(static_cast<const UniChar*>(first), last, allocator));
+}
+
+// ------------------------------------------------------------------------------------------
+inline OSPtr<CFStringRef>
+String::make_range_str(
+    char*           first, 
+    char*           last, 
+    CFAllocatorRef  allocator)
+{
+    return (make_range_str(static_cast<const char*>(first), last, allocator));
 }
 
 // ------------------------------------------------------------------------------------------
@@ -922,6 +1117,33 @@ String::operator [] (
         return (CFStringGetCharacterAtIndex(mRef, pos));
 }
 
+// ------------------------------------------------------------------------------------------
+inline String::value_type
+String::const_iterator::get(
+    CFIndex inIndex)    //!< The index of the character to return.
+    const
+{
+    if (mChars != NULL)
+        return (mChars[inIndex]);
+    
+    if (buffers(inIndex))
+        return (mWindow.mChars[inIndex - mWindow.mStart]);
+    
+    return (fill(inIndex));
+}
+
+// ------------------------------------------------------------------------------------------
+inline void
+String::const_iterator::swap(
+    const_iterator& it)     //!< The iterator to swap with.
+{
+    std::swap(mRef, it.mRef);
+    std::swap(mIndex, it.mIndex);
+    std::swap(mChars, it.mChars);
+    std::swap(mWindow, it.mWindow);
+    std::swap(mBuffered, it.mBuffered);
+}
+
 // ------------------------------------------------------------------------------------------
 inline CFStringRef
 String::cf_ref() const
@@ -1066,6 +1288,21 @@ String::operator = (
     return (*this);
 }
 
+#if B_HAS_RVALUE_REFS
+// ------------------------------------------------------------------------------------------
+/*! Exchanges the underlying @c CFStringRefs;  @a str releases ours when it's destroyed.
+*/
+inline String&
+String::operator = (
+    String&&    str)    //!< The input string.
+    throw()
+{
+    swap(str);
+    
+    return (*this);
+}
+#endif
+
 // ------------------------------------------------------------------------------------------
 inline String&
 String::operator = (
@@ -19,6 +19,25 @@
 // file header
 #include "BStringFormatter.h"
 
+// standard headers
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+// library headers
+#if defined(__MWERKS__)
+#   include <hash_map>
+#elif defined(__GNUC__)
+#   include <ext/hash_map>
+#endif
+#include <boost/thread/mutex.hpp>
+#include <boost/utility.hpp>
+
+// B headers
+#include "BErrorHandler.h"
+#include "BException.h"
+#include "BTranscoding.h"
+
 // The version of Boost.Format that's in the 1.31.0 release gives us a "possible unwanted ;" 
 // warning under CodeWarrior, so suppress that warning (since we can't fix it).
 #ifdef __MWERKS__
@@ -28,38 +47,232 @@
 
 namespace B {
 
+// ==========================================================================================
+//  StringFormatter::CompiledFormat
+
+#pragma mark StringFormatter::CompiledFormat
+
+/*! The parsed form of a format string.  The literal text (with escaped percent signs 
+    resolved) is held in mText.  It is divided by mPieces into runs, each of which is 
+    followed by the argument it names, if any.
+    
+    Format strings that contain anything other than positional directives and escaped 
+    percent signs aren't parsed;  mIsCompiled is @c false for them.
+*/
+class StringFormatter::CompiledFormat : public boost::noncopyable
+{
+public:
+    
+    enum { kNoArg = -1, kMaxArgs = 1000 };
+    
+    struct Piece
+    {
+        size_t  mTextEnd;   //!< The end of the run of literal text in mText.
+        int     mArg;       //!< The argument following the run, or kNoArg.
+    };
+    
+    explicit    CompiledFormat(const String& inFormatString);
+    
+    // member variables
+    std::vector<UniChar>    mText;
+    std::vector<Piece>      mPieces;
+    size_t                  mArgCount;
+    bool                    mIsCompiled;
+    std::string             mBoostString;   //!< The format string, for @c boost::format.
+};
+
 // ------------------------------------------------------------------------------------------
-std::string
-StringFormatter::MakeFormatString(const String& inFormatString)
+StringFormatter::CompiledFormat::CompiledFormat(
+    const String&   inFormatString)
+        : mArgCount(0), mIsCompiled(false)
 {
-    std::string sstr;
+    inFormatString.copy(mBoostString, kCFStringEncodingUTF8);
     
-    inFormatString.copy(sstr, kCFStringEncodingUTF8);
+    std::vector<UniChar>    chars(inFormatString.size());
+    size_t                  n   = chars.size();
+    size_t                  i   = 0;
     
-    return (sstr);
+    if (n > 0)
+        inFormatString.copy(&chars[0], n);
+    
+    mText.reserve(n);
+    
+    while (i < n)
+    {
+        if (chars[i] != '%')
+        {
+            mText.push_back(chars[i++]);
+            continue;
+        }
+        
+        if ((i + 1 < n) && (chars[i+1] == '%'))
+        {
+            mText.push_back('%');
+            i += 2;
+            continue;
+        }
+        
+        size_t  j       = i + 1;
+        size_t  argN    = 0;
+        
+        while ((j < n) && (chars[j] >= '0') && (chars[j] <= '9') && (argN < kMaxArgs))
+            argN = (argN * 10) + (chars[j++] - '0');
+        
+        // Anything but "%N%" is left to boost::format.
+        
+        if ((j == i + 1) || (j >= n) || (chars[j] != '%') || (argN == 0) || (argN > kMaxArgs))
+            return;
+        
+        Piece   piece   = { mText.size(), static_cast<int>(argN - 1) };
+        
+        mPieces.push_back(piece);
+        mArgCount   = std::max(mArgCount, argN);
+        i           = j + 1;
+    }
+    
+    Piece   last    = { mText.size(), kNoArg };
+    
+    mPieces.push_back(last);
+    mIsCompiled = true;
+}
+
+
+// ==========================================================================================
+//  StringFormatter::FormatCache
+
+#pragma mark -
+#pragma mark StringFormatter::FormatCache
+
+/*! The cache is keyed by the format strings themselves.  Interning them instead would 
+    be no faster (it involves a hash lookup of its own) and would keep every format 
+    string ever seen alive forever, since interned strings are never released.
+*/
+struct StringFormatter::FormatCache
+{
+    //! The cache is emptied when it reaches this size.
+    enum { kMaxSize = 256 };
+    
+    struct StringHash
+    {
+        size_t  operator () (const String& s) const { return (CFHash(s.cf_ref())); }
+    };
+    
+    struct StringEqual
+    {
+        bool    operator () (const String& s1, const String& s2) const
+                    { return (CFEqual(s1.cf_ref(), s2.cf_ref())); }
+    };
+    
+#if defined(__MWERKS__)
+    typedef Metrowerks::hash_map<String, boost::shared_ptr<const CompiledFormat>, 
+                                 StringHash, StringEqual>   FormatMap;
+#elif defined(__GNUC__)
+    typedef __gnu_cxx::hash_map<String, boost::shared_ptr<const CompiledFormat>, 
+                                StringHash, StringEqual>    FormatMap;
+#endif
+    
+    boost::mutex    mMutex;
+    FormatMap       mFormats;
+};
+
+
+// ==========================================================================================
+//  StringFormatter
+
+#pragma mark -
+#pragma mark StringFormatter
+
+boost::once_flag                    StringFormatter::sFormatCacheInit   = BOOST_ONCE_INIT;
+StringFormatter::FormatCache*       StringFormatter::sFormatCache       = NULL;
+
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::InitFormatCache() throw()
+{
+    try
+    {
+        sFormatCache = new FormatCache;
+    }
+    catch (...)
+    {
+        // sFormatCache stays NULL, so GetFormatCache() will throw.
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+StringFormatter::FormatCache&
+StringFormatter::GetFormatCache()
+{
+    boost::call_once(InitFormatCache, sFormatCacheInit);
+    B_THROW_IF(sFormatCache == NULL, std::bad_alloc());
+    
+    return (*sFormatCache);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the parsed form of @a inFormatString, from the cache if possible.  The 
+    parsing itself happens outside of the cache's lock.
+*/
+boost::shared_ptr<const StringFormatter::CompiledFormat>
+StringFormatter::GetCompiledFormat(
+    const String&   inFormatString)
+{
+    FormatCache&                    cache   = GetFormatCache();
+    FormatCache::FormatMap::iterator it;
+    
+    {
+        boost::mutex::scoped_lock   lock(cache.mMutex);
+        
+        if ((it = cache.mFormats.find(inFormatString)) != cache.mFormats.end())
+            return (it->second);
+    }
+    
+    boost::shared_ptr<const CompiledFormat> format(new CompiledFormat(inFormatString));
+    boost::mutex::scoped_lock               lock(cache.mMutex);
+    
+    // Formatters hold on to their parsed format, so emptying the cache is harmless.
+    
+    if (cache.mFormats.size() >= FormatCache::kMaxSize)
+        cache.mFormats.clear();
+    
+    // If another thread beat us to it, use its parsed format.
+    
+    return (cache.mFormats.insert(FormatCache::FormatMap::value_type(inFormatString, format)).first->second);
 }
 
 // ------------------------------------------------------------------------------------------
 StringFormatter::StringFormatter(const String& inFormatString)
-    : mFormatter(MakeFormatString(inFormatString))
+    : mExceptions(boost::io::all_error_bits), mDumped(false)
 {
+    Init(inFormatString);
 }
 
 // ------------------------------------------------------------------------------------------
 StringFormatter::StringFormatter(const std::string& inFormatString)
-    : mFormatter(inFormatString)
+    : mExceptions(boost::io::all_error_bits), mDumped(false)
 {
+    Init(inFormatString.data(), inFormatString.size());
 }
 
 // ------------------------------------------------------------------------------------------
 StringFormatter::StringFormatter(const char* inFormatString)
-    : mFormatter(inFormatString)
+    : mExceptions(boost::io::all_error_bits), mDumped(false)
 {
+    Init(inFormatString, std::strlen(inFormatString));
 }
 
 // ------------------------------------------------------------------------------------------
 StringFormatter::StringFormatter(const StringFormatter& inFormatter)
-    : mFormatter(inFormatter.mFormatter)
+    : mFormat(inFormatter.mFormat), mArgChars(inFormatter.mArgChars), 
+      mArgEnds(inFormatter.mArgEnds), mExceptions(inFormatter.mExceptions), 
+      mDumped(inFormatter.mDumped)
+{
+    if (inFormatter.mBoostFormat.get() != NULL)
+        mBoostFormat.reset(new BoostFormat(*inFormatter.mBoostFormat));
+}
+
+// ------------------------------------------------------------------------------------------
+StringFormatter::~StringFormatter()
 {
 }
 
@@ -67,16 +280,320 @@ StringFormatter::StringFormatter(const StringFormatter& inFormatter)
 StringFormatter&
 StringFormatter::operator = (const StringFormatter& inFormatter)
 {
-    mFormatter = inFormatter.mFormatter;
+    if (&inFormatter != this)
+    {
+        boost::scoped_ptr<BoostFormat>  boostFormat;
+        
+        if (inFormatter.mBoostFormat.get() != NULL)
+            boostFormat.reset(new BoostFormat(*inFormatter.mBoostFormat));
+        
+        mFormat     = inFormatter.mFormat;
+        mArgChars   = inFormatter.mArgChars;
+        mArgEnds    = inFormatter.mArgEnds;
+        mExceptions = inFormatter.mExceptions;
+        mDumped     = inFormatter.mDumped;
+        mBoostFormat.swap(boostFormat);
+    }
     
     return (*this);
 }
 
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::Init(const String& inFormatString)
+{
+    mFormat = GetCompiledFormat(inFormatString);
+    
+    if (!mFormat->mIsCompiled)
+        Demote();
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::Init(const char* inFormatString, size_t inLength)
+{
+    OSPtr<CFStringRef>  cfstr(CFStringCreateWithBytes(NULL, 
+                                    reinterpret_cast<const UInt8*>(inFormatString), 
+                                    inLength, kCFStringEncodingUTF8, false), 
+                              from_copy, std::nothrow);
+    
+    if (cfstr.get() != NULL)
+    {
+        Init(String(cfstr));
+    }
+    else
+    {
+        // Not UTF-8;  leave it to boost::format.
+        mBoostFormat.reset(new BoostFormat(std::string(inFormatString, inLength)));
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Switches over to @c boost::format, if that hasn't been done already.  The arguments 
+    fed so far are fed again to the @c boost::format object.
+*/
+StringFormatter::BoostFormat&
+StringFormatter::Demote() const
+{
+    if (mBoostFormat.get() == NULL)
+    {
+        boost::scoped_ptr<BoostFormat>  format(new BoostFormat(mFormat->mBoostString));
+        size_t                          begin   = 0;
+        
+        format->exceptions(mExceptions);
+        
+        for (size_t i = 0; i < mArgEnds.size(); i++)
+        {
+            std::string sstr;
+            
+            if (mArgEnds[i] > begin)
+            {
+                if (!Transcoding::EncodeUtf8(&mArgChars[begin], mArgEnds[i] - begin, sstr))
+                    B_THROW(CharacterEncodingException());
+            }
+            
+            *format % sstr;
+            begin = mArgEnds[i];
+        }
+        
+        mBoostFormat.swap(format);
+    }
+    
+    return (*mBoostFormat);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns @c true if the next argument can be appended to mArgChars, @c false if it 
+    must be fed to the @c boost::format object.
+*/
+bool
+StringFormatter::BeginArg()
+{
+    if (mBoostFormat.get() != NULL)
+        return (false);
+    
+    // Like boost::format, start over if the result has already been extracted.
+    
+    if (mDumped)
+        clear();
+    
+    if (mArgEnds.size() >= mFormat->mArgCount)
+    {
+        // Too many arguments.  Let boost::format decide what to do about it.
+        Demote();
+        return (false);
+    }
+    
+    return (true);
+}
+
 // ------------------------------------------------------------------------------------------
 String
 StringFormatter::extract() const
 {
-    return (String(mFormatter.str(), kCFStringEncodingUTF8));
+    if ((mBoostFormat.get() == NULL) && (mArgEnds.size() < mFormat->mArgCount))
+    {
+        // Too few arguments.  Let boost::format decide what to do about it.
+        Demote();
+    }
+    
+    if (mBoostFormat.get() != NULL)
+        return (String(mBoostFormat->str(), kCFStringEncodingUTF8));
+    
+    const CompiledFormat&   format  = *mFormat;
+    size_t                  length  = format.mText.size();
+    
+    for (size_t i = 0; i < format.mPieces.size(); i++)
+    {
+        int arg = format.mPieces[i].mArg;
+        
+        if (arg != CompiledFormat::kNoArg)
+            length += mArgEnds[arg] - ((arg > 0) ? mArgEnds[arg-1] : 0);
+    }
+    
+    mDumped = true;
+    
+    if (length == 0)
+        return (String());
+    
+    // Build the result in a buffer that the CFString adopts.
+    
+    UniChar*    buff    = static_cast<UniChar*>(CFAllocatorAllocate(NULL, length * sizeof(UniChar), 0));
+    UniChar*    out     = buff;
+    size_t      textPos = 0;
+    
+    B_THROW_IF_NULL(buff);
+    
+    for (size_t i = 0; i < format.mPieces.size(); i++)
+    {
+        const CompiledFormat::Piece&    piece   = format.mPieces[i];
+        
+        out     = std::copy(format.mText.begin() + textPos, 
+                            format.mText.begin() + piece.mTextEnd, out);
+        textPos = piece.mTextEnd;
+        
+        if (piece.mArg != CompiledFormat::kNoArg)
+        {
+            size_t  argBegin    = (piece.mArg > 0) ? mArgEnds[piece.mArg-1] : 0;
+            
+            out = std::copy(mArgChars.begin() + argBegin, 
+                            mArgChars.begin() + mArgEnds[piece.mArg], out);
+        }
+    }
+    
+    B_ASSERT(out == buff + length);
+    
+    CFStringRef str = CFStringCreateWithCharactersNoCopy(NULL, buff, length, NULL);
+    
+    if (str == NULL)
+        CFAllocatorDeallocate(NULL, buff);
+    
+    return (String(OSPtr<CFStringRef>(str, from_copy)));
+}
+
+// ------------------------------------------------------------------------------------------
+StringFormatter&
+StringFormatter::clear_bind(int argN)
+{
+    Demote().clear_bind(argN);
+    return (*this); 
+}
+
+// ------------------------------------------------------------------------------------------
+StringFormatter&
+StringFormatter::clear_binds()
+{
+    if (mBoostFormat.get() != NULL)
+        mBoostFormat->clear_binds();
+    else
+        clear();
+    
+    return (*this); 
+}
+
+// ------------------------------------------------------------------------------------------
+unsigned char
+StringFormatter::exceptions(unsigned char newexcept)
+{
+    unsigned char   oldexcept   = mExceptions;
+    
+    mExceptions = newexcept;
+    
+    if (mBoostFormat.get() != NULL)
+        mBoostFormat->exceptions(newexcept);
+    
+    return (oldexcept);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::AppendArg(const std::string& x)
+{
+    AppendUtf8(x.data(), x.size());
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::AppendArg(const char* x)
+{
+    AppendUtf8(x, std::strlen(x));
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::AppendArg(const String& x)
+{
+    AppendCFString(x.cf_ref());
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::AppendArg(const MutableString& x)
+{
+    AppendCFString(x.cf_ref());
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::AppendSigned(SInt64 x)
+{
+    if (x < 0)
+    {
+        mArgChars.push_back('-');
+        AppendUnsigned(0 - static_cast<UInt64>(x));
+    }
+    else
+    {
+        AppendUnsigned(static_cast<UInt64>(x));
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::AppendUnsigned(UInt64 x)
+{
+    UniChar     buff[20];
+    UniChar*    p   = buff + 20;
+    
+    do
+    {
+        *--p    = static_cast<UniChar>('0' + (x % 10));
+        x       /= 10;
+    } while (x != 0);
+    
+    mArgChars.insert(mArgChars.end(), p, buff + 20);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::AppendUtf8(const char* s, size_t n)
+{
+    size_t  size    = mArgChars.size();
+    
+    if (!Transcoding::DecodeUtf8(s, n, mArgChars))
+    {
+        // Let CoreFoundation have a go at it (and report the error if it can't cope 
+        // either, just as it would have with the whole result under boost::format).
+        
+        mArgChars.resize(size);
+        AppendCFString(String(std::string(s, n), kCFStringEncodingUTF8).cf_ref());
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringFormatter::AppendCFString(CFStringRef cfstr)
+{
+    CFIndex length  = CFStringGetLength(cfstr);
+    size_t  size    = mArgChars.size();
+    
+    if (length > 0)
+    {
+        mArgChars.resize(size + length);
+        CFStringGetCharacters(cfstr, CFRangeMake(0, length), &mArgChars[size]);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+std::string
+StringFormatter::BoostArg(const String& x)
+{
+    std::string sstr;
+    
+    x.copy(sstr, kCFStringEncodingUTF8);
+    
+    return (sstr);
+}
+
+// ------------------------------------------------------------------------------------------
+std::string
+StringFormatter::BoostArg(const MutableString& x)
+{
+    std::string sstr;
+    
+    x.copy(sstr, kCFStringEncodingUTF8);
+    
+    return (sstr);
 }
 
 
@@ -22,10 +22,15 @@
 #pragma once
 
 // standard headers
+#include <sstream>
 #include <string>
+#include <vector>
 
 // library headers
 #include <boost/format.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/once.hpp>
 
 // B headers
 #include "BMutableString.h"
@@ -36,8 +41,26 @@ namespace B {
 
 /*! @brief  Type-safe localisable strings.
     
-    @todo   %Document this class!
-    @todo   Investigate using something lighter-weight than boost::format.
+    StringFormatter has the same interface and semantics as @c boost::format, but 
+    produces a String.  Arguments are fed with operator %, and the result is obtained 
+    with extract() (or the Extract() free function):
+    
+    @code
+        String  text    = Extract(StringFormatter(formatStr) % count % name);
+    @endcode
+    
+    Format strings containing only positional directives (eg <tt>"%1% of %2%"</tt>) and 
+    escaped percent signs are handled without involving @c boost::format at all.  Such 
+    format strings are parsed once, and the parsed form is kept in a process-wide cache 
+    keyed by the (interned) format string, so formatting the same localised string 
+    over and over doesn't re-parse it.  Arguments are converted to UTF-16 as they are 
+    fed, directly into a single buffer;  Strings are copied as is, integers are 
+    converted without going through a stream, and other types are written to a 
+    @c std::ostringstream as @c boost::format would.
+    
+    Anything else (printf-style directives, bound arguments, manipulators, argument 
+    count errors) is handed over to a @c boost::format object, so the behaviour is 
+    exactly that of @c boost::format.
 */
 class StringFormatter
 {
@@ -48,6 +71,7 @@ public:
     explicit    StringFormatter(const String& inFormatString);
     explicit    StringFormatter(const std::string& inFormatString);
     explicit    StringFormatter(const char* inFormatString);
+                ~StringFormatter();
     
     StringFormatter&    operator = (const StringFormatter& inFormatter);
     
@@ -81,17 +105,72 @@ public:
     
 private:
     
-    static std::string  MakeFormatString(const String& inFormatString);
+    // types
+    typedef boost::basic_format<char>   BoostFormat;
+    class   CompiledFormat;
+    struct  FormatCache;
+    
+    static boost::shared_ptr<const CompiledFormat>
+                GetCompiledFormat(const String& inFormatString);
+    static FormatCache&
+                GetFormatCache();
+    static void InitFormatCache() throw();
+    
+    void        Init(const char* inFormatString, size_t inLength);
+    void        Init(const String& inFormatString);
+    bool        BeginArg();
+    void        EndArg()    { mArgEnds.push_back(mArgChars.size()); }
+    BoostFormat&    Demote() const;
+    
+    // argument conversion
+    template <class T>
+    void        AppendArg(const T& x);
+    void        AppendArg(const std::string& x);
+    void        AppendArg(const char* x);
+    void        AppendArg(const String& x);
+    void        AppendArg(const MutableString& x);
+    void        AppendArg(short x)              { AppendSigned(x); }
+    void        AppendArg(unsigned short x)     { AppendUnsigned(x); }
+    void        AppendArg(int x)                { AppendSigned(x); }
+    void        AppendArg(unsigned int x)       { AppendUnsigned(x); }
+    void        AppendArg(long x)               { AppendSigned(x); }
+    void        AppendArg(unsigned long x)      { AppendUnsigned(x); }
+    void        AppendArg(SInt64 x)             { AppendSigned(x); }
+    void        AppendArg(UInt64 x)             { AppendUnsigned(x); }
+    void        AppendSigned(SInt64 x);
+    void        AppendUnsigned(UInt64 x);
+    void        AppendUtf8(const char* s, size_t n);
+    void        AppendCFString(CFStringRef cfstr);
+    
+    template <class T>
+    static const T&     BoostArg(const T& x)    { return (x); }
+    static std::string  BoostArg(const String& x);
+    static std::string  BoostArg(const MutableString& x);
     
     // member variables
-    boost::basic_format<char>   mFormatter;
+    boost::shared_ptr<const CompiledFormat> mFormat;
+    std::vector<UniChar>                    mArgChars;      //!< The fed arguments, end to end.
+    std::vector<size_t>                     mArgEnds;       //!< The end of each argument in mArgChars.
+    mutable boost::scoped_ptr<BoostFormat>  mBoostFormat;   //!< Non-NULL once we've fallen back on @c boost::format.
+    unsigned char                           mExceptions;
+    mutable bool                            mDumped;
+    
+    // static member variables
+    static boost::once_flag sFormatCacheInit;
+    static FormatCache*     sFormatCache;
 };
 
 // ------------------------------------------------------------------------------------------
 inline StringFormatter&
 StringFormatter::clear()
 {
-    mFormatter.clear();
+    if (mBoostFormat.get() != NULL)
+        mBoostFormat->clear();
+    
+    mArgChars.clear();
+    mArgEnds.clear();
+    mDumped = false;
+    
     return (*this);
 }
 
@@ -99,32 +178,15 @@ StringFormatter::clear()
 template <class T> inline StringFormatter&
 StringFormatter::operator % (const T& x) 
 { 
-    mFormatter % x;
-    return (*this);
-}
-
-// ------------------------------------------------------------------------------------------
-template <> inline StringFormatter&
-StringFormatter::operator % (const String& x) 
-{
-    std::string sstr;
-    
-    x.copy(sstr, kCFStringEncodingUTF8);
-    
-    mFormatter % sstr;
-    
-    return (*this);
-}
-
-// ------------------------------------------------------------------------------------------
-template <> inline StringFormatter&
-StringFormatter::operator % (const MutableString& x) 
-{
-    std::string sstr;
-    
-    x.copy(sstr, kCFStringEncodingUTF8);
-    
-    mFormatter % sstr;
+    if (BeginArg())
+    {
+        AppendArg(x);
+        EndArg();
+    }
+    else
+    {
+        *mBoostFormat % BoostArg(x);
+    }
     
     return (*this);
 }
@@ -134,34 +196,7 @@ StringFormatter::operator % (const MutableString& x)
 template <class T> inline StringFormatter&
 StringFormatter::operator % (T& x) 
 {
-    mFormatter % x;
-    return (*this);
-}
-
-// ------------------------------------------------------------------------------------------
-template <> inline StringFormatter&
-StringFormatter::operator % (String& x) 
-{
-    std::string sstr;
-    
-    x.copy(sstr, kCFStringEncodingUTF8);
-    
-    mFormatter % sstr;
-    
-    return (*this);
-}
-
-// ------------------------------------------------------------------------------------------
-template <> inline StringFormatter&
-StringFormatter::operator % (MutableString& x) 
-{
-    std::string sstr;
-    
-    x.copy(sstr, kCFStringEncodingUTF8);
-    
-    mFormatter % sstr;
-    
-    return (*this);
+    return (operator % (static_cast<const T&>(x)));
 }
 #endif
 
@@ -169,23 +204,7 @@ StringFormatter::operator % (MutableString& x)
 template <class T> inline StringFormatter&
 StringFormatter::bind_arg(int argN, const T& val) 
 {
-    mFormatter.bind_arg(argN, val);
-    return (*this); 
-}
-
-// ------------------------------------------------------------------------------------------
-inline StringFormatter&
-StringFormatter::clear_bind(int argN)
-{
-    mFormatter.clear_bind(argN);
-    return (*this); 
-}
-
-// ------------------------------------------------------------------------------------------
-inline StringFormatter&
-StringFormatter::clear_binds()
-{
-    mFormatter.clear_binds();
+    Demote().bind_arg(argN, BoostArg(val));
     return (*this); 
 }
 
@@ -193,7 +212,7 @@ StringFormatter::clear_binds()
 template <class T> inline StringFormatter&
 StringFormatter::modify_item(int itemN, const T& manipulator) 
 {
-    mFormatter.modify_item(itemN, manipulator);
+    Demote().modify_item(itemN, manipulator);
     return (*this); 
 }
 
@@ -201,14 +220,20 @@ StringFormatter::modify_item(int itemN, const T& manipulator)
 inline unsigned char
 StringFormatter::exceptions() const
 {
-    return (mFormatter.exceptions());
+    return (mExceptions);
 }
 
 // ------------------------------------------------------------------------------------------
-inline unsigned char
-StringFormatter::exceptions(unsigned char newexcept)
+/*! Writes @a x to a stream, as @c boost::format would, and appends the result.
+*/
+template <class T> void
+StringFormatter::AppendArg(const T& x)
 {
-    return (mFormatter.exceptions(newexcept));
+    std::ostringstream  ostr;
+    
+    ostr << x;
+    
+    AppendArg(ostr.str());
 }
 
 // ------------------------------------------------------------------------------------------
@@ -0,0 +1,139 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BStringInlineBuffer.h"
+
+// standard headers
+#include <algorithm>
+#include <stdexcept>
+
+// B headers
+#include "BErrorHandler.h"
+#include "BMutableString.h"
+#include "BString.h"
+
+
+namespace B {
+
+// ------------------------------------------------------------------------------------------
+StringInlineBuffer::StringInlineBuffer(
+    const String&           inString,       //!< The string.
+    size_t                  inBlockSize)    //!< The number of characters per block.
+        : mString(inString.cf_ptr()), mOffset(0), mLength(inString.size()), 
+          mBlockSize(inBlockSize)
+{
+    Init();
+}
+
+// ------------------------------------------------------------------------------------------
+StringInlineBuffer::StringInlineBuffer(
+    const MutableString&    inString,       //!< The string.
+    size_t                  inBlockSize)    //!< The number of characters per block.
+        : mString(inString.cf_ref()), mOffset(0), mLength(inString.size()), 
+          mBlockSize(inBlockSize)
+{
+    Init();
+}
+
+// ------------------------------------------------------------------------------------------
+StringInlineBuffer::StringInlineBuffer(
+    CFStringRef             inString,       //!< The string.
+    size_t                  inBlockSize)    //!< The number of characters per block.
+        : mString(inString), mOffset(0), mLength(CFStringGetLength(inString)), 
+          mBlockSize(inBlockSize)
+{
+    Init();
+}
+
+// ------------------------------------------------------------------------------------------
+StringInlineBuffer::StringInlineBuffer(
+    CFStringRef             inString,       //!< The string.
+    CFRange                 inRange,        //!< The range of characters within @a inString.
+    size_t                  inBlockSize)    //!< The number of characters per block.
+        : mString(inString), mOffset(inRange.location), mLength(inRange.length), 
+          mBlockSize(inBlockSize)
+{
+    B_THROW_IF((inRange.location < 0) || (inRange.length < 0) || 
+               (inRange.location + inRange.length > CFStringGetLength(inString)), 
+               std::out_of_range("B::StringInlineBuffer range out of range"));
+    
+    Init();
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringInlineBuffer::Init()
+{
+    B_ASSERT(mBlockSize > 0);
+    
+    mChars          = CFStringGetCharactersPtr(mString.get());
+    mBufferStart    = 0;
+    mBufferLength   = 0;
+    
+    if (mChars != NULL)
+        mChars += mOffset;
+    else
+        mBuffer.resize(std::min(mBlockSize, mLength));
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringInlineBuffer::Fill(
+    size_t  inPos) const
+{
+    B_ASSERT(inPos < mLength);
+    
+    mBufferStart    = inPos;
+    mBufferLength   = std::min(mBlockSize, mLength - inPos);
+    
+    CFStringGetCharacters(mString.get(), CFRangeMake(mOffset + mBufferStart, mBufferLength), 
+                          &mBuffer[0]);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns a pointer to the characters starting at index @a inPos, and sets 
+    @a outLength to the number of characters that may be read through it.
+    
+    If the string's storage is accessible, the span extends to the end of the range;  
+    otherwise, it is at most GetBlockSize() characters long.  The pointer remains valid 
+    until the next call to GetBlock() or operator [].
+    
+    If @a inPos is greater than or equal to size(), the results are undefined.
+*/
+const UniChar*
+StringInlineBuffer::GetBlock(
+    size_t  inPos,              //!< The index of the span's first character, relative to the start of the range.
+    size_t& outLength) const    //!< On output, the number of characters in the span.
+{
+    if (mChars != NULL)
+    {
+        outLength = mLength - inPos;
+        
+        return (mChars + inPos);
+    }
+    
+    if ((inPos < mBufferStart) || (inPos >= mBufferStart + mBufferLength))
+        Fill(inPos);
+    
+    outLength = mBufferStart + mBufferLength - inPos;
+    
+    return (&mBuffer[inPos - mBufferStart]);
+}
+
+}   // namespace B
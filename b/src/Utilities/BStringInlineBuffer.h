@@ -0,0 +1,165 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BStringInlineBuffer_H_
+#define BStringInlineBuffer_H_
+
+#pragma once
+
+// standard headers
+#include <vector>
+
+// system headers
+#include <CoreFoundation/CFString.h>
+
+// library headers
+#include <boost/utility.hpp>
+
+// B headers
+#include "BOSPtr.h"
+
+
+namespace B {
+
+// forward declarations
+class   String;
+class   MutableString;
+
+/*!
+    @brief  Gives fast, block-wise access to the characters of a string.
+    
+    StringInlineBuffer plays the same role as CoreFoundation's @c CFStringInlineBuffer, 
+    but with a block size chosen by the caller.  It is meant for code that needs to 
+    look at every character of a string, and for which one call to 
+    @c CFStringGetCharacterAtIndex() per character would be prohibitive.
+    
+    If the string's storage is accessible, characters are read from it directly.  
+    Otherwise, they are copied a block at a time into a buffer owned by the 
+    StringInlineBuffer.
+    
+    There are two ways to get at the characters.  The first is operator [], which 
+    returns a single character and refills the buffer when needed.  The second is 
+    GetBlock(), which returns a pointer to a contiguous span of characters;  this is 
+    the fastest way to walk through a string:
+    
+    @code
+        StringInlineBuffer  buffer(str);
+        const UniChar*      chars;
+        size_t              length;
+        
+        for (size_t pos = 0; pos < buffer.size(); pos += length)
+        {
+            chars = buffer.GetBlock(pos, length);
+            
+            // chars[0] through chars[length-1] are valid here.
+        }
+    @endcode
+    
+    The string must not be modified while the StringInlineBuffer exists.
+    
+    @note   String::const_iterator does its own, smaller-scale buffering, so there's 
+            no need for a StringInlineBuffer when using STL algorithms on a String.
+    
+    @ingroup    Utilities
+*/
+class StringInlineBuffer : public boost::noncopyable
+{
+public:
+    
+    //! @name Constants
+    //@{
+    //! The default number of characters per block.
+    static const size_t kDefaultBlockSize   = 64;
+    //@}
+    
+    //! @name Constructors
+    //@{
+    //! String constructor.
+    explicit    StringInlineBuffer(
+                    const String&           inString,
+                    size_t                  inBlockSize = kDefaultBlockSize);
+    //! MutableString constructor.
+    explicit    StringInlineBuffer(
+                    const MutableString&    inString,
+                    size_t                  inBlockSize = kDefaultBlockSize);
+    //! @c CFStringRef constructor.
+    explicit    StringInlineBuffer(
+                    CFStringRef             inString,
+                    size_t                  inBlockSize = kDefaultBlockSize);
+    //! @c CFStringRef substring constructor.
+                StringInlineBuffer(
+                    CFStringRef             inString,
+                    CFRange                 inRange,
+                    size_t                  inBlockSize = kDefaultBlockSize);
+    //@}
+    
+    //! @name Inquiries
+    //@{
+    //! Returns the number of characters in the buffered range.
+    size_t  size() const            { return (mLength); }
+    //! Returns the number of characters per block.
+    size_t  GetBlockSize() const    { return (mBlockSize); }
+    //! Returns @c true if characters are read directly from the string's storage.
+    bool    IsDirect() const        { return (mChars != NULL); }
+    //@}
+    
+    //! @name Character Access
+    //@{
+    //! Returns the character at index @a inPos.
+    UniChar         operator [] (size_t inPos) const;
+    //! Returns a contiguous span of characters starting at index @a inPos.
+    const UniChar*  GetBlock(size_t inPos, size_t& outLength) const;
+    //@}
+
+private:
+    
+    void    Init();
+    void    Fill(size_t inPos) const;
+    
+    // member variables
+    OSPtr<CFStringRef>              mString;
+    const CFIndex                   mOffset;        //!< The start of the buffered range in mString.
+    const size_t                    mLength;
+    const size_t                    mBlockSize;
+    const UniChar*                  mChars;         //!< The range's characters, or @c NULL if they aren't accessible.
+    mutable std::vector<UniChar>    mBuffer;
+    mutable size_t                  mBufferStart;   //!< The index of mBuffer[0] in the range.
+    mutable size_t                  mBufferLength;
+};
+
+// ------------------------------------------------------------------------------------------
+/*! If @a inPos is greater than or equal to size(), the results are undefined.
+*/
+inline UniChar
+StringInlineBuffer::operator [] (
+    size_t  inPos)  //!< The index of the character, relative to the start of the range.
+    const
+{
+    if (mChars != NULL)
+        return (mChars[inPos]);
+    
+    if ((inPos < mBufferStart) || (inPos >= mBufferStart + mBufferLength))
+        Fill(inPos);
+    
+    return (mBuffer[inPos - mBufferStart]);
+}
+
+}   // namespace B
+
+
+#endif  // BStringInlineBuffer_H_
@@ -0,0 +1,1247 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BStringRope.h"
+
+// standard headers
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// B headers
+#include "BErrorHandler.h"
+#include "BMutableString.h"
+
+
+namespace B {
+
+// ==========================================================================================
+//  StringRope::Node
+
+/*! The tree is a treap:  it is ordered by position, and heap-ordered by mPriority, 
+    which is random.  This keeps its expected depth logarithmic without any explicit 
+    rebalancing.  Each node holds a chunk of characters, which comes after the 
+    characters of its left subtree and before those of its right subtree.
+*/
+struct StringRope::Node
+{
+    Node*       mLeft;
+    Node*       mRight;
+    UInt32      mPriority;
+    size_type   mSize;      //!< The number of characters in the subtree rooted here.
+    size_type   mLength;    //!< The number of characters in mChars.
+    UniChar     mChars[kChunkSize];
+};
+
+
+// ==========================================================================================
+//  StringRope
+
+#pragma mark StringRope
+
+const StringRope::size_type StringRope::npos;
+const StringRope::size_type StringRope::kChunkSize;
+const StringRope::size_type StringRope::kMinFill;
+
+// ------------------------------------------------------------------------------------------
+StringRope::StringRope()
+    : mRoot(NULL), mSeed(1)
+{
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::StringRope(
+    const StringRope&   str)    //!< The source string.
+        : mRoot(NULL), mSeed(str.mSeed)
+{
+    mRoot = Clone(str.mRoot);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::StringRope(
+    const String&   str)    //!< The source string.
+        : mRoot(NULL), mSeed(1)
+{
+    Insert(0, str.cf_ref(), 0, npos);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::StringRope(
+    const MutableString&    str)    //!< The source string.
+        : mRoot(NULL), mSeed(1)
+{
+    Insert(0, str.cf_ref(), 0, npos);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::StringRope(
+    CFStringRef cfstr)  //!< The source string.
+        : mRoot(NULL), mSeed(1)
+{
+    Insert(0, cfstr, 0, npos);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! If @a n is @c npos, @a ustr is assumed to be NUL-terminated.
+*/
+StringRope::StringRope(
+    const UniChar*  ustr,           //!< The source characters.
+    size_type       n /* = npos */) //!< The number of characters.
+        : mRoot(NULL), mSeed(1)
+{
+    append(ustr, n);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::~StringRope()
+{
+    Destroy(mRoot);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope&
+StringRope::operator = (
+    const StringRope&   str)    //!< The source string.
+{
+    StringRope  temp(str);
+    
+    swap(temp);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope&
+StringRope::operator = (
+    const String&   str)    //!< The source string.
+{
+    StringRope  temp(str);
+    
+    swap(temp);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope&
+StringRope::operator = (
+    CFStringRef cfstr)  //!< The source string.
+{
+    StringRope  temp(cfstr);
+    
+    swap(temp);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::size_type
+StringRope::max_size() const
+{
+    return (std::numeric_limits<CFIndex>::max());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @a pos must be less than size().
+*/
+UniChar
+StringRope::operator [] (
+    size_type   pos)    //!< The index of the character.
+    const
+{
+    B_ASSERT(pos < size());
+    
+    const Node* node    = Locate(pos, false);
+    
+    return (node->mChars[pos]);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  @c std::out_of_range    If @a pos >= @c size().
+*/
+UniChar
+StringRope::at(
+    size_type   pos)    //!< The index of the character.
+    const
+{
+    B_THROW_IF(pos >= size(), std::out_of_range("B::StringRope::at() pos out of range"));
+    
+    return (operator [] (pos));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Appends, at most, @a n characters of @a str, starting with index @a pos.
+*/
+StringRope&
+StringRope::append(
+    const String&   str,            //!< The input string.
+    size_type       pos /* = 0 */,  //!< The index of the first character to append.
+    size_type       n /* = npos */) //!< The number of characters to append.
+{
+    Insert(size(), str.cf_ref(), pos, n);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Appends, at most, @a n characters of @a cfstr, starting with index @a pos.
+*/
+StringRope&
+StringRope::append(
+    CFStringRef cfstr,              //!< The input string.
+    size_type   pos /* = 0 */,      //!< The index of the first character to append.
+    size_type   n /* = npos */)     //!< The number of characters to append.
+{
+    Insert(size(), cfstr, pos, n);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! If @a n is @c npos, @a ustr is assumed to be NUL-terminated.
+*/
+StringRope&
+StringRope::append(
+    const UniChar*  ustr,           //!< The input characters.
+    size_type       n /* = npos */) //!< The number of characters to append.
+{
+    return (insert(size(), ustr, n));
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope&
+StringRope::append(
+    size_type   n,  //!< The number of occurrences of @a c to append.
+    UniChar     c)  //!< The character to append.
+{
+    return (insert(size(), n, c));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Inserts, at most, @a n characters of @a str, starting with index @a pos2, so that the 
+    new characters start with index @a pos1.
+    
+    @exception  @c std::out_of_range    If @a pos1 > @c size() or @a pos2 > @a str.size().
+*/
+StringRope&
+StringRope::insert(
+    size_type       pos1,           //!< The index at which to start inserting characters.
+    const String&   str,            //!< The input string.
+    size_type       pos2 /* = 0 */, //!< The index of the first character to insert from the input string.
+    size_type       n /* = npos */) //!< The number of characters to insert.
+{
+    Insert(pos1, str.cf_ref(), pos2, n);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Inserts, at most, @a n characters of @a cfstr, starting with index @a pos2, so that the 
+    new characters start with index @a pos1.
+    
+    @exception  @c std::out_of_range    If @a pos1 > @c size() or @a pos2 > the length of @a cfstr.
+*/
+StringRope&
+StringRope::insert(
+    size_type   pos1,           //!< The index at which to start inserting characters.
+    CFStringRef cfstr,          //!< The input string.
+    size_type   pos2 /* = 0 */, //!< The index of the first character to insert from the input string.
+    size_type   n /* = npos */) //!< The number of characters to insert.
+{
+    Insert(pos1, cfstr, pos2, n);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! If @a n is @c npos, @a ustr is assumed to be NUL-terminated.
+    
+    @exception  @c std::out_of_range    If @a pos > @c size().
+*/
+StringRope&
+StringRope::insert(
+    size_type       pos,            //!< The index at which to start inserting characters.
+    const UniChar*  ustr,           //!< The input characters.
+    size_type       n /* = npos */) //!< The number of characters to insert.
+{
+    B_ASSERT(ustr != NULL);
+    
+    if (n == npos)
+    {
+        for (n = 0; ustr[n] != 0; n++)
+            ;
+    }
+    
+    Insert(pos, ustr, n);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  @c std::out_of_range    If @a pos > @c size().
+*/
+StringRope&
+StringRope::insert(
+    size_type   pos,    //!< The index at which to start inserting characters.
+    size_type   n,      //!< The number of occurrences of @a c to insert.
+    UniChar     c)      //!< The character to insert.
+{
+    std::vector<UniChar>    chars(n, c);
+    
+    if (n > 0)
+        Insert(pos, &chars[0], n);
+    else
+        B_THROW_IF(pos > size(), std::out_of_range("B::StringRope::insert() pos out of range"));
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringRope::clear()
+{
+    Destroy(mRoot);
+    mRoot = NULL;
+    Invalidate();
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Removes, at most, @a n characters from @c *this, starting at index @a pos.
+    
+    @exception  @c std::out_of_range    If @a pos > @c size().
+*/
+StringRope&
+StringRope::erase(
+    size_type   pos /* = 0 */,      //!< The index of the first character to remove.
+    size_type   n /* = npos */)     //!< The number of characters to remove.
+{
+    Erase(pos, CheckedLength(size(), pos, n));
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Replaces, at most, @a n1 characters starting at @a pos1 with, at most, @a n2 
+    characters of @a str starting at @a pos2.
+    
+    @exception  @c std::out_of_range    If @a pos1 > @c size() or @a pos2 > @a str.size().
+*/
+StringRope&
+StringRope::replace(
+    size_type       pos1,           //!< The index of the first character to replace.
+    size_type       n1,             //!< The number of characters to replace.
+    const String&   str,            //!< The input string.
+    size_type       pos2 /* = 0 */, //!< The index of the first character to insert from the input string.
+    size_type       n2 /* = npos */)//!< The number of characters to insert.
+{
+    return (replace(pos1, n1, str.cf_ref(), pos2, n2));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Replaces, at most, @a n1 characters starting at @a pos1 with, at most, @a n2 
+    characters of @a cfstr starting at @a pos2.
+    
+    @exception  @c std::out_of_range    If @a pos1 > @c size() or @a pos2 > the length of @a cfstr.
+*/
+StringRope&
+StringRope::replace(
+    size_type   pos1,               //!< The index of the first character to replace.
+    size_type   n1,                 //!< The number of characters to replace.
+    CFStringRef cfstr,              //!< The input string.
+    size_type   pos2 /* = 0 */,     //!< The index of the first character to insert from the input string.
+    size_type   n2 /* = npos */)    //!< The number of characters to insert.
+{
+    n1 = CheckedLength(size(), pos1, n1);
+    n2 = CheckedLength(CFStringGetLength(cfstr), pos2, n2);
+    
+    // Erasing first would lose the erased text if the insertion then failed, so 
+    // insert first.
+    
+    Insert(pos1 + n1, cfstr, pos2, n2);
+    Erase(pos1, n1);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! If @a n2 is @c npos, @a ustr is assumed to be NUL-terminated.
+    
+    @exception  @c std::out_of_range    If @a pos1 > @c size().
+*/
+StringRope&
+StringRope::replace(
+    size_type       pos1,           //!< The index of the first character to replace.
+    size_type       n1,             //!< The number of characters to replace.
+    const UniChar*  ustr,           //!< The input characters.
+    size_type       n2 /* = npos */)//!< The number of characters to insert.
+{
+    n1 = CheckedLength(size(), pos1, n1);
+    
+    insert(pos1 + n1, ustr, n2);
+    Erase(pos1, n1);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  @c std::out_of_range    If @a pos1 > @c size().
+*/
+StringRope&
+StringRope::replace(
+    size_type   pos1,   //!< The index of the first character to replace.
+    size_type   n1,     //!< The number of characters to replace.
+    size_type   n,      //!< The number of occurrences of @a c to insert.
+    UniChar     c)      //!< The character to insert.
+{
+    n1 = CheckedLength(size(), pos1, n1);
+    
+    insert(pos1 + n1, n, c);
+    Erase(pos1, n1);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::size_type
+StringRope::find(
+    UniChar     c,              //!< The character to look for.
+    size_type   pos /* = 0 */)  //!< The index at which to start looking.
+    const
+{
+    return (find(&c, pos, 1));
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::size_type
+StringRope::find(
+    const String&   str,            //!< The string to look for.
+    size_type       pos /* = 0 */)  //!< The index at which to start looking.
+    const
+{
+    return (find(str.cf_ref(), pos));
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::size_type
+StringRope::find(
+    CFStringRef cfstr,          //!< The string to look for.
+    size_type   pos /* = 0 */)  //!< The index at which to start looking.
+    const
+{
+    size_type               n       = CFStringGetLength(cfstr);
+    const UniChar*          ustr    = CFStringGetCharactersPtr(cfstr);
+    std::vector<UniChar>    buff;
+    
+    if ((ustr == NULL) && (n > 0))
+    {
+        buff.resize(n);
+        CFStringGetCharacters(cfstr, CFRangeMake(0, n), &buff[0]);
+        ustr = &buff[0];
+    }
+    
+    return (find(ustr, pos, n));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The search proceeds a chunk at a time, looking for the first character of @a ustr, 
+    and only compares the remaining characters where it occurs.
+    
+    If @a n is @c npos, @a ustr is assumed to be NUL-terminated.
+    
+    @return The index of the first occurrence, or @c npos if there isn't one.
+*/
+StringRope::size_type
+StringRope::find(
+    const UniChar*  ustr,           //!< The characters to look for.
+    size_type       pos /* = 0 */,  //!< The index at which to start looking.
+    size_type       n /* = npos */) //!< The number of characters in @a ustr.
+    const
+{
+    size_type   len = size();
+    
+    if (n == npos)
+    {
+        for (n = 0; ustr[n] != 0; n++)
+            ;
+    }
+    
+    if ((pos > len) || (n > len - pos))
+        return (npos);
+    
+    if (n == 0)
+        return (pos);
+    
+    while (pos + n <= len)
+    {
+        size_type       offset  = pos;
+        const Node*     node    = Locate(offset, false);
+        const UniChar*  begin   = node->mChars + offset;
+        const UniChar*  end     = node->mChars + node->mLength;
+        const UniChar*  hit     = std::find(begin, end, ustr[0]);
+        
+        pos += hit - begin;
+        
+        if (hit == end)
+            continue;
+        
+        if (pos + n > len)
+            break;
+        
+        if (Matches(pos, ustr, n))
+            return (pos);
+        
+        pos++;
+    }
+    
+    return (npos);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The characters are gathered into a single buffer, which the CFString adopts.  The 
+    CFString is kept until the next edit.
+*/
+CFStringRef
+StringRope::cf_ref() const
+{
+    if (mFlat.get() == NULL)
+    {
+        size_type   len = size();
+        
+        if (len == 0)
+        {
+            mFlat.reset(CFSTR(""));
+        }
+        else
+        {
+            UniChar*    buff    = static_cast<UniChar*>(CFAllocatorAllocate(NULL, len * sizeof(UniChar), 0));
+            CFStringRef str;
+            
+            B_THROW_IF_NULL(buff);
+            
+            copy(buff, len, 0);
+            
+            str = CFStringCreateWithCharactersNoCopy(NULL, buff, len, NULL);
+            
+            if (str == NULL)
+                CFAllocatorDeallocate(NULL, buff);
+            
+            mFlat.reset(str, from_copy);
+        }
+    }
+    
+    return (mFlat.get());
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  @c std::out_of_range    If @a pos > @c size().
+*/
+String
+StringRope::substr(
+    size_type   pos /* = 0 */,      //!< The index of the first character.
+    size_type   n /* = npos */)     //!< The number of characters.
+    const
+{
+    n = CheckedLength(size(), pos, n);
+    
+    if (n == 0)
+        return (String());
+    
+    if (n == size())
+        return (str());
+    
+    std::vector<UniChar>    buff(n);
+    
+    copy(&buff[0], n, pos);
+    
+    return (String(&buff[0], n));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @return The number of characters copied.
+    @exception  @c std::out_of_range    If @a pos > @c size().
+*/
+StringRope::size_type
+StringRope::copy(
+    UniChar*    ustr,           //!< The output buffer.
+    size_type   n,              //!< The maximum number of characters to copy.
+    size_type   pos /* = 0 */)  //!< The index of the first character to copy.
+    const
+{
+    n = CheckedLength(size(), pos, n);
+    
+    for (size_type done = 0; done < n; )
+    {
+        size_type   offset  = pos + done;
+        const Node* node    = Locate(offset, false);
+        size_type   count   = std::min(node->mLength - offset, n - done);
+        
+        std::copy(node->mChars + offset, node->mChars + offset + count, ustr + done);
+        done += count;
+    }
+    
+    return (n);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringRope::swap(
+    StringRope& str)    //!< The string to exchange with.
+{
+    std::swap(mRoot, str.mRoot);
+    std::swap(mSeed, str.mSeed);
+    mFlat.swap(str.mFlat);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the number of characters to operate on, given the string's length @a len, 
+    a starting index @a pos and a requested count @a n (which may be @c npos).
+    
+    @exception  @c std::out_of_range    If @a pos > @a len.
+*/
+StringRope::size_type
+StringRope::CheckedLength(
+    size_type   len, 
+    size_type   pos, 
+    size_type   n)
+{
+    B_THROW_IF(pos > len, std::out_of_range("B::StringRope pos out of range"));
+    
+    return (std::min(n, len - pos));
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::size_type
+StringRope::Size(
+    const Node* inNode)
+{
+    return ((inNode != NULL) ? inNode->mSize : 0);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringRope::Update(
+    Node*   ioNode)
+{
+    ioNode->mSize = Size(ioNode->mLeft) + ioNode->mLength + Size(ioNode->mRight);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the node containing the character at index @a ioPos, and sets @a ioPos to the 
+    character's index within the node.  If @a inAtEnd is @c true, an index falling just 
+    past the end of a node's characters may also designate that node (this is used 
+    when looking for a place to insert characters).
+*/
+const StringRope::Node*
+StringRope::Locate(
+    size_type&  ioPos, 
+    bool        inAtEnd) const
+{
+    const Node* node    = mRoot;
+    
+    while (node != NULL)
+    {
+        size_type   leftSize    = Size(node->mLeft);
+        
+        if (ioPos < leftSize)
+        {
+            node = node->mLeft;
+        }
+        else if ((ioPos - leftSize < node->mLength) || 
+                 (inAtEnd && (ioPos - leftSize == node->mLength)))
+        {
+            ioPos -= leftSize;
+            break;
+        }
+        else
+        {
+            ioPos -= leftSize + node->mLength;
+            node   = node->mRight;
+        }
+    }
+    
+    return (node);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Adds @a n to (or, if @a grow is @c false, subtracts @a n from) the sizes of the nodes 
+    on the path that Locate() follows for @a pos, in insertion mode if @a grow is 
+    @c true.  This must be called before the chunk found by Locate() is changed.
+*/
+void
+StringRope::AdjustSizes(
+    size_type   pos, 
+    size_type   n, 
+    bool        grow)
+{
+    Node*   node    = mRoot;
+    
+    while (node != NULL)
+    {
+        size_type   leftSize    = Size(node->mLeft);
+        
+        if (grow)
+            node->mSize += n;
+        else
+            node->mSize -= n;
+        
+        if (pos < leftSize)
+        {
+            node = node->mLeft;
+        }
+        else if ((pos - leftSize < node->mLength) || 
+                 (grow && (pos - leftSize == node->mLength)))
+        {
+            break;
+        }
+        else
+        {
+            pos -= leftSize + node->mLength;
+            node = node->mRight;
+        }
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Inserts the characters into an existing chunk, if one with enough room is found at 
+    @a pos.  This is the common case when typing.
+*/
+bool
+StringRope::InsertInPlace(
+    size_type       pos, 
+    const UniChar*  ustr, 
+    size_type       n)
+{
+    size_type   offset  = pos;
+    Node*       node    = const_cast<Node*>(Locate(offset, true));
+    
+    if ((node == NULL) || (node->mLength + n > kChunkSize))
+        return (false);
+    
+    AdjustSizes(pos, n, true);
+    
+    std::copy_backward(node->mChars + offset, node->mChars + node->mLength, 
+                       node->mChars + node->mLength + n);
+    std::copy(ustr, ustr + n, node->mChars + offset);
+    node->mLength += n;
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Removes the characters from their chunk, if they are all within one chunk and it 
+    doesn't become empty.  This is the common case when deleting while typing.
+*/
+bool
+StringRope::EraseInPlace(
+    size_type   pos, 
+    size_type   n)
+{
+    size_type   offset  = pos;
+    Node*       node    = const_cast<Node*>(Locate(offset, false));
+    
+    if ((node == NULL) || (offset + n > node->mLength) || (n == node->mLength))
+        return (false);
+    
+    AdjustSizes(pos, n, false);
+    
+    std::copy(node->mChars + offset + n, node->mChars + node->mLength, 
+              node->mChars + offset);
+    node->mLength -= n;
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  @c std::out_of_range    If @a pos > @c size().
+*/
+void
+StringRope::Insert(
+    size_type       pos, 
+    const UniChar*  ustr, 
+    size_type       n)
+{
+    B_THROW_IF(pos > size(), std::out_of_range("B::StringRope::insert() pos out of range"));
+    
+    if (n == 0)
+        return;
+    
+    Invalidate();
+    
+    if (InsertInPlace(pos, ustr, n))
+        return;
+    
+    // Build the new chunks first, so that a failure leaves the tree untouched.
+    
+    Node*   middle  = Build(ustr, n);
+    Node*   left;
+    Node*   right;
+    
+    try
+    {
+        Split(mRoot, pos, left, right);
+    }
+    catch (...)
+    {
+        Destroy(middle);
+        throw;
+    }
+    
+    mRoot = Merge(Merge(left, middle), right);
+    
+    CoalesceAround(pos);
+    CoalesceAround(pos + n);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  @c std::out_of_range    If @a pos > @c size() or @a pos2 > the length of @a cfstr.
+*/
+void
+StringRope::Insert(
+    size_type   pos, 
+    CFStringRef cfstr, 
+    size_type   pos2, 
+    size_type   n)
+{
+    B_ASSERT(cfstr != NULL);
+    
+    n = CheckedLength(CFStringGetLength(cfstr), pos2, n);
+    
+    const UniChar*          ustr    = CFStringGetCharactersPtr(cfstr);
+    std::vector<UniChar>    buff;
+    
+    if (ustr != NULL)
+    {
+        ustr += pos2;
+    }
+    else if (n > 0)
+    {
+        buff.resize(n);
+        CFStringGetCharacters(cfstr, CFRangeMake(pos2, n), &buff[0]);
+        ustr = &buff[0];
+    }
+    
+    Insert(pos, ustr, n);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @a pos and @a n must describe a valid range.
+*/
+void
+StringRope::Erase(
+    size_type   pos, 
+    size_type   n)
+{
+    if (n == 0)
+        return;
+    
+    Invalidate();
+    
+    if (EraseInPlace(pos, n))
+    {
+        CoalesceAround(pos);
+        return;
+    }
+    
+    Node*   left;
+    Node*   middle;
+    Node*   right;
+    
+    // Splitting may need to allocate a node when a boundary falls within a chunk.  
+    // If the second split fails, put things back the way they were.
+    
+    Split(mRoot, pos, left, right);
+    
+    try
+    {
+        Split(right, n, middle, right);
+    }
+    catch (...)
+    {
+        mRoot = Merge(left, right);
+        throw;
+    }
+    
+    Destroy(middle);
+    mRoot = Merge(left, right);
+    
+    CoalesceAround(pos);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns @c true if the @a n characters starting at index @a pos are equal to those of 
+    @a ustr.  The range must be valid.
+*/
+bool
+StringRope::Matches(
+    size_type       pos, 
+    const UniChar*  ustr, 
+    size_type       n) const
+{
+    for (size_type done = 0; done < n; )
+    {
+        size_type   offset  = pos + done;
+        const Node* node    = Locate(offset, false);
+        size_type   count   = std::min(node->mLength - offset, n - done);
+        
+        if (!std::equal(node->mChars + offset, node->mChars + offset + count, ustr + done))
+            return (false);
+        
+        done += count;
+    }
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::Node*
+StringRope::NewNode(
+    const UniChar*  ustr, 
+    size_type       n)
+{
+    B_ASSERT(n <= kChunkSize);
+    
+    Node*   node    = new Node;
+    
+    // A simple xorshift generator is plenty for the purpose of balancing the tree.
+    
+    mSeed ^= mSeed << 13;
+    mSeed ^= mSeed >> 17;
+    mSeed ^= mSeed << 5;
+    
+    node->mLeft     = NULL;
+    node->mRight    = NULL;
+    node->mPriority = mSeed;
+    node->mSize     = n;
+    node->mLength   = n;
+    
+    std::copy(ustr, ustr + n, node->mChars);
+    
+    return (node);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns a tree holding the @a n characters of @a ustr.
+*/
+StringRope::Node*
+StringRope::Build(
+    const UniChar*  ustr, 
+    size_type       n)
+{
+    Node*   tree    = NULL;
+    
+    try
+    {
+        for (size_type done = 0; done < n; )
+        {
+            size_type   count   = std::min(n - done, kChunkSize);
+            
+            tree  = Merge(tree, NewNode(ustr + done, count));
+            done += count;
+        }
+    }
+    catch (...)
+    {
+        Destroy(tree);
+        throw;
+    }
+    
+    return (tree);
+}
+
+// ------------------------------------------------------------------------------------------
+StringRope::Node*
+StringRope::Clone(
+    const Node* inNode)
+{
+    if (inNode == NULL)
+        return (NULL);
+    
+    Node*   node    = new Node(*inNode);
+    
+    node->mLeft     = NULL;
+    node->mRight    = NULL;
+    
+    try
+    {
+        node->mLeft     = Clone(inNode->mLeft);
+        node->mRight    = Clone(inNode->mRight);
+    }
+    catch (...)
+    {
+        Destroy(node);
+        throw;
+    }
+    
+    return (node);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Splits the tree rooted at @a inNode into a tree holding its first @a pos characters 
+    (@a outLeft) and one holding the rest (@a outRight).  The only allocation happens 
+    before anything is modified, so the tree is left intact if it fails.
+*/
+void
+StringRope::Split(
+    Node*       inNode, 
+    size_type   pos, 
+    Node*&      outLeft, 
+    Node*&      outRight)
+{
+    if (inNode == NULL)
+    {
+        outLeft = outRight = NULL;
+        return;
+    }
+    
+    size_type   leftSize    = Size(inNode->mLeft);
+    
+    if (pos <= leftSize)
+    {
+        Split(inNode->mLeft, pos, outLeft, inNode->mLeft);
+        Update(inNode);
+        outRight = inNode;
+    }
+    else if (pos >= leftSize + inNode->mLength)
+    {
+        Split(inNode->mRight, pos - leftSize - inNode->mLength, inNode->mRight, outRight);
+        Update(inNode);
+        outLeft = inNode;
+    }
+    else
+    {
+        // The split falls within this node's chunk.  The tail of the chunk moves to a 
+        // new node, which heads the right-hand tree.
+        
+        size_type   offset  = pos - leftSize;
+        Node*       tail    = NewNode(inNode->mChars + offset, inNode->mLength - offset);
+        Node*       right   = inNode->mRight;
+        
+        inNode->mLength = offset;
+        inNode->mRight  = NULL;
+        Update(inNode);
+        
+        outLeft     = inNode;
+        outRight    = Merge(tail, right);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Coalesces the chunks on either side of index @a pos, ie the chunks holding the 
+    characters at @a pos - 1 and @a pos.  Called after an edit at @a pos.
+*/
+void
+StringRope::CoalesceAround(
+    size_type   pos)
+{
+    if ((pos > 0) && (pos - 1 < size()))
+        Coalesce(pos - 1);
+    
+    if (pos < size())
+        Coalesce(pos);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Merges the chunk holding the character at index @a pos with its neighbours, for as 
+    long as one of a pair of neighbouring chunks has fewer than kMinFill characters and 
+    their combined characters fit into one chunk.  @a pos must be less than size().
+    
+    This never allocates, and so never throws.
+*/
+void
+StringRope::Coalesce(
+    size_type   pos)
+{
+    for (;;)
+    {
+        size_type   offset  = pos;
+        const Node* node    = Locate(offset, false);
+        size_type   start   = pos - offset;
+        size_type   end     = start + node->mLength;
+        
+        if (start > 0)
+        {
+            size_type   prevOffset  = start - 1;
+            const Node* prev        = Locate(prevOffset, false);
+            
+            if (Mergeable(prev, node))
+            {
+                Rejoin(start);
+                continue;
+            }
+        }
+        
+        if (end < size())
+        {
+            size_type   nextOffset  = end;
+            const Node* next        = Locate(nextOffset, false);
+            
+            if (Mergeable(node, next))
+            {
+                Rejoin(end);
+                continue;
+            }
+        }
+        
+        break;
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Splits the tree at index @a pos and puts it back together with Join(), thereby 
+    merging the chunks on either side of @a pos if appropriate.  @a pos must fall on a 
+    chunk boundary, so that Split() doesn't allocate.
+*/
+void
+StringRope::Rejoin(
+    size_type   pos)
+{
+    Node*   left;
+    Node*   right;
+    
+    Split(mRoot, pos, left, right);
+    
+    mRoot = Join(left, right);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Concatenates the trees rooted at @a inLeft and @a inRight, like Merge().  But first, 
+    for as long as the last chunk of @a inLeft and the first chunk of @a inRight fit 
+    into one chunk, and one of them has fewer than kMinFill characters (see 
+    Mergeable()), the latter's characters are moved into the former, and it is deleted.
+*/
+StringRope::Node*
+StringRope::Join(
+    Node*   inLeft, 
+    Node*   inRight)
+{
+    Node*   last    = inLeft;
+    
+    while ((last != NULL) && (last->mRight != NULL))
+        last = last->mRight;
+    
+    while ((last != NULL) && (inRight != NULL))
+    {
+        const Node* first   = inRight;
+        
+        while (first->mLeft != NULL)
+            first = first->mLeft;
+        
+        if (!Mergeable(last, first))
+            break;
+        
+        Node*   removed;
+        
+        inRight = RemoveFirst(inRight, removed);
+        
+        std::copy(removed->mChars, removed->mChars + removed->mLength, 
+                  last->mChars + last->mLength);
+        last->mLength += removed->mLength;
+        
+        // last is at the end of inLeft's right spine, so only that spine's sizes change.
+        
+        for (Node* node = inLeft; node != NULL; node = node->mRight)
+            node->mSize += removed->mLength;
+        
+        delete removed;
+    }
+    
+    return (Merge(inLeft, inRight));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns @c true if the chunks of @a inLeft and @a inRight, which are neighbours, 
+    should be merged into one.
+*/
+bool
+StringRope::Mergeable(
+    const Node* inLeft, 
+    const Node* inRight)
+{
+    return ((inLeft->mLength + inRight->mLength <= kChunkSize) && 
+            ((inLeft->mLength < kMinFill) || (inRight->mLength < kMinFill)));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Detaches the node holding the first chunk of the tree rooted at @a inNode, and 
+    returns it in @a outFirst.  The node's right subtree stays in the tree.  Returns 
+    the tree's new root.
+*/
+StringRope::Node*
+StringRope::RemoveFirst(
+    Node*   inNode, 
+    Node*&  outFirst)
+{
+    if (inNode->mLeft == NULL)
+    {
+        outFirst = inNode;
+        
+        return (inNode->mRight);
+    }
+    
+    inNode->mLeft    = RemoveFirst(inNode->mLeft, outFirst);
+    inNode->mSize   -= outFirst->mLength;
+    
+    return (inNode);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Concatenates the trees rooted at @a inLeft and @a inRight.
+*/
+StringRope::Node*
+StringRope::Merge(
+    Node*   inLeft, 
+    Node*   inRight)
+{
+    if (inLeft == NULL)
+        return (inRight);
+    
+    if (inRight == NULL)
+        return (inLeft);
+    
+    if (inLeft->mPriority > inRight->mPriority)
+    {
+        inLeft->mRight = Merge(inLeft->mRight, inRight);
+        Update(inLeft);
+        
+        return (inLeft);
+    }
+    else
+    {
+        inRight->mLeft = Merge(inLeft, inRight->mLeft);
+        Update(inRight);
+        
+        return (inRight);
+    }
+}
+
+// ------------------------------------------------------------------------------------------
+void
+StringRope::Destroy(
+    Node*   inNode)
+{
+    if (inNode != NULL)
+    {
+        Destroy(inNode->mLeft);
+        Destroy(inNode->mRight);
+        delete inNode;
+    }
+}
+
+}   // namespace B
@@ -0,0 +1,255 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BStringRope_H_
+#define BStringRope_H_
+
+#pragma once
+
+// system headers
+#include <CoreFoundation/CFString.h>
+
+// B headers
+#include "BOSPtr.h"
+#include "BString.h"
+
+
+namespace B {
+
+// forward declarations
+class   MutableString;
+
+/*!
+    @brief  A mutable string that stays fast to edit when it gets large.
+    
+    MutableString keeps its characters in one contiguous @c CFMutableStringRef, so 
+    inserting or removing characters anywhere but at the end moves everything that 
+    follows.  On strings of several megabytes, a sequence of such edits (eg typing in 
+    the middle of a document, or a search-and-replace pass) becomes quadratic.
+    
+    StringRope has the same editing interface as MutableString (append(), insert(), 
+    erase(), replace(), find(), etc.), but keeps its characters in a balanced tree of 
+    chunks of up to kChunkSize characters each.  Edits cost O(log n) plus the size 
+    of the edited text:  small edits are made in place within a chunk, and larger ones 
+    split the tree at the edit's boundaries and splice in new chunks.  After an edit, 
+    a chunk left with fewer than kMinFill characters is merged with its neighbours if 
+    their characters fit in one chunk, so that erasing and splitting don't gradually 
+    fill the tree with nearly empty chunks.
+    
+    The characters are only gathered into a contiguous CFString when one is asked for, 
+    via cf_ref() or str().  The resulting CFString is cached until the next edit, 
+    so asking repeatedly between edits is cheap.
+    
+    @note   The @c CFStringRef returned by cf_ref() is owned by the StringRope, and 
+            becomes invalid at the next edit.  Use str() to hold on to the contents.
+    
+    @ingroup    Utilities
+*/
+class StringRope
+{
+public:
+    
+    //! @name Types
+    //@{
+    typedef String::value_type  value_type;     //!< The type of the characters.
+    typedef String::size_type   size_type;      //!< The unsigned integral type for size values and indices.
+    //@}
+    
+    //! @name Constants
+    //@{
+    //! Sentinel value meaning "not found" or "all remaining characters"
+    static const size_type  npos        = String::npos;
+    //! The maximum number of characters held in one chunk.
+    static const size_type  kChunkSize  = 256;
+    //! Chunks holding fewer characters are merged with their neighbours, where they fit.
+    static const size_type  kMinFill    = kChunkSize / 2;
+    //@}
+    
+    //! @name Constructors / Destructor
+    //@{
+    //! Default constructor.
+                StringRope();
+    //! Copy constructor.
+                StringRope(const StringRope& str);
+    //! String constructor.
+    explicit    StringRope(const String& str);
+    //! MutableString constructor.
+    explicit    StringRope(const MutableString& str);
+    //! @c CFStringRef constructor.
+    explicit    StringRope(CFStringRef cfstr);
+    //! @c UniChar array constructor.
+    explicit    StringRope(const UniChar* ustr, size_type n = npos);
+    //! Destructor.
+                ~StringRope();
+    //@}
+    
+    //! @name Assignment
+    //@{
+    //! StringRope assignment.
+    StringRope& operator = (const StringRope& str);
+    //! String assignment.
+    StringRope& operator = (const String& str);
+    //! @c CFStringRef assignment.
+    StringRope& operator = (CFStringRef cfstr);
+    //@}
+    
+    //! @name Size
+    //@{
+    //! Returns the number of characters in the string.
+    size_type   size() const    { return (Size(mRoot)); }
+    //! Returns the number of characters in the string.
+    size_type   length() const  { return (Size(mRoot)); }
+    //! Returns @c true if the string is empty.
+    bool        empty() const   { return (mRoot == NULL); }
+    //! Returns the maximum possible number of characters in the string.
+    size_type   max_size() const;
+    //@}
+    
+    //! @name Element Access
+    //@{
+    //! Returns the character at index @a pos.
+    UniChar     operator [] (size_type pos) const;
+    //! Returns the character at index @a pos, with range checking.
+    UniChar     at(size_type pos) const;
+    //@}
+    
+    //! @name Appending
+    //@{
+    //! Appends characters from @a str.
+    StringRope& append(const String& str, size_type pos = 0, size_type n = npos);
+    //! Appends characters from @a cfstr.
+    StringRope& append(CFStringRef cfstr, size_type pos = 0, size_type n = npos);
+    //! Appends @a n characters from @a ustr.
+    StringRope& append(const UniChar* ustr, size_type n = npos);
+    //! Appends @a n occurrences of @a c.
+    StringRope& append(size_type n, UniChar c);
+    //! Appends @a c.
+    void        push_back(UniChar c)                { append(1, c); }
+    //! Appends @a str.
+    StringRope& operator += (const String& str)     { return (append(str)); }
+    //! Appends @a c.
+    StringRope& operator += (UniChar c)             { return (append(1, c)); }
+    //@}
+    
+    //! @name Inserting
+    //@{
+    //! Inserts characters from @a str at index @a pos1.
+    StringRope& insert(size_type pos1, const String& str, size_type pos2 = 0, size_type n = npos);
+    //! Inserts characters from @a cfstr at index @a pos1.
+    StringRope& insert(size_type pos1, CFStringRef cfstr, size_type pos2 = 0, size_type n = npos);
+    //! Inserts @a n characters from @a ustr at index @a pos.
+    StringRope& insert(size_type pos, const UniChar* ustr, size_type n = npos);
+    //! Inserts @a n occurrences of @a c at index @a pos.
+    StringRope& insert(size_type pos, size_type n, UniChar c);
+    //@}
+    
+    //! @name Erasing
+    //@{
+    //! Erases all characters.
+    void        clear();
+    //! Erases, at most, @a n characters starting at index @a pos.
+    StringRope& erase(size_type pos = 0, size_type n = npos);
+    //@}
+    
+    //! @name Replacing
+    //@{
+    //! Replaces, at most, @a n1 characters starting at @a pos1 with characters from @a str.
+    StringRope& replace(size_type pos1, size_type n1, const String& str, size_type pos2 = 0, size_type n2 = npos);
+    //! Replaces, at most, @a n1 characters starting at @a pos1 with characters from @a cfstr.
+    StringRope& replace(size_type pos1, size_type n1, CFStringRef cfstr, size_type pos2 = 0, size_type n2 = npos);
+    //! Replaces, at most, @a n1 characters starting at @a pos1 with @a n2 characters from @a ustr.
+    StringRope& replace(size_type pos1, size_type n1, const UniChar* ustr, size_type n2 = npos);
+    //! Replaces, at most, @a n1 characters starting at @a pos1 with @a n occurrences of @a c.
+    StringRope& replace(size_type pos1, size_type n1, size_type n, UniChar c);
+    //@}
+    
+    //! @name Searching
+    //@{
+    //! Returns the index of the first occurrence of @a c at or after @a pos.
+    size_type   find(UniChar c, size_type pos = 0) const;
+    //! Returns the index of the first occurrence of @a str at or after @a pos.
+    size_type   find(const String& str, size_type pos = 0) const;
+    //! Returns the index of the first occurrence of @a cfstr at or after @a pos.
+    size_type   find(CFStringRef cfstr, size_type pos = 0) const;
+    //! Returns the index of the first occurrence of the @a n characters of @a ustr at or after @a pos.
+    size_type   find(const UniChar* ustr, size_type pos = 0, size_type n = npos) const;
+    //@}
+    
+    //! @name Conversions
+    //@{
+    //! Returns the contents as a @c CFStringRef, valid until the next edit.
+    CFStringRef cf_ref() const;
+    //! Returns the contents as a String.
+    String      str() const     { return (String(cf_ref())); }
+    //! Returns, at most, @a n characters starting at index @a pos.
+    String      substr(size_type pos = 0, size_type n = npos) const;
+    //! Copies, at most, @a n characters starting at index @a pos into @a ustr.
+    size_type   copy(UniChar* ustr, size_type n, size_type pos = 0) const;
+    //@}
+    
+    //! @name Miscellaneous
+    //@{
+    //! Exchanges the contents of @c *this and @a str.
+    void        swap(StringRope& str);
+    //@}
+    
+private:
+    
+    struct Node;
+    
+    void            Insert(size_type pos, const UniChar* ustr, size_type n);
+    void            Insert(size_type pos, CFStringRef cfstr, size_type pos2, size_type n);
+    void            Erase(size_type pos, size_type n);
+    bool            InsertInPlace(size_type pos, const UniChar* ustr, size_type n);
+    bool            EraseInPlace(size_type pos, size_type n);
+    void            AdjustSizes(size_type pos, size_type n, bool grow);
+    const Node*     Locate(size_type& ioPos, bool inAtEnd) const;
+    bool            Matches(size_type pos, const UniChar* ustr, size_type n) const;
+    Node*           NewNode(const UniChar* ustr, size_type n);
+    Node*           Build(const UniChar* ustr, size_type n);
+    Node*           Clone(const Node* inNode);
+    void            Split(Node* inNode, size_type pos, Node*& outLeft, Node*& outRight);
+    void            CoalesceAround(size_type pos);
+    void            Coalesce(size_type pos);
+    void            Rejoin(size_type pos);
+    void            Invalidate()    { mFlat.reset(); }
+    
+    static size_type    Size(const Node* inNode);
+    static void         Update(Node* ioNode);
+    static Node*        Merge(Node* inLeft, Node* inRight);
+    static Node*        Join(Node* inLeft, Node* inRight);
+    static Node*        RemoveFirst(Node* inNode, Node*& outFirst);
+    static bool         Mergeable(const Node* inLeft, const Node* inRight);
+    static void         Destroy(Node* inNode);
+    static size_type    CheckedLength(size_type len, size_type pos, size_type n);
+    
+    // member variables
+    Node*                       mRoot;
+    UInt32                      mSeed;  //!< For the nodes' random priorities.
+    mutable OSPtr<CFStringRef>  mFlat;  //!< The contents, once cf_ref() has been called.
+};
+
+// ------------------------------------------------------------------------------------------
+/*! @relates    StringRope
+*/
+inline void swap(StringRope& s1, StringRope& s2)    { s1.swap(s2); }
+
+}   // namespace B
+
+
+#endif  // BStringRope_H_
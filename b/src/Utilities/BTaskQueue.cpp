@@ -0,0 +1,272 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BTaskQueue.h"
+
+// standard headers
+#include <algorithm>
+#include <memory>
+
+// system headers
+#include <sys/time.h>
+
+// B headers
+#include "BAtomic.h"
+
+
+namespace B {
+
+// ==========================================================================================
+//  TaskQueue::Node
+
+struct TaskQueue::Node
+{
+    Node(const Task& inTask, double inTime)
+        : mNext(NULL), mTask(inTask), mTime(inTime) {}
+    
+    Node* volatile  mNext;
+    Task            mTask;
+    double          mTime;      //!< When the task was posted.
+};
+
+
+// ==========================================================================================
+//  TaskQueue
+
+#pragma mark TaskQueue
+
+// ------------------------------------------------------------------------------------------
+TaskQueue::TaskQueue(
+    size_t  inCapacity)     //!< The maximum number of waiting tasks;  zero means unbounded.
+        : mDepth(0), mPostedCount(0), mRejectedCount(0), mCapacity(inCapacity),
+          mExecutedCount(0), mMaxDepth(0), mTotalLatency(0.0), mMaxLatency(0.0)
+{
+    mStub   = new Node(Task(), 0.0);
+    mHead   = mStub;
+    mTail   = mStub;
+}
+
+// ------------------------------------------------------------------------------------------
+TaskQueue::~TaskQueue()
+{
+    Node*   node;
+    
+    while ((node = Pop()) != NULL)
+        delete node;
+    
+    delete mStub;
+}
+
+// ------------------------------------------------------------------------------------------
+/*! May be called from any thread.
+    
+    @return @c true if the task was queued, @c false if the queue was full.
+*/
+bool
+TaskQueue::Post(
+    const Task& inTask)     //!< The task to run.
+{
+    bool    wasEmpty;
+    
+    return (Post(inTask, wasEmpty));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! May be called from any thread.
+    
+    @a outWasEmpty is set to @c true if this is the only waiting task.  Clients that
+    need to wake up the consumer only need to do so in that case.
+    
+    @return @c true if the task was queued, @c false if the queue was full.
+*/
+bool
+TaskQueue::Post(
+    const Task& inTask,         //!< The task to run.
+    bool&       outWasEmpty)    //!< Set to @c true if the queue was empty beforehand.
+{
+    // Reserve a slot first, so that the queue never grows past its capacity.
+    
+    int32_t depth   = AtomicAdd(&mDepth, 1);
+    
+    if ((mCapacity > 0) && (static_cast<size_t>(depth) > mCapacity))
+    {
+        AtomicAdd(&mDepth, -1);
+        AtomicAdd(&mRejectedCount, 1);
+        outWasEmpty = false;
+        
+        return (false);
+    }
+    
+    try
+    {
+        Push(new Node(inTask, GetTime()));
+    }
+    catch (...)
+    {
+        AtomicAdd(&mDepth, -1);
+        throw;
+    }
+    
+    AtomicAdd(&mPostedCount, 1);
+    outWasEmpty = (depth == 1);
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Must only be called from the consumer thread.
+    
+    If a task throws an exception, the exception propagates to the caller;  the
+    remaining tasks stay in the queue.
+    
+    @return The number of tasks run.
+*/
+size_t
+TaskQueue::Drain(
+    size_t  inMaxTasks)     //!< The maximum number of tasks to run;  zero means no limit.
+{
+    size_t  count   = 0;
+    
+    mMaxDepth = std::max(mMaxDepth, size());
+    
+    while ((inMaxTasks == 0) || (count < inMaxTasks))
+    {
+        std::auto_ptr<Node> node(Pop());
+        
+        if (node.get() == NULL)
+            break;
+        
+        double  latency = GetTime() - node->mTime;
+        
+        mTotalLatency  += latency;
+        mMaxLatency     = std::max(mMaxLatency, latency);
+        mExecutedCount++;
+        count++;
+        
+        AtomicAdd(&mDepth, -1);
+        
+        node->mTask();
+    }
+    
+    return (count);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Must only be called from the consumer thread.
+*/
+TaskQueue::Statistics
+TaskQueue::GetStatistics() const
+{
+    Statistics  stats;
+    
+    stats.mPostedCount      = mPostedCount;
+    stats.mExecutedCount    = mExecutedCount;
+    stats.mRejectedCount    = mRejectedCount;
+    stats.mMaxDepth         = mMaxDepth;
+    stats.mMeanLatency      = (mExecutedCount > 0) ? mTotalLatency / mExecutedCount : 0.0;
+    stats.mMaxLatency       = mMaxLatency;
+    
+    return (stats);
+}
+
+// ------------------------------------------------------------------------------------------
+size_t
+TaskQueue::size() const
+{
+    int32_t depth   = mDepth;
+    
+    return ((depth > 0) ? depth : 0);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+TaskQueue::Push(
+    Node*   inNode)
+{
+    Node*   prev;
+    
+    inNode->mNext   = NULL;
+    prev            = static_cast<Node*>(AtomicExchangePtr(
+                            reinterpret_cast<void* volatile*>(&mHead), inNode));
+    
+    // Between the exchange above and the store below, the queue is momentarily
+    // disconnected;  Pop() will see the end of the list at prev.
+    
+    AtomicStorePtr(reinterpret_cast<void* volatile*>(&prev->mNext), inNode);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @return The oldest node, or @c NULL if none is (yet) available.
+*/
+TaskQueue::Node*
+TaskQueue::Pop()
+{
+    Node*   tail    = mTail;
+    Node*   next    = tail->mNext;
+    
+    if (tail == mStub)
+    {
+        if (next == NULL)
+            return (NULL);
+        
+        mTail   = next;
+        tail    = next;
+        next    = next->mNext;
+    }
+    
+    if (next != NULL)
+    {
+        mTail = next;
+        return (tail);
+    }
+    
+    if (tail != mHead)
+    {
+        // A producer is in the middle of Push().
+        return (NULL);
+    }
+    
+    // tail is the last node.  Re-insert the stub behind it, so that tail can be
+    // detached from the list.
+    
+    Push(mStub);
+    
+    next = tail->mNext;
+    
+    if (next != NULL)
+    {
+        mTail = next;
+        return (tail);
+    }
+    
+    return (NULL);
+}
+
+// ------------------------------------------------------------------------------------------
+double
+TaskQueue::GetTime()
+{
+    struct timeval  tv;
+    
+    gettimeofday(&tv, NULL);
+    
+    return (tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+}   // namespace B
@@ -0,0 +1,150 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BTaskQueue_H_
+#define BTaskQueue_H_
+
+#pragma once
+
+// standard headers
+#include <stddef.h>
+#include <stdint.h>
+
+// library headers
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+
+
+namespace B {
+
+/*!
+    @brief  A lock-free, multiple-producer / single-consumer queue of tasks.
+    
+    Any number of threads may call Post() concurrently;  a single thread (the consumer)
+    calls Drain() to run the tasks, in the order in which they were posted.  Posting
+    never blocks:  producers only ever perform a single atomic exchange to link their
+    task into the queue, regardless of how many other producers are active.
+    
+    The queue may be given a capacity, in which case Post() fails (rather than blocks)
+    when that many tasks are already waiting.  This gives producers a way to apply
+    back-pressure, for example by coalescing their results or by dropping them.
+    
+    The queue also keeps statistics about its use:  the number of tasks posted, run and
+    rejected, the maximum depth observed by the consumer, and the time elapsed between
+    the posting of tasks and their execution.
+    
+    TaskQueue is independent of the event loop, and of the Mac OS;  MainThreadExecutor
+    layers it onto the main Carbon %Event loop.
+    
+    @note   The algorithm is Dmitry Vyukov's intrusive MPSC queue.  A consequence of
+            its design is that a task being posted may be momentarily invisible to the
+            consumer, even though size() already accounts for it.  Drain() simply stops
+            in that case;  the task will be picked up by the next call.
+    
+    @sa         MainThreadExecutor
+    @ingroup    Utilities
+*/
+class TaskQueue : public boost::noncopyable
+{
+public:
+    
+    //! @name Types
+    //@{
+    //! The type of tasks.
+    typedef boost::function0<void>  Task;
+    
+    //! Usage statistics.
+    struct Statistics
+    {
+        //! The number of tasks that were accepted by Post().
+        size_t  mPostedCount;
+        //! The number of tasks that were run by Drain().
+        size_t  mExecutedCount;
+        //! The number of tasks that were refused by Post() because the queue was full.
+        size_t  mRejectedCount;
+        //! The largest number of waiting tasks observed by Drain().
+        size_t  mMaxDepth;
+        //! The average time, in seconds, between posting a task and running it.
+        double  mMeanLatency;
+        //! The longest time, in seconds, between posting a task and running it.
+        double  mMaxLatency;
+    };
+    //@}
+    
+    //! @name Constructor & Destructor
+    //@{
+    //! Constructor.  A capacity of zero means the queue is unbounded.
+    explicit    TaskQueue(size_t inCapacity = 0);
+    //! Destructor.  Tasks that haven't been run are discarded.
+                ~TaskQueue();
+    //@}
+    
+    //! @name Producer Functions
+    //@{
+    //! Appends @a inTask to the queue.  Returns @c false if the queue is full.
+    bool        Post(const Task& inTask);
+    //! Appends @a inTask to the queue, and indicates whether the queue was empty beforehand.
+    bool        Post(const Task& inTask, bool& outWasEmpty);
+    //@}
+    
+    //! @name Consumer Functions
+    //@{
+    //! Runs up to @a inMaxTasks tasks (all of them if zero).  Returns the number of tasks run.
+    size_t      Drain(size_t inMaxTasks = 0);
+    //! Returns the usage statistics.
+    Statistics  GetStatistics() const;
+    //@}
+    
+    //! @name Inquiries
+    //@{
+    //! Returns the maximum number of waiting tasks, or zero if the queue is unbounded.
+    size_t      capacity() const    { return (mCapacity); }
+    //! Returns the number of waiting tasks.  The value may be stale by the time it's used.
+    size_t      size() const;
+    //! Returns @c true if no tasks are waiting.  The value may be stale by the time it's used.
+    bool        empty() const       { return (size() == 0); }
+    //@}
+
+private:
+    
+    struct Node;
+    
+    void    Push(Node* inNode);
+    Node*   Pop();
+    
+    static double   GetTime();
+    
+    // member variables (shared)
+    Node* volatile      mHead;          //!< The most recently pushed node.
+    volatile int32_t    mDepth;         //!< The number of accepted tasks that haven't run yet.
+    volatile int32_t    mPostedCount;
+    volatile int32_t    mRejectedCount;
+    const size_t        mCapacity;
+    // member variables (consumer only)
+    Node*               mTail;          //!< The next node to pop.
+    Node*               mStub;
+    size_t              mExecutedCount;
+    size_t              mMaxDepth;
+    double              mTotalLatency;
+    double              mMaxLatency;
+};
+
+}   // namespace B
+
+
+#endif  // BTaskQueue_H_
@@ -0,0 +1,472 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BTranscoding.h"
+
+// standard headers
+#include <algorithm>
+#include <string.h>
+
+// system headers
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+
+
+namespace {
+
+/*! Maps the upper half of Mac OS Roman onto Unicode.  This is Apple's current table, 
+    in which 0xDB is the euro sign.
+*/
+const uint16_t  kMacRomanToUnicode[128] = {
+    0x00C4, 0x00C5, 0x00C7, 0x00C9, 0x00D1, 0x00D6, 0x00DC, 0x00E1,
+    0x00E0, 0x00E2, 0x00E4, 0x00E3, 0x00E5, 0x00E7, 0x00E9, 0x00E8,
+    0x00EA, 0x00EB, 0x00ED, 0x00EC, 0x00EE, 0x00EF, 0x00F1, 0x00F3,
+    0x00F2, 0x00F4, 0x00F6, 0x00F5, 0x00FA, 0x00F9, 0x00FB, 0x00FC,
+    0x2020, 0x00B0, 0x00A2, 0x00A3, 0x00A7, 0x2022, 0x00B6, 0x00DF,
+    0x00AE, 0x00A9, 0x2122, 0x00B4, 0x00A8, 0x2260, 0x00C6, 0x00D8,
+    0x221E, 0x00B1, 0x2264, 0x2265, 0x00A5, 0x00B5, 0x2202, 0x2211,
+    0x220F, 0x03C0, 0x222B, 0x00AA, 0x00BA, 0x03A9, 0x00E6, 0x00F8,
+    0x00BF, 0x00A1, 0x00AC, 0x221A, 0x0192, 0x2248, 0x2206, 0x00AB,
+    0x00BB, 0x2026, 0x00A0, 0x00C0, 0x00C3, 0x00D5, 0x0152, 0x0153,
+    0x2013, 0x2014, 0x201C, 0x201D, 0x2018, 0x2019, 0x00F7, 0x25CA,
+    0x00FF, 0x0178, 0x2044, 0x20AC, 0x2039, 0x203A, 0xFB01, 0xFB02,
+    0x2021, 0x00B7, 0x201A, 0x201E, 0x2030, 0x00C2, 0x00CA, 0x00C1,
+    0x00CB, 0x00C8, 0x00CD, 0x00CE, 0x00CF, 0x00CC, 0x00D3, 0x00D4,
+    0xF8FF, 0x00D2, 0x00DA, 0x00DB, 0x00D9, 0x0131, 0x02C6, 0x02DC,
+    0x00AF, 0x02D8, 0x02D9, 0x02DA, 0x00B8, 0x02DD, 0x02DB, 0x02C7
+};
+
+struct UnicodeToMacRoman
+{
+    uint16_t    mUnicode;
+    uint8_t     mByte;
+};
+
+//! The inverse of kMacRomanToUnicode, sorted by Unicode value.
+const UnicodeToMacRoman kUnicodeToMacRoman[128] = {
+    { 0x00A0, 0xCA }, { 0x00A1, 0xC1 }, { 0x00A2, 0xA2 }, { 0x00A3, 0xA3 },
+    { 0x00A5, 0xB4 }, { 0x00A7, 0xA4 }, { 0x00A8, 0xAC }, { 0x00A9, 0xA9 },
+    { 0x00AA, 0xBB }, { 0x00AB, 0xC7 }, { 0x00AC, 0xC2 }, { 0x00AE, 0xA8 },
+    { 0x00AF, 0xF8 }, { 0x00B0, 0xA1 }, { 0x00B1, 0xB1 }, { 0x00B4, 0xAB },
+    { 0x00B5, 0xB5 }, { 0x00B6, 0xA6 }, { 0x00B7, 0xE1 }, { 0x00B8, 0xFC },
+    { 0x00BA, 0xBC }, { 0x00BB, 0xC8 }, { 0x00BF, 0xC0 }, { 0x00C0, 0xCB },
+    { 0x00C1, 0xE7 }, { 0x00C2, 0xE5 }, { 0x00C3, 0xCC }, { 0x00C4, 0x80 },
+    { 0x00C5, 0x81 }, { 0x00C6, 0xAE }, { 0x00C7, 0x82 }, { 0x00C8, 0xE9 },
+    { 0x00C9, 0x83 }, { 0x00CA, 0xE6 }, { 0x00CB, 0xE8 }, { 0x00CC, 0xED },
+    { 0x00CD, 0xEA }, { 0x00CE, 0xEB }, { 0x00CF, 0xEC }, { 0x00D1, 0x84 },
+    { 0x00D2, 0xF1 }, { 0x00D3, 0xEE }, { 0x00D4, 0xEF }, { 0x00D5, 0xCD },
+    { 0x00D6, 0x85 }, { 0x00D8, 0xAF }, { 0x00D9, 0xF4 }, { 0x00DA, 0xF2 },
+    { 0x00DB, 0xF3 }, { 0x00DC, 0x86 }, { 0x00DF, 0xA7 }, { 0x00E0, 0x88 },
+    { 0x00E1, 0x87 }, { 0x00E2, 0x89 }, { 0x00E3, 0x8B }, { 0x00E4, 0x8A },
+    { 0x00E5, 0x8C }, { 0x00E6, 0xBE }, { 0x00E7, 0x8D }, { 0x00E8, 0x8F },
+    { 0x00E9, 0x8E }, { 0x00EA, 0x90 }, { 0x00EB, 0x91 }, { 0x00EC, 0x93 },
+    { 0x00ED, 0x92 }, { 0x00EE, 0x94 }, { 0x00EF, 0x95 }, { 0x00F1, 0x96 },
+    { 0x00F2, 0x98 }, { 0x00F3, 0x97 }, { 0x00F4, 0x99 }, { 0x00F5, 0x9B },
+    { 0x00F6, 0x9A }, { 0x00F7, 0xD6 }, { 0x00F8, 0xBF }, { 0x00F9, 0x9D },
+    { 0x00FA, 0x9C }, { 0x00FB, 0x9E }, { 0x00FC, 0x9F }, { 0x00FF, 0xD8 },
+    { 0x0131, 0xF5 }, { 0x0152, 0xCE }, { 0x0153, 0xCF }, { 0x0178, 0xD9 },
+    { 0x0192, 0xC4 }, { 0x02C6, 0xF6 }, { 0x02C7, 0xFF }, { 0x02D8, 0xF9 },
+    { 0x02D9, 0xFA }, { 0x02DA, 0xFB }, { 0x02DB, 0xFE }, { 0x02DC, 0xF7 },
+    { 0x02DD, 0xFD }, { 0x03A9, 0xBD }, { 0x03C0, 0xB9 }, { 0x2013, 0xD0 },
+    { 0x2014, 0xD1 }, { 0x2018, 0xD4 }, { 0x2019, 0xD5 }, { 0x201A, 0xE2 },
+    { 0x201C, 0xD2 }, { 0x201D, 0xD3 }, { 0x201E, 0xE3 }, { 0x2020, 0xA0 },
+    { 0x2021, 0xE0 }, { 0x2022, 0xA5 }, { 0x2026, 0xC9 }, { 0x2030, 0xE4 },
+    { 0x2039, 0xDC }, { 0x203A, 0xDD }, { 0x2044, 0xDA }, { 0x20AC, 0xDB },
+    { 0x2122, 0xAA }, { 0x2202, 0xB6 }, { 0x2206, 0xC6 }, { 0x220F, 0xB8 },
+    { 0x2211, 0xB7 }, { 0x221A, 0xC3 }, { 0x221E, 0xB0 }, { 0x222B, 0xBA },
+    { 0x2248, 0xC5 }, { 0x2260, 0xAD }, { 0x2264, 0xB2 }, { 0x2265, 0xB3 },
+    { 0x25CA, 0xD7 }, { 0xF8FF, 0xF0 }, { 0xFB01, 0xDE }, { 0xFB02, 0xDF }
+};
+
+// ------------------------------------------------------------------------------------------
+inline bool
+operator < (
+    const UnicodeToMacRoman&    entry, 
+    uint16_t                    u)
+{
+    return (entry.mUnicode < u);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the number of leading ASCII characters of @a s, and appends them to @a out 
+    as bytes.
+*/
+size_t
+NarrowAscii(
+    const uint16_t* s, 
+    size_t          n, 
+    std::string&    out)
+{
+    size_t  count   = B::Transcoding::CountAscii(s, n);
+    size_t  size    = out.size();
+    
+    if (count == 0)
+        return (0);
+    
+    out.resize(size + count);
+    
+    char*   p   = &out[size];
+    size_t  i   = 0;
+
+#if defined(__SSE2__)
+    
+    // All characters are known to be less than 0x80, so saturation never kicks in.
+    
+    for ( ; i + 16 <= count; i += 16)
+    {
+        __m128i a   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i b   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 8));
+        
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), _mm_packus_epi16(a, b));
+    }
+
+#endif  // __SSE2__
+    
+    for ( ; i < count; i++)
+        p[i] = static_cast<char>(s[i]);
+    
+    return (count);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the number of leading ASCII characters of @a s, and appends them to @a out 
+    as UTF-16.
+*/
+size_t
+WidenAscii(
+    const char*             s, 
+    size_t                  n, 
+    std::vector<uint16_t>&  out)
+{
+    size_t  count   = B::Transcoding::CountAscii(s, n);
+    size_t  size    = out.size();
+    
+    if (count == 0)
+        return (0);
+    
+    out.resize(size + count);
+    
+    uint16_t*   p   = &out[size];
+    size_t      i   = 0;
+
+#if defined(__SSE2__)
+    
+    const __m128i   zero    = _mm_setzero_si128();
+    
+    for ( ; i + 16 <= count; i += 16)
+    {
+        __m128i v   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i),     _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+
+#endif  // __SSE2__
+    
+    for ( ; i < count; i++)
+        p[i] = static_cast<unsigned char>(s[i]);
+    
+    return (count);
+}
+
+}   // anonymous namespace
+
+
+namespace B {
+namespace Transcoding {
+
+// ------------------------------------------------------------------------------------------
+size_t
+CountAscii(
+    const char* s,  //!< The input bytes.
+    size_t      n)  //!< The number of bytes in @a s.
+{
+    size_t  i   = 0;
+
+#if defined(__SSE2__)
+    
+    for ( ; i + 32 <= n; i += 32)
+    {
+        __m128i a   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i b   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 16));
+        
+        if (_mm_movemask_epi8(_mm_or_si128(a, b)) != 0)
+            break;
+    }
+
+#else
+    
+    const uint64_t  kHighBits   = 0x8080808080808080ULL;
+    
+    for ( ; i + 16 <= n; i += 16)
+    {
+        uint64_t    a, b;
+        
+        memcpy(&a, s + i, sizeof(a));
+        memcpy(&b, s + i + 8, sizeof(b));
+        
+        if (((a | b) & kHighBits) != 0)
+            break;
+    }
+
+#endif  // __SSE2__
+    
+    while ((i < n) && (static_cast<unsigned char>(s[i]) < 0x80))
+        i++;
+    
+    return (i);
+}
+
+// ------------------------------------------------------------------------------------------
+size_t
+CountAscii(
+    const uint16_t* s,  //!< The input characters.
+    size_t          n)  //!< The number of characters in @a s.
+{
+    size_t  i   = 0;
+
+#if defined(__SSE2__)
+    
+    const __m128i   kHighBits   = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i   zero        = _mm_setzero_si128();
+    
+    for ( ; i + 16 <= n; i += 16)
+    {
+        __m128i a   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i b   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 8));
+        __m128i hi  = _mm_and_si128(_mm_or_si128(a, b), kHighBits);
+        
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(hi, zero)) != 0xFFFF)
+            break;
+    }
+
+#else
+    
+    const uint64_t  kHighBits   = 0xFF80FF80FF80FF80ULL;
+    
+    for ( ; i + 8 <= n; i += 8)
+    {
+        uint64_t    a, b;
+        
+        memcpy(&a, s + i, sizeof(a));
+        memcpy(&b, s + i + 4, sizeof(b));
+        
+        if (((a | b) & kHighBits) != 0)
+            break;
+    }
+
+#endif  // __SSE2__
+    
+    while ((i < n) && (s[i] < 0x80))
+        i++;
+    
+    return (i);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Fails if @a s contains non-ASCII characters.
+*/
+bool
+EncodeAscii(
+    const uint16_t* s,      //!< The input characters.
+    size_t          n,      //!< The number of characters in @a s.
+    std::string&    out)    //!< The output string.
+{
+    return (NarrowAscii(s, n, out) == n);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Fails if @a s contains unpaired surrogates.
+*/
+bool
+EncodeUtf8(
+    const uint16_t* s,      //!< The input characters.
+    size_t          n,      //!< The number of characters in @a s.
+    std::string&    out)    //!< The output string.
+{
+    size_t  i   = 0;
+    
+    while (i < n)
+    {
+        i += NarrowAscii(s + i, n - i, out);
+        
+        // Convert characters one by one up to the next ASCII character.
+        
+        for ( ; (i < n) && (s[i] >= 0x80); i++)
+        {
+            uint32_t    cp  = s[i];
+            char        buff[4];
+            size_t      len;
+            
+            if (cp < 0x800)
+            {
+                buff[0] = static_cast<char>(0xC0 | (cp >> 6));
+                buff[1] = static_cast<char>(0x80 | (cp & 0x3F));
+                len     = 2;
+            }
+            else if ((cp < 0xD800) || (cp > 0xDFFF))
+            {
+                buff[0] = static_cast<char>(0xE0 | (cp >> 12));
+                buff[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                buff[2] = static_cast<char>(0x80 | (cp & 0x3F));
+                len     = 3;
+            }
+            else if ((cp < 0xDC00) && (i + 1 < n) && (s[i+1] >= 0xDC00) && (s[i+1] <= 0xDFFF))
+            {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (s[++i] - 0xDC00);
+                
+                buff[0] = static_cast<char>(0xF0 | (cp >> 18));
+                buff[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                buff[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                buff[3] = static_cast<char>(0x80 | (cp & 0x3F));
+                len     = 4;
+            }
+            else
+            {
+                return (false);
+            }
+            
+            out.append(buff, len);
+        }
+    }
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Fails if @a s contains characters that have no equivalent in Mac OS Roman.
+*/
+bool
+EncodeMacRoman(
+    const uint16_t* s,      //!< The input characters.
+    size_t          n,      //!< The number of characters in @a s.
+    std::string&    out)    //!< The output string.
+{
+    const UnicodeToMacRoman*    begin   = kUnicodeToMacRoman;
+    const UnicodeToMacRoman*    end     = kUnicodeToMacRoman + 128;
+    size_t                      i       = 0;
+    
+    while (i < n)
+    {
+        i += NarrowAscii(s + i, n - i, out);
+        
+        for ( ; (i < n) && (s[i] >= 0x80); i++)
+        {
+            const UnicodeToMacRoman*    it  = std::lower_bound(begin, end, s[i]);
+            
+            if ((it == end) || (it->mUnicode != s[i]))
+                return (false);
+            
+            out += static_cast<char>(it->mByte);
+        }
+    }
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Fails if @a s isn't well-formed UTF-8 (this includes overlong forms and encoded 
+    surrogates).
+*/
+bool
+DecodeUtf8(
+    const char*             s,      //!< The input bytes.
+    size_t                  n,      //!< The number of bytes in @a s.
+    std::vector<uint16_t>&  out)    //!< The output characters.
+{
+    const unsigned char*    u   = reinterpret_cast<const unsigned char*>(s);
+    size_t                  i   = 0;
+    
+    while (i < n)
+    {
+        i += WidenAscii(s + i, n - i, out);
+        
+        while ((i < n) && (u[i] >= 0x80))
+        {
+            unsigned char   c   = u[i];
+            size_t          len = (c < 0xE0) ? 2 : ((c < 0xF0) ? 3 : 4);
+            unsigned char   lo  = 0x80;
+            unsigned char   hi  = 0xBF;
+            
+            // The bounds on the second byte reject overlong forms, surrogates, and 
+            // code points beyond U+10FFFF (see table 3-7 of the Unicode Standard).
+            
+            if ((c < 0xC2) || (c > 0xF4) || (n - i < len))
+                return (false);
+            else if (c == 0xE0)
+                lo = 0xA0;
+            else if (c == 0xED)
+                hi = 0x9F;
+            else if (c == 0xF0)
+                lo = 0x90;
+            else if (c == 0xF4)
+                hi = 0x8F;
+            
+            if ((u[i+1] < lo) || (u[i+1] > hi))
+                return (false);
+            
+            uint32_t    cp  = c & (0x7F >> len);
+            
+            for (size_t j = 1; j < len; j++)
+            {
+                if ((u[i+j] & 0xC0) != 0x80)
+                    return (false);
+                
+                cp = (cp << 6) | (u[i+j] & 0x3F);
+            }
+            
+            if (cp < 0x10000)
+            {
+                out.push_back(static_cast<uint16_t>(cp));
+            }
+            else
+            {
+                out.push_back(static_cast<uint16_t>(0xD800 + ((cp - 0x10000) >> 10)));
+                out.push_back(static_cast<uint16_t>(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+            }
+            
+            i += len;
+        }
+    }
+    
+    return (true);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+DecodeMacRoman(
+    const char*             s,      //!< The input bytes.
+    size_t                  n,      //!< The number of bytes in @a s.
+    std::vector<uint16_t>&  out)    //!< The output characters.
+{
+    const unsigned char*    u   = reinterpret_cast<const unsigned char*>(s);
+    size_t                  i   = 0;
+    
+    while (i < n)
+    {
+        i += WidenAscii(s + i, n - i, out);
+        
+        for ( ; (i < n) && (u[i] >= 0x80); i++)
+            out.push_back(kMacRomanToUnicode[u[i] - 0x80]);
+    }
+}
+
+}   // namespace Transcoding
+}   // namespace B
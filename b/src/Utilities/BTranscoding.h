@@ -0,0 +1,87 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BTranscoding_H_
+#define BTranscoding_H_
+
+#pragma once
+
+// standard headers
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+namespace B {
+
+/*!
+    @brief  Fast conversions between UTF-16 and the most common byte encodings.
+    
+    The functions in this namespace convert between UTF-16 (the representation used 
+    by String) and ASCII, UTF-8 and Mac OS Roman.  They exist because these 
+    conversions are by far the most frequent ones, and because in practice most of 
+    the text being converted is ASCII:  the functions look for runs of ASCII 
+    characters 16 or 32 at a time, using SSE2 instructions when they are available 
+    and 64-bit integer arithmetic otherwise, and convert those runs in bulk.
+    
+    None of the functions depend on CoreFoundation.  They only perform strict, 
+    lossless conversions;  when given input that can't be converted that way 
+    (unmappable characters, unpaired surrogates, ill-formed UTF-8) they return 
+    @c false, and the caller is expected to fall back on CoreFoundation, which knows 
+    how to report or work around the problem.
+    
+    The @c Encode functions append to their output;  when they return @c false, the 
+    output's contents are unspecified.
+    
+    @ingroup    Utilities
+*/
+namespace Transcoding {
+
+//! @name ASCII Detection
+//@{
+//! Returns the number of ASCII characters at the start of @a s.
+size_t  CountAscii(const char* s, size_t n);
+//! Returns the number of ASCII characters at the start of @a s.
+size_t  CountAscii(const uint16_t* s, size_t n);
+//@}
+
+//! @name Encoding UTF-16
+//@{
+//! Appends the ASCII representation of @a s to @a out.
+bool    EncodeAscii(const uint16_t* s, size_t n, std::string& out);
+//! Appends the UTF-8 representation of @a s to @a out.
+bool    EncodeUtf8(const uint16_t* s, size_t n, std::string& out);
+//! Appends the Mac OS Roman representation of @a s to @a out.
+bool    EncodeMacRoman(const uint16_t* s, size_t n, std::string& out);
+//@}
+
+//! @name Decoding to UTF-16
+//@{
+//! Appends the UTF-16 representation of the UTF-8 text @a s to @a out.
+bool    DecodeUtf8(const char* s, size_t n, std::vector<uint16_t>& out);
+//! Appends the UTF-16 representation of the Mac OS Roman text @a s to @a out.
+void    DecodeMacRoman(const char* s, size_t n, std::vector<uint16_t>& out);
+//@}
+
+}   // namespace Transcoding
+
+}   // namespace B
+
+
+#endif  // BTranscoding_H_
@@ -61,19 +61,35 @@ Url::Url()
 }
 
 // ------------------------------------------------------------------------------------------
+/*! Copying a moved-from URL yields another moved-from URL.
+*/
 Url::Url(const Url& url)
     : mRef(url.mRef)
 {
-    CFRetain(mRef);
+    if (mRef != NULL)
+        CFRetain(mRef);
 }
 
 // ------------------------------------------------------------------------------------------
-Url::Url(OSPtr<CFURLRef> cfurl)
+Url::Url(const OSPtr<CFURLRef>& cfurl)
     : mRef(cfurl)
 {
     CFRetain(mRef);
 }
 
+// ------------------------------------------------------------------------------------------
+/*! Takes ownership of @a cfurl without retaining it.
+    
+    @exception  std::bad_alloc  If @a cfurl is @c NULL.
+*/
+Url::Url(
+    CFURLRef            cfurl,  //!< The URL, obtained from a "Create" or "Copy" function.
+    const from_copy_t&)
+        : mRef(cfurl)
+{
+    B_THROW_IF_NULL(mRef);
+}
+
 // ------------------------------------------------------------------------------------------
 Url::Url(
     const String&               inString)
@@ -130,7 +146,8 @@ Url::Url(
 // ------------------------------------------------------------------------------------------
 Url::~Url()
 {
-    CFRelease(mRef);
+    if (mRef != NULL)
+        CFRelease(mRef);
 }
 
 // ------------------------------------------------------------------------------------------
@@ -139,9 +156,13 @@ Url::Assign(const Url& url)
 {
     if (mRef != url.mRef)
     {
-        CFRelease(mRef);
+        if (url.mRef != NULL)
+            CFRetain(url.mRef);
+        
+        if (mRef != NULL)
+            CFRelease(mRef);
+        
         mRef = url.mRef;
-        CFRetain(mRef);
     }
     
     return (*this);
@@ -149,13 +170,16 @@ Url::Assign(const Url& url)
 
 // ------------------------------------------------------------------------------------------
 Url&
-Url::Assign(OSPtr<CFURLRef> cfurl)
+Url::Assign(const OSPtr<CFURLRef>& cfurl)
 {
     if (mRef != cfurl)
     {
-        CFRelease(mRef);
+        CFRetain(cfurl);
+        
+        if (mRef != NULL)
+            CFRelease(mRef);
+        
         mRef = cfurl;
-        CFRetain(mRef);
     }
     
     return (*this);
@@ -623,30 +647,22 @@ Url::CopyPath(std::string& path) const
 Url
 Url::Absolute() const
 {
-    OSPtr<CFURLRef> url(CFURLCopyAbsoluteURL(mRef), from_copy);
-    
-    return (Url(url));
+    return (Url(CFURLCopyAbsoluteURL(mRef), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
 Url
 Url::PushPath(const String& name, bool is_dir) const
 {
-    OSPtr<CFURLRef> url(CFURLCreateCopyAppendingPathComponent(NULL, mRef, 
-                                                              name.cf_ref(), is_dir), 
-                        from_copy);
-    
-    return (Url(url));
+    return (Url(CFURLCreateCopyAppendingPathComponent(NULL, mRef, name.cf_ref(), is_dir), 
+                from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
 Url
 Url::PopPath() const
 {
-    OSPtr<CFURLRef> url(CFURLCreateCopyDeletingLastPathComponent(NULL, mRef), 
-                        from_copy);
-    
-    return (Url(url));
+    return (Url(CFURLCreateCopyDeletingLastPathComponent(NULL, mRef), from_copy));
 }
 
 // ------------------------------------------------------------------------------------------
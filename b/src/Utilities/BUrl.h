@@ -21,6 +21,9 @@
 
 #pragma once
 
+// standard headers
+#include <algorithm>
+
 // system headers
 #include <CoreFoundation/CFURL.h>
 
@@ -46,7 +49,11 @@ public:
     // constructors / destructor
                 Url();
                 Url(const Url& url);
-    explicit    Url(OSPtr<CFURLRef> cfurl);
+#if B_HAS_RVALUE_REFS
+                Url(Url&& url) throw();
+#endif
+    explicit    Url(const OSPtr<CFURLRef>& cfurl);
+    explicit    Url(CFURLRef cfurl, const from_copy_t&);
     explicit    Url(
                     const String&               inString);
     explicit    Url(
@@ -63,10 +70,13 @@ public:
     
     // assignment
     Url&    operator = (const Url& url);
-    Url&    operator = (OSPtr<CFURLRef> cfurl);
+#if B_HAS_RVALUE_REFS
+    Url&    operator = (Url&& url) throw();
+#endif
+    Url&    operator = (const OSPtr<CFURLRef>& cfurl);
     Url&    operator = (const String& str);
     Url&    Assign(const Url& url);
-    Url&    Assign(OSPtr<CFURLRef> cfurl);
+    Url&    Assign(const OSPtr<CFURLRef>& cfurl);
     Url&    Assign(
                 const String&               inString);
     Url&    Assign(
@@ -80,6 +90,7 @@ public:
                 CFStringEncoding            inEncoding = kCFStringEncodingUTF8, 
                 const Url*                  inBase = NULL);
     void    Clear();
+    void    swap(Url& url);
     
     bool    Empty() const;
     bool    IsStandard() const;                         // conforms to RFC 1808
@@ -171,13 +182,41 @@ Url::operator = (const Url& url)
     return (Assign(url));
 }
 
+#if B_HAS_RVALUE_REFS
+// ------------------------------------------------------------------------------------------
+/*! Takes over @a url's underlying @c CFURLRef.  @a url may then only be assigned to, 
+    copied or destroyed.
+*/
+inline
+Url::Url(Url&& url) throw()
+    : mRef(url.mRef)
+{
+    url.mRef = NULL;
+}
+
+// ------------------------------------------------------------------------------------------
+inline Url&
+Url::operator = (Url&& url) throw()
+{
+    swap(url);
+    return (*this);
+}
+#endif
+
 // ------------------------------------------------------------------------------------------
 inline Url&
-Url::operator = (OSPtr<CFURLRef> cfurl)
+Url::operator = (const OSPtr<CFURLRef>& cfurl)
 {
     return (Assign(cfurl));
 }
 
+// ------------------------------------------------------------------------------------------
+inline void
+Url::swap(Url& url)
+{
+    std::swap(mRef, url.mRef);
+}
+
 // ------------------------------------------------------------------------------------------
 inline Url&
 Url::operator = (const String& str)
@@ -220,6 +259,12 @@ Url::operator != (const Url& url) const
     return (!CFEqual(mRef, url.mRef));
 }
 
+// ------------------------------------------------------------------------------------------
+inline void
+swap(Url& url1, Url& url2)
+{
+    url1.swap(url2);
+}
 
 }   // namespace B
 
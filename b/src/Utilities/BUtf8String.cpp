@@ -0,0 +1,792 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+// file header
+#include "BUtf8String.h"
+
+// standard headers
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+#include <vector>
+
+
+namespace {
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the number of bytes in the UTF-8 sequence introduced by @a c, which must be 
+    a valid lead byte.
+*/
+inline size_t
+SequenceLength(
+    unsigned char   c)
+{
+    return ((c < 0x80) ? 1 : ((c < 0xE0) ? 2 : ((c < 0xF0) ? 3 : 4)));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Decodes the (valid) UTF-8 sequence at @a p.
+*/
+inline uint32_t
+DecodeCodePoint(
+    const char*     p)
+{
+    const unsigned char*    s   = reinterpret_cast<const unsigned char*>(p);
+    
+    if (s[0] < 0x80)
+        return (s[0]);
+    else if (s[0] < 0xE0)
+        return (((s[0] & 0x1F) << 6) | (s[1] & 0x3F));
+    else if (s[0] < 0xF0)
+        return (((s[0] & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F));
+    else
+        return (((s[0] & 0x07) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F));
+}
+
+// ------------------------------------------------------------------------------------------
+inline B::Utf8String::value_type
+HighSurrogate(
+    uint32_t    cp)
+{
+    return (static_cast<B::Utf8String::value_type>(0xD800 + ((cp - 0x10000) >> 10)));
+}
+
+// ------------------------------------------------------------------------------------------
+inline B::Utf8String::value_type
+LowSurrogate(
+    uint32_t    cp)
+{
+    return (static_cast<B::Utf8String::value_type>(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+}
+
+}   // anonymous namespace
+
+
+namespace B {
+
+// ==========================================================================================
+//  Utf8String::Index
+
+struct Utf8String::Index
+{
+    std::vector<IndexEntry> mEntries;   //!< Entry @c j covers UTF-16 index <tt>j * kIndexStride</tt>.
+};
+
+
+// ==========================================================================================
+//  Utf8String
+
+#pragma mark Utf8String
+
+// ------------------------------------------------------------------------------------------
+Utf8String::Utf8String()
+    : mByteSize(0), mCapacity(kInlineCapacity), mLength(0)
+{
+    mInline[0] = 0;
+}
+
+// ------------------------------------------------------------------------------------------
+Utf8String::Utf8String(
+    const Utf8String&   str)    //!< The source string.
+        : mByteSize(0), mCapacity(kInlineCapacity), mLength(0)
+{
+    mInline[0] = 0;
+    
+    append_bytes(str.data(), str.mByteSize, str.mLength);
+}
+
+// ------------------------------------------------------------------------------------------
+Utf8String::Utf8String(
+    const char*     cstr)   //!< The source string, in null-terminated UTF-8.
+        : mByteSize(0), mCapacity(kInlineCapacity), mLength(0)
+{
+    size_type   n   = strlen(cstr);
+    
+    mInline[0] = 0;
+    
+    append_bytes(cstr, n, measure(cstr, n));
+}
+
+// ------------------------------------------------------------------------------------------
+Utf8String::Utf8String(
+    const char*     cstr,   //!< The source string, in UTF-8.
+    size_type       n)      //!< The number of bytes in @a cstr.
+        : mByteSize(0), mCapacity(kInlineCapacity), mLength(0)
+{
+    mInline[0] = 0;
+    
+    append_bytes(cstr, n, measure(cstr, n));
+}
+
+// ------------------------------------------------------------------------------------------
+Utf8String::Utf8String(
+    const std::string&  sstr)   //!< The source string, in UTF-8.
+        : mByteSize(0), mCapacity(kInlineCapacity), mLength(0)
+{
+    mInline[0] = 0;
+    
+    append_bytes(sstr.data(), sstr.size(), measure(sstr.data(), sstr.size()));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  std::invalid_argument   If @a ustr contains unpaired surrogates.
+*/
+Utf8String::Utf8String(
+    const value_type*   ustr,   //!< The source string, in UTF-16.
+    size_type           n)      //!< The number of code units in @a ustr.
+        : mByteSize(0), mCapacity(kInlineCapacity), mLength(0)
+{
+    size_type   bytes   = 0;
+    
+    mInline[0] = 0;
+    
+    // First pass:  validate, and compute the size of the UTF-8 representation.
+    
+    for (size_type i = 0; i < n; i++)
+    {
+        value_type  u   = ustr[i];
+        
+        if (u < 0x80)
+            bytes += 1;
+        else if (u < 0x800)
+            bytes += 2;
+        else if ((u < 0xD800) || (u > 0xDFFF))
+            bytes += 3;
+        else if ((u < 0xDC00) && (i + 1 < n) && (ustr[i+1] >= 0xDC00) && (ustr[i+1] <= 0xDFFF))
+            bytes += 4, i++;
+        else
+            throw std::invalid_argument("B::Utf8String unpaired surrogate");
+    }
+    
+    reserve(bytes);
+    
+    // Second pass:  encode.
+    
+    unsigned char*  out = reinterpret_cast<unsigned char*>(get_data());
+    
+    for (size_type i = 0; i < n; i++)
+    {
+        uint32_t    cp  = ustr[i];
+        
+        if ((cp >= 0xD800) && (cp <= 0xDBFF))
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (ustr[++i] - 0xDC00);
+        
+        if (cp < 0x80)
+        {
+            *out++ = static_cast<unsigned char>(cp);
+        }
+        else if (cp < 0x800)
+        {
+            *out++ = static_cast<unsigned char>(0xC0 | (cp >> 6));
+            *out++ = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            *out++ = static_cast<unsigned char>(0xE0 | (cp >> 12));
+            *out++ = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+            *out++ = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            *out++ = static_cast<unsigned char>(0xF0 | (cp >> 18));
+            *out++ = static_cast<unsigned char>(0x80 | ((cp >> 12) & 0x3F));
+            *out++ = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+            *out++ = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+        }
+    }
+    
+    *out = 0;
+    
+    mByteSize   = bytes;
+    mLength     = n;
+}
+
+#if defined(__APPLE__)
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  std::invalid_argument   If @a cfstr contains unpaired surrogates.
+*/
+Utf8String::Utf8String(
+    CFStringRef     cfstr)  //!< The source string.
+        : mByteSize(0), mCapacity(kInlineCapacity), mLength(0)
+{
+    const char* cstr    = CFStringGetCStringPtr(cfstr, kCFStringEncodingUTF8);
+    
+    mInline[0] = 0;
+    
+    if (cstr != NULL)
+    {
+        size_type   n   = strlen(cstr);
+        
+        append_bytes(cstr, n, measure(cstr, n));
+    }
+    else
+    {
+        CFIndex length  = CFStringGetLength(cfstr);
+        CFIndex size    = CFStringGetMaximumSizeForEncoding(length, kCFStringEncodingUTF8);
+        CFIndex used    = 0;
+        
+        reserve(size);
+        
+        CFIndex converted   = CFStringGetBytes(cfstr, CFRangeMake(0, length), 
+                                               kCFStringEncodingUTF8, 0, false, 
+                                               reinterpret_cast<UInt8*>(get_data()), 
+                                               size, &used);
+        
+        if (converted != length)
+            throw std::invalid_argument("B::Utf8String unpaired surrogate");
+        
+        get_data()[used] = 0;
+        
+        mByteSize   = used;
+        mLength     = length;
+    }
+}
+
+#endif  // __APPLE__
+
+// ------------------------------------------------------------------------------------------
+Utf8String::~Utf8String()
+{
+    if (mCapacity > kInlineCapacity)
+        delete [] mHeap;
+}
+
+// ------------------------------------------------------------------------------------------
+Utf8String&
+Utf8String::operator = (
+    const Utf8String&   str)    //!< The source string.
+{
+    if (&str != this)
+    {
+        clear();
+        append_bytes(str.data(), str.mByteSize, str.mLength);
+    }
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+Utf8String::swap(
+    Utf8String&     str)    //!< The string to exchange contents with.
+{
+    char    temp[sizeof(mInline)];
+    
+    // mInline spans the whole union, so this swaps heap pointers as well.
+    
+    memcpy(temp, mInline, sizeof(mInline));
+    memcpy(mInline, str.mInline, sizeof(mInline));
+    memcpy(str.mInline, temp, sizeof(mInline));
+    
+    std::swap(mByteSize, str.mByteSize);
+    std::swap(mCapacity, str.mCapacity);
+    std::swap(mLength, str.mLength);
+    mIndex.swap(str.mIndex);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+Utf8String::reserve(
+    size_type   n)  //!< The number of bytes.
+{
+    if (n > mCapacity)
+        grow(n);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+Utf8String::grow(
+    size_type   n)
+{
+    size_type   capacity    = std::max(n, 2 * mCapacity);
+    char*       buff        = new char [capacity + 1];
+    
+    memcpy(buff, get_data(), mByteSize + 1);
+    
+    if (mCapacity > kInlineCapacity)
+        delete [] mHeap;
+    
+    mHeap       = buff;
+    mCapacity   = capacity;
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Appends @a n bytes of UTF-8 (which must have been validated already), containing 
+    @a length UTF-16 code units.  @a cstr may point into the string itself.
+*/
+void
+Utf8String::append_bytes(
+    const char* cstr, 
+    size_type   n, 
+    size_type   length)
+{
+    if (mByteSize + n > mCapacity)
+    {
+        const char* data    = get_data();
+        
+        if ((cstr >= data) && (cstr < data + mByteSize))
+        {
+            size_type   offset  = cstr - data;
+            
+            grow(mByteSize + n);
+            cstr = get_data() + offset;
+        }
+        else
+        {
+            grow(mByteSize + n);
+        }
+    }
+    
+    char*   data    = get_data();
+    
+    memmove(data + mByteSize, cstr, n);
+    
+    mByteSize   += n;
+    mLength     += length;
+    data[mByteSize] = 0;
+    
+    mIndex.reset();
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Checks that the @a n bytes at @a cstr are well-formed UTF-8, and returns the number 
+    of UTF-16 code units they represent.
+    
+    @exception  std::invalid_argument   If @a cstr isn't well-formed.
+*/
+Utf8String::size_type
+Utf8String::measure(
+    const char* cstr, 
+    size_type   n)
+{
+    const unsigned char*    s       = reinterpret_cast<const unsigned char*>(cstr);
+    const unsigned char*    end     = s + n;
+    size_type               length  = 0;
+    
+    while (s < end)
+    {
+        unsigned char   c   = *s;
+        
+        if (c < 0x80)
+        {
+            // ASCII is by far the most common case, so skip it quickly.
+            
+            s++;
+            length++;
+            continue;
+        }
+        
+        size_type       len     = SequenceLength(c);
+        unsigned char   lo      = 0x80;
+        unsigned char   hi      = 0xBF;
+        
+        // The bounds on the second byte reject overlong forms, surrogates, and 
+        // code points beyond U+10FFFF (see table 3-7 of the Unicode Standard).
+        
+        if ((c < 0xC2) || (c > 0xF4) || (static_cast<size_type>(end - s) < len))
+            throw std::invalid_argument("B::Utf8String ill-formed UTF-8");
+        else if (c == 0xE0)
+            lo = 0xA0;
+        else if (c == 0xED)
+            hi = 0x9F;
+        else if (c == 0xF0)
+            lo = 0x90;
+        else if (c == 0xF4)
+            hi = 0x8F;
+        
+        if ((s[1] < lo) || (s[1] > hi))
+            throw std::invalid_argument("B::Utf8String ill-formed UTF-8");
+        
+        for (size_type i = 2; i < len; i++)
+        {
+            if ((s[i] & 0xC0) != 0x80)
+                throw std::invalid_argument("B::Utf8String ill-formed UTF-8");
+        }
+        
+        s       += len;
+        length  += (len == 4) ? 2 : 1;
+    }
+    
+    return (length);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Builds the index the first time it's needed.
+*/
+const Utf8String::Index&
+Utf8String::get_index() const
+{
+    if (mIndex.get() == NULL)
+    {
+        boost::scoped_ptr<Index>    index(new Index);
+        const char*                 data    = get_data();
+        size_type                   unit    = 0;
+        size_type                   next    = 0;
+        
+        index->mEntries.reserve(mLength / kIndexStride + 1);
+        
+        for (size_type byte = 0; byte < mByteSize; )
+        {
+            size_type   len     = SequenceLength(data[byte]);
+            size_type   units   = (len == 4) ? 2 : 1;
+            
+            while (next < unit + units)
+            {
+                IndexEntry  entry   = { unit, byte };
+                
+                index->mEntries.push_back(entry);
+                next += kIndexStride;
+            }
+            
+            unit += units;
+            byte += len;
+        }
+        
+        mIndex.swap(index);
+    }
+    
+    return (*mIndex);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the index entry for the code point that contains, or precedes by less than 
+    kIndexStride code units, the UTF-16 index @a pos.  @a pos must be less than size().
+*/
+Utf8String::IndexEntry
+Utf8String::locate(
+    size_type   pos) const
+{
+    return (get_index().mEntries[pos / kIndexStride]);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the byte offset of the code point that starts at UTF-16 index @a pos.
+    
+    @exception  std::invalid_argument   If @a pos falls in the middle of a surrogate pair.
+*/
+Utf8String::size_type
+Utf8String::byte_offset(
+    size_type   pos) const
+{
+    if (is_ascii())
+        return (pos);
+    
+    if (pos >= mLength)
+        return (mByteSize);
+    
+    const char* data    = get_data();
+    IndexEntry  entry   = locate(pos);
+    
+    while (entry.mUnit < pos)
+    {
+        size_type   len     = SequenceLength(data[entry.mByte]);
+        
+        entry.mUnit += (len == 4) ? 2 : 1;
+        entry.mByte += len;
+    }
+    
+    if (entry.mUnit != pos)
+        throw std::invalid_argument("B::Utf8String index splits a surrogate pair");
+    
+    return (entry.mByte);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns the UTF-16 index of the code point starting at byte offset @a byte.
+*/
+Utf8String::size_type
+Utf8String::unit_index(
+    size_type   byte) const
+{
+    if (is_ascii())
+        return (byte);
+    
+    if (byte >= mByteSize)
+        return (mLength);
+    
+    // Find the last entry at or before byte.
+    
+    const std::vector<IndexEntry>&  entries = get_index().mEntries;
+    size_type                       lo      = 0;
+    size_type                       hi      = entries.size();
+    
+    while (hi - lo > 1)
+    {
+        size_type   mid = (lo + hi) / 2;
+        
+        if (entries[mid].mByte <= byte)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    
+    const char* data    = get_data();
+    IndexEntry  entry   = entries[lo];
+    
+    while (entry.mByte < byte)
+    {
+        size_type   len     = SequenceLength(data[entry.mByte]);
+        
+        entry.mUnit += (len == 4) ? 2 : 1;
+        entry.mByte += len;
+    }
+    
+    return (entry.mUnit);
+}
+
+// ------------------------------------------------------------------------------------------
+Utf8String::value_type
+Utf8String::slow_at(
+    size_type   pos) const
+{
+    const char* data    = get_data();
+    IndexEntry  entry   = locate(pos);
+    
+    for (;;)
+    {
+        size_type   len     = SequenceLength(data[entry.mByte]);
+        size_type   units   = (len == 4) ? 2 : 1;
+        
+        if (entry.mUnit + units > pos)
+            break;
+        
+        entry.mUnit += units;
+        entry.mByte += len;
+    }
+    
+    uint32_t    cp  = DecodeCodePoint(data + entry.mByte);
+    
+    if (cp < 0x10000)
+        return (static_cast<value_type>(cp));
+    else if (entry.mUnit == pos)
+        return (HighSurrogate(cp));
+    else
+        return (LowSurrogate(cp));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  std::out_of_range   If @a pos is greater than or equal to size().
+*/
+Utf8String::value_type
+Utf8String::at(
+    size_type   pos)    //!< The index of the code unit to return.
+    const
+{
+    if (pos >= mLength)
+        throw std::out_of_range("B::Utf8String::at pos out of range");
+    
+    return ((*this)[pos]);
+}
+
+#if defined(__APPLE__)
+
+// ------------------------------------------------------------------------------------------
+OSPtr<CFStringRef>
+Utf8String::cf_ptr() const
+{
+    CFStringRef str = CFStringCreateWithBytes(NULL, 
+                                              reinterpret_cast<const UInt8*>(get_data()), 
+                                              mByteSize, kCFStringEncodingUTF8, false);
+    
+    return (OSPtr<CFStringRef>(str, from_copy));
+}
+
+#endif  // __APPLE__
+
+// ------------------------------------------------------------------------------------------
+/*! Byte-wise comparison of UTF-8 orders strings by code point.
+    
+    @return     < 0 if @c *this < @a str;  0 if @c *this == @a str;  > 0 if @c *this > @a str.
+*/
+int
+Utf8String::compare(
+    const Utf8String&   str)    //!< The string to compare against.
+    const
+{
+    int result  = memcmp(get_data(), str.get_data(), std::min(mByteSize, str.mByteSize));
+    
+    if (result == 0)
+        result = (mByteSize < str.mByteSize) ? -1 : ((mByteSize > str.mByteSize) ? 1 : 0);
+    
+    return (result);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! The search is performed on the UTF-8 bytes;  because UTF-8 is self-synchronising, 
+    a match can only start on a code point boundary.
+    
+    @return The index of @a str, or @c npos if not found.
+*/
+Utf8String::size_type
+Utf8String::find(
+    const Utf8String&   str,            //!< The string to look for.
+    size_type           pos /* = 0 */)  //!< The starting position for the search.
+    const
+{
+    if (pos > mLength)
+        return (npos);
+    
+    // An empty string is found where the search starts, even mid-pair, as with String.
+    if (str.empty())
+        return (pos);
+    
+    size_type   start;
+    
+    try
+    {
+        start = byte_offset(pos);
+    }
+    catch (const std::invalid_argument&)
+    {
+        // pos is in the middle of a surrogate pair;  start at the next character.
+        start = byte_offset(pos + 1);
+    }
+    
+    const char* data    = get_data();
+    const char* found   = std::search(data + start, data + mByteSize, 
+                                      str.get_data(), str.get_data() + str.mByteSize);
+    
+    if (found == data + mByteSize)
+        return (npos);
+    
+    return (unit_index(found - data));
+}
+
+// ------------------------------------------------------------------------------------------
+/*! Returns a string containing at most @a n code units of @c *this, starting at 
+    index @a pos.
+    
+    @exception  std::out_of_range       If @a pos is greater than size().
+    @exception  std::invalid_argument   If the substring would split a surrogate pair.
+*/
+Utf8String
+Utf8String::substr(
+    size_type   pos /* = 0 */,      //!< The index of the first code unit.
+    size_type   n /* = npos */)     //!< The number of code units.
+    const
+{
+    if (pos > mLength)
+        throw std::out_of_range("B::Utf8String::substr pos out of range");
+    
+    n = std::min(n, mLength - pos);
+    
+    size_type   first   = byte_offset(pos);
+    size_type   last    = byte_offset(pos + n);
+    Utf8String  result;
+    
+    result.append_bytes(get_data() + first, last - first, n);
+    
+    return (result);
+}
+
+// ------------------------------------------------------------------------------------------
+Utf8String&
+Utf8String::append(
+    const Utf8String&   str)    //!< The string to append.
+{
+    append_bytes(str.get_data(), str.mByteSize, str.mLength);
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+/*! @exception  std::invalid_argument   If @a cstr isn't well-formed UTF-8.
+*/
+Utf8String&
+Utf8String::append(
+    const char* cstr,   //!< The string to append, in UTF-8.
+    size_type   n)      //!< The number of bytes in @a cstr.
+{
+    append_bytes(cstr, n, measure(cstr, n));
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+void
+Utf8String::clear()
+{
+    mByteSize   = 0;
+    mLength     = 0;
+    get_data()[0] = 0;
+    
+    mIndex.reset();
+}
+
+
+// ==========================================================================================
+//  Utf8String::const_iterator
+
+#pragma mark -
+#pragma mark Utf8String::const_iterator
+
+// ------------------------------------------------------------------------------------------
+Utf8String::value_type
+Utf8String::const_iterator::operator * () const
+{
+    uint32_t    cp  = DecodeCodePoint(mPtr);
+    
+    if (cp < 0x10000)
+        return (static_cast<value_type>(cp));
+    else if (!mLow)
+        return (HighSurrogate(cp));
+    else
+        return (LowSurrogate(cp));
+}
+
+// ------------------------------------------------------------------------------------------
+Utf8String::const_iterator&
+Utf8String::const_iterator::operator ++ ()
+{
+    size_type   len = SequenceLength(*mPtr);
+    
+    if ((len == 4) && !mLow)
+    {
+        mLow = true;
+    }
+    else
+    {
+        mPtr += len;
+        mLow = false;
+    }
+    
+    return (*this);
+}
+
+// ------------------------------------------------------------------------------------------
+Utf8String::const_iterator&
+Utf8String::const_iterator::operator -- ()
+{
+    if (mLow)
+    {
+        mLow = false;
+    }
+    else
+    {
+        do
+            --mPtr;
+        while ((*mPtr & 0xC0) == 0x80);
+        
+        mLow = (SequenceLength(*mPtr) == 4);
+    }
+    
+    return (*this);
+}
+
+}   // namespace B
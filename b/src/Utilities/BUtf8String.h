@@ -0,0 +1,340 @@
+// ==========================================================================================
+//  
+//  Copyright (C) 2003-2006 Paul Lalonde enrg.
+//  
+//  This program is free software;  you can redistribute it and/or modify it under the 
+//  terms of the GNU General Public License as published by the Free Software Foundation;  
+//  either version 2 of the License, or (at your option) any later version.
+//  
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY 
+//  WARRANTY;  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A 
+//  PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License along with this 
+//  program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, 
+//  Suite 330, Boston, MA  02111-1307  USA
+//  
+// ==========================================================================================
+
+#ifndef BUtf8String_H_
+#define BUtf8String_H_
+
+#pragma once
+
+// standard headers
+#include <iterator>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// library headers
+#include <boost/scoped_ptr.hpp>
+
+// system headers
+#if defined(__APPLE__)
+#   include <CoreFoundation/CFString.h>
+#endif
+
+// B headers
+#if defined(__APPLE__)
+#   include "BOSPtr.h"
+#endif
+
+
+namespace B {
+
+/*!
+    @brief  A portable, UTF-8 based counterpart to String.
+    
+    String stores its characters in a @c CFStringRef, ie (for most strings) as UTF-16, 
+    and needs CoreFoundation for everything it does.  Utf8String stores its characters 
+    as UTF-8, has no dependency on the Mac OS, and is therefore usable in code that 
+    must also build elsewhere (eg to exercise or benchmark text processing on other 
+    platforms).
+    
+    Utf8String's interface follows String's:  indices, sizes and characters are 
+    expressed in UTF-16 code units, so that code written against one works unchanged 
+    (and gives identical results) with the other.  Internally though:
+        
+        - Strings of up to kInlineCapacity bytes are stored inside the object, 
+          without any heap allocation.  This covers most keys, identifiers and names.
+        - The length in UTF-16 code units is computed when the UTF-8 is validated, 
+          and is cached thereafter;  size() never walks the string.
+        - Pure ASCII strings, in which UTF-16 indices and byte offsets coincide, are 
+          accessed directly.  For other strings, an index that maps UTF-16 positions 
+          to byte offsets every kIndexStride code units is built the first time 
+          it's needed, and discarded when the string changes.
+    
+    The contents of a Utf8String are always valid UTF-8;  functions that would create 
+    invalid UTF-8 (including unpaired surrogates) throw @c std::invalid_argument.
+    
+    On Mac OS X, Utf8String can be constructed from a @c CFStringRef and converted back 
+    with cf_ptr().
+    
+    @note   compare() orders strings by code point, which is not what 
+            @c String::compare() does.
+    
+    @note   Because the index is built lazily by const member functions, a given 
+            non-ASCII Utf8String may not be read concurrently from several threads 
+            (unlike a @c std::string) unless its index has already been built, eg 
+            by a prior call to at().  Concurrent reads of different strings, and 
+            of pure ASCII strings, are safe.
+    
+    @ingroup    Utilities
+*/
+class Utf8String
+{
+public:
+    
+    //! @name Types
+    //@{
+    typedef uint16_t    value_type;         //!< The type of the characters (UTF-16 code units).
+    typedef size_t      size_type;          //!< The unsigned integral type for size values and indices.
+    typedef ptrdiff_t   difference_type;    //!< The signed integral type for difference values.
+    class               const_iterator;     //!< The type of constant iterators.
+    
+    /*! @brief  Non-modifiable iterator on a Utf8String.
+        
+        Iterates over the string's UTF-16 code units, decoding the UTF-8 on the fly.  
+        Characters outside the Basic Multilingual Plane yield two code units (a 
+        surrogate pair), exactly as they would with String.
+    */
+    class const_iterator : public std::iterator<std::bidirectional_iterator_tag, 
+                                                value_type, 
+                                                difference_type, 
+                                                const value_type*, 
+                                                value_type>
+    {
+    public:
+        
+        // constructor
+        const_iterator()                                        : mPtr(NULL), mLow(false) {}
+        
+        value_type      operator * () const;
+        
+        const_iterator& operator ++ ();
+        const_iterator& operator -- ();
+        const_iterator  operator ++ (int)                       { const_iterator temp(*this); ++*this; return (temp); }
+        const_iterator  operator -- (int)                       { const_iterator temp(*this); --*this; return (temp); }
+        
+        bool            operator == (const const_iterator& it) const    { return ((mPtr == it.mPtr) && (mLow == it.mLow)); }
+        bool            operator != (const const_iterator& it) const    { return (!(*this == it)); }
+    
+    private:
+        
+        const_iterator(const char* inPtr)                       : mPtr(inPtr), mLow(false) {}
+        
+        // member variables
+        const char* mPtr;   //!< The first byte of the current code point.
+        bool        mLow;   //!< Are we on the second half of a surrogate pair?
+        
+        // friends
+        friend class    Utf8String;
+    };
+    //@}
+    
+    //! @name Constants
+    //@{
+    //! Sentinel value meaning "not found" or "all remaining characters"
+    static const size_type  npos            = size_type(-1);
+    //! The number of bytes that may be stored without allocating memory.
+    static const size_type  kInlineCapacity = 23;
+    //! The number of UTF-16 code units between entries of the index.
+    static const size_type  kIndexStride    = 32;
+    //@}
+    
+    //! @name Constructors / Destructor
+    //@{
+    //! Default constructor.
+                Utf8String();
+    //! Copy constructor.
+                Utf8String(const Utf8String& str);
+    //! UTF-8 @c char array constructor.
+    explicit    Utf8String(const char* cstr);
+    //! UTF-8 @c char array constructor.
+    explicit    Utf8String(const char* cstr, size_type n);
+    //! UTF-8 @c std::string constructor.
+    explicit    Utf8String(const std::string& sstr);
+    //! UTF-16 array constructor.
+    explicit    Utf8String(const value_type* ustr, size_type n);
+#if defined(__APPLE__)
+    //! @c CFStringRef constructor.
+    explicit    Utf8String(CFStringRef cfstr);
+#endif
+    //! Destructor.
+                ~Utf8String();
+    //@}
+    
+    //! @name Assignment
+    //@{
+    //! Utf8String assignment.
+    Utf8String& operator = (const Utf8String& str);
+    //! Exchanges the contents of the string with @a str.
+    void        swap(Utf8String& str);
+    //@}
+    
+    //! @name Operations for Size and Capacity
+    //@{
+    //! Returns the number of UTF-16 code units in the string.
+    size_type   size() const        { return (mLength); }
+    //! Returns the number of UTF-16 code units in the string.
+    size_type   length() const      { return (mLength); }
+    //! Returns whether the string is empty.
+    bool        empty() const       { return (mByteSize == 0); }
+    //! Returns the number of bytes in the string's UTF-8 representation.
+    size_type   byte_size() const   { return (mByteSize); }
+    //! Returns the number of bytes the string could contain without reallocation.
+    size_type   capacity() const    { return (mCapacity); }
+    //! Returns whether the string consists entirely of ASCII characters.
+    bool        is_ascii() const    { return (mLength == mByteSize); }
+    //! Makes room for at least @a n bytes.
+    void        reserve(size_type n);
+    //@}
+    
+    //! @name Character Access
+    //@{
+    //! Returns the UTF-16 code unit at index @a pos.
+    value_type  operator [] (size_type pos) const;
+    //! Returns the UTF-16 code unit at index @a pos, with bounds checking.
+    value_type  at(size_type pos) const;
+    //! Returns the string's UTF-8 representation, null-terminated.
+    const char* c_str() const       { return (get_data()); }
+    //! Returns the string's UTF-8 representation.
+    const char* data() const        { return (get_data()); }
+#if defined(__APPLE__)
+    //! Returns a @c CFStringRef with the same contents.
+    OSPtr<CFStringRef>  cf_ptr() const;
+#endif
+    //@}
+    
+    //! @name Comparisons
+    //@{
+    //! Compares the string to @a str, by code point.
+    int         compare(const Utf8String& str) const;
+    //@}
+    
+    //! @name Finding and Substrings
+    //@{
+    //! Finds the first occurrence of @a str, starting at index @a pos.
+    size_type   find(const Utf8String& str, size_type pos = 0) const;
+    //! Returns a substring.
+    Utf8String  substr(size_type pos = 0, size_type n = npos) const;
+    //@}
+    
+    //! @name Modifiers
+    //@{
+    //! Appends @a str.
+    Utf8String& append(const Utf8String& str);
+    //! Appends @a n bytes of UTF-8 from @a cstr.
+    Utf8String& append(const char* cstr, size_type n);
+    //! Appends @a str.
+    Utf8String& operator += (const Utf8String& str)    { return (append(str)); }
+    //! Removes all characters.
+    void        clear();
+    //@}
+    
+    //! @name Generating Iterators
+    //@{
+    //! Returns an iterator for the beginning of the string.
+    const_iterator  begin() const   { return (const_iterator(get_data())); }
+    //! Returns an iterator for the end of the string.
+    const_iterator  end() const     { return (const_iterator(get_data() + mByteSize)); }
+    //@}
+
+private:
+    
+    struct IndexEntry
+    {
+        size_type   mUnit;  //!< The UTF-16 index of a code point.
+        size_type   mByte;  //!< The byte offset of the same code point.
+    };
+    
+    struct Index;
+    
+    char*           get_data()                  { return ((mCapacity > kInlineCapacity) ? mHeap : mInline); }
+    const char*     get_data() const            { return ((mCapacity > kInlineCapacity) ? mHeap : mInline); }
+    void            append_bytes(const char* cstr, size_type n, size_type length);
+    void            grow(size_type n);
+    const Index&    get_index() const;
+    IndexEntry      locate(size_type pos) const;
+    size_type       byte_offset(size_type pos) const;
+    size_type       unit_index(size_type byte) const;
+    value_type      slow_at(size_type pos) const;
+    
+    static size_type    measure(const char* cstr, size_type n);
+    
+    // member variables
+    union
+    {
+        char*       mHeap;
+        char        mInline[kInlineCapacity+1];
+    };
+    size_type                           mByteSize;
+    size_type                           mCapacity;
+    size_type                           mLength;    //!< In UTF-16 code units.
+    mutable boost::scoped_ptr<Index>    mIndex;    //!< Built on demand;  see the class's thread-safety note.
+};
+
+// ------------------------------------------------------------------------------------------
+/*! If @a pos is greater than or equal to size(), the results are undefined.
+*/
+inline Utf8String::value_type
+Utf8String::operator [] (
+    size_type   pos)    //!< The index of the code unit to return.
+    const
+{
+    if (is_ascii())
+        return (static_cast<unsigned char>(get_data()[pos]));
+    else
+        return (slow_at(pos));
+}
+
+// ==========================================================================================
+//  Utf8String Global Functions
+
+/*! @defgroup   Utf8StringFunctions Utf8String Global Functions
+*/
+//@{
+
+//! @name Comparison Operators
+//@{
+
+/*! Compares two strings for equality.
+    
+    @return     @c true if @a s1 is equal to @a s2
+    @relates    Utf8String
+*/
+inline bool operator == (const Utf8String& s1, const Utf8String& s2)    { return (s1.compare(s2) == 0); }
+/*! Compares two strings for inequality.
+    
+    @return     @c true if @a s1 is not equal to @a s2
+    @relates    Utf8String
+*/
+inline bool operator != (const Utf8String& s1, const Utf8String& s2)    { return (s1.compare(s2) != 0); }
+/*! Compares two strings, by code point.
+    
+    @return     @c true if @a s1 is less than @a s2
+    @relates    Utf8String
+*/
+inline bool operator <  (const Utf8String& s1, const Utf8String& s2)    { return (s1.compare(s2) <  0); }
+
+//@}
+
+//! @name Miscellaneous
+//@{
+
+// ------------------------------------------------------------------------------------------
+/*! Exchanges the contents of @a s1 and @a s2.
+    
+    @relates    Utf8String
+*/
+inline void swap(Utf8String& s1, Utf8String& s2)    { s1.swap(s2); }
+
+//@}
+
+//@}
+
+}   // namespace B
+
+
+#endif  // BUtf8String_H_
@@ -19,7 +19,11 @@
 // file header
 #include "BCustomView.h"
 
+// standard headers
+#include <typeinfo>
+
 // B headers
+#include "BDispatchTrace.h"
 #include "BEvent.h"
 #include "BEventParams.h"
 #include "BNib.h"
@@ -125,7 +129,8 @@ CustomView::InitEventHandler()
     mEventHandler.Add(this, &CustomView::ControlGetData);
     mEventHandler.Add(this, &CustomView::ControlGetOptimalBounds);
     mEventHandler.Add(this, &CustomView::ControlGetSizeConstraints);
-    mEventHandler.Add(this, &CustomView::ControlBoundsChanged);
+    mEventHandler.Add(this, &CustomView::ControlBoundsChanged, 
+                      kEventArgAttributes | kEventArgPreviousBounds | kEventArgCurrentBounds);
 #if B_BUILDING_CAN_USE_10_3_APIS
     mEventHandler.Add(this, &CustomView::ControlVisibilityChanged);
 #endif
@@ -1967,6 +1972,9 @@ CustomView::ControlDraw(
     {
         // Tell the view to draw.
         
+        B_DISPATCH_TRACE_SCOPE(kDraw, kEventClassControl, kEventControlDraw, 
+                               typeid(*this).name());
+        
         Draw(event.mPartCode, event.mCGContext, event.mDrawShape);
         
         handled = true;
@@ -509,6 +509,16 @@ protected:
                         const Shape&            inShape);
     //@}
     
+    //! @name Event Coalescing
+    //@{
+    //! Drops Carbon %Events of the given @a CLASS and @a KIND that have been superseded by a more recent one.
+    template <UInt32 CLASS, UInt32 KIND>
+    void            CoalesceEvents(
+                        bool            inCoalesce = true);
+    //! Returns the number of Carbon %Events dropped by coalescing.
+    UInt32          GetCoalescedEventCount() const;
+    //@}
+    
     // member variables
     const EViewFlags    mViewFlags; //!< The view's flags.
     bool                mAwakened;
@@ -682,6 +692,28 @@ CustomView::Create(
     return (Create(T::kHIObjectClassID, inViewID, inSuperview, inFrame, inFromNib, inEvent));
 }
 
+// ------------------------------------------------------------------------------------------
+/*! Derived classes may call this to have superseded Carbon %Events of the given 
+    @a CLASS and @a KIND dropped before they reach the corresponding handler.  The 
+    view's handler for the event must already exist.  See EventHandler::Coalesce().
+    
+    @param  CLASS   Template parameter.  Should be an integral four-char constant representing a Carbon %Event class.
+    @param  KIND    Template parameter.  Should be an integral four-char constant representing a Carbon %Event kind in @a CLASS's namespace.
+*/
+template <UInt32 CLASS, UInt32 KIND> inline void
+CustomView::CoalesceEvents(
+    bool    inCoalesce) //!< Whether to coalesce the Carbon %Event.
+{
+    mEventHandler.Coalesce<CLASS, KIND>(inCoalesce);
+}
+
+// ------------------------------------------------------------------------------------------
+inline UInt32
+CustomView::GetCoalescedEventCount() const
+{
+    return (mEventHandler.GetCoalescedCount());
+}
+
 // ------------------------------------------------------------------------------------------
 inline HIViewRef
 CustomView::GetViewRef() const
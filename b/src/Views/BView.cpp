@@ -23,6 +23,7 @@
 #include <Carbon/Carbon.h>
 
 // B headers
+#include "BAllocationAccounting.h"
 #include "BCustomView.h"
 #include "BEvent.h"
 #include "BNib.h"
@@ -100,11 +101,14 @@ View::View(HIViewRef inViewRef)
     View*   view    = this;
     
     ViewObjectProperty::Set(inViewRef, view);
+    
+    AllocationAccounting::Allocated(AllocationAccounting::kViews);
 }
 
 // ------------------------------------------------------------------------------------------
 View::~View()
 {
+    AllocationAccounting::Deallocated(AllocationAccounting::kViews);
 }
 
 // ------------------------------------------------------------------------------------------
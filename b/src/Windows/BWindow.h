@@ -317,6 +317,16 @@ protected:
     virtual bool    ShouldWindowClose();
     virtual Size    GetIdealSize() const;
     
+    //! @name Event Coalescing
+    //@{
+    //! Drops Carbon %Events of the given @a CLASS and @a KIND that have been superseded by a more recent one.
+    template <UInt32 CLASS, UInt32 KIND>
+    void            CoalesceEvents(
+                        bool            inCoalesce = true);
+    //! Returns the number of Carbon %Events dropped by coalescing.
+    UInt32          GetCoalescedEventCount() const;
+    //@}
+    
     // Carbon %Event handlers
     virtual void    HandleShowing();
     virtual void    HandleHiding();
@@ -532,6 +542,28 @@ Window::CreateFromNibWithState(
     return (windowPtr);
 }
 
+// ------------------------------------------------------------------------------------------
+/*! Derived classes may call this to have superseded Carbon %Events of the given 
+    @a CLASS and @a KIND dropped before they reach the corresponding handler.  The 
+    window's handler for the event must already exist.  See EventHandler::Coalesce().
+    
+    @param  CLASS   Template parameter.  Should be an integral four-char constant representing a Carbon %Event class.
+    @param  KIND    Template parameter.  Should be an integral four-char constant representing a Carbon %Event kind in @a CLASS's namespace.
+*/
+template <UInt32 CLASS, UInt32 KIND> inline void
+Window::CoalesceEvents(
+    bool    inCoalesce) //!< Whether to coalesce the Carbon %Event.
+{
+    mEventHandler.Coalesce<CLASS, KIND>(inCoalesce);
+}
+
+// ------------------------------------------------------------------------------------------
+inline UInt32
+Window::GetCoalescedEventCount() const
+{
+    return (mEventHandler.GetCoalescedCount());
+}
+
 // ------------------------------------------------------------------------------------------
 /*! @param  VIEW    Template parameter.  The C/C++ class of the view object.  Must be View or a class derived from View.
     